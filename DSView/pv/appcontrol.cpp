@@ -117,8 +117,13 @@ bool AppControl::Init()
         return false;
     }
 
-    // Load the protocol decoders
-    if (srd_decoder_load_all() != SRD_OK)
+    // Load the protocol decoders, unchanged ones come from the manifest
+    // and are imported when first used
+    QString manifestDir = GetUserDataDir();
+    QDir().mkpath(manifestDir);
+    QString manifest = manifestDir + "/decoders.manifest";
+
+    if (srd_decoder_load_all_cached(manifest.toUtf8().data()) != SRD_OK)
     {
         dsv_err("ERROR: load the protocol decoders failed.");
         return false;
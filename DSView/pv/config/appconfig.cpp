@@ -122,6 +122,9 @@ static void _loadApp(AppOptions &o, QSettings &st)
     getFiled("displayProfileInBar", st, o.displayProfileInBar, false);
     getFiled("swapBackBufferAlways", st, o.swapBackBufferAlways, false);
     getFiled("fontSize", st, o.fontSize, 9.0);
+    getFiled("historyFrames", st, o.historyFrames, 8);
+    getFiled("historyMemory", st, o.historyMemory, 512);
+    getFiled("historyEvict", st, o.historyEvict, 0);
 
     o.warnofMultiTrig = true;
 
@@ -148,6 +151,9 @@ static void _saveApp(AppOptions &o, QSettings &st)
     setFiled("displayProfileInBar", st, o.displayProfileInBar);
     setFiled("swapBackBufferAlways", st, o.swapBackBufferAlways);
     setFiled("fontSize", st, o.fontSize);
+    setFiled("historyFrames", st, o.historyFrames);
+    setFiled("historyMemory", st, o.historyMemory);
+    setFiled("historyEvict", st, o.historyEvict);
 
     QString fmt =  FormatArrayToString(o.m_protocolFormats);
     setFiled("protocalFormats", st, fmt);
@@ -66,6 +66,9 @@ struct AppOptions
     bool  displayProfileInBar;
     bool  swapBackBufferAlways;
     float fontSize;
+    int   historyFrames; // repeat mode capture history
+    int   historyMemory; // MB
+    int   historyEvict;
 
     std::vector<StringPair> m_protocolFormats;
 };
@@ -76,6 +76,7 @@ void AnalogSnapshot::init_all()
     _ring_sample_count = 0;
     _memory_failed = false;
     _last_ended = true; 
+    publish();
 
     for (unsigned int i = 0; i < _channel_num; i++) {
         for (unsigned int level = 0; level < ScaleStepCount; level++) {
@@ -197,6 +198,8 @@ void AnalogSnapshot::append_payload(const sr_datafeed_analog &analog)
 	// Generate the first mip-map from the data
     if (analog.num_samples != 0) // guarantee new samples to compute
         append_payload_to_envelope_levels();
+
+    publish();
 }
 
 void AnalogSnapshot::append_data(void *data, uint64_t samples, uint16_t pitch)
@@ -0,0 +1,121 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2016 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include "binarymodel.h"
+
+#include <algorithm>
+
+#include "decode/binarydata.h"
+#include "../ui/langresource.h"
+
+namespace pv {
+namespace data {
+
+BinaryModel::BinaryModel(QObject *parent)
+    : QAbstractTableModel(parent),
+      _binary_data(NULL),
+      _first_offset(0),
+      _size(0)
+{
+}
+
+void BinaryModel::setBinaryData(decode::BinaryData *binary_data)
+{
+    _binary_data = binary_data;
+    refresh();
+}
+
+void BinaryModel::refresh()
+{
+    beginResetModel();
+    if (_binary_data) {
+        _first_offset = _binary_data->get_first_offset();
+        _size = _binary_data->get_size();
+    } else {
+        _first_offset = 0;
+        _size = 0;
+    }
+    endResetModel();
+}
+
+int BinaryModel::rowCount(const QModelIndex & /* parent */) const
+{
+    return (_size - _first_offset + BytesPerRow - 1) / BytesPerRow;
+}
+
+int BinaryModel::columnCount(const QModelIndex & /* parent */) const
+{
+    return 3;
+}
+
+QVariant BinaryModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || _binary_data == NULL)
+        return QVariant();
+
+    if (role == Qt::TextAlignmentRole) {
+        return int(Qt::AlignLeft | Qt::AlignVCenter);
+    } else if (role == Qt::DisplayRole) {
+        uint64_t offset = _first_offset + (uint64_t)index.row() * BytesPerRow;
+
+        if (index.column() == 0)
+            return QString("%1").arg(offset, 8, 16, QChar('0')).toUpper();
+
+        unsigned char buf[BytesPerRow];
+        uint64_t len = _binary_data->read(offset, buf, std::min((uint64_t)BytesPerRow, _size - offset));
+        const char *digits = "0123456789ABCDEF";
+        QString text;
+
+        for (uint64_t i = 0; i < len; i++) {
+            if (index.column() == 1) {
+                if (i > 0)
+                    text += ' ';
+                text += QChar(digits[buf[i] >> 4]);
+                text += QChar(digits[buf[i] & 15]);
+            } else {
+                text += (buf[i] >= 32 && buf[i] <= 126) ? QChar(buf[i]) : QChar('.');
+            }
+        }
+        return text;
+    }
+    return QVariant();
+}
+
+QVariant BinaryModel::headerData(int section,
+                                   Qt::Orientation  orientation,
+                                   int role) const
+{
+    if (role != Qt::DisplayRole || orientation == Qt::Vertical)
+        return QVariant();
+
+    switch (section) {
+    case 0:
+        return L_S(STR_PAGE_DLG, S_ID(IDS_DLG_BINARY_OFFSET), "Offset");
+    case 1:
+        return L_S(STR_PAGE_DLG, S_ID(IDS_DLG_BINARY_HEX), "Hex");
+    case 2:
+        return L_S(STR_PAGE_DLG, S_ID(IDS_DLG_BINARY_ASCII), "ASCII");
+    }
+    return QVariant();
+}
+
+} // namespace data
+} // namespace pv
@@ -0,0 +1,62 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2016 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#ifndef DSVIEW_PV_DATA_BINARYMODEL_H
+#define DSVIEW_PV_DATA_BINARYMODEL_H
+
+#include <QAbstractTableModel>
+
+namespace pv {
+namespace data {
+
+namespace decode {
+class BinaryData;
+}
+
+//hex view of a decoder binary output, 16 bytes per row
+class BinaryModel : public QAbstractTableModel
+{
+public:
+    static const int BytesPerRow = 16;
+
+public:
+    BinaryModel(QObject *parent = 0);
+
+    int rowCount(const QModelIndex & /*parent*/) const;
+    int columnCount(const QModelIndex & /*parent*/) const;
+    QVariant data(const QModelIndex &index, int role) const;
+    QVariant headerData(int section, Qt::Orientation orientation,int role) const;
+
+    void setBinaryData(decode::BinaryData *binary_data);
+
+    //takes the bytes appended since the last call
+    void refresh();
+
+private:
+    decode::BinaryData *_binary_data;
+    uint64_t    _first_offset;
+    uint64_t    _size;
+};
+
+} // namespace data
+} // namespace pv
+
+#endif // DSVIEW_PV_DATA_BINARYMODEL_H
@@ -41,66 +41,51 @@ namespace pv {
 namespace data {
 namespace decode {
  
-Annotation::Annotation(const srd_proto_data *const pdata, DecoderStatus *status)
+Annotation::Annotation(const srd_proto_ann_record *rec, int resIndex, DecoderStatus *status)
 {
-	assert(pdata);
-	const srd_proto_data_annotation *const pda =
-		(const srd_proto_data_annotation*)pdata->data;
-	assert(pda);
+	assert(rec);
 	assert(status);
+	assert(resIndex >= 0);
 
-	_start_sample =	pdata->start_sample;
-	_end_sample	  =	pdata->end_sample;
-	_format 	= pda->ann_class;
-    _type 		= pda->ann_type;
-	_resIndex 	= -1;
+	_start_sample =	rec->start_sample;
+	_end_sample	  =	rec->end_sample;
+	_format 	= rec->ann_class;
+    _type 		= rec->ann_type;
+	_resIndex 	= resIndex;
 	_status 	= status;
- 
-	//make resource find key
-	std::string key;
-
-    char **annotations = pda->ann_text;
-    while(annotations && *annotations) {
-		if ((*annotations)[0] != '\n'){
-			key.append(*annotations, strlen(*annotations));
-		}		
-		annotations++;  
-	}
-	
-	if (pda->str_number_hex[0]){
-		//append numeric string
-		key.append(pda->str_number_hex, strlen(pda->str_number_hex));
-	}
- 
+}
+
+//the text is interned by the decoder instance, so this runs once per distinct text
+int Annotation::make_res_index(const srd_proto_ann_text *text, DecoderStatus *status)
+{
+	assert(text);
+	assert(status);
+
 	AnnotationSourceItem *resItem = NULL;
-    _resIndex = _status->m_resTable.MakeIndex(key, resItem);
+    int resIndex = status->m_resTable.MakeIndex(text->ann_text, text->str_number_hex, resItem);
      
      //is a new item
 	if (resItem != NULL){ 
-        char **annotations = pda->ann_text;
-    	while(annotations && *annotations) {
-			if ((*annotations)[0] != '\n'){
-				resItem->src_lines.push_back(QString::fromUtf8(*annotations));
-			}
-			annotations++;  
-		}
- 
 		//get numeric data
-		if (pda->str_number_hex[0]){
-			int str_len = strlen(pda->str_number_hex);
+		if (text->str_number_hex[0]){
+			int str_len = strlen(text->str_number_hex);
 
 			if (str_len <= DECODER_MAX_DATA_BLOCK_LEN){
 				resItem->str_number_hex = (char*)malloc(str_len + 1);
 			
 				if (resItem->str_number_hex != NULL){
-					strcpy(resItem->str_number_hex, pda->str_number_hex);
+					strcpy(resItem->str_number_hex, text->str_number_hex);
 					resItem->is_numeric = true;
+					resItem->is_integer = AnnotationResTable::parse_integer(resItem->str_number_hex,
+											resItem->number_value, resItem->number_bits);
 				}
 			}			
 		}
 
-		_status->m_bNumeric |= resItem->is_numeric;
+		status->m_bNumeric |= resItem->is_numeric;
 	}
+
+	return resIndex;
 }
 
 Annotation::Annotation()
@@ -114,7 +99,7 @@ Annotation::~Annotation()
 {     
 }
   
-const std::vector<QString>& Annotation::annotations() const
+std::vector<QString> Annotation::annotations() const
 {  
 	 AnnotationSourceItem *pobj = _status->m_resTable.GetItem(_resIndex);	 
 	 assert(pobj);
@@ -123,59 +108,15 @@ const std::vector<QString>& Annotation::annotations() const
 
 	//get origin data, is not a numberic value
      if (!resItem.is_numeric){
-        return resItem.src_lines;
+        return _status->m_resTable.GetLines(pobj);
      }
 
 	//resItem.str_number_hex must be not null
 	if (resItem.str_number_hex[0] == 0){
 		assert(false);
 	}
- 
-	 if (resItem.cur_display_format !=  _status->m_format){
-		 resItem.cur_display_format = _status->m_format;
-		 resItem.cvt_lines.clear();
-
-		 if (resItem.src_lines.size() > 0)
-		 { 
-			 int 	text_format_buf_len = 0;
-			 char  *text_format_buf = NULL;
-
-			 //have custom string
-			 for (QString &rd_src : resItem.src_lines)
-			 {			
-				 QString src = rd_src.replace("{$}", "%s");
-
-				 const char *num_str = _status->m_resTable.format_numberic(resItem.str_number_hex, resItem.cur_display_format);
-				 const char *src_str = src.toUtf8().data();
-				
-				 int textlen = strlen(src_str) + strlen(num_str);
-				 assert(textlen > 0);
-
-				 if (textlen >= text_format_buf_len)
-				 {
-					if (text_format_buf)
-						free(text_format_buf);
-					text_format_buf = (char*)malloc(textlen + 8);
-					text_format_buf_len = textlen + 8;
-
-					assert(text_format_buf);
-				 }
-				 
-				 sprintf(text_format_buf, src_str, num_str);
-				 resItem.cvt_lines.push_back(QString(text_format_buf));
-			 }
-
-			 if (text_format_buf)
-				free(text_format_buf);
-		 }
-		 else{
-			 //have only numberic value
-			 const char *num_str = _status->m_resTable.format_numberic(resItem.str_number_hex, resItem.cur_display_format);
-			 resItem.cvt_lines.push_back(QString(num_str));
-		 }
-	 }
-
-	return resItem.cvt_lines;
+
+	return _status->m_resTable.GetFormatLines(_resIndex, _status->m_format);
 }       
 
 bool Annotation::is_numberic()
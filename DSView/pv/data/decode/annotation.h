@@ -31,20 +31,23 @@
 class AnnotationResTable;
 class DecoderStatus;
 
-struct srd_proto_data;
+struct srd_proto_ann_record;
+struct srd_proto_ann_text;
 
 namespace pv {
 namespace data {
 namespace decode {
 
-//create at DecoderStack.annotation_callback
+//create at DecoderStack.annotation_batch_callback
 class Annotation
 {
 public:
-	Annotation(const srd_proto_data *const pdata, DecoderStatus *status);
+	Annotation(const srd_proto_ann_record *rec, int resIndex, DecoderStatus *status);
     Annotation();
 	~Annotation();
 
+	static int make_res_index(const srd_proto_ann_text *text, DecoderStatus *status);
+
 public:
 	inline uint64_t start_sample() const{
 		return _start_sample;
@@ -62,9 +65,13 @@ public:
 		return _type;
 	}  
 
+	inline int res_index() const{
+		return _resIndex;
+	}
+
 	bool is_numberic();
 
-	const std::vector<QString>& annotations() const;
+	std::vector<QString> annotations() const;
 
 private:
 	uint64_t 		_start_sample;
@@ -22,107 +22,149 @@
 #include "annotationrestable.h"
 #include <assert.h>
 #include <stdlib.h> 
+#include <string.h>
 #include <math.h>
 #include "../../log.h"
 #include "../../dsvdef.h"
  
 const char g_bin_cvt_table[] = "0000000100100011010001010110011110001001101010111100110111101111";
- 
- char* bin2oct_string(char *buf, int size, const char *bin, int len){
-	char *wr = buf + size - 1;
-	*wr = 0; //end flag
+const char g_hex_digits[] = "0123456789ABCDEF";
 
-	char *rd = (char*)bin + len - 1; //move to last byte
-	char tmp[3]; 
+static inline int hex_nibble(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	return -1;
+}
 
-	while (rd >= bin && wr > buf)
-	{  
-		wr--;
-		int num = 0;
+//-----------------------------------
 
-		while (rd >= bin && num < 3)
-		{
-			tmp[2-num] = *rd;			 
-			rd--;
-			num++;
-		}
+AnnotationResTable::AnnotationResTable(){
 
-		//fill
-		while (num < 3)
-		{
-			tmp[2-num] = '0';
-			++num;
-		}		
-
-	    if (strncmp(tmp, "000", 3) == 0)
-			*wr = '0';
-		else if (strncmp(tmp, "001", 3) == 0)
-			*wr = '1';
-		else if (strncmp(tmp, "010", 3) == 0)
-			*wr = '2';
-		else if (strncmp(tmp, "011", 3) == 0)
-			*wr = '3';
-		else if (strncmp(tmp, "100", 3) == 0)
-			*wr = '4';
-		else if (strncmp(tmp, "101", 3) == 0)
-			*wr = '5';
-		else if (strncmp(tmp, "110", 3) == 0)
-			*wr = '6';
-		else if (strncmp(tmp, "111", 3) == 0)
-			*wr = '7';
-	} 
-
-	return wr;
-}
+  }
 
-long long bin2long_string(const char *bin, int len)
+//FNV-1a over the raw bytes, lines are separated so "ab","c" differs from "a","bc"
+uint64_t AnnotationResTable::hash_key(const char *const *lines, const char *number_hex)
 {
-	char *rd = (char *)bin + len - 1; //move to last byte
-	int dex = 0;
-	long long value = 0;
-	long long bv = 0;
+	const uint64_t prime = 0x100000001b3ULL;
+	uint64_t h = 0xcbf29ce484222325ULL;
 
-    while (rd >= bin)
-	{
-		if (*rd == '1')
-		{
-			bv = 1 << dex;
-			value += bv;
+	while (lines && *lines){
+		for (const char *p = *lines; *p; p++){
+			h ^= (uint8_t)*p;
+			h *= prime;
 		}
-		rd--;
-		++dex;
+		h ^= 0xff;
+		h *= prime;
+		lines++;
+	}
+
+	for (const char *p = number_hex; *p; p++){
+		h ^= (uint8_t)*p;
+		h *= prime;
 	}
 
-	return value;
+	return h;
 }
 
-//-----------------------------------
+bool AnnotationResTable::equal_key(const AnnotationSourceItem *item, const char *const *lines, const char *number_hex)
+{
+	const char *rd = item->src_text;
+	int n = 0;
+
+	while (lines && *lines){
+		if (n == item->src_line_count || strcmp(rd, *lines) != 0)
+			return false;
+		rd += strlen(rd) + 1;
+		lines++;
+		n++;
+	}
 
-AnnotationResTable::AnnotationResTable(){
+	return n == item->src_line_count && strcmp(rd, number_hex) == 0;
+}
 
-  }
+void AnnotationResTable::grow_slots()
+{
+	std::vector<IndexSlot> old;
+	old.swap(m_slots);
+
+	IndexSlot empty = {0, -1};
+	m_slots.assign(old.empty() ? 1024 : old.size() * 2, empty);
+	const uint64_t mask = m_slots.size() - 1;
+
+	for (const IndexSlot &s : old){
+		if (s.index == -1)
+			continue;
+		uint64_t pos = s.hash & mask;
+		while (m_slots[pos].index != -1)
+			pos = (pos + 1) & mask;
+		m_slots[pos] = s;
+	}
+}
 
 AnnotationResTable::~AnnotationResTable(){
 	reset();
 }
  
-int AnnotationResTable::MakeIndex(const std::string &key, AnnotationSourceItem* &newItem)
+int AnnotationResTable::MakeIndex(const char *const *lines, const char *number_hex, AnnotationSourceItem* &newItem)
 {   
-    auto fd = m_indexs.find(key);
-    if (fd != m_indexs.end()){
-        return (*fd).second;
-    } 
-  
-    AnnotationSourceItem *item = new AnnotationSourceItem();
-    m_resourceTable.push_back(item);
+	assert(number_hex);
+
+	if ((m_resourceTable.size() + 1) * 2 > m_slots.size())
+		grow_slots();
 
-    item->cur_display_format = -1;
+	const uint64_t hash = hash_key(lines, number_hex);
+	const uint64_t mask = m_slots.size() - 1;
+	uint64_t pos = hash & mask;
+
+	while (m_slots[pos].index != -1){
+		const IndexSlot &s = m_slots[pos];
+		if (s.hash == hash && equal_key(m_resourceTable[s.index], lines, number_hex))
+			return s.index;
+		pos = (pos + 1) & mask;
+	}
+
+	//keep a raw copy of the key, QString lines are made when displayed
+	int text_len = strlen(number_hex) + 1;
+	int line_count = 0;
+	for (const char *const *ln = lines; ln && *ln; ln++){
+		text_len += strlen(*ln) + 1;
+		line_count++;
+	}
+
+	char *src_text = (char*)malloc(text_len);
+	if (src_text == NULL){
+		dsv_err("AnnotationResTable::MakeIndex, Malloc memory failed!");
+		return -1;
+	}
+
+	char *wr = src_text;
+	for (const char *const *ln = lines; ln && *ln; ln++){
+		int len = strlen(*ln) + 1;
+		memcpy(wr, *ln, len);
+		wr += len;
+	}
+	memcpy(wr, number_hex, strlen(number_hex) + 1);
+
+    AnnotationSourceItem *item = new AnnotationSourceItem();
     item->is_numeric = false;
 	item->str_number_hex = NULL;
+	item->is_integer = false;
+	item->number_value = 0;
+	item->number_bits = 0;
+	item->src_text = src_text;
+	item->src_line_count = line_count;
+	item->src_loaded = false;
     newItem = item;
-   
-    int dex = m_indexs.size();
-    m_indexs[key] = dex;
+
+    int dex = m_resourceTable.size();
+    m_resourceTable.push_back(item);
+	m_slots[pos].hash = hash;
+	m_slots[pos].index = dex;
     return dex;
 }
 
@@ -133,6 +175,162 @@ AnnotationSourceItem* AnnotationResTable::GetItem(int index){
     return m_resourceTable[index];
 }
 
+std::vector<QString> AnnotationResTable::GetLines(AnnotationSourceItem *item)
+{
+	assert(item);
+
+	std::lock_guard<std::mutex> lock(m_cacheMutex);
+	return load_lines(item);
+}
+
+const std::vector<QString>& AnnotationResTable::load_lines(AnnotationSourceItem *item)
+{
+	if (!item->src_loaded){
+		const char *rd = item->src_text;
+		for (int i = 0; i < item->src_line_count; i++){
+			//a line starting with '\n' is the ignore flag put in place
+			//of an @hex string, the number is formatted instead
+			if (rd[0] != '\n')
+				item->src_lines.push_back(QString::fromUtf8(rd));
+			rd += strlen(rd) + 1;
+		}
+		item->src_loaded = true;
+	}
+
+	return item->src_lines;
+}
+
+std::vector<QString> AnnotationResTable::GetFormatLines(int index, int fmt)
+{
+	if (fmt < 0 || fmt >= DECODER_FORMAT_COUNT)
+		fmt = DecoderDataFormat::hex;
+
+	std::lock_guard<std::mutex> lock(m_cacheMutex);
+
+	FormatCache &cache = m_formatCache[fmt];
+	auto it = cache.index.find(index);
+
+	if (it != cache.index.end()){
+		cache.order.splice(cache.order.begin(), cache.order, it->second);
+		return it->second->second;
+	}
+
+	AnnotationSourceItem *item = GetItem(index);
+	assert(item->is_numeric);
+
+	QString num;
+	if (item->is_integer){
+		char buf[68];
+		format_integer(item->number_value, item->number_bits, fmt, buf);
+		num = QString(buf);
+	}
+	else{
+		num = QString(format_numberic(item->str_number_hex, fmt));
+	}
+
+	std::vector<QString> lines;
+	const std::vector<QString> &src_lines = load_lines(item);
+
+	if (src_lines.size() > 0){
+		//have custom string
+		for (const QString &rd_src : src_lines){
+			lines.push_back(QString(rd_src).replace("{$}", num));
+		}
+	}
+	else{
+		//have only numberic value
+		lines.push_back(num);
+	}
+
+	cache.order.push_front(std::make_pair(index, std::move(lines)));
+	cache.index[index] = cache.order.begin();
+
+	if ((int)cache.order.size() > FormatCacheSize){
+		cache.index.erase(cache.order.back().first);
+		cache.order.pop_back();
+	}
+
+	return cache.order.front().second;
+}
+
+bool AnnotationResTable::parse_integer(const char *hex_str, uint64_t &value, int &bits)
+{
+	assert(hex_str);
+
+	uint64_t v = 0;
+	int len = 0;
+
+	for (const char *rd = hex_str; *rd; rd++){
+		int n = hex_nibble(*rd);
+		if (n < 0 || ++len > 16)
+			return false;
+		v = (v << 4) | n;
+	}
+
+	if (len == 0)
+		return false;
+
+	value = v;
+	bits = len * 4;
+	return true;
+}
+
+//buf must hold at least 66 bytes, returns the string length
+int AnnotationResTable::format_integer(uint64_t value, int bits, int fmt, char *buf)
+{
+	assert(buf);
+	assert(bits > 0 && bits <= 64);
+
+	char *wr = buf;
+	int digits;
+
+	switch (fmt)
+	{
+	case DecoderDataFormat::dec:
+		{
+			char tmp[24];
+			char *rd = tmp + sizeof(tmp);
+			do {
+				*--rd = '0' + (value % 10);
+				value /= 10;
+			} while (value);
+			while (rd < tmp + sizeof(tmp))
+				*wr++ = *rd++;
+		}
+		break;
+
+	case DecoderDataFormat::oct:
+		for (digits = (bits + 2) / 3; digits > 0; digits--)
+			*wr++ = g_hex_digits[(value >> ((digits - 1) * 3)) & 7];
+		break;
+
+	case DecoderDataFormat::bin:
+		for (digits = bits; digits > 0; digits--)
+			*wr++ = ((value >> (digits - 1)) & 1) ? '1' : '0';
+		break;
+
+	case DecoderDataFormat::ascii:
+		//can display chars
+		if (bits == 8 && value >= 33 && value <= 126){
+			*wr++ = (char)value;
+			break;
+		}
+		*wr++ = '[';
+		for (digits = bits / 4; digits > 0; digits--)
+			*wr++ = g_hex_digits[(value >> ((digits - 1) * 4)) & 15];
+		*wr++ = ']';
+		break;
+
+	default:
+		for (digits = bits / 4; digits > 0; digits--)
+			*wr++ = g_hex_digits[(value >> ((digits - 1) * 4)) & 15];
+		break;
+	}
+
+	*wr = 0;
+	return wr - buf;
+}
+
 const char* AnnotationResTable::format_to_string(const char *hex_str, int fmt)
 { 
     //flow, convert to oct\dec\bin format
@@ -140,11 +338,14 @@ const char* AnnotationResTable::format_to_string(const char *hex_str, int fmt)
 	 if (data[0] == 0 || fmt == DecoderDataFormat::hex){
 		 return data;
 	 }
-	
-	 //convert to bin format
-	 char *buf = g_bin_format_tmp_buffer + sizeof(g_bin_format_tmp_buffer) - 2;
-	 buf[1] = 0; //set the end flag
-	 buf[0] = 0;
+
+	 //up to 64 bits
+	 uint64_t value;
+	 int bits;
+	 if (parse_integer(data, value, bits)){
+		 format_integer(value, bits, fmt, g_number_tmp_64);
+		 return g_number_tmp_64;
+	 }
 
 	 int len = strlen(data);
 	  //buffer is not enough
@@ -152,69 +353,55 @@ const char* AnnotationResTable::format_to_string(const char *hex_str, int fmt)
 		 return data;
 	 }
 
-     char *rd = (char*)data + len - 1; //move to last byte
-	 char c = 0;
-	 int dex = 0;
-
-	 while (rd >= data)
-	 {
-		 c = *rd;
-
- 		 if (c >= '0' && c <= '9'){
-			 dex = (int)(c - '0');	 
-		 }
-		 else if (c >= 'A' && c <= 'F'){
-			 dex = (int)(c - 'A') + 10;
-		 }
-		 else if (c >= 'a' && c <= 'f'){
-			 dex = (int)(c - 'a') + 10;
-		 }
-		 else{ 
-			 dsv_err("is not a hex string");
-			 assert(false);
-		 }
-
-         char *ptable = (char*)g_bin_cvt_table + dex * 4;
-
-		 buf -= 4; //move to left for 4 bytes
-		 buf[0] = ptable[0];
-		 buf[1] = ptable[1];
-		 buf[2] = ptable[2];
-		 buf[3] = ptable[3];
-	
-		 rd--;
-	 } 
-
-	 //get bin format 
+	 //wider values have no dec format
 	 if (fmt == DecoderDataFormat::bin){
-		  return buf;
+		 char *wr = g_bin_format_tmp_buffer;
+
+		 for (const char *rd = data; *rd; rd++){
+			 int n = hex_nibble(*rd);
+			 if (n < 0){
+				 dsv_err("is not a hex string");
+				 assert(false);
+				 return data;
+			 }
+			 memcpy(wr, g_bin_cvt_table + n * 4, 4);
+			 wr += 4;
+		 }
+		 *wr = 0;
+		 return g_bin_format_tmp_buffer;
 	 }
 
-	 //get oct format
+	 //take 3 bits at a time from the lowest nibble
 	 if (fmt == DecoderDataFormat::oct){
-		 char *oct_buf = bin2oct_string(g_oct_format_tmp_buffer, 
-		                  sizeof(g_oct_format_tmp_buffer), buf,  len * 4);
-		 return oct_buf;
-	 }
+		 char *wr = g_oct_format_tmp_buffer + sizeof(g_oct_format_tmp_buffer) - 1;
+		 unsigned int acc = 0;
+		 int acc_bits = 0;
+		 *wr = 0;
+
+		 for (const char *rd = data + len - 1; rd >= data; rd--){
+			 int n = hex_nibble(*rd);
+			 if (n < 0){
+				 dsv_err("is not a hex string");
+				 assert(false);
+				 return data;
+			 }
+			 acc |= n << acc_bits;
+			 acc_bits += 4;
 
-	//64 bit integer
-	 if (fmt == DecoderDataFormat::dec && len * 4 <= 64){
-         long long lv = bin2long_string(buf, len * 4);
-		 g_number_tmp_64[0] = 0;
-    	 sprintf(g_number_tmp_64, "%lld", lv);
-         return g_number_tmp_64;
+			 while (acc_bits >= 3){
+				 *--wr = g_hex_digits[acc & 7];
+				 acc >>= 3;
+				 acc_bits -= 3;
+			 }
+		 }
+		 if (acc_bits > 0)
+			 *--wr = g_hex_digits[acc & 7];
+
+		 return wr;
 	 }
-	 
+
 	 //ascii
 	 if (fmt == DecoderDataFormat::ascii && len < 30 - 3){
-		 if (len == 2){
-             int lv = (int)bin2long_string(buf, len * 4);
-			 //can display chars
-			 if (lv >= 33 && lv <= 126){
-				 sprintf(g_number_tmp_64, "%c", (char)lv);
-				 return g_number_tmp_64;
-			 }
-         }
          g_number_tmp_64[0] = '[';
          strcpy(g_number_tmp_64 + 1, data);
          g_number_tmp_64[len+1] = ']';
@@ -335,10 +522,18 @@ void AnnotationResTable::reset()
 	for (auto p : m_resourceTable){
 		if (p->str_number_hex)
 			free(p->str_number_hex);
+		if (p->src_text)
+			free(p->src_text);
 		delete p;
 	}
 	m_resourceTable.clear();
-	m_indexs.clear();
+	m_slots.clear();
+
+	std::lock_guard<std::mutex> lock(m_cacheMutex);
+	for (int i = 0; i < DECODER_FORMAT_COUNT; i++){
+		m_formatCache[i].order.clear();
+		m_formatCache[i].index.clear();
+	}
 }
 
 int AnnotationResTable::hexToDecimal(char * hex)
@@ -21,22 +21,30 @@
 
 #pragma once
 
-#include <map>
-#include <string>
+#include <stdint.h>
 #include <vector>
+#include <list>
+#include <unordered_map>
+#include <mutex>
 #include <QString>
 
 #define DECODER_MAX_DATA_BLOCK_LEN 256
 #define CONVERT_STR_MAX_LEN 150
+#define DECODER_FORMAT_COUNT 5
 
 struct AnnotationSourceItem
 {
     bool    is_numeric;
     char    *str_number_hex; //numerical value hex format string
+    bool    is_integer; //str_number_hex is one value of up to 64 bits
+    uint64_t number_value;
+    int     number_bits; //4 bits per hex digit, keeps the leading zeros
 
-    std::vector<QString> src_lines; //the origin source string lines
-    std::vector<QString> cvt_lines; //the converted to bin/hex/oct format string lines
-    int     cur_display_format; //current format  as bin/ex/oct..., init with -1
+    char    *src_text; //the origin lines and then the hex string, each ends with 0
+    int     src_line_count;
+    bool    src_loaded; //src_lines is made from src_text
+
+    std::vector<QString> src_lines; //the origin source string lines, made when displayed
 };
  
 class AnnotationResTable
@@ -46,8 +54,11 @@ class AnnotationResTable
     ~AnnotationResTable();
 
     public:
-       int MakeIndex(const std::string &key, AnnotationSourceItem* &newItem);
+       int MakeIndex(const char *const *lines, const char *number_hex, AnnotationSourceItem* &newItem);
        AnnotationSourceItem* GetItem(int index);
+       //copies, the cache entries can be evicted once the lock is released
+       std::vector<QString> GetLines(AnnotationSourceItem *item);
+       std::vector<QString> GetFormatLines(int index, int fmt);
 
        inline int GetCount(){
            return m_resourceTable.size();} 
@@ -56,17 +67,44 @@ class AnnotationResTable
 
        void reset();
 
+       static bool parse_integer(const char *hex_str, uint64_t &value, int &bits);
+       static int format_integer(uint64_t value, int bits, int fmt, char *buf);
+
        static int hexToDecimal(char * hex);
        static void decimalToBinString(unsigned long long num, int bitSize, char *buffer, int buffer_size);
 
     private:
         const char* format_to_string(const char *hex_str, int fmt);
 
+        const std::vector<QString>& load_lines(AnnotationSourceItem *item);
+
+        static uint64_t hash_key(const char *const *lines, const char *number_hex);
+        static bool equal_key(const AnnotationSourceItem *item, const char *const *lines, const char *number_hex);
+        void grow_slots();
+
     private:
-        std::map<std::string, int>          m_indexs;
+        //open addressing, the size is a power of 2 and at least twice the item count
+        struct IndexSlot
+        {
+            uint64_t hash;
+            int      index; //-1 if empty
+        };
+
+        //formatted lines of the numeric items last shown, one LRU list per format
+        struct FormatCache
+        {
+            typedef std::list<std::pair<int, std::vector<QString>>> List;
+            List order; //most recently used first
+            std::unordered_map<int, List::iterator> index;
+        };
+        static const int FormatCacheSize = 4096;
+
+        std::vector<IndexSlot>              m_slots;
         std::vector<AnnotationSourceItem*>  m_resourceTable;
+        FormatCache                         m_formatCache[DECODER_FORMAT_COUNT];
+        std::mutex                          m_cacheMutex;
         char g_bin_format_tmp_buffer[DECODER_MAX_DATA_BLOCK_LEN * 4 + 2];
         char g_oct_format_tmp_buffer[DECODER_MAX_DATA_BLOCK_LEN * 3 + 2];
-        char g_number_tmp_64[30];
+        char g_number_tmp_64[68];
         char g_all_buf[CONVERT_STR_MAX_LEN + 1];
 };
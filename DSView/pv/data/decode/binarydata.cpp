@@ -0,0 +1,136 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ * 
+ * Copyright (C) 2021 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include "binarydata.h"
+
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+#include <algorithm>
+
+#include "../../log.h"
+
+using std::min;
+
+namespace pv {
+namespace data {
+namespace decode {
+
+BinaryData::BinaryData()
+{
+    _first_offset = 0;
+    _size = 0;
+}
+
+BinaryData::~BinaryData()
+{
+    clear();
+}
+
+bool BinaryData::append(const unsigned char *data, uint64_t size)
+{
+    assert(data);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    while (size > 0)
+    {
+        uint64_t pos = _size % ChunkSize;
+
+        if (pos == 0){
+            //drop the oldest chunk, like a ring buffer
+            if (_chunks.size() == MaxChunkCount){
+                free(_chunks.front());
+                _chunks.pop_front();
+                _first_offset += ChunkSize;
+            }
+
+            unsigned char *chunk = (unsigned char*)malloc(ChunkSize);
+            if (chunk == NULL){
+                dsv_err("BinaryData::append, Malloc memory failed!");
+                return false;
+            }
+            _chunks.push_back(chunk);
+        }
+
+        uint64_t len = min(size, ChunkSize - pos);
+        memcpy(_chunks.back() + pos, data, len);
+        data += len;
+        size -= len;
+        _size += len;
+    }
+
+    return true;
+}
+
+uint64_t BinaryData::read(uint64_t offset, unsigned char *buf, uint64_t size)
+{
+    assert(buf);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (offset < _first_offset || offset >= _size)
+        return 0;
+
+    size = min(size, _size - offset);
+    uint64_t copied = 0;
+
+    while (copied < size)
+    {
+        uint64_t index = (offset - _first_offset) / ChunkSize;
+        uint64_t pos = offset % ChunkSize;
+        uint64_t len = min(size - copied, ChunkSize - pos);
+
+        memcpy(buf + copied, _chunks[index] + pos, len);
+        offset += len;
+        copied += len;
+    }
+
+    return copied;
+}
+
+uint64_t BinaryData::get_size()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _size;
+}
+
+uint64_t BinaryData::get_first_offset()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _first_offset;
+}
+
+void BinaryData::clear()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (unsigned char *p : _chunks){
+        free(p);
+    }
+    _chunks.clear();
+    _first_offset = 0;
+    _size = 0;
+}
+
+} // decode
+} // data
+} // pv
@@ -0,0 +1,70 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ * 
+ * Copyright (C) 2021 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#ifndef DSVIEW_PV_DATA_DECODE_BINARYDATA_H
+#define DSVIEW_PV_DATA_DECODE_BINARYDATA_H
+
+#include <stdint.h>
+#include <deque>
+#include <mutex>
+
+namespace pv {
+namespace data {
+namespace decode {
+
+//the bytes of one binary output class, the oldest chunks are dropped when full
+class BinaryData
+{
+public:
+    static const uint64_t ChunkSize = 1024 * 1024;
+    static const uint64_t MaxChunkCount = 256;
+
+public:
+    BinaryData();
+    ~BinaryData();
+
+    bool append(const unsigned char *data, uint64_t size);
+
+    /**
+     * Copies the bytes from offset, returns the count copied.
+     */
+    uint64_t read(uint64_t offset, unsigned char *buf, uint64_t size);
+
+    //the end offset, counts all bytes appended
+    uint64_t get_size();
+
+    //the offset of the oldest byte kept
+    uint64_t get_first_offset();
+
+    void clear();
+
+private:
+    std::deque<unsigned char*> _chunks;
+    uint64_t    _first_offset;
+    uint64_t    _size;
+    std::mutex  _mutex;
+};
+
+} // decode
+} // data
+} // pv
+
+#endif // DSVIEW_PV_DATA_DECODE_BINARYDATA_H
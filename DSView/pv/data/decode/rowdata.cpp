@@ -22,6 +22,9 @@
 
 #include <math.h>
 #include <assert.h>
+#include <algorithm>
+#include <unordered_set>
+#include <QRegularExpression>
 
 #include "rowdata.h"
 
@@ -33,6 +36,122 @@ namespace pv {
 namespace data {
 namespace decode {
 
+namespace {
+
+//a search term, the literal part is checked before running the regex
+struct TermMatcher
+{
+    QString literal;
+    bool    is_prefix;
+    bool    use_regex;
+    QRegularExpression rx;
+
+    bool match(const QString &text) const
+    {
+        if (is_prefix){
+            if (!text.startsWith(literal))
+                return false;
+        }
+        else if (!literal.isEmpty() && !text.contains(literal)){
+            return false;
+        }
+        return !use_regex || rx.match(text).hasMatch();
+    }
+};
+
+inline bool is_regex_meta(QChar c)
+{
+    return QString("\\.^$|?*+()[]{}").contains(c);
+}
+
+inline bool is_regex_quantifier(QChar c)
+{
+    return c == '?' || c == '*' || c == '{';
+}
+
+//get the longest literal run outside groups and classes, all of it must appear in a match
+bool make_matcher(TermMatcher &m, const QString &term, bool regex)
+{
+    m.literal = term;
+    m.is_prefix = false;
+    m.use_regex = false;
+
+    if (!regex)
+        return true;
+
+    m.rx.setPattern(term);
+    if (!m.rx.isValid())
+        return false;
+
+    m.literal.clear();
+    m.use_regex = true;
+
+    if (term.contains('|'))
+        return true;
+
+    int depth = 0;
+    int i = 0;
+    bool anchored = term.startsWith('^');
+    if (anchored)
+        i++;
+
+    QString run;
+    bool first_run = true;
+
+    while (i <= term.size()){
+        QChar c = i < term.size() ? term[i] : QChar('\0');
+
+        if (i < term.size() && depth == 0 && !is_regex_meta(c)){
+            run += c;
+            i++;
+            continue;
+        }
+
+        //the char before a quantifier is optional
+        if (i < term.size() && is_regex_quantifier(c) && !run.isEmpty())
+            run.chop(1);
+
+        if (first_run && anchored && !run.isEmpty()){
+            m.literal = run;
+            m.is_prefix = true;
+            //nothing left to match
+            if (i == term.size() && run.size() == term.size() - 1)
+                m.use_regex = false;
+        }
+        else if (!m.is_prefix && run.size() > m.literal.size()){
+            m.literal = run;
+        }
+        first_run = false;
+        run.clear();
+
+        if (i == term.size())
+            break;
+
+        if (c == '\\'){
+            i += 2;
+        }
+        else if (c == '['){
+            i++;
+            if (i < term.size() && term[i] == ']')
+                i++;
+            while (i < term.size() && term[i] != ']')
+                i++;
+            i++;
+        }
+        else{
+            if (c == '(')
+                depth++;
+            else if (c == ')' && depth > 0)
+                depth--;
+            i++;
+        }
+    }
+
+    return true;
+}
+
+} // namespace
+
 std::mutex RowData::_global_visitor_mutex;
 
 RowData::RowData() :
@@ -40,6 +159,7 @@ RowData::RowData() :
     _min_annotation(0)
 {
     _item_count = 0;
+    _generation = 0;
 }
 
 RowData::~RowData()
@@ -56,7 +176,9 @@ void RowData::clear()
         delete p;
     }
     _annotations.clear();
+    _res_postings.clear();
     _item_count = 0;
+    _generation++;
     _min_annotation = 0;
 }
 
@@ -99,15 +221,14 @@ void RowData::get_annotation_subset(std::vector<pv::data::decode::Annotation*> &
 uint64_t RowData::get_annotation_index(uint64_t start_sample)
 {
     std::lock_guard<std::mutex> lock(_global_visitor_mutex);
-    uint64_t index = 0;
 
-     for (Annotation *p : _annotations){
-         if (p->start_sample() > start_sample)
-             break;
-         index++;
-     }
+    //the annotations are pushed in time order
+    auto it = std::upper_bound(_annotations.begin(), _annotations.end(), start_sample,
+                    [](uint64_t sample, const Annotation *a){
+                        return sample < a->start_sample();
+                    });
 
-    return index;
+    return it - _annotations.begin();
 }
 
 bool RowData::push_annotation(Annotation *a)
@@ -118,6 +239,12 @@ bool RowData::push_annotation(Annotation *a)
 
     try {
       _annotations.push_back(a);
+      try {
+        _res_postings[a->res_index()].push_back(_annotations.size() - 1);
+      } catch (const std::bad_alloc&) {
+        _annotations.pop_back();
+        throw;
+      }
       _item_count = _annotations.size();
       _max_annotation = max(_max_annotation, a->end_sample() - a->start_sample());
 
@@ -150,6 +277,94 @@ bool RowData::get_annotation(Annotation &ann, uint64_t index)
     }
 }
 
+uint64_t RowData::get_annotation_page(std::vector<Annotation> &dest,
+                                uint64_t start, uint64_t count)
+{
+    std::lock_guard<std::mutex> lock(_global_visitor_mutex);
+
+    dest.clear();
+
+    if (start >= _annotations.size())
+        return 0;
+
+    //copied, clear() on the decode thread deletes the annotations
+    count = min(count, (uint64_t)(_annotations.size() - start));
+    dest.reserve(count);
+    for (uint64_t i = start; i < start + count; i++)
+        dest.push_back(*_annotations[i]);
+    return count;
+}
+
+bool RowData::search_annotation(std::vector<uint64_t> &dest, const QStringList &terms, bool regex)
+{
+    std::lock_guard<std::mutex> lock(_global_visitor_mutex);
+
+    dest.clear();
+
+    if (terms.isEmpty() || _annotations.empty())
+        return true;
+
+    std::vector<TermMatcher> matchers(terms.size());
+    for (int i = 0; i < terms.size(); i++){
+        if (!make_matcher(matchers[i], terms[i], regex))
+            return false;
+    }
+
+    //every annotation matches an empty text
+    if (terms.size() == 1 && !regex && terms[0].isEmpty()){
+        dest.resize(_annotations.size());
+        for (uint64_t i = 0; i < dest.size(); i++)
+            dest[i] = i;
+        return true;
+    }
+
+    //match each distinct text of this row once
+    std::vector<std::unordered_set<int>> hits(terms.size());
+
+    for (auto &it : _res_postings){
+        const std::vector<QString> lines = _annotations[it.second.front()]->annotations();
+        QString text = lines.empty() ? QString() : lines[0];
+
+        for (int i = 0; i < (int)matchers.size(); i++){
+            if (matchers[i].match(text))
+                hits[i].insert(it.first);
+        }
+    }
+
+    for (int res : hits[0]){
+        const std::vector<uint64_t> &postings = _res_postings[res];
+        dest.insert(dest.end(), postings.begin(), postings.end());
+    }
+    std::sort(dest.begin(), dest.end());
+
+    if (terms.size() == 1)
+        return true;
+
+    //the later terms are checked on the following numeric annotations
+    auto wr = dest.begin();
+
+    for (uint64_t first : dest){
+        uint64_t index = first + 1;
+        int i = 1;
+
+        for (; i < (int)hits.size(); i++){
+            while (index < _annotations.size() && !_annotations[index]->is_numberic())
+                index++;
+
+            if (index >= _annotations.size() 
+                || hits[i].find(_annotations[index]->res_index()) == hits[i].end())
+                break;
+            index++;
+        }
+
+        if (i == (int)hits.size())
+            *wr++ = first;
+    }
+    dest.erase(wr, dest.end());
+
+    return true;
+}
+
 } // decode
 } // data
 } // pv
@@ -25,6 +25,8 @@
 
 #include <vector> 
 #include <mutex>
+#include <unordered_map>
+#include <QStringList>
 
 #include "annotation.h"
 
@@ -54,19 +56,41 @@ public:
 
     bool get_annotation(pv::data::decode::Annotation &ann, uint64_t index);
 
+    /**
+     * Copies up to count annotations from index start, returns the count got.
+     */
+    uint64_t get_annotation_page(std::vector<pv::data::decode::Annotation> &dest,
+                                uint64_t start, uint64_t count);
+
+    //changed on clear, the annotations copied before are out of date then
+    inline uint64_t get_generation(){
+        return _generation;
+    }
+
      /**
 	 * Extracts sorted annotations between two period into a vector.
 	 */
 	void get_annotation_subset(std::vector<pv::data::decode::Annotation*> &dest,
 		                        uint64_t start_sample, uint64_t end_sample);
 
+    /**
+     * Finds the annotations whose text contains the first term, each later
+     * term must be contained in the following numeric annotations in order.
+     * With regex the single term is a pattern, its literal part is used to
+     * prefilter the texts. The matched indexes are sorted.
+     */
+    bool search_annotation(std::vector<uint64_t> &dest, const QStringList &terms, bool regex);
+
     void clear();
 
 private:
     uint64_t        _max_annotation;
     uint64_t        _min_annotation;
     uint64_t        _item_count;
+    volatile uint64_t _generation;
 	std::vector<Annotation*> _annotations;
+    //annotation indexes of each text resource, the texts are matched once per search
+    std::unordered_map<int, std::vector<uint64_t>> _res_postings;
     static std::mutex _global_visitor_mutex;
 };
 
@@ -34,7 +34,8 @@ namespace data {
 
 DecoderModel::DecoderModel(QObject *parent)
     : QAbstractTableModel(parent),
-      _decoder_stack(NULL)
+      _decoder_stack(NULL),
+      _pages_version(0)
 {
 }
 
@@ -42,8 +43,40 @@ void DecoderModel::setDecoderStack(DecoderStack *decoder_stack)
 {
     beginResetModel();
     _decoder_stack = decoder_stack;
+    _pages.clear();
     endResetModel();
 }
+
+const decode::Annotation* DecoderModel::get_annotation(int column, uint64_t index) const
+{
+    if (column < 0 || column >= _decoder_stack->list_rows_size())
+        return NULL;
+
+    if (_pages_version != _decoder_stack->list_rows_version()) {
+        _pages.clear();
+        _pages_version = _decoder_stack->list_rows_version();
+    }
+
+    if ((int)_pages.size() <= column)
+        _pages.resize(column + 1, AnnotationPage{0, 0, {}});
+
+    AnnotationPage &page = _pages[column];
+    uint64_t generation = _decoder_stack->list_row_generation(column);
+
+    //the last page may have grown, reload it if the index is out of it
+    if (page.generation != generation || index < page.start 
+        || index >= page.start + page.items.size())
+    {
+        page.start = index - index % PageSize;
+        page.generation = generation;
+        _decoder_stack->list_annotation_page(page.items, column, page.start, PageSize);
+
+        if (index >= page.start + page.items.size())
+            return NULL;
+    }
+
+    return &page.items[index - page.start];
+}
  
 int DecoderModel::rowCount(const QModelIndex & /* parent */) const
 {
@@ -69,9 +102,9 @@ QVariant DecoderModel::data(const QModelIndex &index, int role) const
         return int(Qt::AlignLeft | Qt::AlignVCenter);
     } else if (role == Qt::DisplayRole) {
         if (_decoder_stack) {
-            pv::data::decode::Annotation ann;
-            if (_decoder_stack->list_annotation(ann, index.column(), index.row())) {
-                return ann.annotations().at(0);
+            const decode::Annotation *ann = get_annotation(index.column(), index.row());
+            if (ann != NULL) {
+                return ann->annotations().at(0);
             }
         }
     }
@@ -23,6 +23,7 @@
 #define DSVIEW_PV_DATA_DECODERMODEL_H
 
 #include <QAbstractTableModel>
+#include <vector>
   
 #include "decode/rowdata.h"
 
@@ -39,6 +40,17 @@ class Row;
 
 class DecoderModel : public QAbstractTableModel
 {
+private:
+    static const uint64_t PageSize = 256;
+
+    //a page of annotations of one list column
+    struct AnnotationPage
+    {
+        uint64_t start;
+        uint64_t generation;
+        std::vector<decode::Annotation> items; //copies, the row may be cleared any time
+    };
+
 public:
     DecoderModel(QObject *parent = 0);
 
@@ -53,8 +65,13 @@ public:
         return _decoder_stack;
     }
 
+private:
+    const decode::Annotation* get_annotation(int column, uint64_t index) const;
+
 private:
     DecoderStack   *_decoder_stack;
+    mutable std::vector<AnnotationPage> _pages; //one page per column
+    mutable uint64_t _pages_version; //DecoderStack::list_rows_version of the pages
 };
 
 } // namespace data
@@ -30,6 +30,7 @@
 #include "decode/decoder.h"
 #include "decode/annotation.h"
 #include "decode/rowdata.h"
+#include "decode/binarydata.h"
 #include "../sigsession.h"
 #include "../view/logicsignal.h"
 #include "../dsvdef.h"
@@ -68,6 +69,7 @@ DecoderStack::DecoderStack(pv::SigSession *session,
     _is_capture_end = true;
     _snapshot = NULL;
     _progress = 0;
+    _list_rows_version = 0;
     _is_decoding = false;
     
     _stack.push_back(new decode::Decoder(dec));
@@ -87,6 +89,7 @@ DecoderStack::~DecoderStack()
         delete kv.second;
     }
     _rows.clear();
+    release_binary_outputs();
 
     //Decoder
     for (auto *p : _stack){
@@ -97,6 +100,7 @@ DecoderStack::~DecoderStack()
     _rows_gshow.clear();
     _rows_lshow.clear();
     _class_rows.clear();
+    _list_rows.clear();
 }
  
 void DecoderStack::add_sub_decoder(decode::Decoder *decoder)
@@ -151,6 +155,7 @@ void DecoderStack::build_row()
         delete kv.second;
     }
     _rows.clear();
+    release_binary_outputs();
 
     // Add classes
     for (auto dec : _stack)
@@ -160,6 +165,13 @@ void DecoderStack::build_row()
 
         dec->reset_start();
 
+        // Add the binary output classes
+        int bin_class = 0;
+        for (const GSList *l = decc->binary; l; l = l->next){
+            _binary_outputs[make_pair(decc, bin_class)] = new decode::BinaryData();
+            bin_class++;
+        }
+
         // Add a row for the decoder if it doesn't have a row list
         if (!decc->annotation_rows) {
             const Row row(decc);
@@ -207,6 +219,42 @@ void DecoderStack::build_row()
             order++;
         }
     }
+
+    build_list_rows();
+}
+
+void DecoderStack::release_binary_outputs()
+{
+    for (auto &kv : _binary_outputs){
+        delete kv.second;
+    }
+    _binary_outputs.clear();
+}
+
+void DecoderStack::get_binary_outputs(std::vector<std::pair<QString, decode::BinaryData*>> &dest)
+{
+    dest.clear();
+
+    for (auto &kv : _binary_outputs){
+        const srd_decoder *const decc = kv.first.first;
+        char **bin_class = (char**)g_slist_nth_data(decc->binary, kv.first.second);
+        assert(bin_class);
+
+        QString title = QString(decc->name) + ": " + QString(bin_class[1]);
+        dest.push_back(make_pair(title, kv.second));
+    }
+}
+
+void DecoderStack::build_list_rows()
+{
+    _list_rows.clear();
+    _list_rows_version++;
+
+    for (auto i = _rows.begin(); i != _rows.end(); i++) {
+        auto iter = _rows_lshow.find((*i).first);
+        if (iter != _rows_lshow.end() && (*iter).second)
+            _list_rows.push_back(i);
+    }
 }
 
 int64_t DecoderStack::samples_decoded()
@@ -289,6 +337,7 @@ void DecoderStack::set_rows_lshow(const decode::Row row, bool show)
     std::map<const decode::Row, bool>::const_iterator iter = _rows_lshow.find(row);
     if (iter != _rows_lshow.end()) {
         _rows_lshow[row] = show;
+        build_list_rows();
     }
 }
 
@@ -310,12 +359,9 @@ uint64_t DecoderStack::list_annotation_size()
     std::lock_guard<std::mutex> lock(_output_mutex);
     uint64_t max_annotation_size = 0;
 
-    for (auto it = _rows.begin(); it != _rows.end(); it++) {
-        auto iter = _rows_lshow.find((*it).first);
-        if (iter != _rows_lshow.end() && (*iter).second){
-            max_annotation_size = max(max_annotation_size,
-                (*it).second->get_annotation_size());
-        }
+    for (auto it : _list_rows) {
+        max_annotation_size = max(max_annotation_size,
+            (*it).second->get_annotation_size());
     }
 
     return max_annotation_size;
@@ -323,42 +369,57 @@ uint64_t DecoderStack::list_annotation_size()
 
 uint64_t DecoderStack::list_annotation_size(uint16_t row_index)
 { 
-    for (auto i = _rows.begin(); i != _rows.end(); i++) {
-        auto iter = _rows_lshow.find((*i).first);
-        if (iter != _rows_lshow.end() && (*iter).second)
-            if (row_index-- == 0) {
-                return (*i).second->get_annotation_size();
-            }
-    }
+    if (row_index < _list_rows.size())
+        return (*_list_rows[row_index]).second->get_annotation_size();
     return 0;
 }
 
-bool DecoderStack::list_annotation(pv::data::decode::Annotation &ann,
-                                  uint16_t row_index, uint64_t col_index)
+bool DecoderStack::list_annotation(decode::Annotation &ann, uint16_t row_index, uint64_t col_index)
 { 
-    for (auto i = _rows.begin(); i != _rows.end(); i++) {
-        auto iter = _rows_lshow.find((*i).first);
-        if (iter != _rows_lshow.end() && (*iter).second) {
-            if (row_index-- == 0) {
-                return (*i).second->get_annotation(ann, col_index);
-            }
-        }
-    }
-
+    if (row_index < _list_rows.size())
+        return (*_list_rows[row_index]).second->get_annotation(ann, col_index);
     return false;
 }
 
+uint64_t DecoderStack::list_annotation_page(std::vector<decode::Annotation> &dest,
+                                  uint16_t row_index, uint64_t start, uint64_t count)
+{
+    dest.clear();
+
+    if (row_index < _list_rows.size())
+        return (*_list_rows[row_index]).second->get_annotation_page(dest, start, count);
+    return 0;
+}
+
+uint64_t DecoderStack::list_annotation_index(uint16_t row_index, uint64_t start_sample)
+{
+    if (row_index < _list_rows.size())
+        return (*_list_rows[row_index]).second->get_annotation_index(start_sample);
+    return 0;
+}
+
+uint64_t DecoderStack::list_row_generation(uint16_t row_index)
+{
+    if (row_index < _list_rows.size())
+        return (*_list_rows[row_index]).second->get_generation();
+    return 0;
+}
+
+bool DecoderStack::search_annotation(std::vector<uint64_t> &dest, uint16_t row_index,
+                                  const QStringList &terms, bool regex)
+{
+    dest.clear();
+
+    if (row_index < _list_rows.size())
+        return (*_list_rows[row_index]).second->search_annotation(dest, terms, regex);
+    return false;
+}
 
 bool DecoderStack::list_row_title(int row, QString &title)
 { 
-    for (auto i = _rows.begin();i != _rows.end(); i++) {
-        auto iter = _rows_lshow.find((*i).first);
-        if (iter != _rows_lshow.end() && (*iter).second) {
-            if (row-- == 0) {
-                title = (*i).first.title();
-                return 1;
-            }
-        }
+    if (row >= 0 && row < (int)_list_rows.size()) {
+        title = (*_list_rows[row]).first.title();
+        return 1;
     }
     return 0;
 }
@@ -380,6 +441,10 @@ void DecoderStack::init()
         (*i).second->clear();
     }
 
+    for (auto &kv : _binary_outputs){
+        kv.second->clear();
+    }
+
     set_mark_index(-1);
 }
  
@@ -390,6 +455,26 @@ void DecoderStack::stop_decode_work()
          _stask_stauts->_bStop = true;
      }
     _decode_state = Stopped; 
+
+    // don't leave the task thread waiting for data
+    pv::data::LogicSnapshot *snapshot = _snapshot;
+    if (snapshot != NULL)
+        snapshot->wake_waiters();
+}
+
+void DecoderStack::set_capture_end_flag(bool isEnd)
+{
+    _is_capture_end = isEnd;
+
+    if (!isEnd){
+        _progress = 0;
+        _is_decoding = false;
+    }
+
+    // the task thread may be waiting for more data
+    pv::data::LogicSnapshot *snapshot = _snapshot;
+    if (isEnd && snapshot != NULL)
+        snapshot->wake_waiters();
 }
 
 void DecoderStack::begin_decode_work()
@@ -523,6 +608,7 @@ void DecoderStack::decode_data(const uint64_t decode_start, const uint64_t decod
 
     std::vector<const uint8_t *> chunk;
     std::vector<uint8_t> chunk_const;
+    std::vector<std::vector<uint8_t>> chunk_buf(logic_di->dec_num_channels);
 
     bool bCheckEnd = false;
     uint64_t end_index = decode_end;
@@ -531,17 +617,18 @@ void DecoderStack::decode_data(const uint64_t decode_start, const uint64_t decod
     uint64_t sended_len  = 0;
     _is_decoding = true;
 
-    void* lbp_array[35];
-
-    for (int j =0 ; j < logic_di->dec_num_channels; j++){
-        lbp_array[j] = NULL;
-    }
+    // How far the decoder falls behind a running capture
+    uint64_t max_lag = 0;
   
     while(i < end_index && !_no_memory && !status->_bStop)
     {
         chunk.clear();
         chunk_const.clear();
 
+        // Taken before the sample count is checked, a publish in
+        // between still ends the wait below.
+        const uint64_t generation = _snapshot->get_data_generation();
+
         if (_is_capture_end)
         {
             if (!bCheckEnd){
@@ -558,10 +645,13 @@ void DecoderStack::decode_data(const uint64_t decode_start, const uint64_t decod
         }
         else if (i >= _snapshot->get_ring_sample_count())
         {   
-            // Wait the data is ready.
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            // Wait the capture publishes more samples.
+            _snapshot->wait_data(generation, MaxWaitTime);
             continue;
         }
+        else {
+            max_lag = max(max_lag, _snapshot->get_ring_sample_count() - i);
+        }
 
         if (_is_capture_end && i == _snapshot->get_ring_sample_count()){
             break;
@@ -569,41 +659,51 @@ void DecoderStack::decode_data(const uint64_t decode_start, const uint64_t decod
 
         uint64_t chunk_end = end_index;
 
-        for (int j =0 ; j < logic_di->dec_num_channels; j++) {
-            int sig_index = logic_di->dec_channelmap[j];
-            void *lbp = NULL;
+        // The chunk is copied out under the read guard, the decoder
+        // then runs without holding off the capture thread.
+        {
+            LogicSnapshot::ReadGuard guard(_snapshot);
+            uint64_t ring_count;
+            uint64_t loop_offset;
+            _snapshot->read_published(ring_count, loop_offset);
 
-            if (sig_index == -1) {
-                chunk.push_back(NULL);
-                chunk_const.push_back(0);
-            }
-            else {
-                if (_snapshot->has_data(sig_index)) {
-                    const uint8_t *data_ptr = _snapshot->get_samples(i, chunk_end, sig_index, &lbp);
-                    chunk.push_back(data_ptr);
-                    chunk_const.push_back(_snapshot->get_sample(i, sig_index));
-
-                    if (_snapshot->is_able_free() == false)
-                    {
-                        if (lbp_array[j] != lbp){
-                            if (lbp_array[j] != NULL)
-                                _snapshot->free_decode_lpb(lbp_array[j]);
-                            lbp_array[j] = lbp;
-                        }
-                    }
+            for (int j =0 ; j < logic_di->dec_num_channels; j++) {
+                int sig_index = logic_di->dec_channelmap[j];
+
+                if (sig_index == -1) {
+                    chunk.push_back(NULL);
+                    chunk_const.push_back(0);
                 }
                 else {
-                    _error_message = L_S(STR_PAGE_MSG, S_ID(IDS_MSG_DECODERSTACK_DECODE_DATA_ERROR),
-                                     "At least one of selected channels are not enabled.");
-                    return;
+                    if (_snapshot->has_data(sig_index)) {
+                        const uint8_t *data_ptr = _snapshot->get_samples(i, chunk_end, sig_index,
+                                                                         ring_count, loop_offset);
+                        chunk.push_back(data_ptr);
+                        chunk_const.push_back(_snapshot->get_sample(i, sig_index, loop_offset));
+                    }
+                    else {
+                        _error_message = L_S(STR_PAGE_MSG, S_ID(IDS_MSG_DECODERSTACK_DECODE_DATA_ERROR),
+                                         "At least one of selected channels are not enabled.");
+                        return;
+                    }
                 }
             }
-        }
 
-        if (chunk_end > end_index)
-            chunk_end = end_index;
-        if (chunk_end - i > MaxChunkSize)
-            chunk_end = i + MaxChunkSize;
+            if (chunk_end > end_index)
+                chunk_end = end_index;
+            if (chunk_end - i > MaxChunkSize)
+                chunk_end = i + MaxChunkSize;
+
+            // the pointers start at the byte holding sample i
+            const uint64_t chunk_bytes = ((i & 7) + (chunk_end - i) + 7) / 8;
+
+            for (int j = 0; j < (int)chunk.size(); j++) {
+                if (chunk[j] == NULL)
+                    continue;
+                chunk_buf[j].assign(chunk[j], chunk[j] + chunk_bytes);
+                chunk[j] = chunk_buf[j].data();
+            }
+        }
 
         bEndTime = (chunk_end == end_index);
 
@@ -663,6 +763,11 @@ void DecoderStack::decode_data(const uint64_t decode_start, const uint64_t decod
  
     dsv_info("%s%llu", "send to decoder times: ", (u64_t)entry_cnt);
 
+    if (max_lag > 0 && _samplerate > 0){
+        dsv_info("Live decode max lag: %llu samples, %.3f ms",
+            (u64_t)max_lag, max_lag * 1000.0 / _samplerate);
+    }
+
     if (error != NULL)
         g_free(error);
   
@@ -724,11 +829,18 @@ void DecoderStack::execute_decode_stack()
 	srd_session_metadata_set(session, SRD_CONF_SAMPLERATE,
 		g_variant_new_uint64((uint64_t)_samplerate));
 
-	srd_pd_output_callback_add(
-                    session, 
-                    SRD_OUTPUT_ANN,
-		            DecoderStack::annotation_callback,
-                    _stask_stauts);
+    decode_task_status *status = _stask_stauts;
+
+	srd_pd_ann_batch_callback_add(
+                    session,
+		            DecoderStack::annotation_batch_callback,
+                    status);
+
+    srd_pd_output_callback_add(
+                    session,
+                    SRD_OUTPUT_BINARY,
+                    DecoderStack::binary_callback,
+                    status);
 
     char *error = NULL;
     if (srd_session_start(session, &error) == SRD_OK){
@@ -745,6 +857,7 @@ void DecoderStack::execute_decode_stack()
     }
 
 	srd_session_destroy(session); 
+    status->_res_index.clear();
 }
 
 uint64_t DecoderStack::sample_count()
@@ -760,10 +873,11 @@ uint64_t DecoderStack::sample_rate()
     return _samplerate;
 }
 
-//the decode callback, annotation object will be create
-void DecoderStack::annotation_callback(srd_proto_data *pdata, void *self)
+//the decode callback, annotation objects will be create
+//called once per chunk and decoder instance, not per annotation
+void DecoderStack::annotation_batch_callback(const srd_proto_ann_batch *batch, void *self)
 {
-	assert(pdata);
+	assert(batch);
 	assert(self);
 
     struct decode_task_status *st = (decode_task_status*)self;
@@ -778,48 +892,99 @@ void DecoderStack::annotation_callback(srd_proto_data *pdata, void *self)
         dsv_err("decode task was deleted.");
         assert(false);
     }
-  
-    if (d->_no_memory) {
+
+    std::vector<int> &res_index = st->_res_index[batch->di];
+    const srd_decoder *const decc = batch->di->decoder;
+    assert(decc);
+
+    // Records of one batch mostly share a few classes
+    int last_class = -1;
+    RowData *row_data = NULL;
+
+    for (unsigned int i = 0; i < batch->count; i++) {
+        if (d->_no_memory)
+            return;
+
+        const srd_proto_ann_record *const rec = &batch->records[i];
+
+        if (rec->text_id >= res_index.size())
+            res_index.resize(rec->text_id + 1, -1);
+        if (res_index[rec->text_id] == -1) {
+            res_index[rec->text_id] = Annotation::make_res_index(batch->texts[rec->text_id],
+                                                                 d->_decoder_status);
+            if (res_index[rec->text_id] == -1) {
+                d->_no_memory = true;
+                return;
+            }
+        }
+
+        if (rec->ann_class != last_class) {
+            auto row_iter = d->_rows.end();
+
+            // Try looking up the sub-row of this class
+            const map<pair<const srd_decoder*, int>, Row>::const_iterator r =
+                d->_class_rows.find(make_pair(decc, rec->ann_class));
+            if (r != d->_class_rows.end())
+                row_iter = d->_rows.find((*r).second);
+            else
+            {
+                // Failing that, use the decoder as a key
+                row_iter = d->_rows.find(Row(decc));
+            }
+
+            assert(row_iter != d->_rows.end());
+            if (row_iter == d->_rows.end()) {
+                dsv_err("Unexpected annotation: decoder = 0x%x, format = %d", (void*)decc, rec->ann_class);
+                assert(0);
+                return;
+            }
+
+            last_class = rec->ann_class;
+            row_data = (*row_iter).second;
+        }
+
+        Annotation *a = new Annotation(rec, res_index[rec->text_id], d->_decoder_status);
+        if (a == NULL){
+            d->_no_memory = true;
+            return;
+        }
+
+        // Add the annotation
+        if (!row_data->push_annotation(a))
+            d->_no_memory = true;
+    }
+}
+ 
+//the decode callback, keeps the raw bytes of binary outputs
+void DecoderStack::binary_callback(srd_proto_data *pdata, void *self)
+{
+    assert(pdata);
+    assert(self);
+
+    struct decode_task_status *st = (decode_task_status*)self;
+
+    DecoderStack *const d = st->_decoder;
+    assert(d);
+
+    if (st->_bStop || d->_no_memory){
         return;
     }
 
-    Annotation *a = new Annotation(pdata, d->_decoder_status);
-    if (a == NULL){
-        d->_no_memory = true;
-        return;     
-    }
-
-	// Find the row
-	assert(pdata->pdo);
-	assert(pdata->pdo->di);
-	const srd_decoder *const decc = pdata->pdo->di->decoder;
-	assert(decc);
-
-    auto row_iter = d->_rows.end();
-	
-	// Try looking up the sub-row of this class
-	const map<pair<const srd_decoder*, int>, Row>::const_iterator r =
-        d->_class_rows.find(make_pair(decc, a->format()));
-	if (r != d->_class_rows.end())
-        row_iter = d->_rows.find((*r).second);
-	else
-	{
-		// Failing that, use the decoder as a key
-        row_iter = d->_rows.find(Row(decc));
-	}
+    const srd_proto_data_binary *const pdb = (const srd_proto_data_binary*)pdata->data;
+    assert(pdb);
+
+    const srd_decoder *const decc = pdata->pdo->di->decoder;
+    auto iter = d->_binary_outputs.find(make_pair(decc, pdb->bin_class));
 
-    assert(row_iter != d->_rows.end());
-    if (row_iter == d->_rows.end()) {
-        dsv_err("Unexpected annotation: decoder = 0x%x, format = %d", (void*)decc, a->format());
-        assert(0);
+    if (iter == d->_binary_outputs.end()){
+        dsv_err("Unknown binary class %d of decoder %s", pdb->bin_class, decc->id);
         return;
     }
 
-	// Add the annotation 
-    if (!(*row_iter).second->push_annotation(a))
-        d->_no_memory = true; 
+    if (!(*iter).second->append(pdb->data, pdb->size))
+        d->_no_memory = true;
 }
- 
+
 void DecoderStack::frame_ended()
 { 
     _options_changed = true; 
@@ -827,13 +992,7 @@ void DecoderStack::frame_ended()
 
 int DecoderStack::list_rows_size()
 { 
-    int rows_size = 0;
-    for (auto i = _rows.begin(); i != _rows.end(); i++) {
-        auto iter = _rows_lshow.find((*i).first);
-        if (iter != _rows_lshow.end() && (*iter).second)
-            rows_size++;
-    }
-    return rows_size;
+    return _list_rows.size();
 }
 
 bool DecoderStack::options_changed()
@@ -25,9 +25,12 @@
 
 #include <libsigrokdecode.h>
 #include <list>
+#include <map>
+#include <vector>
 #include <boost/optional.hpp>
 #include <QObject>
 #include <QString>
+#include <QStringList>
 #include <mutex> 
 
 #include "decode/row.h" 
@@ -53,6 +56,7 @@ class LogicSnapshot;
 
 namespace decode {
 class Annotation;
+class BinaryData;
 class Decoder;
 class RowData;
 }
@@ -63,6 +67,8 @@ struct decode_task_status
 {  
     volatile bool _bStop;
     DecoderStack *_decoder;
+    // text id of each decoder instance -> resource index, -1 if not made yet
+    std::map<const srd_decoder_inst*, std::vector<int>> _res_index;
 };
 
  //a torotocol have a DecoderStack, destroy by DecodeTrace
@@ -76,6 +82,8 @@ private:
 	static const int64_t DecodeChunkLength;
 	static const unsigned int DecodeNotifyPeriod;
     static const uint64_t MaxChunkSize = 1024 * 16;
+    // ms, fallback in case a wake up was missed
+    static const int MaxWaitTime = 100;
 
 public:
     enum decode_state {
@@ -127,11 +135,28 @@ public:
     uint64_t list_annotation_size(uint16_t row_index);
 
 
-    bool list_annotation(decode::Annotation &ann,
-                        uint16_t row_index, uint64_t col_index);
+    bool list_annotation(decode::Annotation &ann, uint16_t row_index, uint64_t col_index);
+
+    uint64_t list_annotation_page(std::vector<decode::Annotation> &dest,
+                        uint16_t row_index, uint64_t start, uint64_t count);
+
+    uint64_t list_row_generation(uint16_t row_index);
+
+    //changed when the shown rows are rebuilt
+    inline uint64_t list_rows_version(){
+        return _list_rows_version;
+    }
+
+    uint64_t list_annotation_index(uint16_t row_index, uint64_t start_sample);
+
+    bool search_annotation(std::vector<uint64_t> &dest, uint16_t row_index,
+                        const QStringList &terms, bool regex);
 
 
     bool list_row_title(int row, QString &title);
+
+    //the binary output classes of all decoders and their data
+    void get_binary_outputs(std::vector<std::pair<QString, decode::BinaryData*>> &dest);
 	 
 	void clear();
     void init();
@@ -167,13 +192,7 @@ public:
         return _is_capture_end;
     }
 
-    inline void set_capture_end_flag(bool isEnd){
-        _is_capture_end = isEnd;
-        if (!isEnd){
-            _progress = 0;
-            _is_decoding = false;
-        }
-    }
+    void set_capture_end_flag(bool isEnd);
 
     inline int get_progress(){
         //if (!_is_decoding && _progress == 0)
@@ -184,7 +203,10 @@ public:
 private:
     void decode_data(const uint64_t decode_start, const uint64_t decode_end, srd_session *const session);
 	void execute_decode_stack();
-	static void annotation_callback(srd_proto_data *pdata, void *self);
+    void build_list_rows();
+	static void annotation_batch_callback(const srd_proto_ann_batch *batch, void *self);
+    static void binary_callback(srd_proto_data *pdata, void *self);
+    void release_binary_outputs();
     void do_decode_work();
   
 signals:
@@ -199,6 +221,10 @@ private:
     std::map<const decode::Row, bool>       _rows_gshow;
     std::map<const decode::Row, bool>       _rows_lshow;
     std::map<std::pair<const srd_decoder*, int>, decode::Row> _class_rows;
+    //the rows shown in the list, indexed by the list column
+    std::vector<std::map<const decode::Row, decode::RowData*>::iterator> _list_rows;
+    uint64_t        _list_rows_version;
+    std::map<std::pair<const srd_decoder*, int>, decode::BinaryData*> _binary_outputs;
   
     SigSession      *_session;
     decode_state    _decode_state;
@@ -0,0 +1,301 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2016 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include "dsoaccumulator.h"
+
+#include <algorithm>
+#include <math.h>
+#include <assert.h>
+
+using namespace std;
+
+namespace pv {
+namespace data {
+
+DsoAccumulator::DsoAccumulator()
+{
+    _mode = ACCUM_OFF;
+    _frames = 0;
+    _dropped = 0;
+    _samples = 0;
+    _samplerate = 0;
+    _columns = 0;
+    _pending_samples = 0;
+    _pending_samplerate = 0;
+    _has_pending = false;
+    _stop = false;
+}
+
+DsoAccumulator::~DsoAccumulator()
+{
+    stop();
+}
+
+void DsoAccumulator::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(_pending_mutex);
+        _stop = true;
+    }
+    _pending_cond.notify_one();
+
+    if (_thread.joinable())
+        _thread.join();
+}
+
+void DsoAccumulator::set_mode(int mode)
+{
+    if (_mode == mode)
+        return;
+
+    _mode = mode;
+    reset();
+}
+
+void DsoAccumulator::reset()
+{
+    {
+        std::lock_guard<std::mutex> lock(_pending_mutex);
+        _has_pending = false;
+    }
+
+    std::lock_guard<std::mutex> lock(_data_mutex);
+    _channels.clear();
+    _samples = 0;
+    _frames = 0;
+    _dropped = 0;
+}
+
+void DsoAccumulator::push_frame(const uint8_t *data, uint64_t samples,
+                                const std::vector<uint16_t> &ch_index, uint64_t samplerate)
+{
+    assert(data);
+
+    if (_mode == ACCUM_OFF || samples == 0 || ch_index.empty())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(_pending_mutex);
+
+        if (_has_pending)
+            _dropped++;
+
+        _pending.assign(data, data + samples * ch_index.size());
+        _pending_ch = ch_index;
+        _pending_samples = samples;
+        _pending_samplerate = samplerate;
+        _has_pending = true;
+
+        if (!_thread.joinable())
+            _thread = std::thread(&DsoAccumulator::accumulate_proc, this);
+    }
+    _pending_cond.notify_one();
+}
+
+void DsoAccumulator::accumulate_proc()
+{
+    std::vector<uint8_t> frame;
+    std::vector<uint16_t> ch_index;
+    uint64_t samples;
+    uint64_t samplerate;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(_pending_mutex);
+            _pending_cond.wait(lock, [this]{ return _has_pending || _stop; });
+
+            if (_stop)
+                break;
+
+            frame.swap(_pending);
+            ch_index.swap(_pending_ch);
+            samples = _pending_samples;
+            samplerate = _pending_samplerate;
+            _has_pending = false;
+        }
+
+        accumulate(frame.data(), samples, ch_index, samplerate);
+        accumulated();
+    }
+}
+
+void DsoAccumulator::setup(uint64_t samples, const std::vector<uint16_t> &ch_index, uint64_t samplerate)
+{
+    _samples = samples;
+    _samplerate = samplerate;
+    _columns = (int)min(samples, (uint64_t)MaxColumns);
+    _frames = 0;
+
+    _column_of.resize(samples);
+    for (uint64_t i = 0; i < samples; i++)
+        _column_of[i] = (uint16_t)(i * _columns / samples);
+
+    _chan_buf.resize(samples);
+
+    _channels.resize(ch_index.size());
+    for (size_t c = 0; c < ch_index.size(); c++) {
+        ChannelAccum &ch = _channels[c];
+        ch.index = ch_index[c];
+        ch.sum.assign(samples, 0);
+        ch.min.assign(samples, 0xff);
+        ch.max.assign(samples, 0);
+        ch.hits.assign((uint64_t)_columns * Levels, 0);
+        ch.intensity.assign((uint64_t)_columns * Levels, 0);
+        ch.max_hits = 0;
+    }
+}
+
+void DsoAccumulator::accumulate(const uint8_t *data, uint64_t samples,
+                                const std::vector<uint16_t> &ch_index, uint64_t samplerate)
+{
+    std::lock_guard<std::mutex> lock(_data_mutex);
+
+    bool changed = samples != _samples
+                || samplerate != _samplerate
+                || _frames >= MaxFrames
+                || ch_index.size() != _channels.size();
+
+    for (size_t c = 0; !changed && c < ch_index.size(); c++)
+        changed = _channels[c].index != ch_index[c];
+
+    // frames of another layout don't mix
+    if (changed)
+        setup(samples, ch_index, samplerate);
+
+    const size_t stride = ch_index.size();
+    uint8_t *v = _chan_buf.data();
+
+    for (size_t c = 0; c < stride; c++) {
+        ChannelAccum &ch = _channels[c];
+
+        // Deinterleave first, the loops below run over plain
+        // arrays and are vectorized by the compiler.
+        const uint8_t *src = data + c;
+        for (uint64_t i = 0; i < samples; i++)
+            v[i] = src[i * stride];
+
+        uint32_t *sum = ch.sum.data();
+        uint8_t *mn = ch.min.data();
+        uint8_t *mx = ch.max.data();
+
+        for (uint64_t i = 0; i < samples; i++)
+            sum[i] += v[i];
+        for (uint64_t i = 0; i < samples; i++)
+            mn[i] = min(mn[i], v[i]);
+        for (uint64_t i = 0; i < samples; i++)
+            mx[i] = max(mx[i], v[i]);
+
+        uint32_t *hits = ch.hits.data();
+        const uint16_t *column = _column_of.data();
+        uint32_t max_hits = ch.max_hits;
+
+        for (uint64_t i = 0; i < samples; i++) {
+            uint32_t h = ++hits[v[i] * _columns + column[i]];
+            max_hits = max(max_hits, h);
+        }
+        ch.max_hits = max_hits;
+
+        grade(ch);
+    }
+
+    _frames++;
+}
+
+// Square root grading, single hits stay visible next to hot spots
+void DsoAccumulator::grade(ChannelAccum &ch)
+{
+    if (ch.max_hits == 0)
+        return;
+
+    const uint64_t cells = ch.hits.size();
+    const uint32_t *hits = ch.hits.data();
+    uint8_t *intensity = ch.intensity.data();
+    const float scale = 255.0f / sqrtf((float)ch.max_hits);
+
+    for (uint64_t i = 0; i < cells; i++) {
+        const float level = sqrtf((float)hits[i]) * scale;
+        intensity[i] = hits[i] == 0 ? 0 : (uint8_t)max(level, 1.0f);
+    }
+}
+
+DsoAccumulator::ChannelAccum* DsoAccumulator::find_channel(uint16_t index)
+{
+    for (auto &ch : _channels) {
+        if (ch.index == index)
+            return &ch;
+    }
+    return NULL;
+}
+
+bool DsoAccumulator::get_average(uint16_t index, uint64_t start, uint64_t end, std::vector<float> &out)
+{
+    std::lock_guard<std::mutex> lock(_data_mutex);
+
+    ChannelAccum *ch = find_channel(index);
+    if (ch == NULL || _frames == 0 || start > end || end >= _samples)
+        return false;
+
+    const uint64_t count = end - start + 1;
+    const float inv = 1.0f / _frames;
+    const uint32_t *sum = ch->sum.data() + start;
+
+    out.resize(count);
+    float *dest = out.data();
+
+    for (uint64_t i = 0; i < count; i++)
+        dest[i] = sum[i] * inv;
+
+    return true;
+}
+
+bool DsoAccumulator::get_envelope(uint16_t index, uint64_t start, uint64_t end,
+                                  std::vector<uint8_t> &lo, std::vector<uint8_t> &hi)
+{
+    std::lock_guard<std::mutex> lock(_data_mutex);
+
+    ChannelAccum *ch = find_channel(index);
+    if (ch == NULL || _frames == 0 || start > end || end >= _samples)
+        return false;
+
+    lo.assign(ch->min.begin() + start, ch->min.begin() + end + 1);
+    hi.assign(ch->max.begin() + start, ch->max.begin() + end + 1);
+
+    return true;
+}
+
+bool DsoAccumulator::get_persistence(uint16_t index, std::vector<uint8_t> &cells,
+                                     int &columns, uint64_t &samples)
+{
+    std::lock_guard<std::mutex> lock(_data_mutex);
+
+    ChannelAccum *ch = find_channel(index);
+    if (ch == NULL || _frames == 0)
+        return false;
+
+    cells = ch->intensity;
+    columns = _columns;
+    samples = _samples;
+
+    return true;
+}
+
+} // namespace data
+} // namespace pv
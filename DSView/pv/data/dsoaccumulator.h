@@ -0,0 +1,147 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2016 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+
+#ifndef DSVIEW_PV_DATA_DSOACCUMULATOR_H
+#define DSVIEW_PV_DATA_DSOACCUMULATOR_H
+
+#include <stdint.h>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+
+#include <QObject>
+
+namespace pv {
+namespace data {
+
+// Accumulates consecutive dso frames into a running average, a min/max
+// envelope and a hit count persistence map. Frames are handed over by
+// the capture thread and folded in on a worker thread, the views only
+// read the results.
+class DsoAccumulator : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum AccumulateMode {
+        ACCUM_OFF = 0,
+        ACCUM_AVERAGE,
+        ACCUM_ENVELOPE,
+        ACCUM_PERSIST,
+    };
+
+    // persistence map size, one row per adc code
+    static const int Levels = 256;
+    static const int MaxColumns = 4096;
+    // restart before the sums can overflow
+    static const uint64_t MaxFrames = 1 << 24;
+
+private:
+    struct ChannelAccum
+    {
+        uint16_t index;
+        std::vector<uint32_t> sum;
+        std::vector<uint8_t> min;
+        std::vector<uint8_t> max;
+        // Levels rows of _columns cells
+        std::vector<uint32_t> hits;
+        std::vector<uint8_t> intensity;
+        uint32_t max_hits;
+    };
+
+public:
+    DsoAccumulator();
+    ~DsoAccumulator();
+
+    void set_mode(int mode);
+
+    inline int get_mode(){
+        return _mode;
+    }
+
+    void reset();
+
+    // Copies one interleaved frame, called from the capture thread.
+    // A frame still waiting when the next one comes is dropped.
+    void push_frame(const uint8_t *data, uint64_t samples,
+                    const std::vector<uint16_t> &ch_index, uint64_t samplerate);
+
+    inline uint64_t get_frames(){
+        return _frames;
+    }
+
+    inline uint64_t get_dropped(){
+        return _dropped;
+    }
+
+    bool get_average(uint16_t index, uint64_t start, uint64_t end, std::vector<float> &out);
+    bool get_envelope(uint16_t index, uint64_t start, uint64_t end,
+                      std::vector<uint8_t> &lo, std::vector<uint8_t> &hi);
+    // Intensity graded persistence map, Levels rows of columns cells
+    // covering samples samples.
+    bool get_persistence(uint16_t index, std::vector<uint8_t> &cells,
+                         int &columns, uint64_t &samples);
+
+signals:
+    void accumulated();
+
+private:
+    void accumulate_proc();
+    void accumulate(const uint8_t *data, uint64_t samples,
+                    const std::vector<uint16_t> &ch_index, uint64_t samplerate);
+    void setup(uint64_t samples, const std::vector<uint16_t> &ch_index, uint64_t samplerate);
+    void grade(ChannelAccum &ch);
+    ChannelAccum* find_channel(uint16_t index);
+    void stop();
+
+private:
+    std::atomic<int> _mode;
+    std::atomic<uint64_t> _frames;
+    std::atomic<uint64_t> _dropped;
+
+    // results, guarded by _data_mutex
+    std::mutex _data_mutex;
+    std::vector<ChannelAccum> _channels;
+    std::vector<uint16_t> _column_of;
+    std::vector<uint8_t> _chan_buf;
+    uint64_t _samples;
+    uint64_t _samplerate;
+    int _columns;
+
+    // the frame handed over to the worker
+    std::mutex _pending_mutex;
+    std::condition_variable _pending_cond;
+    std::vector<uint8_t> _pending;
+    std::vector<uint16_t> _pending_ch;
+    uint64_t _pending_samples;
+    uint64_t _pending_samplerate;
+    bool _has_pending;
+    bool _stop;
+    std::thread _thread;
+};
+
+} // namespace data
+} // namespace pv
+
+#endif // DSVIEW_PV_DATA_DSOACCUMULATOR_H
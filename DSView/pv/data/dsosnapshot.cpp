@@ -88,6 +88,7 @@ void DsoSnapshot::init_all()
     _last_ended = true;
     _envelope_done = false;   
     _is_file = false; 
+    publish();
 
     for (unsigned int i = 0; i < _channel_num; i++) {
         for (unsigned int level = 0; level < ScaleStepCount; level++) {
@@ -226,6 +227,8 @@ void DsoSnapshot::append_payload(const sr_datafeed_dso &dso)
         // Generate the first mip-map from the data
         if (_envelope_en)
             append_payload_to_envelope_levels(dso.samplerate_tog);
+
+        publish();
     }
 }
 
@@ -289,6 +292,28 @@ const uint8_t *DsoSnapshot::get_samples(int64_t start_sample, int64_t end_sample
     return (uint8_t*)_ch_data[order] + start_sample;
 }
 
+bool DsoSnapshot::copy_samples(uint64_t generation, uint16_t ch_index, uint64_t start_sample,
+                               uint64_t count, int step, uint8_t *dest)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (_data_generation != generation || count == 0)
+        return false;
+    if (start_sample + (count - 1) * step >= _sample_count)
+        return false;
+
+    int order = get_ch_order(ch_index);
+    if (order == -1)
+        return false;
+
+    const uint8_t *src = (uint8_t*)_ch_data[order] + start_sample;
+    for (uint64_t i = 0; i < count; i++) {
+        *dest++ = *src;
+        src += step;
+    }
+    return true;
+}
+
 void DsoSnapshot::get_envelope_section(EnvelopeSection &s,
     uint64_t start, uint64_t end, float min_length, int probe_index)
 {
@@ -91,6 +91,11 @@ public:
     void append_payload(const sr_datafeed_dso &dso);
     const uint8_t* get_samples(int64_t start_sample, int64_t end_sample, uint16_t ch_index);
 
+    // Copies count samples of a channel, step apart, under the lock.
+    // Returns false if the data is no longer the given generation.
+    bool copy_samples(uint64_t generation, uint16_t ch_index, uint64_t start_sample,
+                      uint64_t count, int step, uint8_t *dest);
+
 	void get_envelope_section(EnvelopeSection &s,
         uint64_t start, uint64_t end, float min_length, int probe_index);
 
@@ -0,0 +1,576 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2016 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+
+#include "eyestack.h"
+
+#include <algorithm>
+#include <math.h>
+#include <assert.h>
+
+using namespace std;
+
+namespace pv {
+namespace data {
+
+// Loop gains of the software clock recovery, applied per data edge.
+// The fixed clock only follows the phase.
+static const double RecoveredPhaseGain = 1.0 / 64;
+static const double RecoveredRateGain = RecoveredPhaseGain * RecoveredPhaseGain / 4;
+static const double FixedPhaseGain = 1.0 / 1024;
+
+void EyeStack::EdgeDetector::init(const uint8_t *data, uint64_t samples)
+{
+    uint8_t lo = 0xff;
+    uint8_t hi = 0;
+
+    for (uint64_t i = 0; i < samples; i++) {
+        lo = min(lo, data[i]);
+        hi = max(hi, data[i]);
+    }
+
+    threshold = samples == 0 ? 0x80 : (lo + hi + 1) / 2;
+    hyst = max(2, (hi - lo) / 10);
+    level = -1;
+    cross = 0;
+    scan = 1;
+}
+
+void EyeStack::EdgeDetector::detect(const uint8_t *data, uint64_t end,
+                                    std::vector<double> &edges, bool rising_only)
+{
+    for (uint64_t i = scan; i < end; i++) {
+        const int v0 = data[i - 1];
+        const int v1 = data[i];
+
+        // the latest pass through the threshold, between two samples
+        if ((v0 < threshold) != (v1 < threshold))
+            cross = (i - 1) + (double)(threshold - v0) / (v1 - v0);
+
+        if (v1 >= threshold + hyst && level != 1) {
+            if (level == 0)
+                edges.push_back(cross);
+            level = 1;
+        }
+        else if (v1 <= threshold - hyst && level != 0) {
+            if (level == 1 && !rising_only)
+                edges.push_back(cross);
+            level = 0;
+        }
+    }
+
+    scan = max(scan, end);
+}
+
+EyeStack::EyeStack(int data_index, int clock_index, int clock_mode, double bitrate,
+                   double mask_width, double mask_height) :
+    _data_index(data_index),
+    _clock_index(clock_index),
+    _clock_mode(clock_mode),
+    _bitrate(bitrate),
+    _mask_width(mask_width),
+    _mask_height(mask_height)
+{
+    _dropped = 0;
+    _stop = false;
+    _samplerate = 0;
+    _phase = 0;
+    _ui = 0;
+    _locked = false;
+    _next_chunk = 0;
+
+    _hits.assign((uint64_t)Columns * Levels, 0);
+    _intensity.assign((uint64_t)Columns * Levels, 0);
+    _stats.valid = false;
+    _bits = 0;
+    _threshold = 0x80;
+    _result_samplerate = 0;
+
+    _pending_samplerate = 0;
+    _pending_new_frame = false;
+    _has_pending = false;
+    _exit = false;
+}
+
+EyeStack::~EyeStack()
+{
+    stop();
+}
+
+void EyeStack::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(_pending_mutex);
+        _exit = true;
+        _stop = true;
+    }
+    _pending_cond.notify_one();
+
+    if (_thread.joinable())
+        _thread.join();
+}
+
+void EyeStack::reset()
+{
+    {
+        std::lock_guard<std::mutex> lock(_pending_mutex);
+        _has_pending = false;
+    }
+
+    std::lock_guard<std::mutex> lock(_data_mutex);
+    std::fill(_hits.begin(), _hits.end(), 0);
+    std::fill(_intensity.begin(), _intensity.end(), 0);
+    _stats.valid = false;
+    _bits = 0;
+    _dropped = 0;
+}
+
+void EyeStack::push_samples(const uint8_t *data, const uint8_t *clock, uint64_t samples,
+                            uint64_t samplerate, bool new_frame)
+{
+    assert(data);
+
+    if (samples == 0)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(_pending_mutex);
+
+        if (new_frame || !_has_pending) {
+            if (_has_pending && new_frame)
+                _dropped++;
+
+            _pending_data.assign(data, data + samples);
+            _pending_clock.clear();
+            if (clock)
+                _pending_clock.assign(clock, clock + samples);
+            _pending_new_frame = new_frame;
+        }
+        else {
+            // packets of one frame can't be skipped
+            _pending_data.insert(_pending_data.end(), data, data + samples);
+            if (clock)
+                _pending_clock.insert(_pending_clock.end(), clock, clock + samples);
+        }
+
+        _pending_samplerate = samplerate;
+        _has_pending = true;
+
+        if (!_thread.joinable())
+            _thread = std::thread(&EyeStack::eye_proc, this);
+    }
+    _pending_cond.notify_one();
+}
+
+void EyeStack::eye_proc()
+{
+    std::vector<uint8_t> data;
+    std::vector<uint8_t> clock;
+    uint64_t samplerate;
+    bool new_frame;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(_pending_mutex);
+            _pending_cond.wait(lock, [this]{ return _has_pending || _exit; });
+
+            if (_exit)
+                break;
+
+            data.swap(_pending_data);
+            clock.swap(_pending_clock);
+            samplerate = _pending_samplerate;
+            new_frame = _pending_new_frame;
+            _has_pending = false;
+            _pending_data.clear();
+            _pending_clock.clear();
+        }
+
+        append(data, clock, samplerate, new_frame);
+    }
+}
+
+void EyeStack::append(const std::vector<uint8_t> &data, const std::vector<uint8_t> &clock,
+                      uint64_t samplerate, bool new_frame)
+{
+    const bool use_clock = (_clock_mode == CLOCK_CHANNEL);
+
+    if (use_clock && clock.size() != data.size())
+        return;
+
+    if (new_frame || _data_buf.empty()) {
+        _data_buf = data;
+        _clock_buf = clock;
+        _samplerate = samplerate;
+        _edges.clear();
+        _bounds.clear();
+        _locked = false;
+
+        // the thresholds come from the first packet of a frame
+        _data_edge.init(_data_buf.data(), _data_buf.size());
+        if (use_clock)
+            _clock_edge.init(_clock_buf.data(), _clock_buf.size());
+
+        std::lock_guard<std::mutex> lock(_data_mutex);
+        _threshold = _data_edge.threshold;
+        _result_samplerate = samplerate;
+    }
+    else {
+        _data_buf.insert(_data_buf.end(), data.begin(), data.end());
+        _clock_buf.insert(_clock_buf.end(), clock.begin(), clock.end());
+    }
+
+    const uint64_t samples = _data_buf.size();
+    std::vector<double> edges;
+
+    if (use_clock) {
+        // every rising clock edge starts a bit
+        _clock_edge.detect(_clock_buf.data(), samples, edges, true);
+        _bounds.insert(_bounds.end(), edges.begin(), edges.end());
+        if (_bounds.size() > 1)
+            _ui = (_bounds.back() - _bounds.front()) / (_bounds.size() - 1);
+    }
+    else {
+        _data_edge.detect(_data_buf.data(), samples, edges, false);
+        if (!recover_clock(edges))
+            return;
+    }
+
+    // a bit is folded once its two unit interval window is complete
+    uint64_t ready = 0;
+    while (ready + 1 < _bounds.size()) {
+        const double ui = _bounds[ready + 1] - _bounds[ready];
+        if (_bounds[ready] + 1.5 * ui + 2 >= samples)
+            break;
+        ready++;
+    }
+
+    for (uint64_t done = 0; done < ready && !_stop; ) {
+        const uint64_t bits = min(ready - done, (uint64_t)BatchBits);
+        fold_bits(_bounds.data() + done, bits);
+        done += bits;
+        eye_updated();
+    }
+
+    _bounds.erase(_bounds.begin(), _bounds.begin() + ready);
+}
+
+bool EyeStack::recover_clock(std::vector<double> &edges)
+{
+    if (!_locked) {
+        _edges.insert(_edges.end(), edges.begin(), edges.end());
+
+        if (_clock_mode == CLOCK_FIXED || _bitrate > 0) {
+            if (_edges.empty() || _bitrate <= 0 || _samplerate == 0)
+                return false;
+            _ui = _samplerate / _bitrate;
+        }
+        else {
+            if (_edges.size() < (size_t)MinEdges)
+                return false;
+
+            // The shortest intervals are single bits, take a low
+            // percentile as the first guess and refine it over all
+            // the intervals up to 16 bits long.
+            std::vector<double> intervals;
+            for (size_t i = 1; i < _edges.size(); i++)
+                intervals.push_back(_edges[i] - _edges[i - 1]);
+
+            std::vector<double> sorted(intervals);
+            std::sort(sorted.begin(), sorted.end());
+            double ui = sorted[sorted.size() / 10];
+
+            for (int pass = 0; pass < 2 && ui > 0; pass++) {
+                double span = 0;
+                double bits = 0;
+                for (double d : intervals) {
+                    const double n = floor(d / ui + 0.5);
+                    if (n >= 1 && n <= 16) {
+                        span += d;
+                        bits += n;
+                    }
+                }
+                ui = bits > 0 ? span / bits : 0;
+            }
+            _ui = ui;
+        }
+
+        // less than two samples per bit can't be folded
+        if (_ui < 2) {
+            _edges.clear();
+            return false;
+        }
+
+        _phase = _edges[0];
+        _bounds.push_back(_phase);
+        _locked = true;
+
+        edges.assign(_edges.begin() + 1, _edges.end());
+        _edges.clear();
+    }
+
+    const bool track_rate = (_clock_mode == CLOCK_RECOVERED);
+    const double phase_gain = track_rate ? RecoveredPhaseGain : FixedPhaseGain;
+
+    for (double t : edges) {
+        const double n = floor((t - _phase) / _ui + 0.5);
+
+        // a glitch next to the last edge
+        if (n < 1)
+            continue;
+
+        // too long without edges, start over at this one
+        if (n > MaxRunBits) {
+            _phase = t;
+            _bounds.push_back(t);
+            continue;
+        }
+
+        for (int m = 1; m < n; m++)
+            _bounds.push_back(_phase + m * _ui);
+
+        const double expect = _phase + n * _ui;
+        const double err = t - expect;
+
+        _phase = expect + phase_gain * err;
+        if (track_rate)
+            _ui += RecoveredRateGain * err;
+        _bounds.push_back(_phase);
+    }
+
+    return true;
+}
+
+void EyeStack::fold_bits(const double *bounds, uint64_t bits)
+{
+    const uint64_t chunks = (bits + ChunkBits - 1) / ChunkBits;
+    const uint64_t cores = max(std::thread::hardware_concurrency(), 1u);
+    const uint64_t workers = min(min(cores, (uint64_t)8), chunks);
+
+    _thread_hits.resize(workers);
+    for (auto &hits : _thread_hits)
+        hits.assign((uint64_t)Columns * Levels, 0);
+
+    _next_chunk = 0;
+
+    std::vector<std::thread> threads;
+    for (uint64_t i = 1; i < workers; i++)
+        threads.push_back(std::thread(&EyeStack::fold_proc, this, bounds, bits, &_thread_hits[i]));
+
+    fold_proc(bounds, bits, &_thread_hits[0]);
+
+    for (auto &t : threads)
+        t.join();
+
+    std::lock_guard<std::mutex> lock(_data_mutex);
+
+    if (_bits + bits > MaxBits) {
+        std::fill(_hits.begin(), _hits.end(), 0);
+        _bits = 0;
+    }
+
+    const uint64_t cells = _hits.size();
+    uint32_t *hits = _hits.data();
+
+    for (auto &part : _thread_hits) {
+        const uint32_t *src = part.data();
+        for (uint64_t i = 0; i < cells; i++)
+            hits[i] += src[i];
+    }
+
+    _bits += bits;
+    grade();
+    calc_stats();
+}
+
+// Every sample pair inside the window of a bit is drawn as a line,
+// one hit per histogram column.
+void EyeStack::fold_proc(const double *bounds, uint64_t bits, std::vector<uint32_t> *hits)
+{
+    const uint8_t *data = _data_buf.data();
+    const int64_t last = (int64_t)_data_buf.size() - 1;
+    uint32_t *cells = hits->data();
+
+    while (!_stop) {
+        const uint64_t first = _next_chunk++ * ChunkBits;
+        if (first >= bits)
+            break;
+
+        const uint64_t end = min(first + ChunkBits, bits);
+
+        for (uint64_t k = first; k < end; k++) {
+            const double b = bounds[k];
+            const double ui = bounds[k + 1] - b;
+            const double scale = ColumnsPerUI / ui;
+
+            const int64_t s0 = max((int64_t)floor(b - 0.5 * ui), (int64_t)0);
+            const int64_t s1 = min((int64_t)ceil(b + 1.5 * ui), last);
+
+            for (int64_t s = s0; s < s1; s++) {
+                const double c0 = (s - b) * scale + ColumnsPerUI / 2;
+                const int cs = max((int)ceil(c0), 0);
+                const int ce = min((int)ceil(c0 + scale), (int)Columns);
+                const float v0 = data[s];
+                const float slope = (data[s + 1] - v0) / (float)scale;
+
+                for (int c = cs; c < ce; c++) {
+                    const int row = (int)(v0 + slope * (float)(c - c0) + 0.5f);
+                    cells[row * Columns + c]++;
+                }
+            }
+        }
+    }
+}
+
+// Square root grading, single hits stay visible next to hot spots
+void EyeStack::grade()
+{
+    const uint64_t cells = _hits.size();
+    const uint32_t *hits = _hits.data();
+    uint8_t *intensity = _intensity.data();
+    uint32_t max_hits = 0;
+
+    for (uint64_t i = 0; i < cells; i++)
+        max_hits = max(max_hits, hits[i]);
+
+    if (max_hits == 0)
+        return;
+
+    const float scale = 255.0f / sqrtf((float)max_hits);
+
+    for (uint64_t i = 0; i < cells; i++) {
+        const float level = sqrtf((float)hits[i]) * scale;
+        intensity[i] = hits[i] == 0 ? 0 : (uint8_t)max(level, 1.0f);
+    }
+}
+
+// Levels from the eye center, jitter from the threshold crossings and
+// the hits inside a hexagon mask centered in the eye.
+void EyeStack::calc_stats()
+{
+    EyeStats &st = _stats;
+    const uint32_t *hits = _hits.data();
+
+    st.valid = false;
+    st.bits = _bits;
+    st.ui = _ui;
+    st.mask_hits = 0;
+
+    double w[2] = {0, 0};
+    double sum[2] = {0, 0};
+    double sqr[2] = {0, 0};
+
+    const int center = Columns / 2;
+    const int half = ColumnsPerUI / 16;
+
+    for (int row = 0; row < Levels; row++) {
+        if (row == _threshold)
+            continue;
+        const int i = row > _threshold ? 1 : 0;
+        for (int c = center - half; c <= center + half; c++) {
+            const double h = hits[row * Columns + c];
+            w[i] += h;
+            sum[i] += h * row;
+            sqr[i] += h * row * row;
+        }
+    }
+
+    if (w[0] == 0 || w[1] == 0)
+        return;
+
+    st.level0 = sum[0] / w[0];
+    st.level1 = sum[1] / w[1];
+    st.sigma0 = sqrt(max(sqr[0] / w[0] - st.level0 * st.level0, 0.0));
+    st.sigma1 = sqrt(max(sqr[1] / w[1] - st.level1 * st.level1, 0.0));
+    st.height = max((st.level1 - 3 * st.sigma1) - (st.level0 + 3 * st.sigma0), 0.0);
+
+    const double amplitude = st.level1 - st.level0;
+    const double mid = (st.level0 + st.level1) / 2;
+    const int band = max(1, (int)(amplitude / 20));
+    const int row0 = max((int)floor(mid) - band, 0);
+    const int row1 = min((int)ceil(mid) + band, Levels - 1);
+
+    double mean[2];
+    double sigma[2];
+    double spread[2];
+
+    for (int i = 0; i < 2; i++) {
+        double cw = 0, csum = 0, csqr = 0;
+        int lo = Columns, hi = -1;
+
+        for (int c = i * center; c < (i + 1) * center; c++) {
+            double h = 0;
+            for (int row = row0; row <= row1; row++)
+                h += hits[row * Columns + c];
+            if (h == 0)
+                continue;
+            cw += h;
+            csum += h * c;
+            csqr += h * c * c;
+            lo = min(lo, c);
+            hi = max(hi, c);
+        }
+
+        if (cw == 0)
+            return;
+
+        mean[i] = csum / cw;
+        sigma[i] = sqrt(max(csqr / cw - mean[i] * mean[i], 0.0));
+        spread[i] = hi - lo;
+    }
+
+    st.jitter_rms = (sigma[0] + sigma[1]) / 2 / ColumnsPerUI;
+    st.jitter_pp = max(spread[0], spread[1]) / ColumnsPerUI;
+    st.width = max((mean[1] - 3 * sigma[1]) - (mean[0] + 3 * sigma[0]), 0.0) / ColumnsPerUI;
+
+    // full width across the middle, half width at the top and bottom
+    const double hw = _mask_width * ColumnsPerUI / 2;
+    const double hh = _mask_height * amplitude / 2;
+
+    if (hw > 0 && hh > 0) {
+        for (int row = max((int)ceil(mid - hh), 0); row <= min((int)floor(mid + hh), Levels - 1); row++) {
+            const double span = hw * (1 - 0.5 * fabs(row - mid) / hh);
+            const int c0 = max((int)ceil(center - span), 0);
+            const int c1 = min((int)floor(center + span), Columns - 1);
+            for (int c = c0; c <= c1; c++)
+                st.mask_hits += hits[row * Columns + c];
+        }
+    }
+
+    st.valid = true;
+}
+
+bool EyeStack::get_eye(std::vector<uint8_t> &cells, EyeStats &stats, uint64_t &samplerate)
+{
+    std::lock_guard<std::mutex> lock(_data_mutex);
+
+    if (_bits == 0)
+        return false;
+
+    cells = _intensity;
+    stats = _stats;
+    samplerate = _result_samplerate;
+
+    return true;
+}
+
+} // namespace data
+} // namespace pv
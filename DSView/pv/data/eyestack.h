@@ -0,0 +1,206 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2016 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+
+
+#ifndef DSVIEW_PV_DATA_EYESTACK_H
+#define DSVIEW_PV_DATA_EYESTACK_H
+
+#include <stdint.h>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+
+#include <QObject>
+
+namespace pv {
+namespace data {
+
+// Folds a dso channel modulo the unit interval of a serial link into a
+// 2-D hit count histogram (eye diagram). The bit clock is recovered from
+// the data edges, taken from a second channel or given by the user.
+// Samples are handed over by the capture thread, clock recovery runs on
+// a worker thread and the bits are folded in by a pool of threads.
+class EyeStack : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum ClockMode {
+        CLOCK_RECOVERED = 0,
+        CLOCK_FIXED,
+        CLOCK_CHANNEL,
+    };
+
+    // two unit intervals across, one row per adc code
+    static const int Columns = 256;
+    static const int ColumnsPerUI = Columns / 2;
+    static const int Levels = 256;
+    // restart before the hit counts can overflow
+    static const uint64_t MaxBits = 1ULL << 31;
+
+    struct EyeStats
+    {
+        bool valid;
+        uint64_t bits;
+        double ui;          // samples
+        double level0;      // adc codes
+        double level1;
+        double sigma0;
+        double sigma1;
+        double height;      // adc codes
+        double width;       // unit intervals
+        double jitter_rms;  // unit intervals
+        double jitter_pp;   // unit intervals
+        uint64_t mask_hits;
+    };
+
+private:
+    // threshold crossings with hysteresis, carried across packets
+    struct EdgeDetector
+    {
+        int threshold;
+        int hyst;
+        int level;
+        double cross;
+        uint64_t scan;
+
+        void init(const uint8_t *data, uint64_t samples);
+        void detect(const uint8_t *data, uint64_t end,
+                    std::vector<double> &edges, bool rising_only);
+    };
+
+    static const int MinEdges = 32;
+    // longest run of equal bits the recovered clock bridges
+    static const int MaxRunBits = 64;
+    static const uint64_t ChunkBits = 2048;
+    static const uint64_t BatchBits = 256 * 1024;
+
+public:
+    EyeStack(int data_index, int clock_index, int clock_mode, double bitrate,
+             double mask_width, double mask_height);
+    ~EyeStack();
+
+    inline int data_index(){
+        return _data_index;
+    }
+
+    inline int clock_index(){
+        return _clock_index;
+    }
+
+    inline int clock_mode(){
+        return _clock_mode;
+    }
+
+    inline double bitrate(){
+        return _bitrate;
+    }
+
+    inline double mask_width(){
+        return _mask_width;
+    }
+
+    inline double mask_height(){
+        return _mask_height;
+    }
+
+    void reset();
+
+    // Copies samples of the data and clock channels, called from the
+    // capture thread. A new frame replaces a frame that is still waiting,
+    // following packets of the same frame are appended to it.
+    void push_samples(const uint8_t *data, const uint8_t *clock, uint64_t samples,
+                      uint64_t samplerate, bool new_frame);
+
+    inline uint64_t get_dropped(){
+        return _dropped;
+    }
+
+    // Intensity graded histogram, Levels rows of Columns cells
+    bool get_eye(std::vector<uint8_t> &cells, EyeStats &stats, uint64_t &samplerate);
+
+signals:
+    void eye_updated();
+
+private:
+    void eye_proc();
+    void append(const std::vector<uint8_t> &data, const std::vector<uint8_t> &clock,
+                uint64_t samplerate, bool new_frame);
+    bool recover_clock(std::vector<double> &edges);
+    void fold_bits(const double *bounds, uint64_t bits);
+    void fold_proc(const double *bounds, uint64_t bits, std::vector<uint32_t> *hits);
+    void calc_stats();
+    void grade();
+    void stop();
+
+private:
+    const int _data_index;
+    const int _clock_index;
+    const int _clock_mode;
+    const double _bitrate;
+    const double _mask_width;
+    const double _mask_height;
+
+    std::atomic<uint64_t> _dropped;
+    std::atomic<bool> _stop;
+
+    // current frame and clock recovery state, worker thread only
+    std::vector<uint8_t> _data_buf;
+    std::vector<uint8_t> _clock_buf;
+    uint64_t _samplerate;
+    EdgeDetector _data_edge;
+    EdgeDetector _clock_edge;
+    std::vector<double> _edges;
+    std::vector<double> _bounds;
+    double _phase;
+    double _ui;
+    bool _locked;
+    std::atomic<uint64_t> _next_chunk;
+    std::vector<std::vector<uint32_t>> _thread_hits;
+
+    // results, guarded by _data_mutex
+    std::mutex _data_mutex;
+    std::vector<uint32_t> _hits;
+    std::vector<uint8_t> _intensity;
+    EyeStats _stats;
+    uint64_t _bits;
+    int _threshold;
+    uint64_t _result_samplerate;
+
+    // the samples handed over to the worker
+    std::mutex _pending_mutex;
+    std::condition_variable _pending_cond;
+    std::vector<uint8_t> _pending_data;
+    std::vector<uint8_t> _pending_clock;
+    uint64_t _pending_samplerate;
+    bool _pending_new_frame;
+    bool _has_pending;
+    bool _exit;
+    std::thread _thread;
+};
+
+} // namespace data
+} // namespace pv
+
+#endif // DSVIEW_PV_DATA_EYESTACK_H
@@ -24,6 +24,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <math.h>
+#include <algorithm>
  
 #include "logicsnapshot.h"
 #include "../dsvdef.h"
@@ -55,7 +56,6 @@ LogicSnapshot::LogicSnapshot() :
     _total_sample_count = 0;
     _is_loop = false;
     _loop_offset = 0;
-    _able_free = true;
 }
 
 LogicSnapshot::~LogicSnapshot()
@@ -78,11 +78,6 @@ void LogicSnapshot::free_data()
     }
     _ch_data.clear();
     _sample_count = 0;
-
-    for(void *p : _free_block_list){
-        free(p);
-    }
-    _free_block_list.clear();
 }
 
 void LogicSnapshot::init()
@@ -101,28 +96,26 @@ void LogicSnapshot::init_all()
     _memory_failed = false;
     _last_ended = true;
     _loop_offset = 0;
-    _able_free = true;
+    publish();
 }
 
 void LogicSnapshot::clear()
 {
     std::lock_guard<std::mutex> lock(_mutex);
+    ExclusiveGuard ex(this);
     free_data();
     init_all();
 }
 
-void LogicSnapshot::first_payload(const sr_datafeed_logic &logic, uint64_t total_sample_count, GSList *channels, bool able_free)
+void LogicSnapshot::first_payload(const sr_datafeed_logic &logic, uint64_t total_sample_count, GSList *channels)
 {
+    // Buffers are reset or reallocated below
+    ExclusiveGuard ex(this);
+
     bool channel_changed = false;
     uint16_t channel_num = 0;
-    _able_free = able_free;
     _lst_free_block_index = 0;
 
-    for(void *p : _free_block_list){
-        free(p);
-    }
-    _free_block_list.clear();
-
     for (const GSList *l = channels; l; l = l->next) {
         sr_channel *const probe = (sr_channel*)l->data;
         if (probe->type == SR_CHANNEL_LOGIC && probe->enabled) {
@@ -192,8 +185,6 @@ void LogicSnapshot::first_payload(const sr_datafeed_logic &logic, uint64_t total
     for (unsigned int i = 0; i < _channel_num; i++) {
         _last_sample[i] = 0;
         _last_calc_count[i] = 0;
-        _cur_ref_block_indexs[i].root_index = 0;
-        _cur_ref_block_indexs[i].lbp_index = 0;
     }
 
     append_payload(logic);
@@ -205,6 +196,7 @@ void LogicSnapshot::append_payload(const sr_datafeed_logic &logic)
     std::lock_guard<std::mutex> lock(_mutex);
 
     append_cross_payload(logic);
+    publish(_loop_offset);
 }
 
 void LogicSnapshot::append_cross_payload(const sr_datafeed_logic &logic)
@@ -240,9 +232,12 @@ void LogicSnapshot::append_cross_payload(const sr_datafeed_logic &logic)
     if (_is_loop)
     {
         if (_loop_offset >= LeafBlockSamples * Scale){        
+            // Root nodes move, readers have to wait for the new layout
+            ExclusiveGuard ex(this);
             move_first_node_to_last();
             _loop_offset -= LeafBlockSamples * Scale;
             _lst_free_block_index = 0;
+            publish(_loop_offset);
         }
         else{
             int free_count = _loop_offset / LeafBlockSamples;
@@ -252,7 +247,9 @@ void LogicSnapshot::append_cross_payload(const sr_datafeed_logic &logic)
         }
     }
  
-    _ring_sample_count += _loop_offset;
+    // Work on the absolute write position, the published ring count
+    // must not change before the data is in place.
+    uint64_t ring_end = _ring_sample_count + _loop_offset;
  
     // bit align
     while ((_ch_fraction != 0 || _byte_fraction != 0) && len > 0) 
@@ -268,9 +265,9 @@ void LogicSnapshot::append_cross_payload(const sr_datafeed_logic &logic)
         while (_byte_fraction != 0 && len > 0);
 
         if (_byte_fraction == 0) {
-            index0 = _ring_sample_count / LeafBlockSamples / RootScale;
-            index1 = (_ring_sample_count / LeafBlockSamples) % RootScale;
-            offset = (_ring_sample_count % LeafBlockSamples) / 8;
+            index0 = ring_end / LeafBlockSamples / RootScale;
+            index1 = (ring_end / LeafBlockSamples) % RootScale;
+            offset = (ring_end % LeafBlockSamples) / 8;
 
             _ch_fraction = (_ch_fraction + 1) % _channel_num;
 
@@ -289,9 +286,9 @@ void LogicSnapshot::append_cross_payload(const sr_datafeed_logic &logic)
 
             // To the last channel.
             if (_ch_fraction == 0){
-                _ring_sample_count += Scale;
+                ring_end += Scale;
 
-                if (_ring_sample_count % LeafBlockSamples == 0){
+                if (ring_end % LeafBlockSamples == 0){
                     calc_mipmap(_channel_num - 1, index0, index1, LeafBlockSamples, true);
                 }                                
                 break;
@@ -302,9 +299,9 @@ void LogicSnapshot::append_cross_payload(const sr_datafeed_logic &logic)
     // append data 
     assert(_ch_fraction == 0);
     assert(_byte_fraction == 0);
-    assert(_ring_sample_count % Scale == 0);
+    assert(ring_end % Scale == 0);
 
-    uint64_t align_sample_count = _ring_sample_count;
+    uint64_t align_sample_count = ring_end;
     uint64_t *read_ptr = (uint64_t*)data_src_ptr;
     void *end_read_ptr = (uint8_t*)data_src_ptr + len;
   
@@ -412,8 +409,7 @@ void LogicSnapshot::append_cross_payload(const sr_datafeed_logic &logic)
         }
     }
 
-    _ring_sample_count = align_sample_count;
-    _ring_sample_count -= _loop_offset;
+    _ring_sample_count = align_sample_count - _loop_offset;
 
     if (align_sample_count > _total_sample_count){        
         _loop_offset = align_sample_count - _total_sample_count; 
@@ -453,13 +449,11 @@ void LogicSnapshot::capture_ended()
     Snapshot::capture_ended();  
 
     _sample_count = _ring_sample_count;
-    _ring_sample_count += _loop_offset;
-    
-    uint64_t index0 = _ring_sample_count / LeafBlockSamples / RootScale;
-    uint64_t index1 = (_ring_sample_count / LeafBlockSamples) % RootScale;
-    uint64_t offset = (_ring_sample_count % LeafBlockSamples) / 8;
 
-    _ring_sample_count -= _loop_offset;
+    const uint64_t ring_end = _ring_sample_count + _loop_offset;
+    uint64_t index0 = ring_end / LeafBlockSamples / RootScale;
+    uint64_t index1 = (ring_end / LeafBlockSamples) % RootScale;
+    uint64_t offset = (ring_end % LeafBlockSamples) / 8;
 
     if (offset > 0)
     {
@@ -479,6 +473,8 @@ void LogicSnapshot::capture_ended()
             calc_mipmap(chan, index0, index1, offset * 8, true);
         }  
     }
+
+    publish(_loop_offset);
 }
 
 void LogicSnapshot::calc_mipmap(unsigned int order, uint8_t index0, uint8_t index1, uint64_t samples, bool isEnd)
@@ -559,6 +555,9 @@ void LogicSnapshot::calc_mipmap(unsigned int order, uint8_t index0, uint8_t inde
         src_ptr++;
     }  
 
+    // segment totals, the one left partial is done again next time
+    calc_summary(lbp, last_count, samples);
+
     if ((*((uint64_t*)lbp) & LSB) != 0)
         _ch_data[order][index0].first |= 1ULL << index1;
 
@@ -569,14 +568,9 @@ void LogicSnapshot::calc_mipmap(unsigned int order, uint8_t index0, uint8_t inde
         _ch_data[order][index0].tog |= 1ULL << index1;
     }
     else if (isEnd){
-        uint64_t ref_root = _cur_ref_block_indexs[order].root_index;
-        uint64_t ref_lbp  = _cur_ref_block_indexs[order].lbp_index;
-
-        if (_able_free || index0 > ref_root || (index0 == ref_root && index1 > ref_lbp))
-            free(_ch_data[order][index0].lbp[index1]);
-        else
-            _free_block_list.push_back(_ch_data[order][index0].lbp[index1]);
-
+        // A decoder still on this block holds a read guard, the
+        // block is freed once it moved on.
+        retire(_ch_data[order][index0].lbp[index1]);
         _ch_data[order][index0].lbp[index1] = NULL;
     }
 
@@ -586,11 +580,37 @@ void LogicSnapshot::calc_mipmap(unsigned int order, uint8_t index0, uint8_t inde
         _last_calc_count[order] = samples;
 } 
 
-const uint8_t *LogicSnapshot::get_samples(uint64_t start_sample, uint64_t &end_sample, int sig_index, void **lbp)
-{ 
-    std::lock_guard<std::mutex> lock(_mutex);
+void LogicSnapshot::calc_summary(void *lbp, uint64_t from, uint64_t samples)
+{
+    const uint64_t *words = (const uint64_t*)lbp;
+    uint32_t *ones = (uint32_t*)((uint8_t*)lbp + MipmapSpace);
+    uint32_t *togs = ones + Segments;
+    const uint64_t end_word = (samples + Scale - 1) / Scale;
+
+    for (uint64_t seg = from >> SegmentPower; seg * Scale < end_word; seg++)
+    {
+        uint32_t n = seg > 0 ? ones[seg - 1] : 0;
+        uint32_t t = seg > 0 ? togs[seg - 1] : 0;
+        const uint64_t last_word = min((seg + 1) * Scale, end_word);
+
+        for (uint64_t w = seg * Scale; w < last_word; w++) {
+            n += bit_count(words[w]);
+            t += bit_count(block_word_edges(words, w));
+        }
 
-    uint64_t sample_count = _ring_sample_count;
+        ones[seg] = n;
+        togs[seg] = t;
+    }
+}
+
+// The caller holds a read guard over all calls that go together and
+// passes the ring_count/loop_offset pair it read once under it, so the
+// chunks of all channels come from the same published range. The block
+// stays valid until the caller leaves the guard.
+const uint8_t *LogicSnapshot::get_samples(uint64_t start_sample, uint64_t &end_sample, int sig_index,
+                                          uint64_t ring_count, uint64_t loop_offset, void **lbp)
+{
+    const uint64_t sample_count = ring_count;
 
     assert(start_sample < sample_count);
 
@@ -600,8 +620,7 @@ const uint8_t *LogicSnapshot::get_samples(uint64_t start_sample, uint64_t &end_s
     assert(end_sample <= sample_count);
     assert(start_sample <= end_sample);
 
-    start_sample += _loop_offset;
-    _ring_sample_count += _loop_offset;
+    start_sample += loop_offset;
 
     int order = get_ch_order(sig_index);
     uint64_t index0 = start_sample >> (LeafBlockPower + RootScalePower);
@@ -612,38 +631,41 @@ const uint8_t *LogicSnapshot::get_samples(uint64_t start_sample, uint64_t &end_s
                  (index1 << LeafBlockPower) +
                  ~(~0ULL << LeafBlockPower);
 
-    end_sample = min(end_sample + 1, sample_count);
+    // back to ring positions, the chunk must not leave the block
+    end_sample = min(end_sample + 1 - loop_offset, sample_count);
 
-    _ring_sample_count -= _loop_offset;
+    if (order == -1)
+        return NULL;
 
-    if (order == -1 || _ch_data[order][index0].lbp[index1] == NULL)
+    // read once, the writer may retire the block meanwhile
+    void *block = _ch_data[order][index0].lbp[index1];
+    if (block == NULL)
         return NULL;
-    else{
-        if (lbp != NULL)
-            *lbp = _ch_data[order][index0].lbp[index1];
 
-        _cur_ref_block_indexs[order].root_index = index0;
-        _cur_ref_block_indexs[order].lbp_index  = index1;
-        
-        return (uint8_t*)_ch_data[order][index0].lbp[index1] + offset;
-    }
+    if (lbp != NULL)
+        *lbp = block;
+
+    return (uint8_t*)block + offset;
 }
 
 bool LogicSnapshot::get_sample(uint64_t index, int sig_index)
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    return get_sample_unlock(index, sig_index);
+    ReadGuard guard(this);
+    uint64_t ring_count;
+    uint64_t loop_offset;
+    read_published(ring_count, loop_offset);
+
+    return get_sample_unlock(index, sig_index, loop_offset);
 }
 
-bool LogicSnapshot::get_sample_unlock(uint64_t index, int sig_index)
+bool LogicSnapshot::get_sample(uint64_t index, int sig_index, uint64_t loop_offset)
 {
-    index += _loop_offset;
-    _ring_sample_count += _loop_offset;
-
-    bool flag = get_sample_self(index, sig_index);
+    return get_sample_unlock(index, sig_index, loop_offset);
+}
 
-    _ring_sample_count -= _loop_offset;
-    return flag;
+bool LogicSnapshot::get_sample_unlock(uint64_t index, int sig_index, uint64_t loop_offset)
+{
+    return get_sample_self(index + loop_offset, sig_index);
 }
 
 bool LogicSnapshot::get_sample_self(uint64_t index, int sig_index)
@@ -652,7 +674,8 @@ bool LogicSnapshot::get_sample_self(uint64_t index, int sig_index)
     assert(order != -1);
     assert(_ch_data[order].size() != 0);
 
-    if (index < _ring_sample_count) {
+    // index is already shifted by the loop offset
+    if (index < published_end()) {
         uint64_t index_mask = 1ULL << (index & LevelMask[0]);
         uint64_t index0 = index >> (LeafBlockPower + RootScalePower);
         uint64_t index1 = (index & RootMask) >> LeafBlockPower;
@@ -670,86 +693,693 @@ bool LogicSnapshot::get_sample_self(uint64_t index, int sig_index)
     return false;
 }
 
-bool LogicSnapshot::get_display_edges(std::vector<std::pair<bool, bool> > &edges,
-    std::vector<std::pair<uint16_t, bool> > &togs,
-    uint64_t start, uint64_t end, uint16_t width, uint16_t max_togs,
-    double pixels_offset, double min_length, uint16_t sig_index)
+bool LogicSnapshot::get_pixel_states(std::vector<uint8_t> &pixels,
+    uint64_t start, uint64_t end, uint16_t width,
+    double pixels_offset, double samples_per_pixel, int sig_index)
 {
-    if (!edges.empty())
-        edges.clear();
-    if (!togs.empty())
-        togs.clear();
+    pixels.assign(width, 0);
 
-    std::lock_guard<std::mutex> lock(_mutex);
+    ReadGuard guard(this);
+    uint64_t ring_count;
+    uint64_t loop_offset;
+    read_published(ring_count, loop_offset);
 
-    if (_ring_sample_count == 0)
+    if (ring_count == 0 || width == 0)
         return false;
 
-    assert(end < _ring_sample_count);
+    assert(end < ring_count);
     assert(start <= end);
-    assert(min_length > 0);
+    assert(samples_per_pixel > 0);
+
+    const int order = get_ch_order(sig_index);
+    if (order == -1)
+        return false;
+
+    // Column x holds the samples from column_start(x) up to
+    // column_start(x + 1), an edge is drawn in the column of the
+    // first sample after it. Indexes below include the loop offset.
+    const uint64_t first = start + loop_offset;
+    const uint64_t last = end + loop_offset;
+    auto column_start = [&](uint64_t x) {
+        return min((uint64_t)ceil((pixels_offset + x) * samples_per_pixel) + loop_offset, last + 1);
+    };
+
+    const bool start_sample = get_sample_self(first, sig_index);
+    bool level = start_sample;
+    uint64_t index = first + 1;
+    uint16_t x = 0;
+
+    // Jump from edge to edge through the mipmap, idle stretches cost
+    // one search no matter how many columns they cover. Busy stretches
+    // are walked column by column, which is cheaper than a search.
+    while (x < width) {
+        if (x > 0 && (pixels[x - 1] & PixelToggle)) {
+            const uint64_t col_end = column_start(x + 1);
+            if (col_end > index && range_has_toggle(order, index, col_end)) {
+                level = get_sample_self(col_end - 1, sig_index);
+                pixels[x++] = (level ? PixelHigh : 0) | PixelToggle;
+                index = col_end;
+                continue;
+            }
+        }
+
+        uint64_t edge = index;
+        if (index > last || !get_nxt_edge_self(edge, level, last, 0, sig_index) || edge > last)
+            break;
+
+        uint64_t col = (uint64_t)max(floor((edge - loop_offset) / samples_per_pixel - pixels_offset), 0.0);
+        col = min(max(col, (uint64_t)x), (uint64_t)width);
+        while (col > x && column_start(col) > edge)
+            col--;
+        uint64_t col_end = column_start(col + 1);
+        while (col < width && col_end <= edge)
+            col_end = column_start(++col + 1);
+        if (col >= width)
+            break;
+
+        for (; x < col; x++)
+            pixels[x] = level ? PixelHigh : 0;
+
+        col_end = max(col_end, edge + 1);
+        level = get_sample_self(col_end - 1, sig_index);
+        pixels[x++] = (level ? PixelHigh : 0) | PixelToggle;
+        index = col_end;
+    }
+
+    for (; x < width; x++)
+        pixels[x] = level ? PixelHigh : 0;
+
+    return start_sample;
+}
+
+// Whether any sample in [start, end) differs from the one before it,
+// indexes already include the loop offset.
+bool LogicSnapshot::range_has_toggle(int order, uint64_t start, uint64_t end)
+{
+    while (start < end) {
+        const uint64_t root_index = start >> (LeafBlockPower + RootScalePower);
+        const uint64_t lbp_index = (start & RootMask) >> LeafBlockPower;
+        const uint64_t block_start = start & ~LeafMask;
+        const uint64_t block_end = min(block_start + LeafBlockSamples, end);
+        const RootNode &rn = _ch_data[order][root_index];
+
+        // edge between this block and the previous one
+        if (start == block_start && start != 0) {
+            const RootNode &pre = _ch_data[order][(start - 1) >> (LeafBlockPower + RootScalePower)];
+            const uint64_t pre_mask = 1ULL << (((start - 1) & RootMask) >> LeafBlockPower);
+            if (((pre.last & pre_mask) != 0) != ((rn.first & (1ULL << lbp_index)) != 0))
+                return true;
+        }
+
+        if ((rn.tog & (1ULL << lbp_index)) &&
+            block_has_toggle((const uint64_t*)rn.lbp[lbp_index], start & LeafMask,
+                             block_end - block_start))
+            return true;
+
+        start = block_end;
+    }
+
+    return false;
+}
+
+// Same for [start, end) inside one leaf block, the edge at the block
+// start is left to the caller. Whole 64 sample words are answered by
+// the highest mipmap level that covers them.
+bool LogicSnapshot::block_has_toggle(const uint64_t *lbp, uint64_t start, uint64_t end)
+{
+    if (start == 0)
+        start = 1;
+    if (start >= end)
+        return false;
+
+    const uint64_t first_word = start >> ScalePower;
+    const uint64_t last_word = (end - 1) >> ScalePower;
+
+    for (uint64_t w = first_word; w <= last_word; w += max(last_word - first_word, (uint64_t)1)) {
+        const uint64_t cur = lbp[w];
+        const uint64_t pre = (cur << 1) | (w > 0 ? lbp[w - 1] >> (Scale - 1) : cur & LSB);
+        const uint64_t lo = (w == first_word) ? (start & LevelMask[0]) : 0;
+        const uint64_t hi = (w == last_word) ? ((end - 1) & LevelMask[0]) : Scale - 1;
+        const uint64_t mask = (~0ULL << lo) & (~0ULL >> (Scale - 1 - hi));
+
+        if ((cur ^ pre) & mask)
+            return true;
+    }
+
+    return last_word > first_word + 1 &&
+           level_has_bits(lbp, 1, first_word + 1, last_word - 1);
+}
+
+// Whether any bit in [first, last] of a mipmap level is set, whole
+// words in between are looked up one level higher.
+bool LogicSnapshot::level_has_bits(const uint64_t *lbp, unsigned int level,
+                                   uint64_t first, uint64_t last)
+{
+    const uint64_t *bits = lbp + LevelOffset[level];
+    const uint64_t first_word = first >> ScalePower;
+    const uint64_t last_word = last >> ScalePower;
+    const uint64_t first_mask = ~0ULL << (first & LevelMask[0]);
+    const uint64_t last_mask = ~0ULL >> (Scale - 1 - (last & LevelMask[0]));
+
+    if (first_word == last_word)
+        return (bits[first_word] & first_mask & last_mask) != 0;
+
+    if ((bits[first_word] & first_mask) || (bits[last_word] & last_mask))
+        return true;
+
+    return last_word > first_word + 1 && level + 1 < ScaleLevel &&
+           level_has_bits(lbp, level + 1, first_word + 1, last_word - 1);
+}
+
+// Runs the trigger stages over all published samples and collects the
+// position of every sample at which the last stage passes. The stages
+// start over right after each hit. Samples are taken 64 at a time, and
+// spans in which none of the used channels moves are skipped on the
+// mipmap levels. Returns false if canceled.
+bool LogicSnapshot::trigger_search(std::vector<TriggerStage> &stages,
+                                   std::vector<uint64_t> &positions, volatile bool *canceled)
+{
+    ReadGuard guard(this);
+    uint64_t ring_count;
+    uint64_t loop_offset;
+    read_published(ring_count, loop_offset);
+
+    positions.clear();
+
+    if (stages.empty() || ring_count == 0)
+        return true;
+
+    std::vector<int> orders;
+    std::vector<TriggerProg> prog;
+
+    for (auto &s : stages) {
+        TriggerProg p;
+        const std::map<uint16_t, char> *values[2] = {&s.value0, &s.value1};
+
+        for (int k = 0; k < 2; k++) {
+            for (auto &v : *values[k]) {
+                const int order = get_ch_order(v.first);
+                if (order == -1 || v.second == 'X')
+                    continue;
+
+                auto it = find(orders.begin(), orders.end(), order);
+                const uint16_t slot = it - orders.begin();
+                if (it == orders.end())
+                    orders.push_back(order);
+
+                TriggerTerm term = {slot, v.second};
+                p.terms[k].push_back(term);
+            }
+        }
+        p.inv[0] = s.inv0;
+        p.inv[1] = s.inv1;
+        p.logic_and = s.logic_and;
+        p.contiguous = s.contiguous;
+        p.count = max(s.count, (uint32_t)1);
+        prog.push_back(p);
+    }
+
+    const uint64_t start = loop_offset;
+    const uint64_t end = loop_offset + ring_count;
+    const uint64_t end_word = (end + Scale - 1) >> ScalePower;
+    const int slots = orders.size();
+
+    uint64_t cur[CHANNEL_MAX_COUNT];
+    uint64_t pre[CHANNEL_MAX_COUNT];
+    uint64_t last[CHANNEL_MAX_COUNT];
+    TriggerState state = {0, 0};
+
+    // no edge on the first sample
+    for (int i = 0; i < slots; i++) {
+        const bool v = (trigger_word(orders[i], start >> ScalePower) >> (start & LevelMask[0])) & 1;
+        last[i] = v ? ~0ULL : 0;
+    }
 
     uint64_t index = start;
-    bool last_sample;
-    bool start_sample;
 
-    // Get the initial state
-    start_sample = last_sample = get_sample_unlock(index++, sig_index);
-    togs.push_back(pair<uint16_t, bool>(0, last_sample));
+    while (index < end)
+    {
+        if (canceled && *canceled)
+            return false;
+
+        const uint64_t word = index >> ScalePower;
+        const uint64_t lo = index & LevelMask[0];
+
+        if (lo == 0) {
+            uint64_t active = end_word;
+            for (int i = 0; i < slots && active > word; i++)
+                active = next_active_word(orders[i], word, active);
+
+            if (active > word) {
+                const uint64_t span_end = min(active << ScalePower, end);
+                if (!trigger_feed_span(prog, state, last, span_end - index,
+                                       index - loop_offset, positions))
+                    return true;
+                index = span_end;
+                continue;
+            }
+        }
+
+        const uint64_t hi = min((word + 1) << ScalePower, end) - 1 - (word << ScalePower);
 
-    while(edges.size() < width) {
-        // search next edge
-        bool has_edge = get_nxt_edge_unlock(index, last_sample, end, 0, sig_index);
+        for (int i = 0; i < slots; i++) {
+            cur[i] = trigger_word(orders[i], word);
+            pre[i] = (cur[i] << 1) | (last[i] & LSB);
+            if (lo > 0)
+                pre[i] = (pre[i] & ~(LSB << lo)) | ((last[i] & LSB) << lo);
+        }
 
-        // calc the edge position
-        int64_t gap = (index / min_length) - pixels_offset;
-        index = max((uint64_t)ceil((floor(index/min_length) + 1) * min_length), index + 1);
+        if (!trigger_feed_word(prog, state, cur, pre, lo, hi,
+                               (word << ScalePower) - loop_offset, positions))
+            return true;
 
-        while(gap > (int64_t)edges.size() && edges.size() < width){
-            edges.push_back(pair<bool, bool>(false, last_sample));
+        for (int i = 0; i < slots; i++)
+            last[i] = ((cur[i] >> hi) & 1) ? ~0ULL : 0;
+
+        index = (word << ScalePower) + hi + 1;
+    }
+
+    return true;
+}
+
+// Matching samples of one stage, cur holds 64 samples of each slot
+// and pre the sample before each of them.
+uint64_t LogicSnapshot::trigger_mask(const TriggerProg &prog, const uint64_t *cur, const uint64_t *pre)
+{
+    uint64_t mask[2];
+
+    for (int k = 0; k < 2; k++) {
+        uint64_t m = ~0ULL;
+
+        for (const TriggerTerm &t : prog.terms[k]) {
+            const uint64_t c = cur[t.slot];
+            const uint64_t p = pre[t.slot];
+
+            switch (t.flag) {
+            case '0': m &= ~c; break;
+            case '1': m &= c; break;
+            case 'R': m &= ~p & c; break;
+            case 'F': m &= p & ~c; break;
+            case 'C': m &= p ^ c; break;
+            }
         }
+        mask[k] = prog.inv[k] ? ~m : m;
+    }
 
-        if (index > end)
-            last_sample = get_sample_unlock(end, sig_index);
-        else
-            last_sample = get_sample_unlock(index - 1, sig_index);
+    return prog.logic_and ? (mask[0] & mask[1]) : (mask[0] | mask[1]);
+}
+
+// Feeds the samples lo..hi of one word to the stages, the mask is taken
+// again after a stage passes. Returns false once the hit list is full.
+bool LogicSnapshot::trigger_feed_word(std::vector<TriggerProg> &prog, TriggerState &state,
+                                      const uint64_t *cur, const uint64_t *pre, uint64_t lo, uint64_t hi,
+                                      uint64_t base, std::vector<uint64_t> &positions)
+{
+    const uint64_t valid = (~0ULL << lo) & (~0ULL >> (Scale - 1 - hi));
+    uint64_t pos = lo;
+
+    while (pos <= hi)
+    {
+        const TriggerProg &p = prog[state.stage];
+        uint64_t m = trigger_mask(p, cur, pre) & valid & (~0ULL << pos);
+        uint64_t bit;
+
+        if (!p.contiguous) {
+            const uint64_t hits = bit_count(m);
+            if (state.matched + hits < p.count) {
+                state.matched += hits;
+                return true;
+            }
+            for (uint64_t k = p.count - state.matched - 1; k > 0; k--)
+                m &= m - 1;
+            bit = bsf_folded(m);
+        }
+        else {
+            // run of matches starting at pos
+            const uint64_t x = m >> pos;
+            if ((x & LSB) == 0) {
+                state.matched = 0;
+                if (x == 0)
+                    return true;
+                pos += bsf_folded(x);
+                continue;
+            }
+
+            const uint64_t run = (~x == 0) ? Scale - pos : bsf_folded(~x);
+            if (state.matched + run < p.count) {
+                state.matched += run;
+                pos += run;
+                continue;
+            }
+            bit = pos + (p.count - state.matched) - 1;
+        }
+
+        if (!trigger_pass(prog, state, base + bit, positions))
+            return false;
+        pos = bit + 1;
+    }
+
+    return true;
+}
+
+// Same for len samples in which no used channel moves, each stage then
+// matches all of them or none.
+bool LogicSnapshot::trigger_feed_span(std::vector<TriggerProg> &prog, TriggerState &state,
+                                      const uint64_t *level, uint64_t len, uint64_t base,
+                                      std::vector<uint64_t> &positions)
+{
+    uint64_t pos = 0;
+
+    while (pos < len)
+    {
+        const TriggerProg &p = prog[state.stage];
 
-        if (has_edge) {
-            edges.push_back(pair<bool, bool>(true, last_sample));
-            if (togs.size() < max_togs)
-                togs.push_back(pair<uint16_t, bool>(edges.size() - 1, last_sample));
+        if ((trigger_mask(p, level, level) & LSB) == 0) {
+            if (p.contiguous)
+                state.matched = 0;
+            return true;
+        }
+
+        if (state.matched + (len - pos) < p.count) {
+            state.matched += len - pos;
+            return true;
+        }
+
+        const uint64_t bit = pos + (p.count - state.matched) - 1;
+        if (!trigger_pass(prog, state, base + bit, positions))
+            return false;
+        pos = bit + 1;
+    }
+
+    return true;
+}
+
+bool LogicSnapshot::trigger_pass(std::vector<TriggerProg> &prog, TriggerState &state,
+                                 uint64_t index, std::vector<uint64_t> &positions)
+{
+    state.matched = 0;
+
+    if (++state.stage < prog.size())
+        return true;
+
+    state.stage = 0;
+    positions.push_back(index);
+
+    return positions.size() < TriggerMaxHits;
+}
+
+// 64 samples of a channel, index already includes the loop offset
+uint64_t LogicSnapshot::trigger_word(int order, uint64_t word)
+{
+    const uint64_t index = word << ScalePower;
+    const uint64_t root_index = index >> (LeafBlockPower + RootScalePower);
+    const uint64_t lbp_index = (index & RootMask) >> LeafBlockPower;
+    const RootNode &rn = _ch_data[order][root_index];
+
+    if ((rn.tog & (1ULL << lbp_index)) == 0)
+        return (rn.first & (1ULL << lbp_index)) ? ~0ULL : 0;
+
+    return ((const uint64_t*)rn.lbp[lbp_index])[(index & LeafMask) >> ScalePower];
+}
+
+// First word at or after word in which the channel may change. The
+// first word of a leaf block is always taken, its mipmap bit does not
+// see the edge to the block before.
+uint64_t LogicSnapshot::next_active_word(int order, uint64_t word, uint64_t end_word)
+{
+    const uint64_t block_words = LeafBlockSamples / Scale;
+
+    while (word < end_word)
+    {
+        const uint64_t offset = word % block_words;
+        if (offset == 0)
+            return word;
+
+        const uint64_t block = word / block_words;
+        const RootNode &rn = _ch_data[order][block / RootScale];
+        const uint64_t lbp_index = block % RootScale;
+
+        if (rn.tog & (1ULL << lbp_index)) {
+            const uint64_t bit = level_next_bit((const uint64_t*)rn.lbp[lbp_index], 1,
+                                                offset, block_words);
+            if (bit < block_words)
+                return min(word - offset + bit, end_word);
         }
 
-        while(index > end && edges.size() < width)
-            edges.push_back(pair<bool, bool>(false, last_sample));
+        word += block_words - offset;
     }
 
-    if (togs.size() < max_togs) {
-        last_sample = get_sample_unlock(end, sig_index);
-        togs.push_back(pair<uint16_t, bool>(edges.size() - 1, last_sample));
+    return end_word;
+}
+
+// First set bit at or after first on a mipmap level of count bits, or
+// count if there is none. Clear words are skipped one level higher.
+uint64_t LogicSnapshot::level_next_bit(const uint64_t *lbp, unsigned int level,
+                                       uint64_t first, uint64_t count)
+{
+    const uint64_t *bits = lbp + LevelOffset[level];
+    const uint64_t words = count / Scale;
+    uint64_t w = first >> ScalePower;
+    const uint64_t cur = bits[w] & (~0ULL << (first & LevelMask[0]));
+
+    if (cur != 0)
+        return (w << ScalePower) + bsf_folded(cur);
+
+    if (++w >= words)
+        return count;
+
+    if (level + 1 < ScaleLevel) {
+        w = level_next_bit(lbp, level + 1, w, words);
+        return w < words ? (w << ScalePower) + bsf_folded(bits[w]) : count;
     }
 
-    return start_sample;
+    for (; w < words; w++) {
+        if (bits[w] != 0)
+            return (w << ScalePower) + bsf_folded(bits[w]);
+    }
+
+    return count;
+}
+
+// Quiet words are skipped on the mipmap, the edges of the others are
+// taken 64 samples at a time.
+bool LogicSnapshot::get_edges(std::vector<uint64_t> &edges, uint64_t &start, uint64_t end,
+                              uint64_t max_count, int sig_index)
+{
+    ReadGuard guard(this);
+    uint64_t ring_count;
+    uint64_t loop_offset;
+    read_published(ring_count, loop_offset);
+
+    edges.clear();
+
+    const int order = get_ch_order(sig_index);
+    if (order == -1 || ring_count == 0 || max_count == 0)
+        return false;
+
+    end = min(end, ring_count - 1);
+    if (start >= end) {
+        start = end;
+        return true;
+    }
+
+    const uint64_t last = end + loop_offset;
+    const uint64_t end_word = (last >> ScalePower) + 1;
+    uint64_t index = start + 1 + loop_offset;
+
+    while (index <= last)
+    {
+        const uint64_t word = index >> ScalePower;
+
+        if ((index & LevelMask[0]) == 0) {
+            const uint64_t active = next_active_word(order, word, end_word);
+            if (active > word) {
+                index = active << ScalePower;
+                continue;
+            }
+        }
+
+        uint64_t tog = word_edges(order, index, last);
+
+        while (tog != 0) {
+            edges.push_back((word << ScalePower) + bsf_folded(tog) - loop_offset);
+            tog &= tog - 1;
+
+            if (edges.size() == max_count) {
+                start = edges.back();
+                return true;
+            }
+        }
+
+        index = (word + 1) << ScalePower;
+    }
+
+    start = end;
+    return true;
+}
+
+// The edges alternate, the one left over goes the way of the ends.
+bool LogicSnapshot::get_edge_count(uint64_t start, uint64_t end, int sig_index,
+                                   uint64_t &rising, uint64_t &falling)
+{
+    ReadGuard guard(this);
+    uint64_t ring_count;
+    uint64_t loop_offset;
+    read_published(ring_count, loop_offset);
+
+    rising = 0;
+    falling = 0;
+
+    const int order = get_ch_order(sig_index);
+    if (order == -1 || ring_count == 0 || start > end || end > ring_count - 1)
+        return false;
+
+    const uint64_t first = start + loop_offset;
+    const uint64_t last = end + loop_offset;
+    uint64_t high;
+    uint64_t count;
+    range_summary(order, first, last, high, count);
+
+    const bool first_level = get_sample_self(first, sig_index);
+    const bool last_level = get_sample_self(last, sig_index);
+
+    rising = count / 2;
+    falling = count / 2;
+    if (first_level != last_level) {
+        rising += !first_level;
+        falling += first_level;
+    }
+
+    return true;
+}
+
+bool LogicSnapshot::get_range_summary(uint64_t start, uint64_t end, int sig_index,
+                                      uint64_t &high, uint64_t &edges)
+{
+    ReadGuard guard(this);
+    uint64_t ring_count;
+    uint64_t loop_offset;
+    read_published(ring_count, loop_offset);
+
+    high = 0;
+    edges = 0;
+
+    const int order = get_ch_order(sig_index);
+    if (order == -1 || ring_count == 0 || start > end || end > ring_count - 1)
+        return false;
+
+    range_summary(order, start + loop_offset, end + loop_offset, high, edges);
+    return true;
+}
+
+// One step per leaf block: constant blocks are answered by their root
+// node bits, the others by two lookups in the segment totals plus the
+// words of a partial segment at each end.
+void LogicSnapshot::range_summary(int order, uint64_t first, uint64_t last,
+                                  uint64_t &high, uint64_t &edges)
+{
+    uint64_t index = first;
+
+    high = 0;
+    edges = 0;
+
+    while (index <= last)
+    {
+        const uint64_t root_index = index >> (LeafBlockPower + RootScalePower);
+        const uint64_t lbp_index = (index & RootMask) >> LeafBlockPower;
+        const uint64_t block_start = index & ~LeafMask;
+        const uint64_t lo = index & LeafMask;
+        const uint64_t hi = min(block_start + LeafBlockSamples - 1, last) - block_start;
+        const RootNode &rn = _ch_data[order][root_index];
+        const uint64_t *lbp = (const uint64_t*)rn.lbp[lbp_index];
+
+        // edge between this block and the previous one
+        if (lo == 0 && index > first) {
+            const RootNode &pre = _ch_data[order][(index - 1) >> (LeafBlockPower + RootScalePower)];
+            const uint64_t pre_mask = 1ULL << (((index - 1) & RootMask) >> LeafBlockPower);
+            if (((pre.last & pre_mask) != 0) != ((rn.first & (1ULL << lbp_index)) != 0))
+                edges++;
+        }
+
+        if ((rn.tog & (1ULL << lbp_index)) == 0 || lbp == NULL) {
+            if (rn.first & (1ULL << lbp_index))
+                high += hi - lo + 1;
+        }
+        else {
+            uint64_t ones0, togs0;
+            uint64_t ones1, togs1;
+            block_prefix(lbp, lo, ones0, togs0);
+            block_prefix(lbp, hi + 1, ones1, togs1);
+
+            // the edge at lo itself is outside the range
+            togs0 += (block_word_edges(lbp, lo >> ScalePower) >> (lo & LevelMask[0])) & 1;
+
+            high += ones1 - ones0;
+            edges += togs1 - togs0;
+        }
+
+        index = block_start + hi + 1;
+    }
+}
+
+// Set samples and edges among the first count samples of a leaf block
+void LogicSnapshot::block_prefix(const uint64_t *lbp, uint64_t count, uint64_t &ones, uint64_t &togs)
+{
+    const uint32_t *sum_ones = (const uint32_t*)((const uint8_t*)lbp + MipmapSpace);
+    const uint32_t *sum_togs = sum_ones + Segments;
+    const uint64_t seg = count >> SegmentPower;
+    const uint64_t full_words = count >> ScalePower;
+    const uint64_t rest = count & LevelMask[0];
+    uint64_t w = seg * Scale;
+
+    ones = seg > 0 ? sum_ones[seg - 1] : 0;
+    togs = seg > 0 ? sum_togs[seg - 1] : 0;
+
+    for (; w < full_words; w++) {
+        ones += bit_count(lbp[w]);
+        togs += bit_count(block_word_edges(lbp, w));
+    }
+
+    if (rest != 0) {
+        const uint64_t mask = ~(~0ULL << rest);
+        ones += bit_count(lbp[w] & mask);
+        togs += bit_count(block_word_edges(lbp, w) & mask);
+    }
+}
+
+// Edges of the word holding index, from index up to last. Bit 0 is the
+// edge to the word before, the caller makes sure that one is valid.
+uint64_t LogicSnapshot::word_edges(int order, uint64_t index, uint64_t last)
+{
+    const uint64_t word = index >> ScalePower;
+    const uint64_t lo = index & LevelMask[0];
+    const uint64_t hi = min(((word + 1) << ScalePower) - 1, last) - (word << ScalePower);
+    const uint64_t cur = trigger_word(order, word);
+    const uint64_t pre = (cur << 1) | (lo == 0 ? trigger_word(order, word - 1) >> (Scale - 1) : 0);
+
+    return (cur ^ pre) & (~0ULL << lo) & (~0ULL >> (Scale - 1 - hi));
 }
 
 bool LogicSnapshot::get_nxt_edge(uint64_t &index, bool last_sample, uint64_t end,
                       double min_length, int sig_index)
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    return get_nxt_edge_unlock(index, last_sample, end, min_length, sig_index);
+    ReadGuard guard(this);
+    uint64_t ring_count;
+    uint64_t loop_offset;
+    read_published(ring_count, loop_offset);
+
+    return get_nxt_edge_unlock(index, last_sample, end, min_length, sig_index, loop_offset);
 }
 
 bool LogicSnapshot::get_nxt_edge_unlock(uint64_t &index, bool last_sample, uint64_t end,
-                      double min_length, int sig_index)
+                      double min_length, int sig_index, uint64_t loop_offset)
 {
-    index += _loop_offset;
-    end += _loop_offset;
-    _ring_sample_count += _loop_offset;
+    index += loop_offset;
+    end += loop_offset;
 
     bool flag = get_nxt_edge_self(index, last_sample, end, min_length, sig_index);
 
-    index -= _loop_offset;
-    _ring_sample_count -= _loop_offset;
+    index -= loop_offset;
 
     return flag;
 }
@@ -836,22 +1466,23 @@ bool LogicSnapshot::get_nxt_edge_self(uint64_t &index, bool last_sample, uint64_
 bool LogicSnapshot::get_pre_edge(uint64_t &index, bool last_sample,
                       double min_length, int sig_index)
 {
-    std::lock_guard<std::mutex> lock(_mutex);
+    ReadGuard guard(this);
+    uint64_t ring_count;
+    uint64_t loop_offset;
+    read_published(ring_count, loop_offset);
 
-    index += _loop_offset;
-    _ring_sample_count += _loop_offset;
+    index += loop_offset;
 
     bool flag = get_pre_edge_self(index, last_sample, min_length, sig_index);
 
-    index = (index < _loop_offset) ? 0 : index - _loop_offset;
-    _ring_sample_count -= _loop_offset;
+    index = (index < loop_offset) ? 0 : index - loop_offset;
     return flag;
 }
 
 bool LogicSnapshot::get_pre_edge_self(uint64_t &index, bool last_sample,
     double min_length, int sig_index)
 {
-    assert(index < _ring_sample_count);
+    assert(index < published_end());
 
     int order = get_ch_order(sig_index);
     if (order == -1)
@@ -1218,17 +1849,18 @@ bool LogicSnapshot::block_pre_edge(uint64_t *lbp, uint64_t &index, bool last_sam
 bool LogicSnapshot::pattern_search(int64_t start, int64_t end, int64_t& index,
                         std::map<uint16_t, QString> &pattern, bool isNext)
 {
-    std::lock_guard<std::mutex> lock(_mutex);
+    ReadGuard guard(this);
+    uint64_t ring_count;
+    uint64_t loop_offset;
+    read_published(ring_count, loop_offset);
     
-    start += _loop_offset;
-    end += _loop_offset;
-    index += _loop_offset;
-    _ring_sample_count += _loop_offset;
+    start += loop_offset;
+    end += loop_offset;
+    index += loop_offset;
 
     bool flag = pattern_search_self(start, end, index, pattern, isNext);
 
-    index -= _loop_offset;
-    _ring_sample_count -= _loop_offset;
+    index -= loop_offset;
     return flag;
 }
 
@@ -1347,6 +1979,26 @@ bool LogicSnapshot::has_data(int sig_index)
     return get_ch_order(sig_index) != -1;
 }
 
+// Bytes held by the leaf blocks, constant blocks are not stored
+uint64_t LogicSnapshot::get_memory_size()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    uint64_t size = 0;
+
+    for (auto& iter : _ch_data) {
+        size += iter.size() * sizeof(struct RootNode);
+
+        for (auto& iter_rn : iter) {
+            for (unsigned int k = 0; k < Scale; k++){
+                if (iter_rn.lbp[k] != NULL)
+                    size += LeafBlockSpace;
+            }
+        }
+    }
+
+    return size;
+}
+
 int LogicSnapshot::get_block_num()
 {
    int block = ceil((_ring_sample_count+_loop_offset) * 1.0 / LeafBlockSamples) 
@@ -1455,32 +2107,6 @@ void LogicSnapshot::move_first_node_to_last()
     }
 }
 
-void LogicSnapshot::decode_end()
-{
-   std::lock_guard<std::mutex> lock(_mutex);
-
-   for(void *p : _free_block_list){
-        free(p);
-    }
-    _free_block_list.clear();
-}
-
-void LogicSnapshot::free_decode_lpb(void *lbp)
-{
-    assert(lbp);
-
-    std::lock_guard<std::mutex> lock(_mutex);
-
-    for (auto it = _free_block_list.begin(); it != _free_block_list.end(); it++)
-    {
-        if ((*it) == lbp){
-            _free_block_list.erase(it);
-            free(lbp);
-            break;
-        }
-    }
-}
-
 void LogicSnapshot::free_head_blocks(int count)
 {
     assert(count < (int)Scale);
@@ -1490,7 +2116,7 @@ void LogicSnapshot::free_head_blocks(int count)
     {
         for (int j=_lst_free_block_index; j<count; j++){
             if (_ch_data[i][0].lbp[j] != NULL){
-                free(_ch_data[i][0].lbp[j]);
+                retire(_ch_data[i][0].lbp[j]);
                 _ch_data[i][0].lbp[j] = NULL;
             }
 
@@ -53,11 +53,18 @@ private:
     static const uint64_t ScaleSize = Scale / 8;
     static const uint64_t RootScalePower = ScalePower;
     static const uint64_t RootScale = 1 << RootScalePower;
-    static const uint64_t LeafBlockSpace = (Scale + Scale*Scale +
+    static const uint64_t MipmapSpace = (Scale + Scale*Scale +
             Scale*Scale*Scale + Scale*Scale*Scale*Scale) / 8;
 
     static const uint64_t LeafBlockPower = ScaleLevel*ScalePower;
     static const uint64_t LeafBlockSamples = 1 << LeafBlockPower;
+
+    // Behind the mipmap each leaf block keeps running totals of set
+    // samples and of edges, one pair per segment of Scale words.
+    static const uint64_t SegmentPower = 2*ScalePower;
+    static const uint64_t SegmentSamples = 1 << SegmentPower;
+    static const uint64_t Segments = LeafBlockSamples / SegmentSamples;
+    static const uint64_t LeafBlockSpace = MipmapSpace + Segments * 2 * sizeof(uint32_t);
     static const uint64_t RootNodeSamples = LeafBlockSamples*RootScale;
 
     static const uint64_t RootMask = ~(~0ULL << RootScalePower) << LeafBlockPower;
@@ -77,15 +84,53 @@ private:
         void *lbp[Scale];
     };
 
-    struct BlockIndex
+    // TriggerStage compiled for trigger_search(), channels are slots
+    // into the word arrays.
+    struct TriggerTerm
+    {
+        uint16_t    slot;
+        char        flag;
+    };
+
+    struct TriggerProg
+    {
+        std::vector<TriggerTerm> terms[2];
+        bool        inv[2];
+        bool        logic_and;
+        bool        contiguous;
+        uint64_t    count;
+    };
+
+    struct TriggerState
     {
-        uint64_t    root_index;
-        uint64_t    lbp_index;
+        uint64_t    stage;
+        uint64_t    matched;
     };
 
 public:
     typedef std::pair<uint64_t, bool> EdgePair;
 
+    // Per pixel column state written by get_pixel_states()
+    enum PixelState {
+        PixelHigh = 1 << 0,     // level at the end of the column
+        PixelToggle = 1 << 1,   // at least one edge inside the column
+    };
+
+    // One stage of the software trigger, the same model as the stages
+    // the hardware gets from ds_trigger_stage_set_value() and friends.
+    struct TriggerStage
+    {
+        std::map<uint16_t, char> value0; // channel to 0/1/R/F/C, X is left out
+        std::map<uint16_t, char> value1;
+        bool inv0;
+        bool inv1;
+        bool logic_and;
+        bool contiguous;
+        uint32_t count;
+    };
+
+    static const uint64_t TriggerMaxHits = 100000;
+
 private:
     void init_all();
 
@@ -100,21 +145,22 @@ public:
 
     void init();   
 
-    void first_payload(const sr_datafeed_logic &logic, uint64_t total_sample_count, GSList *channels, bool able_free);
+    void first_payload(const sr_datafeed_logic &logic, uint64_t total_sample_count, GSList *channels);
 
 	void append_payload(const sr_datafeed_logic &logic);
 
-    const uint8_t * get_samples(uint64_t start_sample, uint64_t& end_sample, int sig_index, void **lbp=NULL);
+    const uint8_t * get_samples(uint64_t start_sample, uint64_t& end_sample, int sig_index,
+                                uint64_t ring_count, uint64_t loop_offset, void **lbp=NULL);
 
     bool get_sample(uint64_t index, int sig_index);
+    bool get_sample(uint64_t index, int sig_index, uint64_t loop_offset);
 
     void capture_ended();
 
-    bool get_display_edges(std::vector<std::pair<bool, bool>> &edges,
-                           std::vector<std::pair<uint16_t, bool>> &togs,
-                           uint64_t start, uint64_t end, uint16_t width,
-                           uint16_t max_togs, double pixels_offset,
-                           double min_length, uint16_t sig_index);
+    bool get_pixel_states(std::vector<uint8_t> &pixels,
+                          uint64_t start, uint64_t end, uint16_t width,
+                          double pixels_offset, double samples_per_pixel,
+                          int sig_index);
 
     bool get_nxt_edge(uint64_t &index, bool last_sample, uint64_t end,
                       double min_length, int sig_index);
@@ -122,6 +168,22 @@ public:
     bool get_pre_edge(uint64_t &index, bool last_sample,
                       double min_length, int sig_index);
 
+    // Positions of up to max_count edges in (start, end] of a channel,
+    // in order. start is moved to the last one returned, or to end
+    // once the range is done.
+    bool get_edges(std::vector<uint64_t> &edges, uint64_t &start, uint64_t end,
+                   uint64_t max_count, int sig_index);
+
+    // Edges of a channel in (start, end], rising and falling are told
+    // apart by the levels at both ends.
+    bool get_edge_count(uint64_t start, uint64_t end, int sig_index,
+                        uint64_t &rising, uint64_t &falling);
+
+    // Samples at high level in [start, end] and edges in (start, end],
+    // from the segment totals.
+    bool get_range_summary(uint64_t start, uint64_t end, int sig_index,
+                           uint64_t &high, uint64_t &edges);
+
     bool has_data(int sig_index);
     int get_block_num();
     uint64_t get_block_size(int block_index);
@@ -138,24 +200,21 @@ public:
         return _is_loop;
     }
 
-    void decode_end();
-
-    void free_decode_lpb(void *lbp);
-
-    inline bool is_able_free(){
-        return _able_free;
-    } 
-
     inline uint64_t get_loop_offset(){
         return _loop_offset;
     }
 
+    uint64_t get_memory_size();
+
+    bool trigger_search(std::vector<TriggerStage> &stages, std::vector<uint64_t> &positions,
+                        volatile bool *canceled);
+
 private:
-    bool get_sample_unlock(uint64_t index, int sig_index);
+    bool get_sample_unlock(uint64_t index, int sig_index, uint64_t loop_offset);
     bool get_sample_self(uint64_t index, int sig_index);
 
     bool get_nxt_edge_unlock(uint64_t &index, bool last_sample, uint64_t end,
-                      double min_length, int sig_index);
+                      double min_length, int sig_index, uint64_t loop_offset);
     bool get_nxt_edge_self(uint64_t &index, bool last_sample, uint64_t end,
                       double min_length, int sig_index);
 
@@ -168,6 +227,9 @@ private:
     int get_ch_order(int sig_index);
 
     void calc_mipmap(unsigned int order, uint8_t index0, uint8_t index1, uint64_t samples, bool isEnd);
+    void calc_summary(void *lbp, uint64_t from, uint64_t samples);
+    void block_prefix(const uint64_t *lbp, uint64_t count, uint64_t &ones, uint64_t &togs);
+    void range_summary(int order, uint64_t first, uint64_t last, uint64_t &high, uint64_t &edges);
 
     void append_cross_payload(const sr_datafeed_logic &logic);
 
@@ -183,6 +245,33 @@ private:
     bool block_pre_edge(uint64_t *lbp, uint64_t &index, bool last_sample,
                         unsigned int min_level, int sig_index);
 
+    bool range_has_toggle(int order, uint64_t start, uint64_t end);
+    bool block_has_toggle(const uint64_t *lbp, uint64_t start, uint64_t end);
+    bool level_has_bits(const uint64_t *lbp, unsigned int level,
+                        uint64_t first, uint64_t last);
+
+    uint64_t trigger_mask(const TriggerProg &prog, const uint64_t *cur, const uint64_t *pre);
+    bool trigger_feed_word(std::vector<TriggerProg> &prog, TriggerState &state,
+                           const uint64_t *cur, const uint64_t *pre, uint64_t lo, uint64_t hi,
+                           uint64_t base, std::vector<uint64_t> &positions);
+    bool trigger_feed_span(std::vector<TriggerProg> &prog, TriggerState &state,
+                           const uint64_t *level, uint64_t len, uint64_t base,
+                           std::vector<uint64_t> &positions);
+    bool trigger_pass(std::vector<TriggerProg> &prog, TriggerState &state,
+                      uint64_t index, std::vector<uint64_t> &positions);
+    uint64_t trigger_word(int order, uint64_t word);
+    uint64_t next_active_word(int order, uint64_t word, uint64_t end_word);
+    uint64_t level_next_bit(const uint64_t *lbp, unsigned int level,
+                            uint64_t first, uint64_t count);
+    uint64_t word_edges(int order, uint64_t index, uint64_t last);
+
+    // Edges of word w of a leaf block, there is none at the block start
+    inline uint64_t block_word_edges(const uint64_t *lbp, uint64_t w)
+    {
+        const uint64_t cur = lbp[w];
+        return cur ^ ((cur << 1) | (w > 0 ? lbp[w - 1] >> (Scale - 1) : cur & LSB));
+    }
+
     inline uint8_t bsf_folded (uint64_t bb)
     {
         static const uint8_t lsb_64_table[64] = {
@@ -201,6 +290,14 @@ private:
         return lsb_64_table[folded * 0x78291ACF >> 26];
     }
 
+    inline uint8_t bit_count(uint64_t bb)
+    {
+        bb = bb - ((bb >> 1) & 0x5555555555555555ULL);
+        bb = (bb & 0x3333333333333333ULL) + ((bb >> 2) & 0x3333333333333333ULL);
+        bb = (bb + (bb >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+        return (bb * 0x0101010101010101ULL) >> 56;
+    }
+
     inline uint8_t bsr32(uint32_t bb)
     {
         static const uint8_t msb_256_table[256] = {
@@ -248,9 +345,6 @@ private:
     uint64_t    _last_calc_count[CHANNEL_MAX_COUNT];
     bool        _is_loop;
     uint64_t    _loop_offset;
-    bool        _able_free;
-    std::vector<void*> _free_block_list;
-    struct BlockIndex _cur_ref_block_indexs[CHANNEL_MAX_COUNT];
     int         _lst_free_block_index;
  
 	friend class LogicSnapshotTest::Pow2;
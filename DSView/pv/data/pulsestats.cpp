@@ -0,0 +1,319 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2016 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+
+#include "pulsestats.h"
+#include <algorithm>
+#include <math.h>
+#include <assert.h>
+
+#include "logicsnapshot.h"
+
+namespace pv {
+namespace data {
+
+void PulseStats::Accum::init()
+{
+    m2 = 0;
+    stat.count = 0;
+    stat.min = 0;
+    stat.max = 0;
+    stat.mean = 0;
+    stat.stddev = 0;
+    stat.bins.assign(Bins, 0);
+}
+
+void PulseStats::Accum::add(double v)
+{
+    stat.count++;
+    if (stat.count == 1) {
+        stat.min = v;
+        stat.max = v;
+    }
+    else {
+        stat.min = std::min(stat.min, v);
+        stat.max = std::max(stat.max, v);
+    }
+
+    const double delta = v - stat.mean;
+    stat.mean += delta / stat.count;
+    m2 += delta * (v - stat.mean);
+}
+
+void PulseStats::Accum::bin(double v)
+{
+    const double span = stat.max - stat.min;
+    int slot = span > 0 ? (int)((v - stat.min) / span * Bins) : 0;
+    slot = std::max(0, std::min(slot, (int)Bins - 1));
+    stat.bins[slot]++;
+}
+
+void PulseStats::Accum::finish()
+{
+    stat.stddev = stat.count > 0 ? sqrt(m2 / stat.count) : 0;
+}
+
+PulseStats::PulseStats()
+{
+    _running = false;
+    _cancel = false;
+    _has_pending = false;
+    _exit = false;
+}
+
+PulseStats::~PulseStats()
+{
+    stop();
+}
+
+void PulseStats::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(_pending_mutex);
+        _exit = true;
+        _cancel = true;
+    }
+    _pending_cond.notify_one();
+
+    if (_thread.joinable())
+        _thread.join();
+}
+
+void PulseStats::analyze(LogicSnapshot *snapshot, const std::vector<int> &channels,
+                         uint64_t start, uint64_t end)
+{
+    assert(snapshot);
+
+    Job job;
+    job.snapshot = snapshot;
+    job.generation = snapshot->get_data_generation();
+    job.start = std::min(start, end);
+    job.end = std::max(start, end);
+
+    {
+        std::lock_guard<std::mutex> lock(_cache_mutex);
+
+        // results of an older capture in the same snapshot
+        for (auto it = _cache.begin(); it != _cache.end();) {
+            if (std::get<0>(it->first) == snapshot && std::get<1>(it->first) != job.generation)
+                it = _cache.erase(it);
+            else
+                it++;
+        }
+
+        for (int ch : channels) {
+            CacheKey key(snapshot, job.generation, ch, job.start, job.end);
+            if (_cache.find(key) == _cache.end() && snapshot->has_data(ch))
+                job.channels.push_back(ch);
+        }
+    }
+
+    if (job.channels.empty())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(_pending_mutex);
+        _pending = job;
+        _has_pending = true;
+        _cancel = true;
+        _running = true;
+
+        if (!_thread.joinable())
+            _thread = std::thread(&PulseStats::stats_proc, this);
+    }
+    _pending_cond.notify_one();
+}
+
+bool PulseStats::get_result(LogicSnapshot *snapshot, int channel, uint64_t start, uint64_t end,
+                            Result &result)
+{
+    assert(snapshot);
+
+    CacheKey key(snapshot, snapshot->get_data_generation(), channel,
+                 std::min(start, end), std::max(start, end));
+
+    std::lock_guard<std::mutex> lock(_cache_mutex);
+    auto it = _cache.find(key);
+    if (it == _cache.end())
+        return false;
+
+    result = it->second;
+    return true;
+}
+
+void PulseStats::cancel()
+{
+    std::lock_guard<std::mutex> lock(_pending_mutex);
+    _has_pending = false;
+    _cancel = true;
+}
+
+void PulseStats::drop(LogicSnapshot *snapshot)
+{
+    {
+        std::lock_guard<std::mutex> lock(_pending_mutex);
+        if (_has_pending && _pending.snapshot == snapshot)
+            _has_pending = false;
+        _cancel = true;
+    }
+
+    // the running job lets go of the snapshot
+    std::lock_guard<std::mutex> scan_lock(_scan_mutex);
+
+    std::lock_guard<std::mutex> lock(_cache_mutex);
+    for (auto it = _cache.begin(); it != _cache.end();) {
+        if (std::get<0>(it->first) == snapshot)
+            it = _cache.erase(it);
+        else
+            it++;
+    }
+}
+
+void PulseStats::stats_proc()
+{
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(_pending_mutex);
+            if (!_has_pending)
+                _running = false;
+            _pending_cond.wait(lock, [this]{ return _has_pending || _exit; });
+
+            if (_exit)
+                break;
+
+            job = _pending;
+            _has_pending = false;
+            _cancel = false;
+            _running = true;
+        }
+
+        std::lock_guard<std::mutex> scan_lock(_scan_mutex);
+
+        for (int ch : job.channels) {
+            Accum accums[STAT_COUNT];
+            Result result;
+
+            for (auto &a : accums)
+                a.init();
+            result.channel = ch;
+            result.start = job.start;
+            result.end = job.end;
+            result.rising = 0;
+            result.falling = 0;
+
+            // moments first, they give the span of the bins
+            if (!scan(job, ch, accums, false, result))
+                break;
+            for (auto &a : accums)
+                a.finish();
+            if (!scan(job, ch, accums, true, result))
+                break;
+
+            // the capture changed under the job
+            if (job.snapshot->get_data_generation() != job.generation)
+                break;
+
+            for (int i = 0; i < STAT_COUNT; i++)
+                result.stats[i] = accums[i].stat;
+
+            {
+                std::lock_guard<std::mutex> lock(_cache_mutex);
+                CacheKey key(job.snapshot, job.generation, ch, job.start, job.end);
+                _cache[key] = result;
+            }
+            stats_updated();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_pending_mutex);
+            if (!_has_pending)
+                _running = false;
+        }
+        stats_updated();
+    }
+}
+
+// Walks the edges of one channel, a pulse counts once both of its
+// edges are inside the range. The period and duty cycle are taken
+// from one rising edge to the next.
+bool PulseStats::scan(const Job &job, int channel, Accum *accums, bool binning, Result &result)
+{
+    std::vector<uint64_t> edges;
+    uint64_t index = job.start;
+    bool level = job.snapshot->get_sample(job.start, channel);
+    uint64_t last_edge = 0;
+    uint64_t last_rise = 0;
+    uint64_t high = 0;
+    bool have_edge = false;
+    bool have_rise = false;
+
+    auto feed = [&](int type, double v) {
+        if (binning)
+            accums[type].bin(v);
+        else
+            accums[type].add(v);
+    };
+
+    while (index < job.end) {
+        if (_cancel)
+            return false;
+
+        if (!job.snapshot->get_edges(edges, index, job.end, ChunkEdges, channel))
+            return false;
+        if (edges.empty())
+            break;
+
+        for (uint64_t e : edges) {
+            level = !level;
+
+            if (!binning) {
+                result.rising += level;
+                result.falling += !level;
+            }
+
+            if (have_edge)
+                feed(level ? STAT_LOW : STAT_HIGH, e - last_edge);
+
+            if (level) {
+                if (have_rise && high > 0) {
+                    const uint64_t period = e - last_rise;
+                    feed(STAT_PERIOD, period);
+                    feed(STAT_DUTY, (double)high / period);
+                }
+                last_rise = e;
+                have_rise = true;
+                high = 0;
+            }
+            else if (have_rise) {
+                high = e - last_rise;
+            }
+
+            last_edge = e;
+            have_edge = true;
+        }
+    }
+
+    return true;
+}
+
+} // namespace data
+} // namespace pv
@@ -0,0 +1,160 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2016 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+
+#ifndef DSVIEW_PV_DATA_PULSESTATS_H
+#define DSVIEW_PV_DATA_PULSESTATS_H
+
+#include <stdint.h>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+
+#include <QObject>
+
+namespace pv {
+namespace data {
+
+class LogicSnapshot;
+
+// Pulse width, period and duty cycle statistics of logic channels over
+// a sample range, with a histogram of each. The edges are taken from
+// the snapshot in bulk on a worker thread, results are kept per capture
+// and channel range until the data changes.
+class PulseStats : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum StatType {
+        STAT_HIGH = 0,
+        STAT_LOW,
+        STAT_PERIOD,
+        STAT_DUTY,
+        STAT_COUNT,
+    };
+
+    static const int Bins = 64;
+
+    // widths and periods in samples, duty cycles as 0..1
+    struct Stat
+    {
+        uint64_t count;
+        double min;
+        double max;
+        double mean;
+        double stddev;
+        std::vector<uint64_t> bins;  // Bins slots from min to max
+    };
+
+    struct Result
+    {
+        int channel;
+        uint64_t start;
+        uint64_t end;
+        uint64_t rising;
+        uint64_t falling;
+        Stat stats[STAT_COUNT];
+    };
+
+private:
+    static const uint64_t ChunkEdges = 64 * 1024;
+
+    typedef std::tuple<LogicSnapshot*, uint64_t, int, uint64_t, uint64_t> CacheKey;
+
+    struct Job
+    {
+        LogicSnapshot *snapshot;
+        uint64_t generation;
+        std::vector<int> channels;
+        uint64_t start;
+        uint64_t end;
+    };
+
+    // running moments, then the bins once the span is known
+    struct Accum
+    {
+        double m2;
+        Stat stat;
+
+        void init();
+        void add(double v);
+        void bin(double v);
+        void finish();
+    };
+
+public:
+    PulseStats();
+    ~PulseStats();
+
+    // Queues the channels over [start, end] of a finished capture, a
+    // job that is still waiting or running is dropped. Channels whose
+    // result is cached are left out.
+    void analyze(LogicSnapshot *snapshot, const std::vector<int> &channels,
+                 uint64_t start, uint64_t end);
+
+    bool get_result(LogicSnapshot *snapshot, int channel, uint64_t start, uint64_t end,
+                    Result &result);
+
+    inline bool is_running(){
+        return _running;
+    }
+
+    void cancel();
+
+    // Called before the snapshot's data is freed, waits for a job on it.
+    void drop(LogicSnapshot *snapshot);
+
+signals:
+    void stats_updated();
+
+private:
+    void stats_proc();
+    bool scan(const Job &job, int channel, Accum *accums, bool binning, Result &result);
+    void stop();
+
+private:
+    std::atomic<bool> _running;
+    std::atomic<bool> _cancel;
+
+    // results, guarded by _cache_mutex
+    std::mutex _cache_mutex;
+    std::map<CacheKey, Result> _cache;
+
+    // held by the worker while a job reads a snapshot
+    std::mutex _scan_mutex;
+
+    std::mutex _pending_mutex;
+    std::condition_variable _pending_cond;
+    Job _pending;
+    bool _has_pending;
+    bool _exit;
+    std::thread _thread;
+};
+
+} // namespace data
+} // namespace pv
+
+#endif // DSVIEW_PV_DATA_PULSESTATS_H
@@ -25,10 +25,40 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
+#include <chrono>
  
 namespace pv {
 namespace data {
 
+// The guards the current thread holds, one entry per snapshot
+struct SnapshotGuardEntry
+{
+    Snapshot *s;
+    int depth;
+    bool exclusive;
+};
+
+static thread_local std::vector<SnapshotGuardEntry> tl_guards;
+
+static SnapshotGuardEntry* find_guard(Snapshot *s)
+{
+    for (auto &e : tl_guards) {
+        if (e.s == s)
+            return &e;
+    }
+    return NULL;
+}
+
+static void drop_guard(Snapshot *s)
+{
+    for (auto it = tl_guards.begin(); it != tl_guards.end(); it++) {
+        if (it->s == s) {
+            tl_guards.erase(it);
+            return;
+        }
+    }
+}
+
 Snapshot::Snapshot(int unit_size, uint64_t total_sample_count, unsigned int channel_num)
 {
     assert(unit_size > 0);
@@ -43,11 +73,188 @@ Snapshot::Snapshot(int unit_size, uint64_t total_sample_count, unsigned int chan
     _last_ended = true;
     _unit_bytes = 1;
     _unit_pitch = 0;
+    _data_generation = 0;
+    _pub_seq = 0;
+    _pub_sample_count = 0;
+    _pub_ring_count = 0;
+    _pub_loop_offset = 0;
+    _pub_end = 0;
+    _epoch = 0;
+    _readers[0] = 0;
+    _readers[1] = 0;
+    _exclusive = 0;
+    _exclusive_held = false;
 }
 
 Snapshot::~Snapshot()
 {
     free_data();
+    free_retired();
+}
+
+Snapshot::ReadGuard::ReadGuard(Snapshot *s) :
+    _s(s),
+    _epoch(0),
+    _nested(false)
+{
+    // Waiting for a writer here would wait on the outer guard
+    SnapshotGuardEntry *e = find_guard(s);
+    if (e != NULL) {
+        e->depth++;
+        _nested = true;
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(_s->_guard_mutex);
+        _s->_guard_cond.wait(lock, [this]{ return _s->_exclusive == 0; });
+
+        _epoch = _s->_epoch.load();
+        _s->_readers[_epoch & 1]++;
+    }
+
+    tl_guards.push_back({s, 1, false});
+}
+
+Snapshot::ReadGuard::~ReadGuard()
+{
+    SnapshotGuardEntry *e = find_guard(_s);
+    assert(e != NULL);
+
+    if (_nested) {
+        e->depth--;
+        return;
+    }
+
+    assert(e->depth == 1);
+    drop_guard(_s);
+
+    std::lock_guard<std::mutex> lock(_s->_guard_mutex);
+    _s->_readers[_epoch & 1]--;
+    if (_s->_exclusive > 0)
+        _s->_guard_cond.notify_all();
+}
+
+Snapshot::ExclusiveGuard::ExclusiveGuard(Snapshot *s) :
+    _s(s),
+    _nested(false)
+{
+    SnapshotGuardEntry *e = find_guard(s);
+    if (e != NULL) {
+        // a reader can't become the writer, it would wait on itself
+        assert(e->exclusive);
+        e->depth++;
+        _nested = true;
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(_s->_guard_mutex);
+        // new readers are held off from here on
+        _s->_exclusive++;
+        _s->_guard_cond.wait(lock, [this]{
+            return !_s->_exclusive_held
+                && _s->_readers[0].load() == 0 && _s->_readers[1].load() == 0;
+        });
+        _s->_exclusive_held = true;
+    }
+
+    tl_guards.push_back({s, 1, true});
+    _s->free_retired();
+}
+
+Snapshot::ExclusiveGuard::~ExclusiveGuard()
+{
+    SnapshotGuardEntry *e = find_guard(_s);
+    assert(e != NULL);
+
+    if (_nested) {
+        e->depth--;
+        return;
+    }
+
+    drop_guard(_s);
+
+    std::lock_guard<std::mutex> lock(_s->_guard_mutex);
+    _s->_exclusive_held = false;
+    _s->_exclusive--;
+    _s->_guard_cond.notify_all();
+}
+
+void Snapshot::publish(uint64_t loop_offset)
+{
+    std::lock_guard<std::mutex> lock(_publish_mutex);
+
+    _pub_seq++;
+    _pub_sample_count = _sample_count;
+    _pub_ring_count = _ring_sample_count;
+    _pub_loop_offset = loop_offset;
+    _pub_end = _ring_sample_count + loop_offset;
+    _pub_seq++;
+
+    _data_generation++;
+
+    {
+        std::lock_guard<std::mutex> wait_lock(_wait_mutex);
+    }
+    _wait_cond.notify_all();
+
+    // Memory retired two epochs ago can't be reached by anyone who
+    // entered since, free it once the last reader of that epoch left.
+    const uint64_t epoch = _epoch.load();
+    const int old = (epoch + 1) & 1;
+
+    if (_readers[old].load() == 0) {
+        for (void *p : _retired[old])
+            free(p);
+        _retired[old].clear();
+        _epoch = epoch + 1;
+    }
+}
+
+void Snapshot::retire(void *ptr)
+{
+    std::lock_guard<std::mutex> lock(_publish_mutex);
+    _retired[_epoch.load() & 1].push_back(ptr);
+}
+
+void Snapshot::free_retired()
+{
+    std::lock_guard<std::mutex> lock(_publish_mutex);
+
+    for (int i = 0; i < 2; i++) {
+        for (void *p : _retired[i])
+            free(p);
+        _retired[i].clear();
+    }
+}
+
+void Snapshot::wait_data(uint64_t generation, int timeout_ms)
+{
+    std::unique_lock<std::mutex> lock(_wait_mutex);
+
+    if (_data_generation.load() == generation)
+        _wait_cond.wait_for(lock, std::chrono::milliseconds(timeout_ms));
+}
+
+void Snapshot::wake_waiters()
+{
+    {
+        std::lock_guard<std::mutex> lock(_wait_mutex);
+    }
+    _wait_cond.notify_all();
+}
+
+void Snapshot::read_published(uint64_t &ring_count, uint64_t &loop_offset)
+{
+    uint64_t seq;
+
+    do {
+        seq = _pub_seq.load();
+        ring_count = _pub_ring_count.load();
+        loop_offset = _pub_loop_offset.load();
+    }
+    while ((seq & 1) || seq != _pub_seq.load());
 }
 
 void Snapshot::free_data()
@@ -55,6 +262,7 @@ void Snapshot::free_data()
     _capacity = 0;
     _sample_count = 0;
     _ch_index.clear();
+    publish();
 }
 
 bool Snapshot::empty()
@@ -67,14 +275,12 @@ bool Snapshot::empty()
 
 uint64_t Snapshot::get_sample_count()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    return _sample_count;
+    return _pub_sample_count;
 }
 
 uint64_t Snapshot::get_ring_sample_count()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
-    return _ring_sample_count;
+    return _pub_ring_count;
 }
  
 uint64_t Snapshot::get_ring_start()
@@ -110,6 +316,7 @@ uint64_t Snapshot::ring_end()
 void Snapshot::capture_ended()
 {
     _last_ended = true;
+    _data_generation++;
 }
 
 void Snapshot::set_samplerate(double samplerate)
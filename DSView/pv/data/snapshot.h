@@ -25,6 +25,8 @@
 
 #include <mutex>
 #include <vector>
+#include <atomic>
+#include <condition_variable>
 
 namespace pv {
 namespace data {
@@ -74,17 +76,71 @@ public:
         return _samplerate; 
     }
 
+    // Bumped on every publish, views use it to tell whether
+    // their cached geometry is still valid.
+    inline uint64_t get_data_generation(){
+        return _data_generation;
+    }
+
+    // Blocks until the next publish after the given generation,
+    // a wake_waiters() call, or the timeout.
+    void wait_data(uint64_t generation, int timeout_ms);
+    void wake_waiters();
+
     void set_samplerate(double samplerate);
 
     virtual void capture_ended();
     virtual bool has_data(int index) = 0;
     virtual int get_block_num() = 0;
     virtual uint64_t get_block_size(int block_index) = 0;
+
+    // Readers of published data don't take the data lock. They register
+    // in the current epoch, and writers retire memory instead of freeing
+    // it until no reader of an older epoch is left. A thread may nest
+    // guards of the same snapshot, the inner ones are no-ops, and guards
+    // of different snapshots are counted apart.
+    class ReadGuard
+    {
+    public:
+        explicit ReadGuard(Snapshot *s);
+        ~ReadGuard();
+
+    private:
+        Snapshot   *_s;
+        uint64_t    _epoch;
+        bool        _nested;
+    };
+
+    // Under a read guard, the counts the reader should stick to
+    // until it leaves the guard.
+    void read_published(uint64_t &ring_count, uint64_t &loop_offset);
      
 
 protected:
+    // Waits for all readers to leave and holds new ones off, for
+    // changes that move or free data readers might be walking.
+    class ExclusiveGuard
+    {
+    public:
+        explicit ExclusiveGuard(Snapshot *s);
+        ~ExclusiveGuard();
+
+    private:
+        Snapshot   *_s;
+        bool        _nested;
+    };
+
     virtual void free_data();
 
+    // Writer side, make the current counts visible to readers.
+    void publish(uint64_t loop_offset = 0);
+    void retire(void *ptr);
+
+    // ring count plus loop offset, as last published
+    inline uint64_t published_end(){
+        return _pub_end;
+    }
+
     inline uint64_t sample_count(){
         return _sample_count;
     }
@@ -92,6 +148,8 @@ protected:
     uint64_t ring_start();
     uint64_t ring_end();
 
+    void free_retired();
+
 protected:
     mutable std::mutex  _mutex;  
     mutable std::vector<uint16_t> _ch_index;
@@ -107,6 +165,24 @@ protected:
     bool        _memory_failed;
     bool        _last_ended;
     double      _samplerate;
+    std::atomic<uint64_t> _data_generation;
+
+private:
+    std::mutex  _publish_mutex;
+    std::atomic<uint64_t> _pub_seq;
+    std::atomic<uint64_t> _pub_sample_count;
+    std::atomic<uint64_t> _pub_ring_count;
+    std::atomic<uint64_t> _pub_loop_offset;
+    std::atomic<uint64_t> _pub_end;
+    std::atomic<uint64_t> _epoch;
+    std::atomic<int> _readers[2];
+    int         _exclusive; // writers waiting or holding, under _guard_mutex
+    bool        _exclusive_held;
+    std::mutex  _guard_mutex;
+    std::condition_variable _guard_cond;
+    std::vector<void*> _retired[2];
+    std::mutex  _wait_mutex;
+    std::condition_variable _wait_cond;
 };
 
 } // namespace data
@@ -25,6 +25,8 @@
 #include "../sigsession.h"
 #include "../view/dsosignal.h"
 #include <math.h>
+#include <string.h>
+#include <algorithm>
 
 #define PI 3.1415
 
@@ -34,6 +36,10 @@ using namespace std;
 namespace pv {
 namespace data {
 
+// the fftw planner is not thread safe, the spectrogram jobs
+// make and destroy their plans on other threads
+static std::mutex fftw_plan_mutex;
+
 const QString SpectrumStack::windows_support[5] = {
     QT_TR_NOOP("Rectangle"),
     QT_TR_NOOP("Hann"),
@@ -50,31 +56,43 @@ const uint64_t SpectrumStack::length_support[5] = {
     16384,
 };
 
+const uint64_t SpectrumStack::SpectrogramTileRows = 256;
+const uint64_t SpectrumStack::SpectrogramRowFrames = 4;
+const uint64_t SpectrumStack::SpectrogramCacheBytes = 64 * 1024 * 1024;
+
 SpectrumStack::SpectrumStack(pv::SigSession *session, int index) :
     _session(session),
     _index(index),
     _dc_ignore(true),
     _sample_interval(1),
     _spectrum_state(Init),
-    _fft_plan(NULL)
+    _fft_plan(NULL),
+    _spectrogram_en(false),
+    _sg_workers(0)
 {
 }
 
 SpectrumStack::~SpectrumStack()
 {
+    stop_spectrogram();
+
     _xn.clear();
     _xk.clear();
     _power_spectrum.clear();
-    if (_fft_plan)
+    if (_fft_plan) {
+        std::lock_guard<std::mutex> lock(fftw_plan_mutex);
         fftw_destroy_plan(_fft_plan);
+    }
 }
 
 void SpectrumStack::clear()
 {
+    init();
 }
 
 void SpectrumStack::init()
 {
+    stop_spectrogram();
 }
 
 int SpectrumStack::get_index()
@@ -93,6 +111,8 @@ void SpectrumStack::set_sample_num(uint64_t num)
     _xn.resize(_sample_num);
     _xk.resize(_sample_num);
     _power_spectrum.resize(_sample_num/2+1);
+
+    std::lock_guard<std::mutex> lock(fftw_plan_mutex);
     _fft_plan = fftw_plan_r2r_1d(_sample_num, _xn.data(), _xk.data(),
                                  FFTW_R2HC, FFTW_ESTIMATE);
 }
@@ -217,6 +237,9 @@ void SpectrumStack::calc_fft()
          _power_spectrum[_sample_num/2] = abs(_xk[_sample_num/2])/wsum;  /* Nyquist freq. */
 
     _spectrum_state = Stopped;
+
+    if (_spectrogram_en)
+        update_spectrogram(data, dsoSig);
 }
 
 double SpectrumStack::window(uint64_t i, int type)
@@ -237,5 +260,403 @@ double SpectrumStack::window(uint64_t i, int type)
     }
 }
 
+static inline uint8_t spectrogram_cell(double mag)
+{
+    if (mag <= 0)
+        return 0;
+
+    const double v = 20*log10(mag) - SpectrumStack::SpectrogramDbFloor;
+    if (v <= 0)
+        return 0;
+    if (v >= 255)
+        return 255;
+    return (uint8_t)(v + 0.5);
+}
+
+// a tile is keyed by it's level in the top byte and it's index below
+static inline uint64_t spectrogram_key(int level, uint64_t tile)
+{
+    return ((uint64_t)level << 56) | tile;
+}
+
+static inline int spectrogram_key_level(uint64_t key)
+{
+    return (int)(key >> 56);
+}
+
+static inline uint64_t spectrogram_key_tile(uint64_t key)
+{
+    return key & ~(~0ULL << 56);
+}
+
+void SpectrumStack::set_spectrogram_enable(bool enable)
+{
+    _spectrogram_en = enable;
+    if (enable)
+        start_spectrogram();
+    else
+        init();
+}
+
+bool SpectrumStack::spectrogram_enabled()
+{
+    return _spectrogram_en;
+}
+
+SpectrumStack::SpectrogramJob::SpectrogramJob() :
+    snapshot(NULL),
+    generation(0),
+    sample_num(0),
+    interval(1),
+    windows_index(0),
+    offset(0),
+    vscale(0),
+    hop(0),
+    frames(0),
+    levels(1),
+    wsum(1),
+    plan(NULL),
+    use_clock(0),
+    running(0),
+    stop(false)
+{
+}
+
+SpectrumStack::SpectrogramJob::~SpectrogramJob()
+{
+    if (plan) {
+        std::lock_guard<std::mutex> lock(fftw_plan_mutex);
+        fftw_destroy_plan(plan);
+    }
+}
+
+void SpectrumStack::start_spectrogram()
+{
+    if (!_spectrogram_en || _sample_num == 0)
+        return;
+
+    pv::data::DsoSnapshot *data = NULL;
+    pv::view::DsoSignal *dsoSig = NULL;
+
+    for(auto s : _session->get_signals()) {
+        if (s->signal_type() == SR_CHANNEL_DSO) {
+            dsoSig = (view::DsoSignal*)s;
+            if (dsoSig->get_index() == _index && dsoSig->enabled()) {
+                data = dsoSig->data();
+                break;
+            }
+        }
+    }
+
+    if (data == NULL || data->empty())
+        return;
+
+    update_spectrogram(data, dsoSig);
+}
+
+bool SpectrumStack::same_spectrogram_params(const SpectrogramJob *a, const SpectrogramJob *b)
+{
+    return a->sample_num == b->sample_num &&
+           a->interval == b->interval &&
+           a->windows_index == b->windows_index &&
+           a->offset == b->offset &&
+           a->vscale == b->vscale;
+}
+
+void SpectrumStack::update_spectrogram(DsoSnapshot *data, pv::view::DsoSignal *dsoSig)
+{
+    // Short-time FFT over the whole capture with 50% overlapped frames.
+    // Nothing is computed here, the view asks for the tiles it shows.
+    const uint64_t win_len = _sample_num * _sample_interval;
+    const uint64_t sample_count = data->get_sample_count();
+    if (_sample_num < 2 || sample_count < win_len)
+        return;
+
+    std::shared_ptr<SpectrogramJob> job(new SpectrogramJob());
+    job->snapshot = data;
+    job->generation = data->get_data_generation();
+    job->sample_num = _sample_num;
+    job->interval = _sample_interval;
+    job->windows_index = _windows_index;
+    job->offset = dsoSig->get_hw_offset();
+    job->vscale = dsoSig->get_vDialValue() * dsoSig->get_factor() * DS_CONF_DSO_VDIVS / (1000*255.0);
+
+    // calc_fft() runs for every payload, the same frame is not done twice
+    {
+        std::lock_guard<std::mutex> lock(_sg_mutex);
+        const SpectrogramJob *last = _sg_job.get();
+        if (last && last->snapshot == job->snapshot && last->generation == job->generation
+            && same_spectrogram_params(last, job.get()))
+            return;
+    }
+
+    job->hop = std::max(win_len / 2, (uint64_t)1);
+    job->frames = (sample_count - win_len) / job->hop + 1;
+    while (((job->frames - 1) >> (job->levels - 1)) >= SpectrogramTileRows)
+        job->levels++;
+
+    job->window.resize(job->sample_num);
+    job->wsum = 0;
+    for (uint64_t i = 0; i < job->sample_num; i++) {
+        job->window[i] = window(i, job->windows_index);
+        job->wsum += job->window[i];
+    }
+    if (job->wsum == 0)
+        job->wsum = 1;
+
+    // The plan is shared by all workers, each of them executes it on
+    // it's own buffers by fftw_execute_r2r().
+    {
+        std::vector<double> xn(job->sample_num);
+        std::vector<double> xk(job->sample_num);
+        std::lock_guard<std::mutex> lock(fftw_plan_mutex);
+        job->plan = fftw_plan_r2r_1d(job->sample_num, xn.data(), xk.data(),
+                                     FFTW_R2HC, FFTW_ESTIMATE | FFTW_UNALIGNED);
+    }
+    if (job->plan == NULL)
+        return;
+
+    std::lock_guard<std::mutex> lock(_sg_mutex);
+
+    if (_sg_job) {
+        _sg_job->stop = true;
+        if (!_sg_job->tiles.empty())
+            _sg_prev = _sg_job;
+    }
+
+    // the overview is always there to fall back to
+    job->queue.push_back(spectrogram_key(job->levels - 1, 0));
+    _sg_job = job;
+    run_spectrogram(job);
+}
+
+// Called with _sg_mutex held. The workers are detached, so the
+// caller never waits for a job it replaces.
+void SpectrumStack::run_spectrogram(std::shared_ptr<SpectrogramJob> job)
+{
+    int worker_num = std::max((int)std::thread::hardware_concurrency(), 1);
+    worker_num = std::min(worker_num, (int)job->queue.size());
+
+    while (job->running < worker_num) {
+        job->running++;
+        _sg_workers++;
+        std::thread(&SpectrumStack::spectrogram_proc, this, job).detach();
+    }
+}
+
+void SpectrumStack::stop_spectrogram()
+{
+    std::unique_lock<std::mutex> lock(_sg_mutex);
+
+    if (_sg_job)
+        _sg_job->stop = true;
+
+    _sg_cond.wait(lock, [this]{ return _sg_workers == 0; });
+
+    _sg_job.reset();
+    _sg_prev.reset();
+}
+
+void SpectrumStack::spectrogram_proc(std::shared_ptr<SpectrogramJob> job)
+{
+    std::vector<double> xn(job->sample_num);
+    std::vector<double> xk(job->sample_num);
+    std::vector<uint8_t> samples(job->sample_num);
+
+    std::unique_lock<std::mutex> lock(_sg_mutex);
+
+    while (!job->stop && !job->queue.empty()) {
+        const uint64_t key = job->queue.front();
+        job->queue.pop_front();
+        if (job->tiles.count(key) || job->busy.count(key))
+            continue;
+
+        job->busy.insert(key);
+        lock.unlock();
+
+        SpectrogramTile tile;
+        const bool ret = calc_spectrogram_tile(job.get(), key, tile, xn, xk, samples);
+
+        lock.lock();
+        job->busy.erase(key);
+
+        // the frame has been rewritten, a new job is on the way
+        if (!ret)
+            job->stop = true;
+        if (job->stop)
+            break;
+
+        tile.used = ++job->use_clock;
+        job->tiles[key] = std::move(tile);
+        evict_spectrogram_tiles(job.get());
+
+        lock.unlock();
+        spectrogram_updated();
+        lock.lock();
+    }
+
+    job->running--;
+    job.reset();
+
+    _sg_workers--;
+    _sg_cond.notify_all();
+}
+
+bool SpectrumStack::calc_spectrogram_tile(SpectrogramJob *job, uint64_t key, SpectrogramTile &tile,
+                                          std::vector<double> &xn, std::vector<double> &xk,
+                                          std::vector<uint8_t> &samples)
+{
+    const int level = spectrogram_key_level(key);
+    const uint64_t n = job->sample_num;
+    const uint64_t bins = n / 2;
+    const uint64_t level_rows = ((job->frames - 1) >> level) + 1;
+    const uint64_t first = spectrogram_key_tile(key) * SpectrogramTileRows;
+
+    tile.rows = first < level_rows ? std::min(SpectrogramTileRows, level_rows - first) : 0;
+    tile.cells.assign(tile.rows * bins, 0);
+
+    for (uint64_t row = 0; row < tile.rows; row++) {
+        const uint64_t f0 = (first + row) << level;
+        const uint64_t span = std::min((uint64_t)1 << level, job->frames - f0);
+        const uint64_t picks = std::min(span, SpectrogramRowFrames);
+        uint8_t *dest = &tile.cells[row * bins];
+
+        for (uint64_t pick = 0; pick < picks; pick++) {
+            if (job->stop)
+                return true;
+
+            // Only one frame is copied at a time, the dso buffers are
+            // rewritten in place by the next capture.
+            const uint64_t f = f0 + pick * span / picks;
+            if (!job->snapshot->copy_samples(job->generation, _index, f * job->hop,
+                                             n, job->interval, samples.data()))
+                return false;
+
+            for (uint64_t i = 0; i < n; i++)
+                xn[i] = (samples[i] - job->offset) * job->vscale * job->window[i];
+
+            fftw_execute_r2r(job->plan, xn.data(), xk.data());
+
+            uint8_t v = spectrogram_cell(fabs(xk[0]) / job->wsum);
+            if (v > dest[0])
+                dest[0] = v;
+            for (uint64_t k = 1; k < bins; k++) {
+                v = spectrogram_cell(sqrt((xk[k]*xk[k] + xk[n-k]*xk[n-k]) * 2) / job->wsum);
+                if (v > dest[k])
+                    dest[k] = v;
+            }
+        }
+    }
+
+    return true;
+}
+
+// Called with _sg_mutex held, the least recently shown tiles go
+// first and the overview is kept.
+void SpectrumStack::evict_spectrogram_tiles(SpectrogramJob *job)
+{
+    const uint64_t tile_bytes = SpectrogramTileRows * std::max(job->sample_num / 2, (uint64_t)1);
+    const uint64_t max_tiles = std::max(SpectrogramCacheBytes / tile_bytes, (uint64_t)8);
+    const uint64_t top = spectrogram_key(job->levels - 1, 0);
+
+    while (job->tiles.size() > max_tiles) {
+        auto lru = job->tiles.end();
+        for (auto it = job->tiles.begin(); it != job->tiles.end(); it++) {
+            if (it->first != top && (lru == job->tiles.end() || it->second.used < lru->second.used))
+                lru = it;
+        }
+        if (lru == job->tiles.end())
+            break;
+        job->tiles.erase(lru);
+    }
+}
+
+void SpectrumStack::lock_spectrogram()
+{
+    _sg_mutex.lock();
+}
+
+void SpectrumStack::unlock_spectrogram()
+{
+    _sg_mutex.unlock();
+}
+
+uint64_t SpectrumStack::get_spectrogram_frames()
+{
+    return _sg_job ? _sg_job->frames : 0;
+}
+
+uint64_t SpectrumStack::get_spectrogram_bins()
+{
+    return _sg_job ? _sg_job->sample_num / 2 : 0;
+}
+
+uint64_t SpectrumStack::get_spectrogram_hop()
+{
+    return _sg_job ? _sg_job->hop : 0;
+}
+
+int SpectrumStack::get_spectrogram_levels()
+{
+    return _sg_job ? _sg_job->levels : 0;
+}
+
+int SpectrumStack::get_spectrogram_level(double frames_per_row)
+{
+    int level = 0;
+    const int levels = get_spectrogram_levels();
+    while (level + 1 < levels && (double)(1ULL << (level + 1)) <= frames_per_row)
+        level++;
+    return level;
+}
+
+void SpectrumStack::request_spectrogram_tiles(int level, uint64_t first_tile, uint64_t last_tile)
+{
+    if (!_sg_job || _sg_job->stop)
+        return;
+
+    SpectrogramJob *job = _sg_job.get();
+    level = std::max(std::min(level, job->levels - 1), 0);
+
+    job->queue.clear();
+    const uint64_t top = spectrogram_key(job->levels - 1, 0);
+    if (!job->tiles.count(top) && !job->busy.count(top))
+        job->queue.push_back(top);
+
+    for (uint64_t i = first_tile; i <= last_tile; i++) {
+        const uint64_t key = spectrogram_key(level, i);
+        if (!job->tiles.count(key) && !job->busy.count(key))
+            job->queue.push_back(key);
+    }
+
+    run_spectrogram(_sg_job);
+}
+
+const uint8_t* SpectrumStack::get_spectrogram_tile(int level, uint64_t tile, uint64_t &rows)
+{
+    if (!_sg_job)
+        return NULL;
+
+    const uint64_t key = spectrogram_key(level, tile);
+
+    for (SpectrogramJob *job : {_sg_job.get(), _sg_prev.get()}) {
+        if (job == NULL)
+            continue;
+        // the last frame's tiles only stand in for the same layout
+        if (job != _sg_job.get() && !(same_spectrogram_params(job, _sg_job.get())
+            && job->frames == _sg_job->frames && job->hop == _sg_job->hop))
+            continue;
+
+        auto it = job->tiles.find(key);
+        if (it != job->tiles.end() && it->second.rows > 0) {
+            it->second.used = ++job->use_clock;
+            rows = it->second.rows;
+            return it->second.cells.data();
+        }
+    }
+
+    return NULL;
+}
+
 } // namespace data
 } // namespace pv
@@ -25,6 +25,15 @@
 #include "signaldata.h"
 
 #include <list>
+#include <map>
+#include <set>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <condition_variable>
 
 #include <boost/optional.hpp> 
   
@@ -53,6 +62,55 @@ private:
     static const QString windows_support[5];
     static const uint64_t length_support[5];
 
+public:
+    // The spectrogram is a pyramid of tiles, a row of level l peaks the
+    // base frames [r << l, (r + 1) << l), tiles hold SpectrogramTileRows rows.
+    static const uint64_t SpectrogramTileRows;
+    // zoomed out rows take the peak of at most this many frames
+    static const uint64_t SpectrogramRowFrames;
+    static const uint64_t SpectrogramCacheBytes;
+    // cells are quantized as (dB - SpectrogramDbFloor) with 1dB step
+    static const int SpectrogramDbFloor = -200;
+
+private:
+    struct SpectrogramTile
+    {
+        std::vector<uint8_t> cells; // rows * bins
+        uint64_t rows;
+        uint64_t used; // lru stamp
+    };
+
+    // the tiles of one frame with one set of settings
+    struct SpectrogramJob
+    {
+        // what the result is made of
+        DsoSnapshot *snapshot;
+        uint64_t generation;
+        uint64_t sample_num;
+        int interval;
+        int windows_index;
+        int offset;
+        double vscale;
+
+        uint64_t hop;
+        uint64_t frames;
+        int levels;
+        std::vector<double> window;
+        double wsum;
+        fftw_plan plan;
+
+        // under _sg_mutex
+        std::map<uint64_t, SpectrogramTile> tiles;
+        std::deque<uint64_t> queue;
+        std::set<uint64_t> busy;
+        uint64_t use_clock;
+        int running;
+        std::atomic<bool> stop;
+
+        SpectrogramJob();
+        ~SpectrogramJob();
+    };
+
 public:
     enum spectrum_state {
         Init,
@@ -90,7 +148,40 @@ public:
 
     double window(uint64_t i, int type);
 
+    void set_spectrogram_enable(bool enable);
+    bool spectrogram_enabled();
+    void start_spectrogram();
+    void stop_spectrogram();
+
+    /**
+     * Locks the result, the calls below must be made with the
+     * lock held and the cells are valid until unlock_spectrogram().
+     */
+    void lock_spectrogram();
+    void unlock_spectrogram();
+    uint64_t get_spectrogram_frames();
+    uint64_t get_spectrogram_bins();
+    uint64_t get_spectrogram_hop();
+    int get_spectrogram_levels();
+    // the coarsest level which still has a row per frames_per_row frames
+    int get_spectrogram_level(double frames_per_row);
+    // queues the missing tiles of a level, the earlier requests are dropped
+    void request_spectrogram_tiles(int level, uint64_t first_tile, uint64_t last_tile);
+    // NULL until the tile is done, the last frame's tile is given meanwhile
+    const uint8_t* get_spectrogram_tile(int level, uint64_t tile, uint64_t &rows);
+
 signals:
+    void spectrogram_updated();
+
+private:
+    void update_spectrogram(DsoSnapshot *data, pv::view::DsoSignal *dsoSig);
+    void run_spectrogram(std::shared_ptr<SpectrogramJob> job);
+    void spectrogram_proc(std::shared_ptr<SpectrogramJob> job);
+    bool calc_spectrogram_tile(SpectrogramJob *job, uint64_t key, SpectrogramTile &tile,
+                               std::vector<double> &xn, std::vector<double> &xk,
+                               std::vector<uint8_t> &samples);
+    void evict_spectrogram_tiles(SpectrogramJob *job);
+    static bool same_spectrogram_params(const SpectrogramJob *a, const SpectrogramJob *b);
 
 private:
     pv::SigSession *_session;
@@ -106,6 +197,15 @@ private:
     std::vector<double> _xn;
     std::vector<double> _xk;
     std::vector<double> _power_spectrum;
+
+    bool _spectrogram_en;
+    // the tiles of the current frame, and the ones of the last
+    // frame which are shown until they are replaced
+    std::shared_ptr<SpectrogramJob> _sg_job;
+    std::shared_ptr<SpectrogramJob> _sg_prev;
+    int _sg_workers; // detached worker threads alive, under _sg_mutex
+    std::condition_variable _sg_cond;
+    std::mutex _sg_mutex;
 };
 
 } // namespace data
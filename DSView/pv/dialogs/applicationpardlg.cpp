@@ -31,6 +31,7 @@
 #include <QLabel>
 #include <vector>
 #include <QGridLayout>
+#include <QSpinBox>
 
 #include "../config/appconfig.h"
 #include "../ui/langresource.h"
@@ -124,6 +125,20 @@ bool ApplicationParamDlg::ShowDlg(QWidget *parent)
     QCheckBox *ck_abortData = new QCheckBox();
     ck_abortData->setChecked(app.appOptions.swapBackBufferAlways);
 
+    QSpinBox *sbHistoryFrames = new QSpinBox();
+    sbHistoryFrames->setRange(0, 256);
+    sbHistoryFrames->setValue(app.appOptions.historyFrames);
+
+    QSpinBox *sbHistoryMemory = new QSpinBox();
+    sbHistoryMemory->setRange(16, 65536);
+    sbHistoryMemory->setSuffix(" MB");
+    sbHistoryMemory->setValue(app.appOptions.historyMemory);
+
+    QComboBox *cbHistoryEvict = new DsComboBox();
+    cbHistoryEvict->addItem(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_HISTORY_EVICT_OLDEST), "Oldest first"));
+    cbHistoryEvict->addItem(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_HISTORY_EVICT_LARGEST), "Largest first"));
+    cbHistoryEvict->setCurrentIndex(app.appOptions.historyEvict == HISTORY_EVICT_LARGEST ? 1 : 0);
+
     QComboBox *ftCbSize = new DsComboBox();
     ftCbSize->setFixedWidth(50);
     bind_font_size_list(ftCbSize, app.appOptions.fontSize);
@@ -137,6 +152,12 @@ bool ApplicationParamDlg::ShowDlg(QWidget *parent)
     logicLay->addWidget(ck_quickScroll, 0, 1, Qt::AlignRight);
     logicLay->addWidget(new QLabel(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_USE_ABORT_DATA_REPEAT), "Used abort data")), 1, 0, Qt::AlignLeft); 
     logicLay->addWidget(ck_abortData, 1, 1, Qt::AlignRight);
+    logicLay->addWidget(new QLabel(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_HISTORY_FRAMES), "History frames")), 2, 0, Qt::AlignLeft);
+    logicLay->addWidget(sbHistoryFrames, 2, 1, Qt::AlignRight);
+    logicLay->addWidget(new QLabel(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_HISTORY_MEMORY), "History memory")), 3, 0, Qt::AlignLeft);
+    logicLay->addWidget(sbHistoryMemory, 3, 1, Qt::AlignRight);
+    logicLay->addWidget(new QLabel(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_HISTORY_EVICT), "History eviction")), 4, 0, Qt::AlignLeft);
+    logicLay->addWidget(cbHistoryEvict, 4, 1, Qt::AlignRight);
     lay->addWidget(logicGroup);
 
     //Scope group
@@ -186,6 +207,18 @@ bool ApplicationParamDlg::ShowDlg(QWidget *parent)
             app.appOptions.swapBackBufferAlways = ck_abortData->isChecked();
             bAppChanged = true;
         }        
+        if (app.appOptions.historyFrames != sbHistoryFrames->value()){
+            app.appOptions.historyFrames = sbHistoryFrames->value();
+            bAppChanged = true;
+        }
+        if (app.appOptions.historyMemory != sbHistoryMemory->value()){
+            app.appOptions.historyMemory = sbHistoryMemory->value();
+            bAppChanged = true;
+        }
+        if (app.appOptions.historyEvict != cbHistoryEvict->currentIndex()){
+            app.appOptions.historyEvict = cbHistoryEvict->currentIndex();
+            bAppChanged = true;
+        }
         if (app.appOptions.fontSize != fSize){
             app.appOptions.fontSize = fSize;
             bFontChanged = true;
@@ -0,0 +1,155 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2016 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include "binaryview.h"
+
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QFile>
+#include <QFileInfo>
+#include <QFileDialog>
+
+#include "../sigsession.h"
+#include "../data/decoderstack.h"
+#include "../data/decodermodel.h"
+#include "../data/decode/binarydata.h"
+#include "../config/appconfig.h"
+#include "../utility/path.h"
+#include "../log.h"
+#include "../ui/langresource.h"
+
+namespace pv {
+namespace dialogs {
+
+BinaryView::BinaryView(QWidget *parent, SigSession *session) :
+    DSDialog(parent),
+    _session(session),
+    _button_box(QDialogButtonBox::Ok,
+        Qt::Horizontal, this)
+{
+    _output_combobox = new DsComboBox(this);
+    _export_button = new QPushButton(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_EXPORT), "Export"), this);
+
+    const auto decoder_stack = _session->get_decoder_model()->getDecoderStack();
+    if (decoder_stack) {
+        decoder_stack->get_binary_outputs(_outputs);
+    }
+
+    for (auto &o : _outputs) {
+        _output_combobox->addItem(o.first);
+    }
+    _export_button->setEnabled(!_outputs.empty());
+
+    QHBoxLayout *hlayout = new QHBoxLayout();
+    hlayout->addWidget(_output_combobox, 1);
+    hlayout->addWidget(_export_button);
+
+    _table_view = new QTableView(this);
+    _table_view->setModel(&_model);
+    _table_view->setShowGrid(false);
+    _table_view->setFont(QFont("Courier New"));
+    _table_view->verticalHeader()->hide();
+    _table_view->horizontalHeader()->setStretchLastSection(true);
+    _table_view->setMinimumSize(640, 400);
+
+    QVBoxLayout *vlayout = new QVBoxLayout();
+    vlayout->addLayout(hlayout);
+    vlayout->addWidget(_table_view);
+    vlayout->addWidget(&_button_box);
+
+    layout()->addLayout(vlayout);
+    setTitle(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_BINARY_OUTPUT), "Binary Output"));
+
+    connect(_output_combobox, SIGNAL(currentIndexChanged(int)), this, SLOT(on_output_changed(int)));
+    connect(_export_button, SIGNAL(clicked()), this, SLOT(on_export()));
+    connect(&_button_box, SIGNAL(accepted()), this, SLOT(accept()));
+    connect(_session->device_event_object(), SIGNAL(device_updated()), this, SLOT(reject()));
+
+    on_output_changed(_output_combobox->currentIndex());
+}
+
+void BinaryView::on_output_changed(int index)
+{
+    if (index >= 0 && index < (int)_outputs.size())
+        _model.setBinaryData(_outputs[index].second);
+    else
+        _model.setBinaryData(NULL);
+
+    _table_view->resizeColumnToContents(0);
+    _table_view->resizeColumnToContents(1);
+}
+
+void BinaryView::on_export()
+{
+    int index = _output_combobox->currentIndex();
+    if (index < 0 || index >= (int)_outputs.size())
+        return;
+
+    AppConfig &app = AppConfig::Instance();
+    QString default_name = app.userHistory.protocolExportPath + "/" + "decoder-";
+    default_name += _session->get_session_time().toString("-yyMMdd-hhmmss");
+
+    QString file_name = QFileDialog::getSaveFileName(
+        this,
+        L_S(STR_PAGE_DLG, S_ID(IDS_DLG_EXPORT_DATA), "Export Data"),
+        default_name, "Binary files (*.bin)");
+
+    if (file_name == ""){
+        return;
+    }
+
+    QFileInfo f(file_name);
+    if (f.suffix().compare("bin"))
+        file_name += ".bin";
+
+    QString fname = path::GetDirectoryName(file_name);
+    if (fname != app.userHistory.protocolExportPath)
+    {
+        app.userHistory.protocolExportPath = fname;
+        app.SaveHistory();
+    }
+
+    QFile file(file_name);
+    if (!file.open(QIODevice::WriteOnly)){
+        dsv_err("Failed to create file:%s", file_name.toUtf8().data());
+        return;
+    }
+
+    //copy the kept bytes out in blocks
+    data::decode::BinaryData *binary_data = _outputs[index].second;
+    uint64_t offset = binary_data->get_first_offset();
+    char buf[64 * 1024];
+    uint64_t len;
+
+    while ((len = binary_data->read(offset, (unsigned char*)buf, sizeof(buf))) > 0)
+    {
+        if (file.write(buf, len) != (qint64)len){
+            dsv_err("Failed to write file:%s", file_name.toUtf8().data());
+            break;
+        }
+        offset += len;
+    }
+
+    file.close();
+}
+
+} // namespace dialogs
+} // namespace pv
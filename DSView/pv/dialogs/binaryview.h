@@ -0,0 +1,74 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2016 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#ifndef DSVIEW_PV_BINARYVIEW_H
+#define DSVIEW_PV_BINARYVIEW_H
+
+#include <QDialogButtonBox>
+#include <QVBoxLayout>
+#include <QTableView>
+#include <QPushButton>
+#include <QString>
+#include <vector>
+
+#include "dsdialog.h"
+#include "../ui/dscombobox.h"
+#include "../data/binarymodel.h"
+
+namespace pv {
+
+class SigSession;
+
+namespace data {
+namespace decode {
+class BinaryData;
+}
+}
+
+namespace dialogs {
+
+//browses the binary outputs of the current decoder as hex, and saves them to file
+class BinaryView : public DSDialog
+{
+    Q_OBJECT
+
+public:
+    BinaryView(QWidget *parent, SigSession *session);
+
+private slots:
+    void on_output_changed(int index);
+    void on_export();
+
+private:
+    SigSession *_session;
+
+    DsComboBox *_output_combobox;
+    QTableView *_table_view;
+    QPushButton *_export_button;
+    QDialogButtonBox _button_box;
+    data::BinaryModel _model;
+    std::vector<std::pair<QString, data::decode::BinaryData*>> _outputs;
+};
+
+} // namespace dialogs
+} // namespace pv
+
+#endif // DSVIEW_PV_BINARYVIEW_H
@@ -0,0 +1,307 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2016 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include "capturehistory.h"
+
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+#include <QHeaderView>
+#include <QFuture>
+#include <QProgressDialog>
+#include <QtConcurrent/QtConcurrent>
+#include <vector>
+#include <assert.h>
+
+#include "search.h"
+#include "../sigsession.h"
+#include "../data/logicsnapshot.h"
+#include "../data/decoderstack.h"
+#include "../view/decodetrace.h"
+#include "../ui/langresource.h"
+#include "../ui/msgbox.h"
+
+namespace pv {
+namespace dialogs {
+
+enum HistoryColumn
+{
+    COL_FRAME = 0,
+    COL_TIME,
+    COL_SAMPLES,
+    COL_MEMORY,
+    COL_SEARCH,
+    COL_ANNOTATIONS,
+    COL_COUNT,
+};
+
+static QString memory_text(uint64_t bytes)
+{
+    if (bytes >= 1024 * 1024)
+        return QString::number(bytes / (1024.0 * 1024.0), 'f', 2) + " MB";
+    return QString::number(bytes / 1024.0, 'f', 1) + " KB";
+}
+
+CaptureHistory::CaptureHistory(SigSession *session, QWidget *parent) :
+    DSDialog(parent),
+    _session(session)
+{
+    _decode_row = -1;
+
+    setMinimumSize(640, 360);
+
+    _table = new QTableWidget(this);
+    _table->setColumnCount(COL_COUNT);
+    _table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    _table->setSelectionMode(QAbstractItemView::SingleSelection);
+    _table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    _table->verticalHeader()->hide();
+    _table->horizontalHeader()->setStretchLastSection(true);
+
+    _memory_label = new QLabel(this);
+    _prev_button = new QPushButton(this);
+    _next_button = new QPushButton(this);
+    _search_button = new QPushButton(this);
+    _decode_button = new QPushButton(this);
+    _close_button = new QPushButton(this);
+
+    QHBoxLayout *hlayout = new QHBoxLayout();
+    hlayout->addWidget(_prev_button);
+    hlayout->addWidget(_next_button);
+    hlayout->addWidget(_search_button);
+    hlayout->addWidget(_decode_button);
+    hlayout->addStretch(1);
+    hlayout->addWidget(_memory_label);
+    hlayout->addWidget(_close_button);
+
+    QVBoxLayout *vlayout = new QVBoxLayout();
+    vlayout->addWidget(_table);
+    vlayout->addLayout(hlayout);
+    layout()->addLayout(vlayout);
+
+    connect(_table, SIGNAL(itemSelectionChanged()), this, SLOT(on_row_changed()));
+    connect(_prev_button, SIGNAL(clicked()), this, SLOT(on_prev()));
+    connect(_next_button, SIGNAL(clicked()), this, SLOT(on_next()));
+    connect(_search_button, SIGNAL(clicked()), this, SLOT(on_search_all()));
+    connect(_decode_button, SIGNAL(clicked()), this, SLOT(on_decode_all()));
+    connect(_close_button, SIGNAL(clicked()), this, SLOT(accept()));
+    connect(&_decode_timer, SIGNAL(timeout()), this, SLOT(on_decode_timeout()));
+
+    retranslateUi();
+    load_frames();
+}
+
+void CaptureHistory::changeEvent(QEvent *event)
+{
+    if (event->type() == QEvent::LanguageChange)
+        retranslateUi();
+    DSDialog::changeEvent(event);
+}
+
+void CaptureHistory::retranslateUi()
+{
+    QStringList headers;
+    headers << L_S(STR_PAGE_DLG, S_ID(IDS_DLG_HISTORY_FRAME), "Frame")
+            << L_S(STR_PAGE_DLG, S_ID(IDS_DLG_HISTORY_TIME), "Time")
+            << L_S(STR_PAGE_DLG, S_ID(IDS_DLG_HISTORY_SAMPLES), "Samples")
+            << L_S(STR_PAGE_DLG, S_ID(IDS_DLG_HISTORY_MEMORY_USED), "Memory")
+            << L_S(STR_PAGE_DLG, S_ID(IDS_DLG_HISTORY_SEARCH_RESULT), "Search")
+            << L_S(STR_PAGE_DLG, S_ID(IDS_DLG_HISTORY_ANNOTATIONS), "Annotations");
+    _table->setHorizontalHeaderLabels(headers);
+
+    _prev_button->setText(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_HISTORY_PREV), "Previous"));
+    _next_button->setText(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_HISTORY_NEXT), "Next"));
+    _search_button->setText(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_HISTORY_SEARCH_ALL), "Search all"));
+    _decode_button->setText(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_HISTORY_DECODE_ALL), "Decode all"));
+    _close_button->setText(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_CLOSE), "Close"));
+    setTitle(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_CAPTURE_HISTORY), "Capture History"));
+}
+
+// History frames first, the latest capture is the last row
+int CaptureHistory::row_to_index(int row)
+{
+    return row == _session->get_history_count() ? -1 : row;
+}
+
+int CaptureHistory::index_to_row(int index)
+{
+    return index == -1 ? _session->get_history_count() : index;
+}
+
+void CaptureHistory::load_frames()
+{
+    int count = _session->get_history_count();
+
+    _table->blockSignals(true);
+    _table->setRowCount(count + 1);
+
+    for (int row = 0; row <= count; row++){
+        SessionData *data = _session->get_history_frame(row_to_index(row));
+        assert(data);
+
+        QString name = row == count ?
+                L_S(STR_PAGE_DLG, S_ID(IDS_DLG_HISTORY_LATEST), "Latest")
+                : QString::number(row + 1);
+
+        _table->setItem(row, COL_FRAME, new QTableWidgetItem(name));
+        _table->setItem(row, COL_TIME,
+                new QTableWidgetItem(data->_trig_time.toString("hh:mm:ss.zzz")));
+        _table->setItem(row, COL_SAMPLES,
+                new QTableWidgetItem(QString::number(data->get_logic()->get_sample_count())));
+        _table->setItem(row, COL_MEMORY,
+                new QTableWidgetItem(memory_text(data->get_memory_size())));
+        _table->setItem(row, COL_SEARCH, new QTableWidgetItem(""));
+        _table->setItem(row, COL_ANNOTATIONS, new QTableWidgetItem(""));
+    }
+
+    _table->selectRow(index_to_row(_session->get_history_view_index()));
+    _table->blockSignals(false);
+
+    QString strMem(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_HISTORY_TOTAL), "Total"));
+    _memory_label->setText(strMem + ": " + memory_text(_session->get_history_memory()));
+
+    bool bIdle = !_session->is_working();
+    _prev_button->setEnabled(bIdle);
+    _next_button->setEnabled(bIdle);
+    _search_button->setEnabled(bIdle);
+    _decode_button->setEnabled(bIdle && _session->get_decode_signals().size() > 0);
+}
+
+void CaptureHistory::on_row_changed()
+{
+    int row = _table->currentRow();
+    if (row < 0 || _decode_timer.isActive())
+        return;
+
+    if (!_session->show_history_frame(row_to_index(row))){
+        _table->blockSignals(true);
+        _table->selectRow(index_to_row(_session->get_history_view_index()));
+        _table->blockSignals(false);
+    }
+}
+
+void CaptureHistory::on_prev()
+{
+    int row = index_to_row(_session->get_history_view_index());
+    if (row > 0)
+        _table->selectRow(row - 1);
+}
+
+void CaptureHistory::on_next()
+{
+    int row = index_to_row(_session->get_history_view_index());
+    if (row < _table->rowCount() - 1)
+        _table->selectRow(row + 1);
+}
+
+void CaptureHistory::on_search_all()
+{
+    if (_session->is_working())
+        return;
+
+    Search dlg(this, _session, _pattern);
+    if (!dlg.exec())
+        return;
+
+    _pattern = dlg.get_pattern();
+    for (auto& iter : _pattern) {
+        iter.second.remove(QChar(' '), Qt::CaseInsensitive);
+        iter.second = iter.second.toUpper();
+    }
+
+    int rows = _table->rowCount();
+    std::vector<int64_t> hits(rows, -1);
+
+    // The frames do not change while the capture is stopped
+    QFuture<void> future;
+    future = QtConcurrent::run([&]{
+        for (int row = 0; row < rows; row++){
+            data::LogicSnapshot *logic = _session->get_history_frame(row_to_index(row))->get_logic();
+            if (logic->empty())
+                continue;
+
+            int64_t index = 0;
+            const int64_t end = logic->get_sample_count() - 1;
+            if (logic->pattern_search(0, end, index, _pattern, true))
+                hits[row] = index;
+        }
+    });
+
+    Qt::WindowFlags flags = Qt::CustomizeWindowHint;
+    QProgressDialog progress(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_HISTORY_SEARCHING), "Searching frames..."),
+                        L_S(STR_PAGE_DLG, S_ID(IDS_DLG_CANCEL), "Cancel"),0,0,this,flags);
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setWindowFlags(Qt::Dialog | Qt::FramelessWindowHint | Qt::WindowSystemMenuHint |
+                       Qt::WindowMinimizeButtonHint | Qt::WindowMaximizeButtonHint);
+    progress.setCancelButton(NULL);
+
+    QFutureWatcher<void> watcher;
+    connect(&watcher,SIGNAL(finished()),&progress,SLOT(cancel()));
+    watcher.setFuture(future);
+    progress.exec();
+    future.waitForFinished();
+
+    QString strNone(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_HISTORY_NOT_FOUND), "Not found"));
+
+    for (int row = 0; row < rows; row++){
+        QString text = hits[row] == -1 ? strNone : QString::number(hits[row]);
+        _table->item(row, COL_SEARCH)->setText(text);
+    }
+}
+
+void CaptureHistory::on_decode_all()
+{
+    if (_session->is_working() || _decode_timer.isActive())
+        return;
+
+    _decode_row = 0;
+    _table->setEnabled(false);
+    _decode_button->setEnabled(false);
+    _session->show_history_frame(row_to_index(_decode_row));
+    _decode_timer.start(100);
+}
+
+// One frame at a time, the decoders run on the frame being shown
+void CaptureHistory::on_decode_timeout()
+{
+    if (_session->is_decoding())
+        return;
+
+    uint64_t total = 0;
+    for (auto de : _session->get_decode_signals()){
+        total += de->decoder()->list_annotation_size();
+    }
+    _table->item(_decode_row, COL_ANNOTATIONS)->setText(QString::number(total));
+
+    _decode_row++;
+
+    if (_decode_row >= _table->rowCount() || _session->is_working()){
+        _decode_timer.stop();
+        _table->setEnabled(true);
+        _decode_button->setEnabled(true);
+        _table->selectRow(_decode_row - 1);
+        return;
+    }
+
+    _session->show_history_frame(row_to_index(_decode_row));
+}
+
+} // namespace dialogs
+} // namespace pv
@@ -0,0 +1,85 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2016 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+
+#ifndef DSVIEW_PV_CAPTUREHISTORY_H
+#define DSVIEW_PV_CAPTUREHISTORY_H
+
+#include <QGridLayout>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QLabel>
+#include <QTimer>
+#include <QString>
+#include <map>
+
+#include "dsdialog.h"
+
+namespace pv {
+
+class SigSession;
+
+namespace dialogs {
+
+// Browse the frames kept by repeat mode, one row per frame
+class CaptureHistory : public DSDialog
+{
+	Q_OBJECT
+
+public:
+    CaptureHistory(SigSession *session, QWidget *parent);
+
+private:
+    void changeEvent(QEvent *event);
+    void retranslateUi();
+
+    void load_frames();
+    int row_to_index(int row);
+    int index_to_row(int index);
+
+private slots:
+    void on_row_changed();
+    void on_prev();
+    void on_next();
+    void on_search_all();
+    void on_decode_all();
+    void on_decode_timeout();
+
+private:
+    SigSession *_session;
+
+    QTableWidget *_table;
+    QLabel *_memory_label;
+    QPushButton *_prev_button;
+    QPushButton *_next_button;
+    QPushButton *_search_button;
+    QPushButton *_decode_button;
+    QPushButton *_close_button;
+
+    QTimer _decode_timer;
+    int _decode_row;
+    std::map<uint16_t, QString> _pattern;
+};
+
+} // namespace dialogs
+} // namespace pv
+
+#endif // DSVIEW_PV_CAPTUREHISTORY_H
@@ -0,0 +1,175 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2016 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+
+#include "eyeoptions.h"
+
+#include <QLabel>
+#include <QVariant>
+#include <algorithm>
+
+#include "../sigsession.h"
+#include "../data/eyestack.h"
+#include "../view/dsosignal.h"
+#include "../view/eyetrace.h"
+#include "../view/mathtrace.h"
+#include "../ui/langresource.h"
+
+using namespace pv::data;
+
+namespace pv {
+namespace dialogs {
+
+EyeOptions::EyeOptions(SigSession *session, QWidget *parent) :
+    DSDialog(parent),
+    _session(session),
+    _button_box(QDialogButtonBox::Ok | QDialogButtonBox::Cancel,
+        Qt::Horizontal, this)
+{
+    setMinimumSize(300, 260);
+
+    _enable = new QCheckBox(this);
+    _data_combobox = new DsComboBox(this);
+    _clock_combobox = new DsComboBox(this);
+    _clock_ch_combobox = new DsComboBox(this);
+
+    for(auto s : _session->get_signals()) {
+        if (s->signal_type() == SR_CHANNEL_DSO) {
+            view::DsoSignal *dsoSig = (view::DsoSignal*)s;
+            _data_combobox->addItem(dsoSig->get_name(), QVariant::fromValue(dsoSig->get_index()));
+            _clock_ch_combobox->addItem(dsoSig->get_name(), QVariant::fromValue(dsoSig->get_index()));
+        }
+    }
+
+    _clock_combobox->addItem(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_EYE_CLOCK_RECOVERED), "Recovered"),
+                             QVariant::fromValue((int)EyeStack::CLOCK_RECOVERED));
+    _clock_combobox->addItem(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_EYE_CLOCK_FIXED), "Fixed bit rate"),
+                             QVariant::fromValue((int)EyeStack::CLOCK_FIXED));
+    _clock_combobox->addItem(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_EYE_CLOCK_CHANNEL), "Clock channel"),
+                             QVariant::fromValue((int)EyeStack::CLOCK_CHANNEL));
+
+    // 0 lets the recovered clock find the bit rate
+    _bitrate = new QDoubleSpinBox(this);
+    _bitrate->setRange(0, 1000000);
+    _bitrate->setDecimals(3);
+    _bitrate->setSuffix(" kbps");
+
+    _mask_width = new QDoubleSpinBox(this);
+    _mask_width->setRange(0, 1);
+    _mask_width->setSingleStep(0.05);
+    _mask_width->setSuffix(" UI");
+    _mask_width->setValue(0.4);
+
+    _mask_height = new QDoubleSpinBox(this);
+    _mask_height->setRange(0, 1);
+    _mask_height->setSingleStep(0.05);
+    _mask_height->setValue(0.4);
+
+    auto eye = _session->get_eye_trace();
+    if (eye) {
+        EyeStack *eye_stack = eye->get_eye_stack();
+        _enable->setChecked(eye->enabled());
+        _data_combobox->setCurrentIndex(std::max(_data_combobox->findData(eye_stack->data_index()), 0));
+        _clock_combobox->setCurrentIndex(eye_stack->clock_mode());
+        _clock_ch_combobox->setCurrentIndex(std::max(_clock_ch_combobox->findData(eye_stack->clock_index()), 0));
+        _bitrate->setValue(eye_stack->bitrate() / 1000);
+        _mask_width->setValue(eye_stack->mask_width());
+        _mask_height->setValue(eye_stack->mask_height());
+    }
+    else {
+        _enable->setChecked(false);
+        _clock_ch_combobox->setCurrentIndex(_clock_ch_combobox->count() > 1 ? 1 : 0);
+    }
+    clock_changed(_clock_combobox->currentIndex());
+
+    _glayout = new QGridLayout();
+    _glayout->setVerticalSpacing(5);
+    _glayout->addWidget(new QLabel(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_ENABLE), "Enable"), this), 0, 0);
+    _glayout->addWidget(_enable, 0, 1);
+    _glayout->addWidget(new QLabel(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_EYE_DATA_SOURCE), "Data Source: "), this), 1, 0);
+    _glayout->addWidget(_data_combobox, 1, 1);
+    _glayout->addWidget(new QLabel(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_EYE_CLOCK), "Clock: "), this), 2, 0);
+    _glayout->addWidget(_clock_combobox, 2, 1);
+    _glayout->addWidget(new QLabel(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_EYE_CLOCK_SOURCE), "Clock Source: "), this), 3, 0);
+    _glayout->addWidget(_clock_ch_combobox, 3, 1);
+    _glayout->addWidget(new QLabel(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_EYE_BITRATE), "Bit rate: "), this), 4, 0);
+    _glayout->addWidget(_bitrate, 4, 1);
+    _glayout->addWidget(new QLabel(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_EYE_MASK_WIDTH), "Mask Width: "), this), 5, 0);
+    _glayout->addWidget(_mask_width, 5, 1);
+    _glayout->addWidget(new QLabel(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_EYE_MASK_HEIGHT), "Mask Height: "), this), 6, 0);
+    _glayout->addWidget(_mask_height, 6, 1);
+
+    _layout = new QVBoxLayout();
+    _layout->addLayout(_glayout);
+    _layout->addWidget(&_button_box);
+
+    layout()->addLayout(_layout);
+    setTitle(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_EYE_OPTIONS), "Eye Diagram Options"));
+
+    connect(&_button_box, SIGNAL(accepted()), this, SLOT(accept()));
+    connect(&_button_box, SIGNAL(rejected()), this, SLOT(reject()));
+    connect(_clock_combobox, SIGNAL(currentIndexChanged(int)), this, SLOT(clock_changed(int)));
+    connect(_session->device_event_object(), SIGNAL(device_updated()), this, SLOT(reject()));
+}
+
+void EyeOptions::clock_changed(int index)
+{
+    const int mode = _clock_combobox->itemData(index).toInt();
+    _clock_ch_combobox->setEnabled(mode == EyeStack::CLOCK_CHANNEL);
+    _bitrate->setEnabled(mode != EyeStack::CLOCK_CHANNEL);
+}
+
+void EyeOptions::accept()
+{
+    using namespace Qt;
+    QDialog::accept();
+
+    const int mode = _clock_combobox->currentData().toInt();
+    const int data_index = _data_combobox->currentData().toInt();
+    const int clock_index = _clock_ch_combobox->currentData().toInt();
+
+    bool enable = _enable->isChecked() && _data_combobox->count() > 0;
+    if (mode == EyeStack::CLOCK_CHANNEL && clock_index == data_index)
+        enable = false;
+
+    _session->eye_rebuild(enable, data_index, clock_index, mode, _bitrate->value() * 1000,
+                          _mask_width->value(), _mask_height->value());
+
+    for(auto s : _session->get_signals()) {
+        if (s->signal_type() == SR_CHANNEL_DSO) {
+            view::DsoSignal *dsoSig = (view::DsoSignal*)s;
+            dsoSig->set_show(!enable);
+        }
+    }
+    auto mathTrace = _session->get_math_trace();
+    if (mathTrace && mathTrace->enabled()) {
+        mathTrace->set_show(!enable);
+    }
+}
+
+void EyeOptions::reject()
+{
+    using namespace Qt;
+    QDialog::reject();
+}
+
+} // namespace dialogs
+} // namespace pv
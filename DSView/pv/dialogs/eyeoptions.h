@@ -0,0 +1,74 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2016 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+
+
+#ifndef DSVIEW_PV_EYEOPTIONS_H
+#define DSVIEW_PV_EYEOPTIONS_H
+
+#include <QDialogButtonBox>
+#include <QGridLayout>
+#include <QVBoxLayout>
+#include <QCheckBox>
+#include <QDoubleSpinBox>
+
+#include "dsdialog.h"
+#include "../ui/dscombobox.h"
+
+namespace pv {
+
+class SigSession;
+
+namespace dialogs {
+
+class EyeOptions : public DSDialog
+{
+    Q_OBJECT
+
+public:
+    EyeOptions(SigSession *session, QWidget *parent);
+
+protected:
+    void accept();
+    void reject();
+
+private slots:
+    void clock_changed(int index);
+
+private:
+    SigSession *_session;
+
+    QCheckBox *_enable;
+    DsComboBox *_data_combobox;
+    DsComboBox *_clock_combobox;
+    DsComboBox *_clock_ch_combobox;
+    QDoubleSpinBox *_bitrate;
+    QDoubleSpinBox *_mask_width;
+    QDoubleSpinBox *_mask_height;
+    QGridLayout *_glayout;
+    QVBoxLayout *_layout;
+    QDialogButtonBox _button_box;
+};
+
+} // namespace dialogs
+} // namespace pv
+
+#endif // DSVIEW_PV_EYEOPTIONS_H
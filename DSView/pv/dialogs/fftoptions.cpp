@@ -132,7 +132,7 @@ FftOptions::FftOptions(QWidget *parent, SigSession *session) :
             QVariant::fromValue(i));
     }
     assert(_view_combobox->count() > 0);
-    _view_combobox->setCurrentIndex(_view_combobox->count()-1);
+    _view_combobox->setCurrentIndex(pv::view::SpectrumTrace::DbvRMS);
     for (unsigned int i = 0; i < dbv_ranges.size(); i++)
     {
         _dbv_combobox->addItem(QString::number(dbv_ranges[i]),
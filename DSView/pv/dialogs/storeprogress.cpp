@@ -28,6 +28,8 @@
 #include <QTextEdit>
 #include <QPushButton>
 #include <QRadioButton>
+#include <QCheckBox>
+#include <QLabel>
 #include "../ui/msgbox.h"
 #include "../config/appconfig.h"
 #include "../interface/icallbacks.h"
@@ -44,6 +46,7 @@ StoreProgress::StoreProgress(SigSession *session, QWidget *parent) :
 {
     _fileLab = NULL;
     _ckOrigin = NULL;
+    _ckAnnotation = NULL;
 
     this->setMinimumSize(550, 220);
     this->setModal(true);
@@ -77,9 +80,13 @@ StoreProgress::StoreProgress(SigSession *session, QWidget *parent) :
     _space->setMinimumHeight(80);
     _space->setVisible(false);
 
+    _speedLab = new QLabel(this);
+    _speedLab->setVisible(false);
+
     grid->addWidget(&_progress, 0, 0, 1, 4);
     grid->addWidget(_fileLab, 1, 0, 1, 3);
     grid->addWidget(_openButton, 1, 3, 1, 1);    
+    grid->addWidget(_speedLab, 2, 0, 1, 2);
     grid->addWidget(_space);
 
     QDialogButtonBox  *_button_box = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, 
@@ -114,15 +121,24 @@ StoreProgress::~StoreProgress()
 
     if (file != ""){
         _fileLab->setText(file); 
-
-        if (_ckOrigin != NULL){
-            bool bFlag = file.endsWith(".csv");
-            _ckOrigin->setVisible(bFlag);
-            _ckCompress->setVisible(bFlag);
-        }
+        update_options(file);
     }          
  }
 
+// The data options of the chosen export format.
+void StoreProgress::update_options(const QString &file)
+{
+    if (_ckOrigin != NULL){
+        bool bFlag = file.endsWith(".csv");
+        _ckOrigin->setVisible(bFlag);
+        _ckCompress->setVisible(bFlag);
+    }
+
+    if (_ckAnnotation != NULL){
+        _ckAnnotation->setVisible(file.endsWith(".dscol"));
+    }
+}
+
 void StoreProgress::reject()
 {
     using namespace Qt;
@@ -142,6 +158,9 @@ void StoreProgress::accept()
 
     if (_isBusy)
         return;
+
+    _store_session.set_export_annotations(_ckAnnotation != NULL
+                && _ckAnnotation->isVisible() && _ckAnnotation->isChecked());
     
      _progress.setVisible(true);
      _fileLab->setVisible(false);     
@@ -152,6 +171,9 @@ void StoreProgress::accept()
         _ckOrigin->setVisible(false);
         _ckCompress->setVisible(false);
      }
+     if (_ckAnnotation != NULL){
+        _ckAnnotation->setVisible(false);
+     }
      _space->setVisible(true);
 
 
@@ -168,6 +190,8 @@ void StoreProgress::accept()
     if (_isExport){
         if (_store_session.export_start()){
             _isBusy = true;
+            _elapsed.start();
+            _speedLab->setVisible(true);
             _store_session.session()->set_saving(true);
             QTimer::singleShot(100, this, SLOT(timeout()));
             setTitle(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_EXPORTING), "Exporting..."));    
@@ -235,6 +259,13 @@ void StoreProgress::export_run()
 
         lay->addWidget(_ckOrigin);
         lay->addWidget(_ckCompress);
+
+        if (_store_session.session()->get_decode_signals().size() > 0){
+            _ckAnnotation = new QCheckBox();
+            _ckAnnotation->setText(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_EXPORT_ANNOTATIONS), "Decoder annotations"));
+            _ckAnnotation->setChecked(true);
+            lay->addWidget(_ckAnnotation);
+        }
         _grid->addLayout(lay, 2, 0, 1, 2);
 
         connect(_ckOrigin, SIGNAL(clicked(bool)), this, SLOT(on_ck_origin(bool)));
@@ -245,12 +276,7 @@ void StoreProgress::export_run()
     setTitle(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_EXPORT), "Export"));
     QString file = _store_session.MakeExportFile(false);
     _fileLab->setText(file); 
-
-     if (_ckOrigin != NULL){
-            bool bFlag = file.endsWith(".csv");
-            _ckOrigin->setVisible(bFlag);
-            _ckCompress->setVisible(bFlag);
-     }
+    update_options(file);
 
     show();
 }
@@ -278,6 +304,16 @@ void StoreProgress::on_progress_updated()
     int percent = p.first * 1.0 / p.second * 100;
     _progress.setValue(percent);
 
+    // Throughput of the export file.
+    if (_isExport && _elapsed.isValid()){
+        qint64 ms = _elapsed.elapsed();
+        if (ms > 0){
+            double speed = _store_session.bytes_stored() / 1048576.0 * 1000.0 / ms;
+            _speedLab->setText(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_EXPORT_SPEED), "Speed")
+                                + QString(": %1 MB/s").arg(speed, 0, 'f', 1));
+        }
+    }
+
     const QString err = _store_session.error();
 	if (!err.isEmpty()) {
 		show_error();
@@ -24,15 +24,18 @@
 #define DSVIEW_PV_DIALOGS_SAVEPROGRESS_H
  
 #include <QProgressBar>
+#include <QElapsedTimer>
 #include "../storesession.h"
 #include "../dialogs/dsdialog.h" 
 #include "../interface/icallbacks.h"
 
 class QTextEdit;
 class QRadioButton;
+class QCheckBox;
 class QGridLayout;
 class QPushButton;
 class QWidget;
+class QLabel;
 
 namespace pv {
 
@@ -57,6 +60,7 @@ protected:
 
 private:
 	void show_error();
+    void update_options(const QString &file);
     void closeEvent(QCloseEvent* e);
 
 signals:
@@ -81,9 +85,12 @@ private:
     QTextEdit           *_fileLab;
     QRadioButton        *_ckOrigin;
     QRadioButton        *_ckCompress;
+    QCheckBox           *_ckAnnotation;
     QPushButton         *_openButton;
     QGridLayout         *_grid;
     QWidget             *_space;
+    QLabel              *_speedLab;
+    QElapsedTimer        _elapsed;
     bool                 _isBusy;
 };
 
@@ -0,0 +1,125 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2016 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include "triggermarks.h"
+
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+
+#include "../sigsession.h"
+#include "../data/logicsnapshot.h"
+#include "../view/view.h"
+#include "../view/ruler.h"
+#include "../ui/langresource.h"
+
+namespace pv {
+namespace dialogs {
+
+TriggerMarks::TriggerMarks(QWidget *parent, view::View &view, SigSession *session,
+                           const std::vector<uint64_t> &positions) :
+    DSDialog(parent),
+    _view(view),
+    _session(session),
+    _positions(positions)
+{
+    setMinimumSize(320, 400);
+
+    _list = new QListWidget(this);
+    _list->setSelectionMode(QAbstractItemView::SingleSelection);
+
+    const uint64_t samplerate = _session->cur_snap_samplerate();
+    for (size_t i = 0; i < _positions.size(); i++) {
+        QString text = QString::number(i + 1) + "\t"
+                     + view::Ruler::format_real_time(_positions[i], samplerate);
+        _list->addItem(text);
+    }
+
+    _count_label = new QLabel(this);
+    _prev_button = new QPushButton(this);
+    _next_button = new QPushButton(this);
+    _close_button = new QPushButton(this);
+
+    QHBoxLayout *hlayout = new QHBoxLayout();
+    hlayout->addWidget(_prev_button);
+    hlayout->addWidget(_next_button);
+    hlayout->addStretch(1);
+    hlayout->addWidget(_close_button);
+
+    QVBoxLayout *vlayout = new QVBoxLayout();
+    vlayout->addWidget(_count_label);
+    vlayout->addWidget(_list);
+    vlayout->addLayout(hlayout);
+    layout()->addLayout(vlayout);
+
+    connect(_list, SIGNAL(currentRowChanged(int)), this, SLOT(on_row_changed(int)));
+    connect(_prev_button, SIGNAL(clicked()), this, SLOT(on_prev()));
+    connect(_next_button, SIGNAL(clicked()), this, SLOT(on_next()));
+    connect(_close_button, SIGNAL(clicked()), this, SLOT(accept()));
+
+    retranslateUi();
+    _list->setCurrentRow(0);
+}
+
+void TriggerMarks::changeEvent(QEvent *event)
+{
+    if (event->type() == QEvent::LanguageChange)
+        retranslateUi();
+    DSDialog::changeEvent(event);
+}
+
+void TriggerMarks::retranslateUi()
+{
+    QString strCount(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_TRIGGER_POSITIONS_FOUND), "Positions found"));
+    strCount += ": " + QString::number(_positions.size());
+    if (_positions.size() >= data::LogicSnapshot::TriggerMaxHits)
+        strCount += "+";
+    _count_label->setText(strCount);
+
+    _prev_button->setText(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_HISTORY_PREV), "Previous"));
+    _next_button->setText(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_HISTORY_NEXT), "Next"));
+    _close_button->setText(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_CLOSE), "Close"));
+    setTitle(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_TRIGGER_MARKS), "Trigger Positions"));
+}
+
+void TriggerMarks::on_row_changed(int row)
+{
+    if (row < 0 || row >= (int)_positions.size())
+        return;
+
+    _view.set_search_pos(_positions[row], true);
+}
+
+void TriggerMarks::on_prev()
+{
+    int row = _list->currentRow();
+    if (row > 0)
+        _list->setCurrentRow(row - 1);
+}
+
+void TriggerMarks::on_next()
+{
+    int row = _list->currentRow();
+    if (row < _list->count() - 1)
+        _list->setCurrentRow(row + 1);
+}
+
+} // namespace dialogs
+} // namespace pv
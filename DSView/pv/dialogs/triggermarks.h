@@ -0,0 +1,77 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2016 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+
+#ifndef DSVIEW_PV_TRIGGERMARKS_H
+#define DSVIEW_PV_TRIGGERMARKS_H
+
+#include <QPushButton>
+#include <QListWidget>
+#include <QLabel>
+#include <vector>
+#include <stdint.h>
+
+#include "dsdialog.h"
+
+namespace pv {
+
+class SigSession;
+
+namespace view {
+class View;
+}
+
+namespace dialogs {
+
+// The positions found by the software trigger, one entry per hit
+class TriggerMarks : public DSDialog
+{
+	Q_OBJECT
+
+public:
+    TriggerMarks(QWidget *parent, view::View &view, SigSession *session,
+                 const std::vector<uint64_t> &positions);
+
+private:
+    void changeEvent(QEvent *event);
+    void retranslateUi();
+
+private slots:
+    void on_row_changed(int row);
+    void on_prev();
+    void on_next();
+
+private:
+    view::View &_view;
+    SigSession *_session;
+    std::vector<uint64_t> _positions;
+
+    QListWidget *_list;
+    QLabel *_count_label;
+    QPushButton *_prev_button;
+    QPushButton *_next_button;
+    QPushButton *_close_button;
+};
+
+} // namespace dialogs
+} // namespace pv
+
+#endif // DSVIEW_PV_TRIGGERMARKS_H
@@ -31,6 +31,7 @@
 #include "../view/logicsignal.h"
 #include "../data/signaldata.h"
 #include "../data/snapshot.h" 
+#include "../data/logicsnapshot.h"
 #include "../dialogs/dsdialog.h"
 #include "../dialogs/dsmessagebox.h"
 #include "../config/appconfig.h"
@@ -38,6 +39,7 @@
 #include "../ui/msgbox.h"
 #include <QObject>
 #include <QPainter> 
+#include <QHeaderView>
 #include "../appcontrol.h"
 #include "../ui/fn.h"
 #include "../log.h"
@@ -49,6 +51,75 @@ namespace dock {
 
 using namespace pv::view;
 
+enum StatsColumn
+{
+    STATS_CHANNEL = 0,
+    STATS_TYPE,
+    STATS_COUNT,
+    STATS_MIN,
+    STATS_MAX,
+    STATS_MEAN,
+    STATS_STDDEV,
+    STATS_COLUMNS,
+};
+
+enum SummaryColumn
+{
+    SUMMARY_CHANNEL = 0,
+    SUMMARY_HIGH,
+    SUMMARY_LOW,
+    SUMMARY_DUTY,
+    SUMMARY_EDGES,
+    SUMMARY_RATE,
+    SUMMARY_COLUMNS,
+};
+
+static const int StatsHistHeight = 60;
+
+// Ruler prefix 0 is femto
+static QString stats_time_text(double samples, double samplerate)
+{
+    if (samples <= 0 || samplerate <= 0)
+        return "0";
+
+    const double t = samples / samplerate;
+    const int prefix = std::max(0, std::min((int)floor((log10(t) + 15) / 3), 8));
+    return Ruler::format_time(t, prefix).mid(1);
+}
+
+static QString stats_rate_text(double rate)
+{
+    static const char *prefixes[] = {"", "k", "M", "G"};
+    int i = 0;
+
+    while (rate >= 1000 && i < 3) {
+        rate /= 1000;
+        i++;
+    }
+    return QString::number(rate, 'f', 2) + prefixes[i] + "/s";
+}
+
+static QString stats_value_text(int type, double v, double samplerate)
+{
+    if (type == data::PulseStats::STAT_DUTY)
+        return QString::number(v * 100, 'f', 2) + "%";
+    return stats_time_text(v, samplerate);
+}
+
+static QString stats_type_text(int type)
+{
+    switch (type) {
+    case data::PulseStats::STAT_HIGH:
+        return L_S(STR_PAGE_DLG, S_ID(IDS_DLG_STATS_HIGH), "High");
+    case data::PulseStats::STAT_LOW:
+        return L_S(STR_PAGE_DLG, S_ID(IDS_DLG_STATS_LOW), "Low");
+    case data::PulseStats::STAT_PERIOD:
+        return L_S(STR_PAGE_DLG, S_ID(IDS_DLG_STATS_PERIOD), "Period");
+    default:
+        return L_S(STR_PAGE_DLG, S_ID(IDS_DLG_STATS_DUTY), "Duty");
+    }
+}
+
 MeasureDock::MeasureDock(QWidget *parent, View &view, SigSession *session) :
     QScrollArea(parent),
     _session(session),
@@ -120,6 +191,69 @@ MeasureDock::MeasureDock(QWidget *parent, View &view, SigSession *session) :
     _edge_layout->setColumnStretch(1, 50);
     _edge_groupBox->setLayout(_edge_layout);
 
+    /* pulse statistics group */
+    _stats_groupBox = new QGroupBox(_widget);
+    _stats_groupBox->setMinimumWidth(300);
+    _stats_box = create_probe_selector(_widget);
+    _stats_box->insertItem(0, L_S(STR_PAGE_DLG, S_ID(IDS_DLG_STATS_ALL), "All"));
+    _stats_box->setCurrentIndex(0);
+    _stats_btn = new QPushButton(_widget);
+
+    _stats_row.cursor1 = -1;
+    _stats_row.cursor2 = -1;
+    _stats_row.box = _stats_box;
+    _stats_row.del_bt = NULL;
+    _stats_row.start_bt = new QPushButton(" ", _widget);
+    _stats_row.end_bt = new QPushButton(" ", _widget);
+    _stats_row.r_label = NULL;
+
+    QLabel cal_lb;
+    cal_lb.setFont(font());
+    int bt_w = cal_lb.fontMetrics().horizontalAdvance("22") + 8;
+    _stats_row.start_bt->setFixedWidth(bt_w);
+    _stats_row.end_bt->setFixedWidth(bt_w);
+    set_cursor_btn_color(_stats_row.start_bt);
+    set_cursor_btn_color(_stats_row.end_bt);
+
+    _summary_table = new QTableWidget(_widget);
+    _summary_table->setColumnCount(SUMMARY_COLUMNS);
+    _summary_table->setSelectionMode(QAbstractItemView::NoSelection);
+    _summary_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    _summary_table->verticalHeader()->hide();
+    _summary_table->horizontalHeader()->setStretchLastSection(true);
+    _summary_table->setMinimumHeight(120);
+
+    _stats_table = new QTableWidget(_widget);
+    _stats_table->setColumnCount(STATS_COLUMNS);
+    _stats_table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    _stats_table->setSelectionMode(QAbstractItemView::SingleSelection);
+    _stats_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    _stats_table->verticalHeader()->hide();
+    _stats_table->horizontalHeader()->setStretchLastSection(true);
+    _stats_table->setMinimumHeight(150);
+    _stats_hist = new QLabel(_widget);
+    _stats_hist->setFixedHeight(StatsHistHeight);
+    _stats_info = new QLabel(_widget);
+
+    QHBoxLayout *stats_row_layout = new QHBoxLayout();
+    stats_row_layout->setSpacing(0);
+    stats_row_layout->addWidget(_stats_row.start_bt);
+    stats_row_layout->addWidget(new QLabel("-", _widget));
+    stats_row_layout->addWidget(_stats_row.end_bt);
+    stats_row_layout->addWidget(new QLabel("@", _widget));
+    stats_row_layout->addWidget(_stats_box);
+    stats_row_layout->addStretch(1);
+    stats_row_layout->addWidget(_stats_btn);
+
+    QVBoxLayout *stats_layout = new QVBoxLayout();
+    stats_layout->setSpacing(5);
+    stats_layout->addLayout(stats_row_layout);
+    stats_layout->addWidget(_summary_table);
+    stats_layout->addWidget(_stats_table);
+    stats_layout->addWidget(_stats_hist);
+    stats_layout->addWidget(_stats_info);
+    _stats_groupBox->setLayout(stats_layout);
+
     /* cursors group */
     _time_label = new QLabel(_widget);
     _cursor_groupBox = new QGroupBox(_widget);
@@ -134,6 +268,7 @@ MeasureDock::MeasureDock(QWidget *parent, View &view, SigSession *session) :
     layout->addWidget(_mouse_groupBox);
     layout->addWidget(_dist_groupBox);
     layout->addWidget(_edge_groupBox);
+    layout->addWidget(_stats_groupBox);
     layout->addWidget(_cursor_groupBox);
     layout->addStretch(1);
     _widget->setLayout(layout);
@@ -150,6 +285,12 @@ MeasureDock::MeasureDock(QWidget *parent, View &view, SigSession *session) :
     connect(_edge_add_btn, SIGNAL(clicked()), this, SLOT(add_edge_measure()));
     connect(_fen_checkBox, SIGNAL(stateChanged(int)), &_view, SLOT(set_measure_en(int)));
     connect(&_view, SIGNAL(measure_updated()), this, SLOT(measure_updated()));
+    connect(_stats_row.start_bt, SIGNAL(clicked()), this, SLOT(show_all_coursor()));
+    connect(_stats_row.end_bt, SIGNAL(clicked()), this, SLOT(show_all_coursor()));
+    connect(_stats_box, SIGNAL(currentIndexChanged(int)), this, SLOT(update_stats()));
+    connect(_stats_btn, SIGNAL(clicked()), this, SLOT(analyze_stats()));
+    connect(_stats_table, SIGNAL(itemSelectionChanged()), this, SLOT(draw_stats_hist()));
+    connect(_session->get_pulse_stats(), SIGNAL(stats_updated()), this, SLOT(update_stats()));
 
     update_font();
 }
@@ -174,6 +315,28 @@ void MeasureDock::retranslateUi()
     _dist_groupBox->setTitle(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_CURSOR_DISTANCE), "Cursor Distance"));
     _edge_groupBox->setTitle(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_EDGES), "Edges"));
     _cursor_groupBox->setTitle(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_CURSORS), "Cursors"));
+    _stats_groupBox->setTitle(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_PULSE_STATS), "Pulse Statistics"));
+    _stats_box->setItemText(0, L_S(STR_PAGE_DLG, S_ID(IDS_DLG_STATS_ALL), "All"));
+
+    QStringList headers;
+    headers << L_S(STR_PAGE_DLG, S_ID(IDS_DLG_CHANNEL), "Channel")
+            << L_S(STR_PAGE_DLG, S_ID(IDS_DLG_STATS_TYPE), "Type")
+            << L_S(STR_PAGE_DLG, S_ID(IDS_DLG_STATS_COUNT), "Count")
+            << L_S(STR_PAGE_DLG, S_ID(IDS_DLG_STATS_MIN), "Min")
+            << L_S(STR_PAGE_DLG, S_ID(IDS_DLG_STATS_MAX), "Max")
+            << L_S(STR_PAGE_DLG, S_ID(IDS_DLG_STATS_MEAN), "Mean")
+            << L_S(STR_PAGE_DLG, S_ID(IDS_DLG_STATS_STDDEV), "Std dev");
+    _stats_table->setHorizontalHeaderLabels(headers);
+
+    headers.clear();
+    headers << L_S(STR_PAGE_DLG, S_ID(IDS_DLG_CHANNEL), "Channel")
+            << L_S(STR_PAGE_DLG, S_ID(IDS_DLG_STATS_HIGH_TIME), "High time")
+            << L_S(STR_PAGE_DLG, S_ID(IDS_DLG_STATS_LOW_TIME), "Low time")
+            << L_S(STR_PAGE_DLG, S_ID(IDS_DLG_STATS_DUTY), "Duty")
+            << L_S(STR_PAGE_DLG, S_ID(IDS_DLG_STATS_EDGE_COUNT), "Edges")
+            << L_S(STR_PAGE_DLG, S_ID(IDS_DLG_STATS_EDGE_RATE), "Edges/s");
+    _summary_table->setHorizontalHeaderLabels(headers);
+    update_stats();
 
     _channel_label->setText(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_CHANNEL), "Channel"));
     _edge_label->setText(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_RIS_OR_FAL_EDGE), "Rising/Falling/Edges"));
@@ -216,15 +379,25 @@ void MeasureDock::refresh()
 
 void MeasureDock::reload()
 {
-    if (_session->get_device()->get_work_mode() == LOGIC)
+    if (_session->get_device()->get_work_mode() == LOGIC){
         _edge_groupBox->setVisible(true);
-    else
+        _stats_groupBox->setVisible(true);
+    }
+    else{
         _edge_groupBox->setVisible(false);
+        _stats_groupBox->setVisible(false);
+    }
 
     for (auto &o : _edge_row_list){
         update_probe_selector(o.box);
     }
 
+    _stats_box->blockSignals(true);
+    update_probe_selector(_stats_box);
+    _stats_box->insertItem(0, L_S(STR_PAGE_DLG, S_ID(IDS_DLG_STATS_ALL), "All"));
+    _stats_box->setCurrentIndex(0);
+    _stats_box->blockSignals(false);
+
     reCalc();
 }
 
@@ -561,6 +734,14 @@ void MeasureDock::set_sel_cursor()
         }
     } 
 
+    if (type == 0)
+    {
+        if (_stats_row.start_bt == _sel_btn || _stats_row.end_bt == _sel_btn){
+            inf = &_stats_row;
+            type = 3;
+        }
+    }
+
     assert(inf);
 
     _sel_btn->setText(sel_cursor_bt->text());
@@ -575,8 +756,10 @@ void MeasureDock::set_sel_cursor()
 
     if (type == 1)
         update_dist();
-    else
+    else if (type == 2)
         update_edge();
+    else
+        update_stats();
 }
 
 void MeasureDock::update_dist()
@@ -668,6 +851,230 @@ void MeasureDock::update_edge()
     }
 }
 
+// The whole capture unless both cursors are set
+data::LogicSnapshot* MeasureDock::get_stats_range(uint64_t &start, uint64_t &end)
+{
+    const auto snapshot = _session->get_snapshot(SR_CHANNEL_LOGIC);
+    const auto logic_snapshot = dynamic_cast<data::LogicSnapshot*>(snapshot);
+
+    if (logic_snapshot == NULL || logic_snapshot->empty())
+        return NULL;
+
+    const uint64_t last = logic_snapshot->get_sample_count() - 1;
+
+    if (_stats_row.cursor1 != -1 && _stats_row.cursor2 != -1) {
+        start = _view.get_cursor_samples(_stats_row.cursor1-1);
+        end = _view.get_cursor_samples(_stats_row.cursor2-1);
+        if (start > end)
+            std::swap(start, end);
+        end = std::min(end, last);
+    }
+    else {
+        start = 0;
+        end = last;
+    }
+
+    return start < end ? logic_snapshot : NULL;
+}
+
+std::vector<int> MeasureDock::get_stats_channels()
+{
+    std::vector<int> channels;
+    const int index = _stats_box->currentIndex();
+
+    if (index < 0)
+        return channels;
+
+    if (index == 0) {
+        for (int i = 1; i < _stats_box->count(); i++)
+            channels.push_back(_stats_box->itemText(i).toInt());
+    }
+    else {
+        channels.push_back(_stats_box->currentText().toInt());
+    }
+
+    return channels;
+}
+
+void MeasureDock::analyze_stats()
+{
+    uint64_t start;
+    uint64_t end;
+    data::LogicSnapshot *logic_snapshot = get_stats_range(start, end);
+
+    if (_session->is_working() || logic_snapshot == NULL) {
+        QString strMsg(L_S(STR_PAGE_MSG, S_ID(IDS_MSG_NO_SAMPLE_DATA), "No Sample data!"));
+        MsgBox::Show(strMsg);
+        return;
+    }
+
+    _session->get_pulse_stats()->analyze(logic_snapshot, get_stats_channels(), start, end);
+    update_stats();
+}
+
+// Shows what the cache holds for the current channels and range
+void MeasureDock::update_stats()
+{
+    auto &cursor_list = _view.get_cursorList();
+
+    if (_stats_row.cursor1 > (int)cursor_list.size()) {
+        _stats_row.start_bt->setText(" ");
+        _stats_row.cursor1 = -1;
+        set_cursor_btn_color(_stats_row.start_bt);
+    }
+    if (_stats_row.cursor2 > (int)cursor_list.size()) {
+        _stats_row.end_bt->setText(" ");
+        _stats_row.cursor2 = -1;
+        set_cursor_btn_color(_stats_row.end_bt);
+    }
+
+    data::PulseStats *stats = _session->get_pulse_stats();
+    uint64_t start;
+    uint64_t end;
+    data::LogicSnapshot *logic_snapshot = get_stats_range(start, end);
+
+    _stats_results.clear();
+
+    if (logic_snapshot != NULL) {
+        for (int ch : get_stats_channels()) {
+            data::PulseStats::Result result;
+            if (stats->get_result(logic_snapshot, ch, start, end, result))
+                _stats_results.push_back(result);
+        }
+    }
+
+    const double samplerate = logic_snapshot ? logic_snapshot->samplerate() : 0;
+    const int rows = _stats_results.size() * data::PulseStats::STAT_COUNT;
+    int cur_row = _stats_table->currentRow();
+    int row = 0;
+
+    _stats_table->blockSignals(true);
+    _stats_table->setRowCount(rows);
+
+    for (auto &r : _stats_results) {
+        for (int i = 0; i < data::PulseStats::STAT_COUNT; i++, row++) {
+            const data::PulseStats::Stat &st = r.stats[i];
+            const bool valid = st.count > 0;
+            QString cells[STATS_COLUMNS];
+
+            cells[STATS_CHANNEL] = QString::number(r.channel);
+            cells[STATS_TYPE] = stats_type_text(i);
+            cells[STATS_COUNT] = QString::number(st.count);
+            cells[STATS_MIN] = valid ? stats_value_text(i, st.min, samplerate) : "-";
+            cells[STATS_MAX] = valid ? stats_value_text(i, st.max, samplerate) : "-";
+            cells[STATS_MEAN] = valid ? stats_value_text(i, st.mean, samplerate) : "-";
+            cells[STATS_STDDEV] = valid ? stats_value_text(i, st.stddev, samplerate) : "-";
+
+            for (int c = 0; c < STATS_COLUMNS; c++)
+                _stats_table->setItem(row, c, new QTableWidgetItem(cells[c]));
+        }
+    }
+
+    if (rows > 0)
+        _stats_table->selectRow(cur_row >= 0 && cur_row < rows ? cur_row : 0);
+    _stats_table->blockSignals(false);
+
+    const bool running = stats->is_running();
+    _stats_btn->setEnabled(!running);
+    _stats_btn->setText(running ? L_S(STR_PAGE_DLG, S_ID(IDS_DLG_STATS_ANALYZING), "Analyzing...")
+                                : L_S(STR_PAGE_DLG, S_ID(IDS_DLG_STATS_ANALYZE), "Analyze"));
+
+    update_summary();
+    draw_stats_hist();
+}
+
+// High time, duty cycle and edges of every enabled logic channel over
+// the statistics range, cheap enough to follow the cursors.
+void MeasureDock::update_summary()
+{
+    uint64_t start;
+    uint64_t end;
+    data::LogicSnapshot *logic_snapshot = get_stats_range(start, end);
+    int row = 0;
+
+    _summary_table->setRowCount(0);
+
+    if (logic_snapshot == NULL)
+        return;
+
+    const double samplerate = logic_snapshot->samplerate();
+    const uint64_t length = end - start + 1;
+
+    for(auto s : _session->get_signals()) {
+        if (s->signal_type() != SR_CHANNEL_LOGIC || !s->enabled())
+            continue;
+
+        view::LogicSignal *logicSig = (view::LogicSignal*)s;
+        uint64_t high;
+        uint64_t edges;
+
+        if (!logicSig->summary(end, start, high, edges))
+            continue;
+
+        QString cells[SUMMARY_COLUMNS];
+        cells[SUMMARY_CHANNEL] = QString::number(s->get_index());
+        cells[SUMMARY_HIGH] = stats_time_text(high, samplerate);
+        cells[SUMMARY_LOW] = stats_time_text(length - high, samplerate);
+        cells[SUMMARY_DUTY] = QString::number(high * 100.0 / length, 'f', 2) + "%";
+        cells[SUMMARY_EDGES] = QString::number(edges);
+        cells[SUMMARY_RATE] = samplerate > 0 ? stats_rate_text(edges * samplerate / length) : "-";
+
+        _summary_table->setRowCount(row + 1);
+        for (int c = 0; c < SUMMARY_COLUMNS; c++)
+            _summary_table->setItem(row, c, new QTableWidgetItem(cells[c]));
+        row++;
+    }
+}
+
+void MeasureDock::draw_stats_hist()
+{
+    const int row = _stats_table->currentRow();
+
+    if (row < 0 || row >= (int)_stats_results.size() * data::PulseStats::STAT_COUNT) {
+        _stats_hist->clear();
+        _stats_info->setText(" ");
+        return;
+    }
+
+    const data::PulseStats::Result &r = _stats_results[row / data::PulseStats::STAT_COUNT];
+    const int type = row % data::PulseStats::STAT_COUNT;
+    const data::PulseStats::Stat &st = r.stats[type];
+    const int bins = data::PulseStats::Bins;
+    const int w = std::max(_stats_hist->width(), bins * 2);
+    const int h = StatsHistHeight;
+
+    uint64_t peak = 1;
+    for (uint64_t n : st.bins)
+        peak = std::max(peak, n);
+
+    QPixmap pixmap(w, h);
+    pixmap.fill(Qt::transparent);
+    QPainter painter(&pixmap);
+    const QColor fore = palette().color(QPalette::WindowText);
+
+    for (int b = 0; b < bins; b++) {
+        const int bar = st.bins[b] * (h - 1) / peak;
+        const int x0 = b * w / bins;
+        const int x1 = (b + 1) * w / bins;
+        if (bar > 0)
+            painter.fillRect(x0, h - 1 - bar, std::max(x1 - x0 - 1, 1), bar, fore);
+    }
+    painter.setPen(fore);
+    painter.drawLine(0, h - 1, w - 1, h - 1);
+    painter.end();
+
+    _stats_hist->setPixmap(pixmap);
+
+    const auto snapshot = _session->get_snapshot(SR_CHANNEL_LOGIC);
+    const double samplerate = snapshot ? snapshot->samplerate() : 0;
+    QString info(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_STATS_EDGES), "Rising/Falling: "));
+    info += QString::number(r.rising) + "/" + QString::number(r.falling);
+    if (st.count > 0)
+        info += "    " + stats_value_text(type, st.min, samplerate) + " ~ "
+                + stats_value_text(type, st.max, samplerate);
+    _stats_info->setText(info);
+}
+
 void MeasureDock::set_cursor_btn_color(QPushButton *btn)
 {
     bool ret;
@@ -721,6 +1128,9 @@ void MeasureDock::cursor_moving()
     }
 
     update_dist();
+
+    if (_stats_row.cursor1 != -1 && _stats_row.cursor2 != -1)
+        update_summary();
 }
 
 void MeasureDock::reCalc()
@@ -728,6 +1138,7 @@ void MeasureDock::reCalc()
     cursor_update();
     update_dist();
     update_edge();
+    update_stats();
 }
 
 void MeasureDock::goto_cursor()
@@ -41,6 +41,7 @@
 
 #include "../ui/dscombobox.h"
 #include "../interface/icallbacks.h"
+#include "../data/pulsestats.h"
 
 namespace pv {
 
@@ -95,6 +96,9 @@ private:
 
     void build_dist_pannel();
     void build_edge_pannel();
+    data::LogicSnapshot* get_stats_range(uint64_t &start, uint64_t &end);
+    std::vector<int> get_stats_channels();
+    void update_summary();
 
 private:
     QComboBox* create_probe_selector(QWidget *parent);
@@ -112,6 +116,9 @@ private slots:
     void set_cursor_btn_color(QPushButton *btn);
     void del_cursor();
     void add_dist_measure();
+    void analyze_stats();
+    void update_stats();
+    void draw_stats_hist();
 
 public slots:   
     void cursor_update();
@@ -143,6 +150,16 @@ private:
     QWidget     *_dist_pannel;
     QWidget     *_edge_pannel;
 
+    QGroupBox *_stats_groupBox;
+    QComboBox *_stats_box;
+    cursor_row_info _stats_row;
+    QPushButton *_stats_btn;
+    QTableWidget *_summary_table;
+    QTableWidget *_stats_table;
+    QLabel *_stats_hist;
+    QLabel *_stats_info;
+    std::vector<data::PulseStats::Result> _stats_results;
+
     QGridLayout *_cursor_layout;
     QGroupBox *_cursor_groupBox;
     std::vector<cursor_row_info>   _dist_row_list;
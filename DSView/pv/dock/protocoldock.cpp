@@ -26,6 +26,7 @@
 #include "../data/decoderstack.h"
 #include "../dialogs/protocollist.h"
 #include "../dialogs/protocolexp.h" 
+#include "../dialogs/binaryview.h"
 #include "../view/view.h"
 
 #include <QObject>
@@ -67,6 +68,7 @@ ProtocolDock::ProtocolDock(QWidget *parent, view::View &view, SigSession *sessio
     _view(view)
 {
     _session = session;
+    _search_column = 0;
     _cur_search_index = -1;
     _search_edited = false; 
     _pro_add_button = NULL;
@@ -140,6 +142,8 @@ ProtocolDock::ProtocolDock(QWidget *parent, view::View &view, SigSession *sessio
     _bot_set_button->setFlat(true);
     _bot_save_button = new QPushButton(bot_panel);
     _bot_save_button->setFlat(true);
+    _bot_binary_button = new QPushButton(bot_panel);
+    _bot_binary_button->setFlat(true);
     _dn_nav_button = new QPushButton(bot_panel);
     _dn_nav_button->setFlat(true);
     _bot_title_label = new QLabel(bot_panel);
@@ -148,6 +152,7 @@ ProtocolDock::ProtocolDock(QWidget *parent, view::View &view, SigSession *sessio
     bot_title_layout->setSpacing(2);
     bot_title_layout->addWidget(_bot_set_button);
     bot_title_layout->addWidget(_bot_save_button);
+    bot_title_layout->addWidget(_bot_binary_button);
     bot_title_layout->addWidget(_bot_title_label, 1);
     bot_title_layout->addWidget(_dn_nav_button);
     
@@ -208,6 +213,7 @@ ProtocolDock::ProtocolDock(QWidget *parent, view::View &view, SigSession *sessio
 
     connect(_dn_nav_button, SIGNAL(clicked()),this, SLOT(nav_table_view()));
     connect(_bot_save_button, SIGNAL(clicked()),this, SLOT(export_table_view()));
+    connect(_bot_binary_button, SIGNAL(clicked()),this, SLOT(show_binary_view()));
     connect(_bot_set_button, SIGNAL(clicked()),this, SLOT(set_model()));
     connect(_pre_button, SIGNAL(clicked()),this, SLOT(search_pre()));
     connect(_nxt_button, SIGNAL(clicked()),this, SLOT(search_nxt()));
@@ -244,6 +250,7 @@ void ProtocolDock::retranslateUi()
     _ann_search_edit->setPlaceholderText(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_SEARCH), "search"));
     _matchs_title_label->setText(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_MATCHING_ITEMS), "Matching Items:"));
     _bot_title_label->setText(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_PROTOCOL_LIST_VIEWER), "Protocol List Viewer"));
+    _bot_binary_button->setToolTip(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_BINARY_OUTPUT), "Binary Output"));
     _pro_keyword_edit->ResetText();
 }
 
@@ -260,6 +267,7 @@ void ProtocolDock::reStyle()
     _del_all_button->setIcon(QIcon(iconPath+"/del.svg"));
     _bot_set_button->setIcon(QIcon(iconPath+"/gear.svg"));
     _bot_save_button->setIcon(QIcon(iconPath+"/save.svg"));
+    _bot_binary_button->setIcon(QIcon(iconPath+"/export.svg"));
     _dn_nav_button->setIcon(QIcon(iconPath+"/nav.svg"));
     _pre_button->setIcon(QIcon(iconPath+"/pre.svg"));
     _nxt_button->setIcon(QIcon(iconPath+"/next.svg"));
@@ -487,7 +495,6 @@ void ProtocolDock::set_model()
     pv::dialogs::ProtocolList *protocollist_dlg = new pv::dialogs::ProtocolList(this, _session);
     protocollist_dlg->exec();
     resize_table_view(_session->get_decoder_model());
-    _model_proxy.setSourceModel(_session->get_decoder_model());
     search_done();
 
     // clear mark_index of all DecoderStacks
@@ -519,7 +526,6 @@ void ProtocolDock::update_model()
         if (index >= decode_sigs.size())
             decoder_model->setDecoderStack(decode_sigs.at(0)->decoder());
     }
-    _model_proxy.setSourceModel(decoder_model);
     search_done();
     resize_table_view(decoder_model);
 }
@@ -560,41 +566,20 @@ void ProtocolDock::item_clicked(const QModelIndex &index)
         }
     }
     _table_view->resizeRowToContents(index.row());
-    if (index.column() != _model_proxy.filterKeyColumn()) {
-        _model_proxy.setFilterKeyColumn(index.column());
-        _model_proxy.setSourceModel(decoder_model);
+    if (index.column() != _search_column) {
+        _search_column = index.column();
         search_done();
     }
-    QModelIndex filterIndex = _model_proxy.mapFromSource(index);
-    if (filterIndex.isValid()) {
-        _cur_search_index = filterIndex.row();
+
+    auto it = std::lower_bound(_search_matches.begin(), _search_matches.end(), (uint64_t)index.row());
+    int pos = it - _search_matches.begin();
+
+    if (_search_matches.empty()) {
+        _cur_search_index = -1;
+    } else if (it != _search_matches.end() && *it == (uint64_t)index.row()) {
+        _cur_search_index = pos;
     } else {
-        if (_model_proxy.rowCount() == 0) {
-            _cur_search_index = -1;
-        } else {
-            uint64_t up = 0;
-            uint64_t dn = _model_proxy.rowCount() - 1;
-            do {
-                uint64_t md = (up + dn)/2;
-                QModelIndex curIndex = _model_proxy.mapToSource(_model_proxy.index(md,_model_proxy.filterKeyColumn()));
-                if (index.row() == curIndex.row()) {
-                    _cur_search_index = md;
-                    break;
-                } else if (md == up) {
-                    if (curIndex.row() < index.row() && up < dn) {
-                        QModelIndex nxtIndex = _model_proxy.mapToSource(_model_proxy.index(md+1,_model_proxy.filterKeyColumn()));
-                        if (nxtIndex.row() < index.row())
-                            md++;
-                    }
-                    _cur_search_index = md + ((curIndex.row() < index.row()) ? 0.5 : -0.5);
-                    break;
-                } else if (curIndex.row() < index.row()) {
-                    up = md;
-                } else if (curIndex.row() > index.row()) {
-                    dn = md;
-                }
-            }while(1);
-        }
+        _cur_search_index = pos - 0.5;
     }
 }
 
@@ -620,6 +605,12 @@ void ProtocolDock::export_table_view()
     protocolexp_dlg->exec();
 }
 
+void ProtocolDock::show_binary_view()
+{
+    pv::dialogs::BinaryView *binary_dlg = new pv::dialogs::BinaryView(this, _session);
+    binary_dlg->exec();
+}
+
 void ProtocolDock::nav_table_view()
 {
     uint64_t row_index = 0;
@@ -628,28 +619,21 @@ void ProtocolDock::nav_table_view()
     auto decoder_stack = decoder_model->getDecoderStack();
     if (decoder_stack) {
         uint64_t offset = _view.offset() * (decoder_stack->samplerate() * _view.scale());
-        std::map<const pv::data::decode::Row, bool> rows = decoder_stack->get_rows_lshow();
-        int column = _model_proxy.filterKeyColumn();
-        for (std::map<const pv::data::decode::Row, bool>::const_iterator i = rows.begin();
-            i != rows.end(); i++) {
-            if ((*i).second && column-- == 0) {
-                row_index = decoder_stack->get_annotation_index((*i).first, offset);
-                break;
-            }
-        }
-        QModelIndex index = _model_proxy.mapToSource(_model_proxy.index(row_index, _model_proxy.filterKeyColumn()));
+        row_index = decoder_stack->list_annotation_index(_search_column, offset);
+        QModelIndex index = decoder_model->index(row_index, _search_column);
         if(index.isValid()){
             _table_view->scrollTo(index);
             _table_view->setCurrentIndex(index);
 
             pv::data::decode::Annotation ann;
-            decoder_stack->list_annotation(ann, index.column(), index.row());
+            bool has_ann = decoder_stack->list_annotation(ann, index.column(), index.row());
             const auto &decode_sigs = _session->get_decode_signals();
 
             for(auto d : decode_sigs) {
                 d->decoder()->set_mark_index(-1);
             }
-            decoder_stack->set_mark_index((ann.start_sample()+ann.end_sample())/2);
+            if (has_ann)
+                decoder_stack->set_mark_index((ann.start_sample()+ann.end_sample())/2);
             _view.set_all_update(true);
             _view.update();
         }
@@ -659,68 +643,29 @@ void ProtocolDock::nav_table_view()
 void ProtocolDock::search_pre()
 {
     search_update();
-    // now the proxy only contains rows that match the name
-    // let's take the pre one and map it to the original model
-    if (_model_proxy.rowCount() == 0) {
+    // the matches are sorted annotation indexes of the search column,
+    // take the pre one
+    if (_search_matches.empty()) {
         _table_view->scrollToTop();
         _table_view->clearSelection();
         _matchs_label->setText(QString::number(0));
         _cur_search_index = -1;
         return;
     }
-    int i = 0;
-    uint64_t rowCount = _model_proxy.rowCount();
-    QModelIndex matchingIndex;
-    pv::data::DecoderModel *decoder_model = _session->get_decoder_model();
 
-    auto decoder_stack = decoder_model->getDecoderStack();
-    do {
-        _cur_search_index--;
-        if (_cur_search_index <= -1 || _cur_search_index >= _model_proxy.rowCount())
-            _cur_search_index = _model_proxy.rowCount() - 1;
+    _cur_search_index--;
+    if (_cur_search_index <= -1 || _cur_search_index >= _search_matches.size())
+        _cur_search_index = _search_matches.size() - 1;
 
-        matchingIndex = _model_proxy.mapToSource(_model_proxy.index(ceil(_cur_search_index),_model_proxy.filterKeyColumn()));
-        if (!decoder_stack || !matchingIndex.isValid())
-            break;
-        i = 1;
-        uint64_t row = matchingIndex.row() + 1;
-        uint64_t col = matchingIndex.column();
-        pv::data::decode::Annotation ann;
-        bool ann_valid;
-        while(i < _str_list.size()) {
-            QString nxt = _str_list.at(i);
-
-            do {
-                ann_valid = decoder_stack->list_annotation(ann, col, row);
-                row++;
-            }while(ann_valid && !ann.is_numberic());
-
-            QString source = ann.annotations().at(0);
-            if (ann_valid && source.contains(nxt))
-                i++;
-            else
-                break;
-        }
-    }while(i < _str_list.size() && --rowCount);
-
-    if(i >= _str_list.size() && matchingIndex.isValid()){
-        _table_view->scrollTo(matchingIndex);
-        _table_view->setCurrentIndex(matchingIndex);
-        _table_view->clicked(matchingIndex);
-    } else {
-        _table_view->scrollToTop();
-        _table_view->clearSelection();
-        _matchs_label->setText(QString::number(0));
-        _cur_search_index = -1;
-    }
+    search_select(_search_matches[(uint64_t)ceil(_cur_search_index)]);
 }
 
 void ProtocolDock::search_nxt()
 {
     search_update();
-    // now the proxy only contains rows that match the name
-    // let's take the pre one and map it to the original model
-    if (_model_proxy.rowCount() == 0) {
+    // the matches are sorted annotation indexes of the search column,
+    // take the next one
+    if (_search_matches.empty()) {
         _table_view->scrollToTop();
         _table_view->clearSelection();
         _matchs_label->setText(QString::number(0));
@@ -728,51 +673,18 @@ void ProtocolDock::search_nxt()
         return;
     }
 
-    int i = 0;
-    uint64_t rowCount = _model_proxy.rowCount();
-    QModelIndex matchingIndex;
-    pv::data::DecoderModel *decoder_model = _session->get_decoder_model();
-    auto decoder_stack = decoder_model->getDecoderStack();
-
-    if (decoder_stack == NULL){ 
-        dsv_err("decoder_stack is null");
-        return;
-    }  
-
-    do {
-        _cur_search_index++;
-        if (_cur_search_index < 0 || _cur_search_index >= _model_proxy.rowCount())
-            _cur_search_index = 0;
-
-        matchingIndex = _model_proxy.mapToSource(_model_proxy.index(floor(_cur_search_index),_model_proxy.filterKeyColumn()));
-        
-        if (!matchingIndex.isValid())
-            break;
-
-        i = 1;
-        uint64_t row = matchingIndex.row() + 1;
-        uint64_t col = matchingIndex.column();
-        pv::data::decode::Annotation ann;
-        bool ann_valid;
+    _cur_search_index++;
+    if (_cur_search_index < 0 || _cur_search_index >= _search_matches.size())
+        _cur_search_index = 0;
 
-        while(i < _str_list.size()) {
-            QString nxt = _str_list.at(i);
-
-            do {
-                ann_valid = decoder_stack->list_annotation(ann, col, row);
-                row++;
-            }while(ann_valid && !ann.is_numberic());
+    search_select(_search_matches[(uint64_t)floor(_cur_search_index)]);
+}
 
-            auto strlist = ann.annotations();
-            QString source = ann.annotations().at(0);
-            if (ann_valid && source.contains(nxt))
-                i++;
-            else
-                break;
-        }
-    }while(i < _str_list.size() && --rowCount);
+void ProtocolDock::search_select(uint64_t row)
+{
+    QModelIndex matchingIndex = _session->get_decoder_model()->index(row, _search_column);
 
-    if(i >= _str_list.size() && matchingIndex.isValid()){
+    if (matchingIndex.isValid()) {
         _table_view->scrollTo(matchingIndex);
         _table_view->setCurrentIndex(matchingIndex);
         _table_view->clicked(matchingIndex);
@@ -787,13 +699,25 @@ void ProtocolDock::search_nxt()
 void ProtocolDock::search_done()
 {
     QString str = _ann_search_edit->text().trimmed();
-    QRegularExpression rx("(-)");
-    _str_list = str.split(rx);
-    _model_proxy.setFilterFixedString(_str_list.first());
-    if (_str_list.size() > 1)
-        _matchs_label->setText("...");
-    else
-        _matchs_label->setText(QString::number(_model_proxy.rowCount()));
+    bool regex = false;
+
+    // "/pattern/" is a regular expression, otherwise "a-b" finds a then b
+    if (str.size() > 2 && str.startsWith('/') && str.endsWith('/')) {
+        _str_list = QStringList(str.mid(1, str.size() - 2));
+        regex = true;
+    }
+    else {
+        QRegularExpression rx("(-)");
+        _str_list = str.split(rx);
+    }
+
+    _search_matches.clear();
+
+    auto decoder_stack = _session->get_decoder_model()->getDecoderStack();
+    if (decoder_stack)
+        decoder_stack->search_annotation(_search_matches, _search_column, _str_list, regex);
+
+    _matchs_label->setText(QString::number(_search_matches.size()));
 }
 
 void ProtocolDock::search_changed()
@@ -813,7 +737,7 @@ void ProtocolDock::search_update()
     if (!decoder_stack)
         return;
 
-    if (decoder_stack->list_annotation_size(_model_proxy.filterKeyColumn()) > ProgressRows) {
+    if (decoder_stack->list_annotation_size(_search_column) > ProgressRows) {
         QFuture<void> future;
         future = QtConcurrent::run([&]{
             search_done();
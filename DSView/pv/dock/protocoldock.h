@@ -33,7 +33,6 @@
 #include <QScrollArea>
 #include <QSplitter>
 #include <QTableView>
-#include <QSortFilterProxyModel>
 #include <QLineEdit>
 #include <QToolButton>
 
@@ -131,6 +130,7 @@ private slots:
     void decoded_progress(int progress);
     void set_model();   
     void export_table_view();
+    void show_binary_view();
     void nav_table_view();
     void item_clicked(const QModelIndex &index);
     void column_resize(int index, int old_size, int new_size);
@@ -141,11 +141,15 @@ private slots:
     void search_update();
     void show_protocol_select();
 
+private:
+    void search_select(uint64_t row);
+
 private:
     SigSession *_session;
     view::View &_view;
-    QSortFilterProxyModel _model_proxy;
-    int _cur_search_index;
+    int _search_column;
+    std::vector<uint64_t> _search_matches; //sorted annotation indexes of the search column
+    double _cur_search_index; //x.5 if the selected row is between two matches
     QStringList _str_list;
 
     QWidget     *_top_panel; 
@@ -164,6 +168,7 @@ private:
 
     QPushButton *_bot_set_button;
     QPushButton *_bot_save_button;
+    QPushButton *_bot_binary_button;
     QPushButton *_dn_nav_button;
     QPushButton *_ann_search_button;
     std::vector<DecoderInfoItem*> _decoderInfoList;
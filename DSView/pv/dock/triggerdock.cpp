@@ -35,6 +35,9 @@
 #include <QApplication>
 #include <math.h>
 #include <libsigrok.h>
+#include <QFuture>
+#include <QProgressDialog>
+#include <QtConcurrent/QtConcurrent>
 
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
     #include <QRegularExpression>
@@ -53,15 +56,17 @@
 #include "../data/decode/annotationrestable.h"
 #include "../appcontrol.h"
 #include "../ui/fn.h"
+#include "../dialogs/triggermarks.h"
 
 namespace pv {
 namespace dock {
 
 const int TriggerDock::MinTrigPosition = 1;
 
-TriggerDock::TriggerDock(QWidget *parent, SigSession *session) :
+TriggerDock::TriggerDock(QWidget *parent, view::View &view, SigSession *session) :
     QScrollArea(parent),
-    _session(session)
+    _session(session),
+    _view(view)
 {
     
     _cur_ch_num = 16;
@@ -103,9 +108,13 @@ TriggerDock::TriggerDock(QWidget *parent, SigSession *session) :
     _adv_tabWidget->setDisabled(true);
     setup_adv_tab();
 
+    _find_button = new QPushButton(_widget);
+    _find_button->setDisabled(true);
+
     connect(_simple_radioButton, SIGNAL(clicked()), this, SLOT(simple_trigger()));
     connect(_adv_radioButton, SIGNAL(clicked()), this, SLOT(adv_trigger()));
     connect(stages_comboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(widget_enable(int)));
+    connect(_find_button, SIGNAL(clicked()), this, SLOT(on_find_trigger()));
 
 
     QVBoxLayout *layout = new QVBoxLayout(_widget);
@@ -125,6 +134,7 @@ TriggerDock::TriggerDock(QWidget *parent, SigSession *session) :
 
     layout->addLayout(gLayout);
     layout->addWidget(_adv_tabWidget);
+    layout->addWidget(_find_button, 0, Qt::AlignRight);
     layout->addStretch(1);
     _widget->setLayout(layout);
 
@@ -169,6 +179,7 @@ void TriggerDock::retranslateUi()
     _serial_note_label->setText(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_SERIAL_NOTE_LABEL), 
                                 "X: Don't care\n0: Low level\n1: High level\nR: Rising edge\nF: Falling edge\nC: Rising/Falling edge"));
     _data_bits_label->setText(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_DATA_BITS), "Data Bits"));
+    _find_button->setText(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_FIND_TRIGGER_IN_DATA), "Find in Data"));
 
     for (int i = 0; i < _inv_exp_label_list.length(); i++){
         _inv_exp_label_list.at(i)->setText(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_INV), "Inv"));
@@ -205,6 +216,7 @@ void TriggerDock::simple_trigger()
     _stages_label->setDisabled(true);
     stages_comboBox->setDisabled(true);
     _adv_tabWidget->setDisabled(true);
+    _find_button->setDisabled(true);
 }
 
 void TriggerDock::adv_trigger()
@@ -223,7 +235,11 @@ void TriggerDock::adv_trigger()
             widget_enable(0);
         }
     }
-    else if (_session->get_device()->is_file() == false){
+    else if (_session->get_device()->is_virtual()) {
+        // no capture trigger, the stages are only searched in the data
+        widget_enable(0);
+    }
+    else {
         QString strMsg(L_S(STR_PAGE_MSG, S_ID(IDS_MSG_AD_TRIGGER_NEED_HARDWARE),
                                       "Advanced Trigger need DSLogic Hardware Support!"));
         MsgBox::Show(strMsg);
@@ -240,6 +256,7 @@ void TriggerDock::widget_enable(int index)
     stages_comboBox->setVisible(true);
     stages_comboBox->setDisabled(false);
     _adv_tabWidget->setDisabled(false);
+    _find_button->setDisabled(false);
     enable_stages = stages_comboBox->currentText().toInt();
 
     for (int i = 0; i < enable_stages; i++) {
@@ -422,6 +439,100 @@ bool TriggerDock::commit_trigger()
     }
 }
 
+// The stage trigger settings for LogicSnapshot::trigger_search()
+void TriggerDock::get_trigger_stages(std::vector<data::LogicSnapshot::TriggerStage> &stages)
+{
+    stages.clear();
+
+    for (int i = 0; i < stages_comboBox->currentText().toInt(); i++) {
+        QString value0_str, value1_str;
+        if (_cur_ch_num == 32) {
+            value0_str = _value0_ext32_lineEdit_list.at(i)->text() + " " + _value0_lineEdit_list.at(i)->text();
+            value1_str = _value1_ext32_lineEdit_list.at(i)->text() + " " + _value1_lineEdit_list.at(i)->text();
+        } else {
+            value0_str = _value0_lineEdit_list.at(i)->text();
+            value1_str = _value1_lineEdit_list.at(i)->text();
+        }
+        value0_str = value0_str.toUpper();
+        value1_str = value1_str.toUpper();
+
+        data::LogicSnapshot::TriggerStage stage;
+
+        // the msb channel goes first, as for ds_trigger_stage_set_value()
+        for (int j = 0; j < _cur_ch_num; j++) {
+            const uint16_t channel = _cur_ch_num - j - 1;
+
+            if (j * 2 < value0_str.size() && value0_str.at(j * 2) != 'X')
+                stage.value0[channel] = value0_str.at(j * 2).toLatin1();
+            if (j * 2 < value1_str.size() && value1_str.at(j * 2) != 'X')
+                stage.value1[channel] = value1_str.at(j * 2).toLatin1();
+        }
+
+        stage.inv0 = _inv0_comboBox_list.at(i)->currentIndex() == 1;
+        stage.inv1 = _inv1_comboBox_list.at(i)->currentIndex() == 1;
+        stage.logic_and = _logic_comboBox_list.at(i)->currentIndex() == 1;
+        stage.contiguous = _contiguous_checkbox_list.at(i)->isChecked();
+        stage.count = _count_spinBox_list.at(i)->value();
+        stages.push_back(stage);
+    }
+}
+
+void TriggerDock::on_find_trigger()
+{
+    if (_adv_tabWidget->currentIndex() != 0) {
+        QString strMsg(L_S(STR_PAGE_MSG, S_ID(IDS_MSG_FIND_STAGE_TRIGGER_ONLY),
+                                      "Only the stage trigger can be found in the data!"));
+        MsgBox::Show(strMsg);
+        return;
+    }
+
+    const auto snapshot = _session->get_snapshot(SR_CHANNEL_LOGIC);
+    const auto logic_snapshot = dynamic_cast<data::LogicSnapshot*>(snapshot);
+
+    if (_session->is_working() || logic_snapshot == NULL || logic_snapshot->empty()) {
+        QString strMsg(L_S(STR_PAGE_MSG, S_ID(IDS_MSG_NO_SAMPLE_DATA), "No Sample data!"));
+        MsgBox::Show(strMsg);
+        return;
+    }
+
+    std::vector<data::LogicSnapshot::TriggerStage> stages;
+    std::vector<uint64_t> positions;
+    volatile bool canceled = false;
+
+    get_trigger_stages(stages);
+
+    QFuture<void> future;
+    future = QtConcurrent::run([&]{
+        logic_snapshot->trigger_search(stages, positions, &canceled);
+    });
+
+    Qt::WindowFlags flags = Qt::CustomizeWindowHint;
+    QProgressDialog dlg(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_FIND_TRIGGER_PROGRESS), "Finding trigger positions..."),
+                        L_S(STR_PAGE_DLG, S_ID(IDS_DLG_CANCEL), "Cancel"),0,0,this,flags);
+    dlg.setWindowModality(Qt::WindowModal);
+    dlg.setWindowFlags(Qt::Dialog | Qt::FramelessWindowHint | Qt::WindowSystemMenuHint |
+                       Qt::WindowMinimizeButtonHint | Qt::WindowMaximizeButtonHint);
+    connect(&dlg, &QProgressDialog::canceled, [&]{ canceled = true; });
+
+    QFutureWatcher<void> watcher;
+    connect(&watcher,SIGNAL(finished()),&dlg,SLOT(cancel()));
+    watcher.setFuture(future);
+    dlg.exec();
+    future.waitForFinished();
+
+    if (canceled)
+        return;
+
+    if (positions.empty()) {
+        QString strMsg(L_S(STR_PAGE_MSG, S_ID(IDS_MSG_TRIGGER_NOT_FOUND), "Trigger not found in the data!"));
+        MsgBox::Show(strMsg);
+        return;
+    }
+
+    dialogs::TriggerMarks marks(this, _view, _session, positions);
+    marks.exec();
+}
+
 void TriggerDock::update_view()
 {
     // TRIGGERPOS
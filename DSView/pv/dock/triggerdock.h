@@ -42,11 +42,16 @@
 #include <vector>
 #include "../ui/dscombobox.h"
 #include "../interface/icallbacks.h"
+#include "../data/logicsnapshot.h"
 
 namespace pv {
 
 class SigSession;
 
+namespace view {
+class View;
+}
+
 namespace dock {
 
 class TriggerDock : public QScrollArea, public IFontForm
@@ -57,7 +62,7 @@ private:
     static const int MinTrigPosition;
 
 public:
-    TriggerDock(QWidget *parent, SigSession *session);
+    TriggerDock(QWidget *parent, view::View &view, SigSession *session);
     ~TriggerDock();
 
     void paintEvent(QPaintEvent *);
@@ -86,6 +91,8 @@ private:
      */
     bool commit_trigger();
 
+    void get_trigger_stages(std::vector<data::LogicSnapshot::TriggerStage> &stages);
+
     //IFontForm
     void update_font() override;
 
@@ -97,9 +104,11 @@ private slots:
     void on_hex_checkbox_click(bool ck);
     void on_serial_value_changed(const QString &v);
     void on_serial_hex_changed();
+    void on_find_trigger();
 
 private:
     SigSession *_session;
+    view::View &_view;
 
     int _cur_ch_num;
     QWidget *_widget;
@@ -129,6 +138,7 @@ private:
     QVector <QCheckBox *> _contiguous_checkbox_list;
 
     QTabWidget *_adv_tabWidget;
+    QPushButton *_find_button;
     QGroupBox *_serial_groupBox;
     QLabel *_serial_start_label;
     QLineEdit *_serial_start_lineEdit;
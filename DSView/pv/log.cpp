@@ -22,6 +22,7 @@
 #include "log.h"
 #include <QString>
 #include <QDir>
+#include <QtGlobal>
 #include  "config/appconfig.h"
 #include "utility/path.h"
 #include <string>
@@ -30,17 +31,33 @@ xlog_writer *dsv_log = nullptr;
 static xlog_context *log_ctx = nullptr;
 static bool b_logfile = false;
 static int log_file_index = -1; 
+static QtMessageHandler prev_msg_handler = nullptr;
+
+// Qt aborts after a fatal message, the queued records are written first.
+static void dsv_msg_handler(QtMsgType type, const QMessageLogContext &context, const QString &msg)
+{
+    if (type == QtFatalMsg && log_ctx != nullptr){
+        dsv_err("Fatal: %s", msg.toUtf8().data());
+        xlog_flush(log_ctx);
+    }
+
+    if (prev_msg_handler != nullptr)
+        prev_msg_handler(type, context, msg);
+}
 
 void dsv_log_init()
 {
     if (log_ctx == nullptr){
         log_ctx = xlog_new();  
         dsv_log = xlog_create_writer(log_ctx, "DSView"); 
+        prev_msg_handler = qInstallMessageHandler(dsv_msg_handler);
     }
 } 
 
 void dsv_log_uninit()
 { 
+    qInstallMessageHandler(prev_msg_handler);
+    prev_msg_handler = nullptr;
     xlog_free(log_ctx);
     xlog_free_writer(dsv_log);
     log_ctx = nullptr;
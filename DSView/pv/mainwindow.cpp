@@ -164,13 +164,17 @@ namespace pv
         _logo_bar = new toolbars::LogoBar(_session, this);
         _logo_bar->setObjectName("logo_bar");
 
+        // Setup _view widget
+        _view = new pv::view::View(_session, _sampling_bar, this);
+        _vertical_layout->addWidget(_view);
+
         // trigger dock
         _trigger_dock = new QDockWidget(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_TRIGGER_DOCK_TITLE), "Trigger Setting..."), this);
         _trigger_dock->setObjectName("trigger_dock");
         _trigger_dock->setFeatures(QDockWidget::DockWidgetMovable);
         _trigger_dock->setAllowedAreas(Qt::RightDockWidgetArea);
         _trigger_dock->setVisible(false);
-        _trigger_widget = new dock::TriggerDock(_trigger_dock, _session);        
+        _trigger_widget = new dock::TriggerDock(_trigger_dock, *_view, _session);        
         _trigger_dock->setWidget(_trigger_widget);
 
         _dso_trigger_dock = new QDockWidget(L_S(STR_PAGE_DLG, S_ID(IDS_DLG_TRIGGER_DOCK_TITLE), "Trigger Setting..."), this);
@@ -181,10 +185,6 @@ namespace pv
         _dso_trigger_widget = new dock::DsoTriggerDock(_dso_trigger_dock, _session);
         _dso_trigger_dock->setWidget(_dso_trigger_widget);
 
-        // Setup _view widget
-        _view = new pv::view::View(_session, _sampling_bar, this);
-        _vertical_layout->addWidget(_view);
-
         setIconSize(QSize(40, 40));
         addToolBar(_sampling_bar);
         addToolBar(_trig_bar);
@@ -33,6 +33,9 @@
 #include "data/decodermodel.h"
 #include "data/spectrumstack.h"
 #include "data/mathstack.h"
+#include "data/dsoaccumulator.h"
+#include "data/pulsestats.h"
+#include "data/eyestack.h"
 
 #include "view/analogsignal.h"
 #include "view/dsosignal.h"
@@ -41,6 +44,7 @@
 #include "view/decodetrace.h"
 #include "view/spectrumtrace.h"
 #include "view/lissajoustrace.h"
+#include "view/eyetrace.h"
 #include "view/mathtrace.h"
 
 #include <assert.h>
@@ -74,6 +78,11 @@ namespace pv
         _trig_pos = 0;
     }
 
+    uint64_t SessionData::get_memory_size()
+    {
+        return logic.get_memory_size();
+    }
+
     // TODO: This should not be necessary
     SigSession *SigSession::_session = NULL;
 
@@ -108,13 +117,18 @@ namespace pv
         _data_list.push_back(new SessionData());
         _view_data = _data_list[0];
         _capture_data = _data_list[0];
+        _live_view_data = NULL;
+        _history_view = -1;
 
         this->add_msg_listener(this);
 
         _decoder_model = new pv::data::DecoderModel(NULL);
 
         _lissajous_trace = NULL;
+        _eye_trace = NULL;
         _math_trace = NULL;
+        _dso_accumulator = new data::DsoAccumulator();
+        _pulse_stats = new data::PulseStats();
         _is_decoding = false;
         _bClose = false;
         _callback = NULL;
@@ -139,11 +153,23 @@ namespace pv
 
     SigSession::~SigSession()
     {
+        // the statistics worker may still read a frame
+        DESTROY_OBJECT(_pulse_stats);
+
+        for(auto p : _history){
+            p->clear();
+            delete p;
+        }
+        _history.clear();
+
         for(auto p : _data_list){
             p->clear();
             delete p;
         }
         _data_list.clear();
+
+        DESTROY_OBJECT(_eye_trace);
+        DESTROY_OBJECT(_dso_accumulator);
     }
 
     bool SigSession::init()
@@ -243,6 +269,7 @@ namespace pv
             dsv_info("Switch to device \"%s\" done.", _device_agent.name().toUtf8().data());
 
         clear_all_decoder();
+        clear_history();
 
         _view_data->clear();
         _capture_data->clear();
@@ -469,6 +496,8 @@ namespace pv
             if (_math_trace){
                 _math_trace->get_math_stack()->init();
             }
+
+            reset_dso_accumulation();
         }   
 
         // update current hw offset
@@ -526,6 +555,7 @@ namespace pv
 
         clear_all_decode_task2();
         clear_decode_result(); 
+        clear_history();
         
         _capture_data->clear();
         _view_data->clear();       
@@ -856,6 +886,7 @@ namespace pv
         unsigned int dso_probe_count = 0;
         unsigned int analog_probe_count = 0;
 
+        clear_history();
         _capture_data->clear();
         _view_data->clear();
         set_cur_snap_samplerate(_device_agent.get_sample_rate());
@@ -923,6 +954,7 @@ namespace pv
 
         spectrum_rebuild();
         lissajous_disable();
+        eye_disable();
         math_disable();
     }
 
@@ -1165,12 +1197,9 @@ namespace pv
         {
             _capture_data->get_logic()->set_loop(is_loop_mode());
 
-            bool bNotFree = _is_decoding && _view_data == _capture_data;
-
             _capture_data->get_logic()->first_payload(o, 
                             _device_agent.get_sample_limit(),
-                            _device_agent.get_channels(),
-                            !bNotFree);
+                            _device_agent.get_channels());
 
             // @todo Putting this here means that only listeners querying
             // for logic will be notified. Currently the only user of
@@ -1222,7 +1251,10 @@ namespace pv
             set_session_time(_trig_time);
         }
 
-        if (_capture_data->get_dso()->last_ended())
+        const bool first_payload = _capture_data->get_dso()->last_ended();
+        const uint64_t old_sample_count = _capture_data->get_dso()->get_sample_count();
+
+        if (first_payload)
         { 
             // reset scale of dso signal
             for (auto s : _signals)
@@ -1267,6 +1299,31 @@ namespace pv
             return;
         }
 
+        // fold the frame into the average/envelope/persistence display
+        if (!_is_instant && o.num_samples > 0
+            && _dso_accumulator->get_mode() != data::DsoAccumulator::ACCUM_OFF)
+        {
+            std::vector<uint16_t> ch_index;
+
+            for (const GSList *l = _device_agent.get_channels(); l; l = l->next) {
+                sr_channel *const probe = (sr_channel*)l->data;
+                if (probe->type == SR_CHANNEL_DSO && (probe->enabled || _device_agent.is_file()))
+                    ch_index.push_back(probe->index);
+            }
+
+            _dso_accumulator->push_frame((const uint8_t*)o.data, o.num_samples,
+                                         ch_index, _device_agent.get_sample_rate());
+        }
+
+        // instant captures come in pieces, the others a frame at a time
+        if (_eye_trace && _eye_trace->enabled() && o.num_samples > 0)
+        {
+            if (first_payload || !_is_instant)
+                feed_eye(_capture_data->get_dso(), 0, true);
+            else
+                feed_eye(_capture_data->get_dso(), old_sample_count, false);
+        }
+
         // calculate related spectrum results
         for (auto m : _spectrum_traces)
         {
@@ -1293,6 +1350,25 @@ namespace pv
         _data_updated = true;
     }
 
+    void SigSession::feed_eye(data::DsoSnapshot *dso, uint64_t start, bool new_frame)
+    {
+        data::EyeStack *eye_stack = _eye_trace->get_eye_stack();
+        const uint64_t sample_count = dso->get_sample_count();
+
+        if (start >= sample_count || !dso->has_data(eye_stack->data_index()))
+            return;
+
+        const uint8_t *clock = NULL;
+        if (eye_stack->clock_mode() == data::EyeStack::CLOCK_CHANNEL) {
+            if (!dso->has_data(eye_stack->clock_index()))
+                return;
+            clock = dso->get_samples(start, sample_count - 1, eye_stack->clock_index());
+        }
+
+        eye_stack->push_samples(dso->get_samples(start, sample_count - 1, eye_stack->data_index()),
+                                clock, sample_count - start, dso->samplerate(), new_frame);
+    }
+
     void SigSession::feed_in_analog(const sr_datafeed_analog &o)
     {
         if (_capture_data->get_analog()->memory_failed())
@@ -1687,6 +1763,9 @@ namespace pv
 
     void SigSession::lissajous_rebuild(bool enable, int xindex, int yindex, double percent)
     {
+        if (enable)
+            eye_disable();
+
         DESTROY_OBJECT(_lissajous_trace);
         _lissajous_trace = new view::LissajousTrace(enable, _view_data->get_dso(), xindex, yindex, percent);
         signals_changed();
@@ -1698,6 +1777,34 @@ namespace pv
             _lissajous_trace->set_enable(false);
     }
 
+    void SigSession::eye_rebuild(bool enable, int data_index, int clock_index, int clock_mode,
+                                 double bitrate, double mask_width, double mask_height)
+    {
+        ds_lock_guard lock(_data_mutex);
+
+        if (enable)
+            lissajous_disable();
+
+        DESTROY_OBJECT(_eye_trace);
+
+        auto eye_stack = new data::EyeStack(data_index, clock_index, clock_mode,
+                                            bitrate, mask_width, mask_height);
+        _eye_trace = new view::EyeTrace(enable, eye_stack);
+
+        // fold the capture on screen right away
+        data::DsoSnapshot *dso = _view_data->get_dso();
+        if (enable && !dso->empty())
+            feed_eye(dso, 0, true);
+
+        signals_changed();
+    }
+
+    void SigSession::eye_disable()
+    {
+        if (_eye_trace)
+            _eye_trace->set_enable(false);
+    }
+
     void SigSession::math_rebuild(bool enable, view::DsoSignal *dsoSig1,
                                   view::DsoSignal *dsoSig2,
                                   data::MathStack::MathType type)
@@ -1724,6 +1831,20 @@ namespace pv
         signals_changed();
     }
 
+    void SigSession::set_dso_accumulate_mode(int mode)
+    {
+        _dso_accumulator->set_mode(mode);
+        data_updated();
+    }
+
+    // the accumulated frames and the eye diagram start over
+    void SigSession::reset_dso_accumulation()
+    {
+        _dso_accumulator->reset();
+        if (_eye_trace)
+            _eye_trace->get_eye_stack()->reset();
+    }
+
     void SigSession::math_disable()
     {
         if (_math_trace)
@@ -1956,8 +2077,6 @@ namespace pv
             task = get_top_decode_task();
         }
 
-        _view_data->get_logic()->decode_end();
-
         dsv_info("------->decode thread end");
         _is_decoding = false;        
     }
@@ -2210,11 +2329,13 @@ namespace pv
 
                     _trig_check_timer.Stop();
 
+                    _capture_data->_trig_time = _trig_time;
+
                     //Switch the caputrued data buffer to view.
                     if (bSwapBuffer)
                     {
                         if (_view_data != _capture_data)
-                            _view_data->clear();
+                            push_history(_view_data);
                         
                         _view_data = _capture_data; 
                         attach_data_to_signal(_view_data); 
@@ -2283,6 +2404,7 @@ namespace pv
                 }
             }
 
+            clear_history();
             _capture_data->clear();
             _view_data->clear();
             _capture_data = _view_data;              
@@ -2404,8 +2526,146 @@ namespace pv
         set_cur_samplelimits(_device_agent.get_sample_limit());
     }
 
+    // Keep the frame that is replaced by a new repeat capture
+    void SigSession::push_history(SessionData *data)
+    {
+        assert(data);
+
+        AppConfig &app = AppConfig::Instance();
+
+        if (app.appOptions.historyFrames <= 0 
+            || _device_agent.get_work_mode() != LOGIC 
+            || data->get_logic()->have_data() == false){
+            data->clear();
+            return;
+        }
+
+        // The frame leaves the double buffer, a new one takes its place.
+        for (int i=0; i<(int)_data_list.size(); i++){
+            if (_data_list[i] == data){
+                _data_list[i] = new SessionData();
+                _history.push_back(data);
+                break;
+            }
+        }
+
+        evict_history();
+    }
+
+    void SigSession::evict_history()
+    {
+        AppConfig &app = AppConfig::Instance();
+        uint64_t budget = (uint64_t)app.appOptions.historyMemory * 1024 * 1024;
+        int max_count = app.appOptions.historyFrames;
+        
+        std::vector<uint64_t> sizes;
+        uint64_t total = 0;
+
+        for (auto p : _history){
+            sizes.push_back(p->get_memory_size());
+            total += sizes.back();
+        }
+
+        while (_history.size() > 0 
+            && ((int)_history.size() > max_count || total > budget))
+        {
+            int index = 0;
+
+            if (app.appOptions.historyEvict == HISTORY_EVICT_LARGEST){
+                for (int i=1; i<(int)sizes.size(); i++){
+                    if (sizes[i] > sizes[index])
+                        index = i;
+                }
+            }
+
+            SessionData *p = _history[index];
+            _pulse_stats->drop(p->get_logic());
+            p->clear();
+            delete p;
+
+            total -= sizes[index];
+            _history.erase(_history.begin() + index);
+            sizes.erase(sizes.begin() + index);
+        }
+    }
+
+    SessionData* SigSession::get_history_frame(int index)
+    {
+        if (index == -1){
+            return _history_view == -1 ? _view_data : _live_view_data;
+        }
+        if (index < 0 || index >= (int)_history.size())
+            return NULL;
+        return _history[index];
+    }
+
+    bool SigSession::show_history_frame(int index)
+    {
+        if (_is_working || index < -1 || index >= (int)_history.size())
+            return false;
+
+        if (index == _history_view)
+            return true;
+
+        SessionData *data = get_history_frame(index);
+
+        if (_history_view == -1)
+            _live_view_data = _view_data;
+
+        clear_all_decode_task2();
+        clear_decode_result();
+
+        _view_data = data;
+        _history_view = index;
+        attach_data_to_signal(_view_data);
+        set_session_time(_view_data->_trig_time);
+
+        _callback->receive_trigger(_view_data->_trig_pos);
+        _callback->trigger_message(DSV_MSG_DATA_POOL_CHANGED);
+
+        // Decode the shown frame with the same decoders.
+        for (auto de : _decode_traces){
+            de->decoder()->set_capture_end_flag(true);
+            de->frame_ended();
+            add_decode_task(de);
+        }
+
+        _callback->frame_ended();
+
+        return true;
+    }
+
+    void SigSession::clear_history()
+    {
+        if (_history_view != -1){
+            // Decoders may read the shown frame.
+            clear_all_decode_task2();
+            _view_data = _live_view_data;
+            _live_view_data = NULL;
+            _history_view = -1;
+            attach_data_to_signal(_view_data);
+        }
+
+        for (auto p : _history){
+            _pulse_stats->drop(p->get_logic());
+            p->clear();
+            delete p;
+        }
+        _history.clear();
+    }
+
+    uint64_t SigSession::get_history_memory()
+    {
+        uint64_t total = 0;
+        for (auto p : _history){
+            total += p->get_memory_size();
+        }
+        return total;
+    }
+
     void SigSession::clear_view_data()
     {
+        clear_history();
         _view_data->clear();
         data_updated();
     }
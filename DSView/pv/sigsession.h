@@ -31,6 +31,7 @@
 #include <thread>
 #include <QDateTime>
 #include <list>
+#include <deque>
 
 #include "view/mathtrace.h"
 #include "data/mathstack.h"
@@ -59,6 +60,8 @@ class DsoSnapshot;
 class LogicSnapshot;
 class DecoderModel;
 class MathStack;
+class DsoAccumulator;
+class PulseStats;
 
 namespace decode {
     class Decoder;
@@ -71,6 +74,7 @@ class GroupSignal;
 class DecodeTrace;
 class SpectrumTrace;
 class LissajousTrace;
+class EyeTrace;
 class MathTrace;
 }
 
@@ -88,6 +92,13 @@ enum DEVICE_COLLECT_MODE
     COLLECT_LOOP = 2,
 }; 
 
+// Which capture history frame goes first when the budget is exceeded
+enum HISTORY_EVICT_MODE
+{
+    HISTORY_EVICT_OLDEST = 0,
+    HISTORY_EVICT_LARGEST = 1,
+};
+
 class SessionData
 {
 public:
@@ -107,10 +118,13 @@ public:
 
     void clear();
 
+    uint64_t get_memory_size();
+
 public:
     uint64_t       _cur_snap_samplerate;
     uint64_t       _cur_samplelimits;
     uint64_t       _trig_pos;
+    QDateTime      _trig_time;
 
 private:
     data::LogicSnapshot   logic;
@@ -204,6 +218,25 @@ public:
     bool is_first_store_confirm();
     bool get_capture_status(bool &triggered, int &progress);
 
+    // Repeat mode capture history, oldest frame first.
+    // The latest capture is not in it, its view index is -1.
+    inline int get_history_count(){
+        return (int)_history.size();
+    }
+
+    inline int get_history_view_index(){
+        return _history_view;
+    }
+
+    SessionData* get_history_frame(int index);
+    bool show_history_frame(int index);
+    void clear_history();
+    uint64_t get_history_memory();
+
+    inline bool is_decoding(){
+        return _is_decoding;
+    }
+
     inline void clear_store_confirm_flag(){
         _confirm_store_time_id = _work_time_id;
     }
@@ -238,6 +271,21 @@ public:
     inline view::MathTrace* get_math_trace(){
         return _math_trace;
     }
+
+    inline view::EyeTrace* get_eye_trace(){
+        return _eye_trace;
+    }
+
+    inline data::DsoAccumulator* get_dso_accumulator(){
+        return _dso_accumulator;
+    }
+
+    void set_dso_accumulate_mode(int mode);
+    void reset_dso_accumulation();
+
+    inline data::PulseStats* get_pulse_stats(){
+        return _pulse_stats;
+    }
  
     uint16_t get_ch_num(int type); 
  
@@ -251,6 +299,9 @@ public:
     void spectrum_rebuild();
     void lissajous_rebuild(bool enable, int xindex, int yindex, double percent);
     void lissajous_disable();
+    void eye_rebuild(bool enable, int data_index, int clock_index, int clock_mode,
+                     double bitrate, double mask_width, double mask_height);
+    void eye_disable();
 
     void math_rebuild(bool enable,pv::view::DsoSignal *dsoSig1,
                       pv::view::DsoSignal *dsoSig2,
@@ -476,6 +527,8 @@ private:
     void feed_timeout();    
     void clear_decode_result();
     void attach_data_to_signal(SessionData *data);
+    void push_history(SessionData *data);
+    void evict_history();
 
     bool action_start_capture(bool instant);
     bool action_stop_capture();
@@ -507,6 +560,7 @@ private:
 	void feed_in_logic(const sr_datafeed_logic &o);
 
     void feed_in_dso(const sr_datafeed_dso &o);
+    void feed_eye(data::DsoSnapshot *dso, uint64_t start, bool new_frame);
 	void feed_in_analog(const sr_datafeed_analog &o);    
 	void data_feed_in(const struct sr_dev_inst *sdi,
 		        const struct sr_datafeed_packet *packet); 
@@ -549,6 +603,9 @@ private:
     pv::data::DecoderModel          *_decoder_model;
     std::vector<view::SpectrumTrace*> _spectrum_traces;
     view::LissajousTrace            *_lissajous_trace;
+    view::EyeTrace                  *_eye_trace;
+    data::DsoAccumulator            *_dso_accumulator;
+    data::PulseStats                *_pulse_stats;
     view::MathTrace                 *_math_trace;
   
     DsTimer     _feed_timer;
@@ -603,6 +660,9 @@ private:
     SessionData       *_view_data;
     SessionData       *_capture_data;
     std::vector<SessionData*> _data_list;
+    std::deque<SessionData*> _history;
+    SessionData       *_live_view_data;
+    int               _history_view;
     IDecoderPannel  *_decoder_pannel;
     sr_status       _dso_status;
     bool            _dso_status_valid;
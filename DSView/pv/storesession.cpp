@@ -32,6 +32,7 @@
 #include "data/decoderstack.h"
 #include "data/decode/decoder.h"
 #include "data/decode/row.h"
+#include "data/decode/annotation.h"
 #include "view/trace.h"
 #include "view/signal.h"
 #include "view/logicsignal.h"
@@ -48,6 +49,7 @@
 #include <math.h>
 #include <QTextStream>
 #include <list>
+#include <algorithm>
 
 #ifdef _WIN32
 #include <QTextCodec>
@@ -63,6 +65,9 @@
 #include "ui/langresource.h"
 
 #define DEOCDER_CONFIG_VERSION  2
+
+// The export output is written to the file in blocks of this size.
+#define EXPORT_BUFFER_SIZE  (4 * 1024 * 1024)
  
 namespace pv { 
 
@@ -71,8 +76,13 @@ StoreSession::StoreSession(SigSession *session) :
     _outModule(NULL),
 	_units_stored(0),
     _unit_count(0),
+    _bytes_stored(0),
+    _fill_bytes(0),
+    _write_stop(false),
+    _write_failed(false),
     _has_error(false),
-    _canceled(false)
+    _canceled(false),
+    _export_annotations(false)
 { 
     _sessionDataGetter = NULL;
 }
@@ -115,8 +125,11 @@ QList<QString> StoreSession::getSuportedExportFormats(){
         if(*supportedModules == NULL)
             break;
         if (_session->get_device()->get_work_mode() != LOGIC &&
-            strcmp((*supportedModules)->id, "csv"))
-            break;
+            strcmp((*supportedModules)->id, "csv") &&
+            strcmp((*supportedModules)->id, "dscol")){
+            supportedModules++;
+            continue;
+        }
         QString format((*supportedModules)->desc);
         format.append(" (*.");
         format.append((*supportedModules)->id);
@@ -783,11 +796,22 @@ void StoreSession::export_proc(data::Snapshot *snapshot)
        }
     }
 
-    QFile file(_file_name);
-    file.open(QIODevice::WriteOnly | QIODevice::Text);
-    QTextStream out(&file); 
-    encoding::set_utf8(out);
-    //out.setGenerateByteOrderMark(true);  // UTF-8 without BOM
+    // The module output is UTF-8 already, it is written as it is.
+    QIODevice::OpenMode mode = QIODevice::WriteOnly;
+    if (strcmp(_outModule->id, "dscol") != 0)
+        mode |= QIODevice::Text;
+
+    // The writer keeps its own large batches, the file needs no buffer.
+    _out_file.setFileName(_file_name);
+    if (!_out_file.open(mode | QIODevice::Unbuffered)){
+        dsv_err("Failed to open the export file.");
+        _has_error = true;
+        _error = L_S(STR_PAGE_MSG, S_ID(IDS_MSG_STORESESS_EXPORTPROC_ERROR4), "Failed to open the export file.");
+        _outModule->cleanup(&output);
+        g_hash_table_destroy(params);
+        return;
+    }
+    start_writer();
 
     // Meta
     GString *data_out;
@@ -836,25 +860,31 @@ void StoreSession::export_proc(data::Snapshot *snapshot)
     p.payload = &meta;
     p.bExportOriginalData = 0;
     _outModule->receive(&output, &p, &data_out);
+    bool write_ok = write_out(data_out);
 
-    if(data_out){
-        out << QString::fromUtf8((char*) data_out->str);
-        g_string_free(data_out,TRUE);
-    }
     for (GSList *l = meta.config; l; l = l->next) {
         src = (struct sr_config *)l->data;
         _session->get_device()->free_config(src);
     }
     g_slist_free(meta.config);
 
-    if (channel_type == SR_CHANNEL_LOGIC) {
+    bool edge_module = (origin_flag == 0 && strcmp(_outModule->id, "csv") == 0)
+                        || strcmp(_outModule->id, "dscol") == 0;
+
+    if (channel_type == SR_CHANNEL_LOGIC && edge_module) {
+        _unit_count = logic_snapshot->get_ring_sample_count();
+        if (write_ok)
+            write_ok = export_logic_edges(logic_snapshot, &output);
+    }
+    else if (channel_type == SR_CHANNEL_LOGIC) {
         _unit_count = logic_snapshot->get_ring_sample_count();
         int blk_num = logic_snapshot->get_block_num();
         bool sample;
         std::vector<uint8_t *> buf_vec;
         std::vector<bool> buf_sample;
+        std::vector<uint8_t> xbuf;
 
-        for (int blk = 0; !_canceled  &&  blk < blk_num; blk++) {
+        for (int blk = 0; !_canceled && write_ok && blk < blk_num; blk++) {
             uint64_t buf_sample_num = logic_snapshot->get_block_size(blk) * 8;
             buf_vec.clear();
             buf_sample.clear();
@@ -875,28 +905,40 @@ void StoreSession::export_proc(data::Snapshot *snapshot)
             unsigned int usize = 8192;
             unsigned int size = usize;
             struct sr_datafeed_logic lp;
+            memset(&lp, 0, sizeof(lp));
+            lp.format = LA_CROSS_DATA;
+
+            xbuf.resize(usize * unitsize);
 
             for(uint64_t i = 0; !_canceled && i < buf_sample_num; i+=usize){
                 if(buf_sample_num - i < usize)
                     size = buf_sample_num - i;
-                uint8_t *xbuf = (uint8_t *)malloc(size * unitsize);
-                if (xbuf == NULL) {
-                    _has_error = true;
-                    _error = L_S(STR_PAGE_DLG, S_ID(IDS_MSG_STORESESS_EXPORTPROC_ERROR2), "xbuffer malloc failed.");
-                    return;
-                }                
-                memset(xbuf, 0, size * unitsize);
-
-                for (uint64_t j = 0; j < size; j++) {
-                    for (unsigned int k = 0; k < buf_vec.size(); k++) {
-                        if (buf_vec[k] == NULL && buf_sample[k])
-                            xbuf[j*unitsize+k/8] +=  1 << k%8;
-                        else if (buf_vec[k] && (buf_vec[k][(i+j)/8] & (1 << j%8)))
-                            xbuf[j*unitsize+k/8] +=  1 << k%8;
+                memset(xbuf.data(), 0, size * unitsize);
+
+                // Transpose a channel at a time, skipping the zero bytes.
+                for (unsigned int k = 0; k < buf_vec.size(); k++) {
+                    uint8_t *wr = xbuf.data() + k / 8;
+                    uint8_t mask = 1 << k % 8;
+
+                    if (buf_vec[k] == NULL) {
+                        if (buf_sample[k]) {
+                            for (uint64_t j = 0; j < size; j++)
+                                wr[j * unitsize] |= mask;
+                        }
+                        continue;
+                    }
+
+                    const uint8_t *rd = buf_vec[k] + i / 8;
+                    for (uint64_t j = 0; j < size; j += 8) {
+                        uint8_t v = rd[j / 8];
+                        for (int b = 0; v != 0; b++, v >>= 1) {
+                            if (v & 1)
+                                wr[(j + b) * unitsize] |= mask;
+                        }
                     }
                 }
 
-                lp.data = xbuf;
+                lp.data = xbuf.data();
                 lp.length = size * unitsize;
                 lp.unitsize = unitsize;
                 p.type = SR_DF_LOGIC;
@@ -904,15 +946,12 @@ void StoreSession::export_proc(data::Snapshot *snapshot)
                 p.payload = &lp;
                 p.bExportOriginalData = origin_flag;
                 _outModule->receive(&output, &p, &data_out);
-
-                if(data_out){
-                    out << QString::fromUtf8((char*) data_out->str);
-                    g_string_free(data_out,TRUE);
+                if (!write_out(data_out)) {
+                    write_ok = false;
+                    break;
                 }
 
                 _units_stored += size;
-                if (xbuf)
-                    free(xbuf);
                 progress_updated();
             }
         }
@@ -926,12 +965,13 @@ void StoreSession::export_proc(data::Snapshot *snapshot)
         uint8_t *ch_data_buffer = (uint8_t*)malloc(usize * dso_snapshot->get_channel_num() + 1);
         if (ch_data_buffer == NULL){
             dsv_err("StoreSession::export_proc, malloc failed.");
-            return;
+            _has_error = true;
+            _error = L_S(STR_PAGE_DLG, S_ID(IDS_MSG_STORESESS_EXPORTPROC_ERROR2), "xbuffer malloc failed.");
         }
 
         int ch_num = dso_snapshot->get_channel_num();
 
-        for(uint64_t i = 0; !_canceled && i < _unit_count; i+=usize){
+        for(uint64_t i = 0; ch_data_buffer && !_canceled && write_ok && i < _unit_count; i+=usize){
             if(_unit_count - i < usize)
                 size = _unit_count - i;
 
@@ -965,10 +1005,9 @@ void StoreSession::export_proc(data::Snapshot *snapshot)
             p.payload = &dp;
             p.bExportOriginalData = 0;
             _outModule->receive(&output, &p, &data_out);
-
-            if(data_out){
-                out << (char*) data_out->str;
-                g_string_free(data_out,TRUE);
+            if (!write_out(data_out)) {
+                write_ok = false;
+                break;
             }
 
             _units_stored += size;
@@ -1000,7 +1039,7 @@ void StoreSession::export_proc(data::Snapshot *snapshot)
         block_buffer[1] = data_buffer;
         block_samples[1] = ring_start;
 
-        for (int j=0; j<2; j++)
+        for (int j=0; j<2 && write_ok; j++)
         {  
             uint64_t sample_count = block_samples[j];
 
@@ -1027,11 +1066,10 @@ void StoreSession::export_proc(data::Snapshot *snapshot)
                 p.payload = &ap;
                 p.bExportOriginalData = 0;
                 _outModule->receive(&output, &p, &data_out);
-
-                if(data_out){
-                    out << (char*) data_out->str;
-                    g_string_free(data_out,TRUE);
-                }           
+                if (!write_out(data_out)) {
+                    write_ok = false;
+                    break;
+                }
 
                 _units_stored += size;
                 progress_updated();
@@ -1041,8 +1079,21 @@ void StoreSession::export_proc(data::Snapshot *snapshot)
         }
     }
 
-    // optional, as QFile destructor will already do it:
-    file.close();
+    if (_export_annotations && !_canceled && write_ok)
+        write_ok = export_annotations(&output);
+
+    p.type = SR_DF_END;
+    p.status = SR_PKT_OK;
+    p.payload = NULL;
+    p.bExportOriginalData = 0;
+    _outModule->receive(&output, &p, &data_out);
+    if (write_ok)
+        write_out(data_out);
+    else if (data_out != NULL)
+        g_string_free(data_out, TRUE);
+
+    stop_writer();
+    _out_file.close();
     _outModule->cleanup(&output);
     g_hash_table_destroy(params);
     if (filenameGVariant != NULL)
@@ -1052,6 +1103,301 @@ void StoreSession::export_proc(data::Snapshot *snapshot)
 }
 
  
+// Sends only the samples where any channel changes, found 64 samples
+// at a time. A block with no data of any channel only checks its first word.
+bool StoreSession::export_logic_edges(data::LogicSnapshot *logic_snapshot, struct sr_output *output)
+{
+    std::vector<int> ch_index;
+
+    for(auto s : _session->get_signals()) {
+        if (s->get_type() == SR_CHANNEL_LOGIC && logic_snapshot->has_data(s->get_index()))
+            ch_index.push_back(s->get_index());
+    }
+
+    const int ch_num = ch_index.size();
+    if (ch_num == 0)
+        return true;
+
+    const uint16_t unitsize = (ch_num + 7) / 8;
+    const unsigned int max_units = 8192;
+    std::vector<uint8_t*> buf_vec(ch_num);
+    std::vector<uint64_t> words(ch_num);
+    std::vector<uint64_t> last(ch_num, 0);
+    std::vector<uint8_t> units(max_units * unitsize);
+    std::vector<uint64_t> sample_index(max_units);
+    unsigned int unit_num = 0;
+    uint64_t sample_base = 0;
+    bool first = true;
+
+    struct sr_datafeed_packet p;
+    struct sr_datafeed_logic lp;
+    GString *data_out;
+
+    memset(&lp, 0, sizeof(lp));
+    lp.format = LA_EDGE_DATA;
+    lp.unitsize = unitsize;
+    lp.data = units.data();
+    lp.sample_index = sample_index.data();
+    p.type = SR_DF_LOGIC;
+    p.status = SR_PKT_OK;
+    p.payload = &lp;
+    p.bExportOriginalData = 0;
+
+    int blk_num = logic_snapshot->get_block_num();
+
+    for (int blk = 0; !_canceled && blk < blk_num; blk++) {
+        uint64_t blk_bytes = logic_snapshot->get_block_size(blk);
+        bool idle = true;
+
+        for (int k = 0; k < ch_num; k++) {
+            bool sample;
+            buf_vec[k] = logic_snapshot->get_block_buf(blk, ch_index[k], sample);
+
+            if (buf_vec[k] == NULL)
+                words[k] = sample ? ~0ULL : 0;
+            else
+                idle = false;
+        }
+
+        for (uint64_t pos = 0; !_canceled && pos < blk_bytes; pos += 8) {
+            uint64_t bytes = std::min<uint64_t>(8, blk_bytes - pos);
+            uint64_t valid = (bytes == 8) ? ~0ULL : (1ULL << bytes * 8) - 1;
+            uint64_t change = first ? 1 : 0;
+            first = false;
+
+            for (int k = 0; k < ch_num; k++) {
+                if (buf_vec[k] != NULL) {
+                    words[k] = 0;
+                    memcpy(&words[k], buf_vec[k] + pos, bytes);
+                }
+                change |= (words[k] ^ ((words[k] << 1) | last[k])) & valid;
+                last[k] = (words[k] >> (bytes * 8 - 1)) & 1;
+            }
+
+            for (int bit = 0; change != 0; bit++, change >>= 1) {
+                if ((change & 1) == 0)
+                    continue;
+
+                uint8_t *unit = &units[unit_num * unitsize];
+                memset(unit, 0, unitsize);
+
+                for (int k = 0; k < ch_num; k++) {
+                    if ((words[k] >> bit) & 1)
+                        unit[k / 8] |= 1 << (k % 8);
+                }
+                sample_index[unit_num] = sample_base + pos * 8 + bit;
+
+                if (++unit_num == max_units) {
+                    lp.length = unit_num * unitsize;
+                    _outModule->receive(output, &p, &data_out);
+                    if (!write_out(data_out))
+                        return false;
+                    unit_num = 0;
+                }
+            }
+
+            // The rest of an idle block repeats the first word.
+            if (idle)
+                break;
+        }
+
+        sample_base += blk_bytes * 8;
+        _units_stored += blk_bytes * 8;
+        progress_updated();
+    }
+
+    if (unit_num > 0) {
+        lp.length = unit_num * unitsize;
+        _outModule->receive(output, &p, &data_out);
+        return write_out(data_out);
+    }
+    return true;
+}
+
+// Sends the annotations of the rows shown in the protocol list, a page at a time.
+bool StoreSession::export_annotations(struct sr_output *output)
+{
+    const uint64_t page_size = 4096;
+    std::vector<data::decode::Annotation> page;
+    std::vector<QByteArray> texts;
+    std::vector<const char*> text_ptrs;
+    std::vector<uint64_t> starts;
+    std::vector<uint64_t> ends;
+    struct sr_datafeed_packet p;
+    struct sr_datafeed_annotation ap;
+    GString *data_out;
+
+    p.type = SR_DF_ANNOTATION;
+    p.status = SR_PKT_OK;
+    p.payload = &ap;
+    p.bExportOriginalData = 0;
+
+    for (auto trace : _session->get_decode_signals()) {
+        data::DecoderStack *stack = trace->decoder();
+        int row_num = stack->list_rows_size();
+
+        for (int row = 0; !_canceled && row < row_num; row++) {
+            QString title;
+            if (!stack->list_row_title(row, title))
+                continue;
+
+            QByteArray row_name = title.toUtf8();
+            uint64_t total = stack->list_annotation_size(row);
+
+            for (uint64_t start = 0; !_canceled && start < total; start += page_size) {
+                uint64_t num = stack->list_annotation_page(page, row, start, page_size);
+                if (num == 0)
+                    break;
+
+                texts.clear();
+                text_ptrs.clear();
+                starts.clear();
+                ends.clear();
+
+                for (const auto &ann : page) {
+                    const std::vector<QString> strs = ann.annotations();
+                    texts.push_back(strs.empty() ? QByteArray() : strs[0].toUtf8());
+                    starts.push_back(ann.start_sample());
+                    ends.push_back(ann.end_sample());
+                }
+                for (auto &t : texts)
+                    text_ptrs.push_back(t.constData());
+
+                ap.row = row_name.constData();
+                ap.num = page.size();
+                ap.start = starts.data();
+                ap.end = ends.data();
+                ap.text = text_ptrs.data();
+                _outModule->receive(output, &p, &data_out);
+                if (!write_out(data_out))
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Collects the module output, a full batch goes to the writer thread.
+// The module output is queued as it is, without copying it again.
+// Returns false once the writer has failed, the export has to stop.
+bool StoreSession::write_out(GString *data)
+{
+    if (data == NULL)
+        return true;
+
+    if (data->len == 0){
+        g_string_free(data, TRUE);
+        return true;
+    }
+
+    _fill_batch.push_back(data);
+    _fill_bytes += data->len;
+
+    if (_fill_bytes >= EXPORT_BUFFER_SIZE)
+        return flush_out();
+    return true;
+}
+
+// Hands the filled batch to the writer, after it is done with the last one.
+bool StoreSession::flush_out()
+{
+    std::unique_lock<std::mutex> lock(_write_mutex);
+    _write_cond.wait(lock, [this]{ return _write_batch.empty() || _write_failed; });
+
+    if (_write_failed) {
+        free_batch(_fill_batch);
+        _fill_bytes = 0;
+        return false;
+    }
+
+    if (_fill_batch.empty())
+        return true;
+
+    _write_batch.swap(_fill_batch);
+    _fill_bytes = 0;
+    _write_cond.notify_all();
+    return true;
+}
+
+void StoreSession::free_batch(std::vector<GString*> &batch)
+{
+    for (GString *data : batch)
+        g_string_free(data, TRUE);
+    batch.clear();
+}
+
+void StoreSession::start_writer()
+{
+    _fill_batch.clear();
+    _write_batch.clear();
+    _fill_bytes = 0;
+    _bytes_stored = 0;
+    _write_stop = false;
+    _write_failed = false;
+    _write_thread = std::thread(&StoreSession::write_proc, this);
+}
+
+// Writes the last batch and waits for the writer to end.
+void StoreSession::stop_writer()
+{
+    flush_out();
+
+    {
+        std::lock_guard<std::mutex> lock(_write_mutex);
+        _write_stop = true;
+    }
+    _write_cond.notify_all();
+
+    if (_write_thread.joinable())
+        _write_thread.join();
+
+    free_batch(_fill_batch);
+    free_batch(_write_batch);
+}
+
+void StoreSession::write_proc()
+{
+    std::vector<GString*> batch;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_write_mutex);
+            _write_cond.wait(lock, [this]{ return !_write_batch.empty() || _write_stop; });
+
+            if (_write_batch.empty())
+                break;
+            batch.swap(_write_batch);
+        }
+        _write_cond.notify_all();
+
+        bool failed = false;
+
+        for (GString *data : batch){
+            if (_out_file.write(data->str, data->len) != (qint64)data->len){
+                failed = true;
+                break;
+            }
+            _bytes_stored += data->len;
+        }
+
+        if (failed){
+            dsv_err("Failed to write the export file.");
+            free_batch(batch);
+
+            // the exporter sees it on the next flush and stops
+            std::lock_guard<std::mutex> lock(_write_mutex);
+            _has_error = true;
+            _error = L_S(STR_PAGE_MSG, S_ID(IDS_MSG_STORESESS_EXPORTPROC_ERROR3), "Failed to write the export file.");
+            _write_failed = true;
+            _write_cond.notify_all();
+            break;
+        }
+
+        free_batch(batch);
+    }
+}
+ 
 bool StoreSession::decoders_gen(std::string &str)
 {  
     QJsonArray dec_array;
@@ -26,7 +26,11 @@
 #include <stdint.h>
 #include <string>
 #include <thread>  
+#include <vector>
+#include <mutex>
+#include <condition_variable>
 #include <QObject>
+#include <QFile>
 #include <libsigrok.h> 
 
 #include "interface/icallbacks.h"
@@ -61,6 +65,14 @@ public:
 
 	std::pair<uint64_t, uint64_t> progress();
 
+    inline uint64_t bytes_stored(){
+        return _bytes_stored;
+    }
+
+    inline void set_export_annotations(bool enable){
+        _export_annotations = enable;
+    }
+
 	const QString& error();
 
     bool save_start();
@@ -78,6 +90,14 @@ private:
     void save_dso(pv::data::DsoSnapshot *dso_snapshot);
     bool meta_gen(data::Snapshot *snapshot, std::string &str);
     void export_proc(pv::data::Snapshot *snapshot);   
+    bool export_logic_edges(pv::data::LogicSnapshot *logic_snapshot, struct sr_output *output);
+    bool export_annotations(struct sr_output *output);
+    bool write_out(GString *data);
+    bool flush_out();
+    void free_batch(std::vector<GString*> &batch);
+    void start_writer();
+    void stop_writer();
+    void write_proc();
     bool decoders_gen(std::string &str);
  
 
@@ -115,9 +135,22 @@ private:
  
 	uint64_t        _units_stored;
 	uint64_t        _unit_count;
+    volatile uint64_t _bytes_stored;
+    QFile           _out_file;
+
+    // The export output, one batch filled while the other is written.
+    std::thread     _write_thread;
+    std::mutex      _write_mutex;
+    std::condition_variable _write_cond;
+    std::vector<GString*> _fill_batch;
+    std::vector<GString*> _write_batch;
+    uint64_t        _fill_bytes;
+    bool            _write_stop;
+    bool            _write_failed;
     bool            _has_error;
 	QString         _error;
     volatile bool   _canceled;
+    bool            _export_annotations;
     ZipMaker        m_zipDoc;  
 };
 
@@ -28,7 +28,10 @@
 #include "../sigsession.h"
 #include "../dialogs/fftoptions.h"
 #include "../dialogs/lissajousoptions.h"
+#include "../dialogs/eyeoptions.h"
 #include "../dialogs/mathoptions.h"
+#include "../dialogs/capturehistory.h"
+#include "../data/dsoaccumulator.h"
 #include "../view/trace.h"
 #include "../dialogs/applicationpardlg.h"
 #include "../ui/langresource.h"
@@ -69,6 +72,12 @@ TrigBar::TrigBar(SigSession *session, QWidget *parent) :
 
     _action_lissajous = new QAction(this);
     _action_lissajous->setObjectName(QString::fromUtf8("actionLissajous"));
+
+    _action_eye = new QAction(this);
+    _action_eye->setObjectName(QString::fromUtf8("actionEye"));
+
+    _action_history = new QAction(this);
+    _action_history->setObjectName(QString::fromUtf8("actionHistory"));
    
     _dark_style = new QAction(this);
     _dark_style->setObjectName(QString::fromUtf8("actionDark"));
@@ -83,10 +92,40 @@ TrigBar::TrigBar(SigSession *session, QWidget *parent) :
 
      _action_dispalyOptions = new QAction(this);
 
+    // dso frame accumulation, one mode at a time
+    _action_accum_off = new QAction(this);
+    _action_accum_off->setData(data::DsoAccumulator::ACCUM_OFF);
+    _action_accum_average = new QAction(this);
+    _action_accum_average->setData(data::DsoAccumulator::ACCUM_AVERAGE);
+    _action_accum_envelope = new QAction(this);
+    _action_accum_envelope->setData(data::DsoAccumulator::ACCUM_ENVELOPE);
+    _action_accum_persist = new QAction(this);
+    _action_accum_persist->setData(data::DsoAccumulator::ACCUM_PERSIST);
+    _action_accum_reset = new QAction(this);
+
+    _accumulate_group = new QActionGroup(this);
+    _accumulate_group->setExclusive(true);
+
+    for (QAction *action : {_action_accum_off, _action_accum_average,
+                            _action_accum_envelope, _action_accum_persist}) {
+        action->setCheckable(true);
+        _accumulate_group->addAction(action);
+    }
+    _action_accum_off->setChecked(true);
+
+    _accumulate_menu = new QMenu(this);
+    _accumulate_menu->setObjectName(QString::fromUtf8("menuAccumulate"));
+    _accumulate_menu->addActions(_accumulate_group->actions());
+    _accumulate_menu->addSeparator();
+    _accumulate_menu->addAction(_action_accum_reset);
+
     _display_menu = new QMenu(this);
     _display_menu->setContentsMargins(0,0,0,0);
     
     _display_menu->addAction(_action_lissajous);    
+    _display_menu->addAction(_action_eye);
+    _display_menu->addAction(_action_history);
+    _display_menu->addMenu(_accumulate_menu);
     _display_menu->addMenu(_themes);
 	_display_menu->addAction(_action_dispalyOptions);
 
@@ -119,6 +158,10 @@ TrigBar::TrigBar(SigSession *session, QWidget *parent) :
     connect(_action_fft, SIGNAL(triggered()), this, SLOT(on_actionFft_triggered()));
     connect(_action_math, SIGNAL(triggered()), this, SLOT(on_actionMath_triggered()));
     connect(_action_lissajous, SIGNAL(triggered()), this, SLOT(on_actionLissajous_triggered()));
+    connect(_action_eye, SIGNAL(triggered()), this, SLOT(on_actionEye_triggered()));
+    connect(_action_history, SIGNAL(triggered()), this, SLOT(on_actionHistory_triggered()));
+    connect(_accumulate_group, SIGNAL(triggered(QAction*)), this, SLOT(on_accumulate_mode(QAction*)));
+    connect(_action_accum_reset, SIGNAL(triggered()), this, SLOT(on_accumulate_reset()));
     connect(_dark_style, SIGNAL(triggered()), this, SLOT(on_actionDark_triggered()));
     connect(_light_style, SIGNAL(triggered()), this, SLOT(on_actionLight_triggered()));
     connect(_action_dispalyOptions, SIGNAL(triggered()), this, SLOT(on_display_setting()));
@@ -147,6 +190,14 @@ void TrigBar::retranslateUi()
     _setting_button.setText(L_S(STR_PAGE_TOOLBAR, S_ID(IDS_TOOLBAR_DISPLAY), "Display"));    
     _themes->setTitle(L_S(STR_PAGE_TOOLBAR, S_ID(IDS_TOOLBAR_DISPLAY_THEMES), "Themes"));
     _action_lissajous->setText(L_S(STR_PAGE_TOOLBAR, S_ID(IDS_TOOLBAR_DISPLAY_LISSAJOUS), "Lissajous"));
+    _action_eye->setText(L_S(STR_PAGE_TOOLBAR, S_ID(IDS_TOOLBAR_DISPLAY_EYE), "Eye diagram"));
+    _action_history->setText(L_S(STR_PAGE_TOOLBAR, S_ID(IDS_TOOLBAR_DISPLAY_HISTORY), "Capture history"));
+    _accumulate_menu->setTitle(L_S(STR_PAGE_TOOLBAR, S_ID(IDS_TOOLBAR_DISPLAY_ACCUMULATE), "Accumulate"));
+    _action_accum_off->setText(L_S(STR_PAGE_TOOLBAR, S_ID(IDS_TOOLBAR_ACCUMULATE_OFF), "Off"));
+    _action_accum_average->setText(L_S(STR_PAGE_TOOLBAR, S_ID(IDS_TOOLBAR_ACCUMULATE_AVERAGE), "Average"));
+    _action_accum_envelope->setText(L_S(STR_PAGE_TOOLBAR, S_ID(IDS_TOOLBAR_ACCUMULATE_ENVELOPE), "Envelope"));
+    _action_accum_persist->setText(L_S(STR_PAGE_TOOLBAR, S_ID(IDS_TOOLBAR_ACCUMULATE_PERSIST), "Persistence"));
+    _action_accum_reset->setText(L_S(STR_PAGE_TOOLBAR, S_ID(IDS_TOOLBAR_ACCUMULATE_RESET), "Reset"));
 
    
     _dark_style->setText(L_S(STR_PAGE_TOOLBAR, S_ID(IDS_TOOLBAR_DISPLAY_THEMES_DARK), "Dark"));
@@ -172,6 +223,8 @@ void TrigBar::reStyle()
     _action_fft->setIcon(QIcon(iconPath+"/fft.svg"));
     _action_math->setIcon(QIcon(iconPath+"/math.svg"));
     _action_lissajous->setIcon(QIcon(iconPath+"/lissajous.svg"));
+    _action_eye->setIcon(QIcon(iconPath+"/osc.svg"));
+    _action_history->setIcon(QIcon(iconPath+"/repeat.svg"));
     _dark_style->setIcon(QIcon(iconPath+"/dark.svg"));
     _light_style->setIcon(QIcon(iconPath+"/light.svg"));
 
@@ -245,6 +298,9 @@ void TrigBar::reload()
         _search_action->setVisible(true);
         _function_action->setVisible(false);
         _action_lissajous->setVisible(false);
+        _action_eye->setVisible(false);
+        _action_history->setVisible(true);
+        _accumulate_menu->menuAction()->setVisible(false);
         _action_dispalyOptions->setVisible(true);
 
     } else if (mode == ANALOG) {
@@ -254,6 +310,9 @@ void TrigBar::reload()
         _search_action->setVisible(false);
         _function_action->setVisible(false);
         _action_lissajous->setVisible(false);
+        _action_eye->setVisible(false);
+        _action_history->setVisible(false);
+        _accumulate_menu->menuAction()->setVisible(false);
         _action_dispalyOptions->setVisible(true);
 
     } else if (mode == DSO) {
@@ -263,6 +322,9 @@ void TrigBar::reload()
         _search_action->setVisible(false);
         _function_action->setVisible(true);
         _action_lissajous->setVisible(true);
+        _action_eye->setVisible(true);
+        _action_history->setVisible(false);
+        _accumulate_menu->menuAction()->setVisible(true);
         _action_dispalyOptions->setVisible(true);
     }
 
@@ -315,6 +377,28 @@ void TrigBar::on_actionLissajous_triggered()
     lissajous_dlg.exec();
 }
 
+void TrigBar::on_actionEye_triggered()
+{
+    pv::dialogs::EyeOptions eye_dlg(_session, this);
+    eye_dlg.exec();
+}
+
+void TrigBar::on_actionHistory_triggered()
+{
+    pv::dialogs::CaptureHistory history_dlg(_session, this);
+    history_dlg.exec();
+}
+
+void TrigBar::on_accumulate_mode(QAction *action)
+{
+    _session->set_dso_accumulate_mode(action->data().toInt());
+}
+
+void TrigBar::on_accumulate_reset()
+{
+    _session->get_dso_accumulator()->reset();
+}
+
  void TrigBar::on_display_setting()
  {    
     pv::dialogs::ApplicationParamDlg dlg;
@@ -27,6 +27,7 @@
 #include <QToolButton>
 #include <QAction>
 #include <QMenu>
+#include <QActionGroup>
 #include "../interface/icallbacks.h"
 
 class DockOptions;
@@ -70,6 +71,10 @@ private slots:
     void on_actionDark_triggered();
     void on_actionLight_triggered();
     void on_actionLissajous_triggered();
+    void on_actionEye_triggered();
+    void on_actionHistory_triggered();
+    void on_accumulate_mode(QAction *action);
+    void on_accumulate_reset();
     void on_actionFft_triggered();
     void on_actionMath_triggered();
     void on_display_setting();
@@ -106,6 +111,16 @@ private:
     QAction     *_dark_style;
     QAction     *_light_style;
     QAction     *_action_lissajous;
+    QAction     *_action_eye;
+    QAction     *_action_history;
+
+    QMenu       *_accumulate_menu;
+    QActionGroup *_accumulate_group;
+    QAction     *_action_accum_off;
+    QAction     *_action_accum_average;
+    QAction     *_action_accum_envelope;
+    QAction     *_action_accum_persist;
+    QAction     *_action_accum_reset;
 };
 
 } // namespace toolbars
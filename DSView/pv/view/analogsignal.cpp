@@ -489,7 +489,9 @@ void AnalogSignal::paint_trace(QPainter &p,
         p.setPen(_colour);
         //p.setPen(QPen(_colour, 2, Qt::SolidLine));
 
-        QPointF *points = new QPointF[sample_count];
+        if (_trace_points.size() < (size_t)sample_count)
+            _trace_points.resize(sample_count);
+        QPointF *points = _trace_points.data();
         QPointF *point = points;
         uint64_t yindex = start_index;
 
@@ -518,7 +520,6 @@ void AnalogSignal::paint_trace(QPainter &p,
         }
 
         p.drawPolyline(points, point - points);
-        delete[] points;
     }
 }
 
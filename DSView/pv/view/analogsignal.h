@@ -23,6 +23,7 @@
 #ifndef DSVIEW_PV_ANALOGSIGNAL_H
 #define DSVIEW_PV_ANALOGSIGNAL_H
 
+#include <vector>
 #include "signal.h"
 
 namespace pv {
@@ -165,6 +166,7 @@ private:
 	pv::data::AnalogSnapshot *_data;
 
     QRectF *_rects;
+    std::vector<QPointF> _trace_points;
 
 	float _scale;
     double _zero_vrate;
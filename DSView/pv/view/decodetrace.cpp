@@ -428,8 +428,9 @@ void DecodeTrace::draw_instant(const pv::data::decode::Annotation &a, QPainter &
 {
     (void)outline;
 
-	const QString text = a.annotations().empty() ?
-		QString() : a.annotations().back();
+	const std::vector<QString> annotations = a.annotations();
+	const QString text = annotations.empty() ?
+		QString() : annotations.back();
 //	const double w = min((double)p.boundingRect(QRectF(), 0, text).width(),
 //		0.0) + h;
     const double w = min(min_annWidth, (double)h);
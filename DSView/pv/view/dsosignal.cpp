@@ -28,6 +28,7 @@
 #include "view.h"
 #include "../dsvdef.h"
 #include "../data/dsosnapshot.h"
+#include "../data/dsoaccumulator.h"
 #include "../sigsession.h" 
 #include "../log.h"
 #include "../appcontrol.h"
@@ -107,6 +108,9 @@ DsoSignal::DsoSignal(data::DsoSnapshot *data,
     _vDial = new dslDial(vValue.count(), vDialValueStep, vValue, vUnit);
     _colour = SignalColours[probe->index % countof(SignalColours)];
 
+    connect(session->get_dso_accumulator(), SIGNAL(accumulated()),
+            this, SLOT(on_accumulated()));
+
     load_settings();
 }
 
@@ -181,8 +185,11 @@ bool DsoSignal::go_vDialPre(bool manul)
 
     if (enabled() && !_vDial->isMin()) 
     {
-        if (session->is_running_status())
+        // frames of another scale don't mix
+        if (session->is_running_status()){
             session->refresh(RefreshShort);
+            session->reset_dso_accumulation();
+        }
 
         const double pre_vdiv = _vDial->get_value();
         _vDial->set_sel(_vDial->get_sel() - 1);
@@ -216,8 +223,11 @@ bool DsoSignal::go_vDialNext(bool manul)
 
     if (enabled() && !_vDial->isMax())
     {
-        if (session->is_running_status())
+        // frames of another scale don't mix
+        if (session->is_running_status()){
             session->refresh(RefreshShort);
+            session->reset_dso_accumulation();
+        }
 
         const double pre_vdiv = _vDial->get_value();
         _vDial->set_sel(_vDial->get_sel() + 1);
@@ -468,6 +478,9 @@ void DsoSignal::set_zero_ratio(double ratio)
     _zero_offset = ratio2value(ratio); 
     session->get_device()->set_config_uint16(SR_CONF_PROBE_OFFSET,
                           _zero_offset, _probe, NULL);
+
+    if (session->is_running_status())
+        session->reset_dso_accumulation();
 }
 
 void DsoSignal::set_factor(uint64_t factor)
@@ -803,12 +816,24 @@ void DsoSignal::paint_mid(QPainter &p, int left, int right, QColor fore, QColor
             (int64_t)0), last_sample);
         const int hw_offset = get_hw_offset();
 
-        if (samples_per_pixel < EnvelopeThreshold) {
+        // The average and persistence replace the live frame,
+        // the envelope is drawn behind it.
+        const int accum_mode = session->get_dso_accumulator()->get_mode();
+        bool live = true;
+
+        if (accum_mode != data::DsoAccumulator::ACCUM_OFF) {
+            live = !paint_accumulated(p, accum_mode, zeroY, left,
+                        start_sample, end_sample, hw_offset,
+                        pixels_offset, samples_per_pixel)
+                   || accum_mode == data::DsoAccumulator::ACCUM_ENVELOPE;
+        }
+
+        if (live && samples_per_pixel < EnvelopeThreshold) {
             _data->enable_envelope(false);
             paint_trace(p, _data, zeroY, left,
                 start_sample, end_sample, hw_offset,
                 pixels_offset, samples_per_pixel, enabled_channels);
-        } else {
+        } else if (live) {
             _data->enable_envelope(true);
             paint_envelope(p, _data, zeroY, left,
                 start_sample, end_sample, hw_offset,
@@ -981,7 +1006,9 @@ void DsoSignal::paint_trace(QPainter &p,
         trace_colour.setAlpha(View::ForeAlpha);
         p.setPen(trace_colour);
 
-        QPointF *points = new QPointF[sample_count];
+        if (_trace_points.size() < (size_t)sample_count)
+            _trace_points.resize(sample_count);
+        QPointF *points = _trace_points.data();
         QPointF *point = points;
 
         float top = get_view_rect().top();
@@ -1008,8 +1035,6 @@ void DsoSignal::paint_trace(QPainter &p,
         }
 
         p.drawPolyline(points, point - points);
-
-        delete[] points;
     }
 }
 
@@ -1036,7 +1061,9 @@ void DsoSignal::paint_envelope(QPainter &p,
     envelope_colour.setAlpha(View::ForeAlpha);
     p.setBrush(envelope_colour);
 
-	QRectF *const rects = new QRectF[e.length];
+    if (_envelope_rects.size() < e.length)
+        _envelope_rects.resize(e.length);
+	QRectF *const rects = _envelope_rects.data();
 	QRectF *rect = rects;
     float top = get_view_rect().top();
     float bottom = get_view_rect().bottom();
@@ -1061,9 +1088,148 @@ void DsoSignal::paint_envelope(QPainter &p,
 	}
 
 	p.drawRects(rects, e.length);
+}
+
+bool DsoSignal::paint_accumulated(QPainter &p, int mode,
+    int zeroY, int left, const int64_t start, const int64_t end, int hw_offset,
+    const double pixels_offset, const double samples_per_pixel)
+{
+    using pv::data::DsoAccumulator;
 
-	delete[] rects;
-    //delete[] e.samples;
+    DsoAccumulator *accum = session->get_dso_accumulator();
+    const int index = get_index();
+    const double pixels_per_sample = 1.0 / samples_per_pixel;
+    const float x = (start / samples_per_pixel - pixels_offset) + left + _view->trig_hoff()*pixels_per_sample;
+
+    if (mode == DsoAccumulator::ACCUM_PERSIST) {
+        int columns = 0;
+        uint64_t samples = 0;
+        if (!accum->get_persistence(index, _persist_cells, columns, samples))
+            return false;
+
+        if (_persist_image.width() != columns)
+            _persist_image = QImage(columns, DsoAccumulator::Levels, QImage::Format_ARGB32_Premultiplied);
+
+        // one image row per adc code, the hit count grades the alpha
+        const uint8_t *cells = _persist_cells.data();
+        for (int v = 0; v < DsoAccumulator::Levels; v++) {
+            QRgb *line = (QRgb*)_persist_image.scanLine(v);
+            for (int col = 0; col < columns; col++) {
+                const int a = *cells++;
+                line[col] = qRgba(_colour.red() * a / 255, _colour.green() * a / 255,
+                                  _colour.blue() * a / 255, a);
+            }
+        }
+
+        const QRect rect = get_view_rect();
+        const float x0 = x - start * pixels_per_sample;
+        const float y0 = zeroY + (-0.5f - hw_offset) * _scale;
+        const float y1 = zeroY + (DsoAccumulator::Levels - 0.5f - hw_offset) * _scale;
+        const QRectF target(x0, min(y0, y1), samples * pixels_per_sample, fabs(y1 - y0));
+
+        p.save();
+        p.setClipRect(QRect(left, rect.top(), rect.right() - left, rect.height()));
+        p.drawImage(target, y1 < y0 ? _persist_image.mirrored(false, true) : _persist_image);
+        p.restore();
+        return true;
+    }
+
+    const int64_t count = end - start + 1;
+    if (count < 2)
+        return false;
+
+    if (mode == DsoAccumulator::ACCUM_AVERAGE) {
+        if (!accum->get_average(index, start, end, _accum_lo))
+            return false;
+
+        if (samples_per_pixel < 1) {
+            if (_trace_points.size() < (size_t)count)
+                _trace_points.resize(count);
+
+            const float top = get_view_rect().top();
+            const float bottom = get_view_rect().bottom();
+            QPointF *point = _trace_points.data();
+
+            for (int64_t i = 0; i < count; i++) {
+                const float y = zeroY + (_accum_lo[i] - hw_offset) * _scale;
+                *point++ = QPointF(x + i * pixels_per_sample, min(max(top, y), bottom));
+            }
+
+            QColor trace_colour = _colour;
+            trace_colour.setAlpha(View::ForeAlpha);
+            p.setPen(trace_colour);
+            p.drawPolyline(_trace_points.data(), count);
+        }
+        else {
+            paint_band(p, _accum_lo.data(), _accum_lo.data(), count,
+                       x, zeroY, hw_offset, samples_per_pixel, View::ForeAlpha);
+        }
+        return true;
+    }
+
+    if (mode == DsoAccumulator::ACCUM_ENVELOPE) {
+        if (!accum->get_envelope(index, start, end, _accum_min, _accum_max))
+            return false;
+
+        _accum_lo.assign(_accum_min.begin(), _accum_min.end());
+        _accum_hi.assign(_accum_max.begin(), _accum_max.end());
+        paint_band(p, _accum_lo.data(), _accum_hi.data(), count,
+                   x, zeroY, hw_offset, samples_per_pixel, View::BackAlpha);
+        return true;
+    }
+
+    return false;
+}
+
+// Fills lo..hi, one column per pixel or per sample when zoomed in
+void DsoSignal::paint_band(QPainter &p, const float *lo, const float *hi, int64_t count,
+    float x, int zeroY, int hw_offset, const double samples_per_pixel, int alpha)
+{
+    const float top = get_view_rect().top();
+    const float bottom = get_view_rect().bottom();
+    const float right = get_view_rect().right();
+    const int64_t step = max((int64_t)1, (int64_t)samples_per_pixel);
+    const float width = max(1.0, 1.0 / samples_per_pixel);
+
+    if (_envelope_rects.size() < (size_t)(count / step + 1))
+        _envelope_rects.resize(count / step + 1);
+    QRectF *const rects = _envelope_rects.data();
+    QRectF *rect = rects;
+
+    for (int64_t i = 0; i < count; i += step) {
+        const float col_x = x + i / samples_per_pixel;
+        if (col_x > right)
+            break;
+
+        const int64_t n = min(step, count - i);
+        float vmin = lo[i];
+        float vmax = hi[i];
+        for (int64_t k = 1; k < n; k++) {
+            vmin = min(vmin, lo[i + k]);
+            vmax = max(vmax, hi[i + k]);
+        }
+
+        const float y0 = min(max(top, zeroY + (vmin - hw_offset) * _scale), bottom);
+        const float y1 = min(max(top, zeroY + (vmax - hw_offset) * _scale), bottom);
+        const float h = max(fabs(y1 - y0), 1.0f);
+
+        *rect++ = QRectF(col_x, min(y0, y1), width, h);
+    }
+
+    QColor band_colour = _colour;
+    band_colour.setAlpha(alpha);
+    p.setPen(QPen(Qt::NoPen));
+    p.setBrush(band_colour);
+    p.drawRects(rects, rect - rects);
+}
+
+void DsoSignal::on_accumulated()
+{
+    if (!_view || !enabled())
+        return;
+
+    _view->set_update(_viewport, true);
+    _view->update();
 }
 
 void DsoSignal::paint_type_options(QPainter &p, int right, const QPoint pt, QColor fore)
@@ -23,6 +23,8 @@
 #ifndef DSVIEW_PV_DSOSIGNAL_H
 #define DSVIEW_PV_DSOSIGNAL_H
 
+#include <vector>
+#include <QImage>
 #include "signal.h"
 #include "../dstimer.h"
   
@@ -259,11 +261,21 @@ private:
         const double pixels_offset, const double samples_per_pixel,
         uint64_t num_channels);
 
+    bool paint_accumulated(QPainter &p, int mode,
+        int zeroY, int left, const int64_t start, const int64_t end, int hw_offset,
+        const double pixels_offset, const double samples_per_pixel);
+
+    void paint_band(QPainter &p, const float *lo, const float *hi, int64_t count,
+        float x, int zeroY, int hw_offset, const double samples_per_pixel, int alpha);
+
     void paint_hover_measure(QPainter &p, QColor fore, QColor back);
     void auto_set();
 
     void call_auto_end();
 
+private slots:
+    void on_accumulated();
+
 private:
     pv::data::DsoSnapshot *_data;
 	float _scale;
@@ -307,6 +319,16 @@ private:
     QPointF _hover_point;
     float _hover_value;
     DsTimer _end_timer;
+
+    // reused across paints, only ever grown
+    std::vector<QPointF> _trace_points;
+    std::vector<QRectF> _envelope_rects;
+    std::vector<float> _accum_lo;
+    std::vector<float> _accum_hi;
+    std::vector<uint8_t> _accum_min;
+    std::vector<uint8_t> _accum_max;
+    std::vector<uint8_t> _persist_cells;
+    QImage _persist_image;
 };
 
 } // namespace view
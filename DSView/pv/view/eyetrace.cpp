@@ -0,0 +1,245 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2016 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+
+#include "eyetrace.h"
+
+#include <math.h>
+#include <QPolygonF>
+#include <QStringList>
+
+#include "view.h"
+#include "ruler.h"
+#include "dsosignal.h"
+#include "../sigsession.h"
+#include "../dsvdef.h"
+#include "../ui/langresource.h"
+
+using namespace std;
+
+namespace pv {
+namespace view {
+
+EyeTrace::EyeTrace(bool enable, data::EyeStack *eye_stack):
+    Trace("Eye", eye_stack->data_index(), SR_CHANNEL_EYE),
+    _eye_stack(eye_stack),
+    _enable(enable),
+    _has_eye(false),
+    _samplerate(0)
+{
+    _stats.valid = false;
+
+    connect(_eye_stack, SIGNAL(eye_updated()), this, SLOT(on_eye_updated()));
+}
+
+EyeTrace::~EyeTrace()
+{
+    DESTROY_OBJECT(_eye_stack);
+}
+
+DsoSignal* EyeTrace::find_signal()
+{
+    for (auto s : _view->session().get_signals()) {
+        if (s->signal_type() == SR_CHANNEL_DSO && s->get_index() == _eye_stack->data_index())
+            return (DsoSignal*)s;
+    }
+    return NULL;
+}
+
+// histogram cell coordinates to the screen, adc code 0 on top
+QPointF EyeTrace::cell_point(double column, double level)
+{
+    using pv::data::EyeStack;
+
+    return QPointF(_border.left() + column * _border.width() / EyeStack::Columns,
+                   _border.top() + (level + 0.5) * _border.height() / EyeStack::Levels);
+}
+
+void EyeTrace::paint_back(QPainter &p, int left, int right, QColor fore, QColor back)
+{
+    assert(_view);
+
+    fore.setAlpha(view::View::BackAlpha);
+    _border = QRect(left, 0, right - left, _viewport->height()).marginsRemoved(QMargins(10, 10, 10, 10));
+
+    QPen solidPen(fore);
+    solidPen.setStyle(Qt::SolidLine);
+    p.setPen(solidPen);
+    p.setBrush(back.black() > 0x80 ? back.darker() : back.lighter());
+    p.drawRect(_border);
+
+    QPen dashPen(fore);
+    dashPen.setStyle(Qt::DashLine);
+    p.setPen(dashPen);
+
+    // two unit intervals across, a line every quarter
+    const double spanY = _border.height() / (double)DIV_NUM;
+    const double spanX = _border.width() / (double)DIV_NUM;
+
+    for (int i = 1; i < DIV_NUM; i++) {
+        const double posY = _border.top() + spanY * i;
+        p.drawLine(_border.left(), posY, _border.right(), posY);
+        const double posX = _border.left() + spanX * i;
+        p.drawLine(posX, _border.top(), posX, _border.bottom());
+    }
+
+    fore.setAlpha(view::View::ForeAlpha);
+    p.setPen(fore);
+    p.drawText(_border.marginsRemoved(QMargins(10, 10, 10, 10)),
+               L_S(STR_PAGE_DLG, S_ID(IDS_DLG_EYE_DIAGRAM), "Eye Diagram"), Qt::AlignTop | Qt::AlignLeft);
+
+    _view->set_back(true);
+}
+
+void EyeTrace::paint_mid(QPainter &p, int left, int right, QColor fore, QColor back)
+{
+    using pv::data::EyeStack;
+
+    (void)fore;
+    (void)back;
+    (void)left;
+    (void)right;
+
+    assert(_view);
+
+    if (!enabled())
+        return;
+
+    _has_eye = _eye_stack->get_eye(_cells, _stats, _samplerate);
+
+    if (!_has_eye) {
+        p.setPen(view::View::Red);
+        p.drawText(_border.marginsRemoved(QMargins(10, 30, 10, 30)),
+                   L_S(STR_PAGE_DLG, S_ID(IDS_DLG_EYE_NO_CLOCK), "No bit clock recovered."));
+        return;
+    }
+
+    DsoSignal *dsoSig = find_signal();
+    const QColor colour = (dsoSig && dsoSig->get_colour().isValid()) ? dsoSig->get_colour() : view::View::Blue;
+
+    if (_image.isNull())
+        _image = QImage(EyeStack::Columns, EyeStack::Levels, QImage::Format_ARGB32_Premultiplied);
+
+    // one image row per adc code, the hit count grades the alpha
+    const uint8_t *cells = _cells.data();
+    for (int v = 0; v < EyeStack::Levels; v++) {
+        QRgb *line = (QRgb*)_image.scanLine(v);
+        for (int col = 0; col < EyeStack::Columns; col++) {
+            const int a = *cells++;
+            line[col] = qRgba(colour.red() * a / 255, colour.green() * a / 255,
+                              colour.blue() * a / 255, a);
+        }
+    }
+
+    p.drawImage(_border, _image);
+
+    if (_stats.valid)
+        paint_mask(p);
+}
+
+// The mask is centered in the eye, its size relative to the unit
+// interval and the distance between the two levels.
+void EyeTrace::paint_mask(QPainter &p)
+{
+    using pv::data::EyeStack;
+
+    const double hw = _eye_stack->mask_width() * EyeStack::ColumnsPerUI / 2;
+    const double hh = _eye_stack->mask_height() * (_stats.level1 - _stats.level0) / 2;
+    if (hw <= 0 || hh <= 0)
+        return;
+
+    const double cx = EyeStack::Columns / 2;
+    const double cy = (_stats.level0 + _stats.level1) / 2;
+
+    QPolygonF mask;
+    mask << cell_point(cx - hw, cy)
+         << cell_point(cx - hw / 2, cy - hh)
+         << cell_point(cx + hw / 2, cy - hh)
+         << cell_point(cx + hw, cy)
+         << cell_point(cx + hw / 2, cy + hh)
+         << cell_point(cx - hw / 2, cy + hh);
+
+    QColor colour = _stats.mask_hits > 0 ? view::View::Red : view::View::Green;
+    p.setPen(colour);
+    colour.setAlpha(view::View::BackAlpha);
+    p.setBrush(colour);
+    p.drawPolygon(mask);
+}
+
+void EyeTrace::paint_fore(QPainter &p, int left, int right, QColor fore, QColor back)
+{
+    (void)left;
+    (void)right;
+    (void)back;
+
+    assert(_view);
+
+    if (!enabled() || !_has_eye || _samplerate == 0)
+        return;
+
+    QStringList lines;
+    const double ui_time = _stats.ui * 1e9 / _samplerate;
+
+    lines << L_S(STR_PAGE_DLG, S_ID(IDS_DLG_EYE_BITS), "Bits: ") + QString::number(_stats.bits);
+    if (_stats.ui > 0)
+        lines << L_S(STR_PAGE_DLG, S_ID(IDS_DLG_EYE_BITRATE), "Bit rate: ")
+                 + Ruler::format_freq(_stats.ui / _samplerate);
+
+    DsoSignal *dsoSig = find_signal();
+
+    if (_stats.valid && dsoSig) {
+        lines << L_S(STR_PAGE_DLG, S_ID(IDS_DLG_EYE_HEIGHT), "Eye height: ")
+                 + dsoSig->get_voltage(_stats.height, 2);
+        lines << L_S(STR_PAGE_DLG, S_ID(IDS_DLG_EYE_WIDTH), "Eye width: ")
+                 + QString::number(_stats.width, 'f', 3) + " UI (" + dsoSig->get_time(_stats.width * ui_time) + ")";
+        lines << L_S(STR_PAGE_DLG, S_ID(IDS_DLG_EYE_JITTER_RMS), "Jitter RMS: ")
+                 + dsoSig->get_time(_stats.jitter_rms * ui_time);
+        lines << L_S(STR_PAGE_DLG, S_ID(IDS_DLG_EYE_JITTER_PP), "Jitter p-p: ")
+                 + dsoSig->get_time(_stats.jitter_pp * ui_time);
+        lines << L_S(STR_PAGE_DLG, S_ID(IDS_DLG_EYE_MASK_HITS), "Mask hits: ")
+                 + QString::number(_stats.mask_hits);
+    }
+
+    fore.setAlpha(view::View::ForeAlpha);
+    p.setPen(fore);
+    p.drawText(_border.marginsRemoved(QMargins(10, 30, 10, 10)),
+               Qt::AlignTop | Qt::AlignLeft, lines.join("\n"));
+}
+
+void EyeTrace::paint_label(QPainter &p, int right, const QPoint pt, QColor fore)
+{
+    (void)p;
+    (void)right;
+    (void)pt;
+    (void)fore;
+}
+
+void EyeTrace::on_eye_updated()
+{
+    if (!_view || !enabled())
+        return;
+
+    _view->set_update(_viewport, true);
+    _view->update();
+}
+
+} // namespace view
+} // namespace pv
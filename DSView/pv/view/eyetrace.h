@@ -0,0 +1,117 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2016 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+
+
+#ifndef DSVIEW_PV_EYETRACE_H
+#define DSVIEW_PV_EYETRACE_H
+
+#include <QImage>
+#include <vector>
+
+#include "trace.h"
+#include "../data/eyestack.h"
+
+namespace pv {
+namespace view {
+
+class DsoSignal;
+
+//when device is oscilloscope mode, it can use to draw the eye diagram
+//of a serial link, created by SigSession
+class EyeTrace : public Trace
+{
+    Q_OBJECT
+
+private:
+    static const int DIV_NUM = 8;
+
+public:
+    EyeTrace(bool enable, pv::data::EyeStack *eye_stack);
+
+    virtual ~EyeTrace();
+
+    inline bool enabled(){
+        return _enable;
+    }
+
+    inline void set_enable(bool enable){
+        _enable = enable;
+    }
+
+    inline pv::data::EyeStack* get_eye_stack(){
+        return _eye_stack;
+    }
+
+    inline int rows_size(){
+        return 0;
+    }
+
+    /**
+     * Paints the background layer of the trace with a QPainter
+     * @param p the QPainter to paint into.
+     * @param left the x-coordinate of the left edge of the signal
+     * @param right the x-coordinate of the right edge of the signal
+     **/
+    void paint_back(QPainter &p, int left, int right, QColor fore, QColor back);
+
+    /**
+     * Paints the signal with a QPainter
+     * @param p the QPainter to paint into.
+     * @param left the x-coordinate of the left edge of the signal.
+     * @param right the x-coordinate of the right edge of the signal.
+     **/
+    void paint_mid(QPainter &p, int left, int right, QColor fore, QColor back);
+
+    /**
+     * Paints the signal with a QPainter
+     * @param p the QPainter to paint into.
+     * @param left the x-coordinate of the left edge of the signal.
+     * @param right the x-coordinate of the right edge of the signal.
+     **/
+    void paint_fore(QPainter &p, int left, int right, QColor fore, QColor back);
+
+    void paint_label(QPainter &p, int right, const QPoint pt, QColor fore);
+
+private:
+    DsoSignal* find_signal();
+    QPointF cell_point(double column, double level);
+    void paint_mask(QPainter &p);
+
+private slots:
+    void on_eye_updated();
+
+private:
+    pv::data::EyeStack *_eye_stack;
+
+    bool _enable;
+    QRect _border;
+    bool _has_eye;
+    std::vector<uint8_t> _cells;
+    pv::data::EyeStack::EyeStats _stats;
+    uint64_t _samplerate;
+    QImage _image;
+};
+
+} // namespace view
+} // namespace pv
+
+#endif // DSVIEW_PV_EYETRACE_H
@@ -46,6 +46,8 @@ LogicSignal::LogicSignal(data::LogicSnapshot *data,
 {
     _trig = NONTRIG; 
     _paint_align_sample_count = 0;
+    _wave_valid = false;
+    _wave_ready = false;
 }
 
 LogicSignal::LogicSignal(view::LogicSignal *s,
@@ -56,12 +58,14 @@ LogicSignal::LogicSignal(view::LogicSignal *s,
     _trig(s->get_trig())
 { 
     _paint_align_sample_count = 0;
+    _wave_valid = false;
+    _wave_ready = false;
 }
 
 LogicSignal::~LogicSignal()
 {
-    _cur_edges.clear();
-    _cur_pulses.clear();
+    _pixel_states.clear();
+    _wave_lines.clear();
 }
 
 void LogicSignal::set_trig(int trig)
@@ -107,34 +111,78 @@ void LogicSignal::paint_mid_align_sample(QPainter &p, int left, int right, QColo
 
 void LogicSignal::paint_mid_align(QPainter &p, int left, int right, QColor fore, QColor back, uint64_t end_align_sample)
 {
-	using pv::view::View;
-
     (void)back;
 
+    if (prepare_wave(left, right, end_align_sample))
+        paint_wave(p, fore);
+}
+
+void LogicSignal::paint_wave(QPainter &p, QColor fore)
+{
+    if (!update_wave())
+        return;
+
+    p.setPen(_colour.isValid() ? _colour : fore);
+    p.drawLines(_wave_lines.data(), _wave_lines.size());
+}
+
+bool LogicSignal::prepare_wave(int left, int right, uint64_t end_align_sample)
+{
 	assert(_data);
     assert(_view);
 	assert(right >= left);
 
-    const int y = get_y() + _totalHeight * 0.5;
-    const double scale = _view->scale();
-    assert(scale > 0);
-    const int64_t offset = _view->offset();
-
-    const int high_offset = y - _totalHeight + 0.5f;
-    const int low_offset = y + 0.5f;
+    _wave_ready = false;
 
-    double samplerate = _data->samplerate();
+    const double samplerate = _data->samplerate();
     if (_data->empty() || samplerate == 0)
-		return;
+		return false;
   
     if (!_data->has_data(_probe->index))
-        return;
+        return false;
 
     if (end_align_sample >= _data->get_ring_sample_count())
         end_align_sample = _data->get_ring_sample_count() - 1;
 
-    const int64_t last_sample = end_align_sample;
-	const double samples_per_pixel = samplerate * scale;
+    WaveKey &key = _wave_next;
+    key.offset = _view->offset();
+    key.scale = _view->scale();
+    assert(key.scale > 0);
+    key.samplerate = samplerate;
+    key.y = get_y() + _totalHeight * 0.5;
+    key.height = _totalHeight;
+    key.left = left;
+    key.right = right;
+    key.end_align = end_align_sample;
+    key.generation = _data->get_data_generation();
+
+    _wave_ready = true;
+    return true;
+}
+
+bool LogicSignal::update_wave()
+{
+    if (!_wave_ready)
+        return false;
+
+    // Cursor and hover repaints keep the same view and data, so the
+    // lines from the previous paint can be drawn again as they are.
+    const WaveKey &key = _wave_next;
+    if (_wave_valid && key == _wave_key)
+        return true;
+    _wave_valid = false;
+
+    const int y = key.y;
+    const double scale = key.scale;
+    const int64_t offset = key.offset;
+    const int left = key.left;
+    const int right = key.right;
+
+    const int high_offset = y - key.height + 0.5f;
+    const int low_offset = y + 0.5f;
+
+    const int64_t last_sample = key.end_align;
+	const double samples_per_pixel = key.samplerate * scale;
 
     uint16_t width = right - left;
     const double start = offset * samples_per_pixel;
@@ -143,51 +191,39 @@ void LogicSignal::paint_mid_align(QPainter &p, int left, int right, QColor fore,
     const uint64_t start_index = max((uint64_t)floor(start), (uint64_t)0);
     
     if (start_index > end_index)
-        return;
+        return false;
 
     width = min(width, (uint16_t)ceil((end_index + 1)/samples_per_pixel - offset));
-    const uint16_t max_togs = width / TogMaxScale;
+    if (width == 0)
+        return false;
 
-    const bool first_sample = _data->get_display_edges(_cur_pulses, _cur_edges,
-                                                          start_index, end_index, width, max_togs,
-                                                          offset,
-                                                          samples_per_pixel, _probe->index);
-    assert(_cur_pulses.size() >= width);
+    const bool first_sample = _data->get_pixel_states(_pixel_states,
+                                                      start_index, end_index, width,
+                                                      offset, samples_per_pixel,
+                                                      _probe->index);
+    assert(_pixel_states.size() == width);
 
     int preX = 0;
     int preY = first_sample ? high_offset : low_offset;
-    int x = preX;
-    std::vector<QLine> wave_lines;
-    
-    if (_cur_edges.size() < max_togs) {
-        std::vector<std::pair<uint16_t, bool>>::const_iterator i;
-        for (i = _cur_edges.begin() + 1; i != _cur_edges.end() - 1; i++) {
-            x = (*i).first;
+    std::vector<QLine> &wave_lines = _wave_lines;
+    wave_lines.clear();
+
+    // One vertical line per toggled column, flat runs in between
+    for (int x = 0; x < width - 1; x++) {
+        const uint8_t state = _pixel_states[x];
+        if (state & pv::data::LogicSnapshot::PixelToggle) {
             wave_lines.push_back(QLine(preX, preY, x, preY));
             wave_lines.push_back(QLine(x, high_offset, x, low_offset));
             preX = x;
-            preY = (*i).second ? high_offset : low_offset;
-        }
-        x = (*i).first;
-        wave_lines.push_back(QLine(preX, preY, x, preY));
-    }
-    else {
-        std::vector<std::pair<bool, bool>>::const_iterator i = _cur_pulses.begin();
-        while (i != _cur_pulses.end() - 1) {
-            if ((*i).first) {
-                wave_lines.push_back(QLine(preX, preY, x, preY));
-                wave_lines.push_back(QLine(x, high_offset, x, low_offset));
-                preX = x;
-                preY = (*i).second ? high_offset : low_offset;
-            }
-            x++;
-            i++;
+            preY = (state & pv::data::LogicSnapshot::PixelHigh) ? high_offset : low_offset;
         }
-        wave_lines.push_back(QLine(preX, preY, x, preY));
     }
+    wave_lines.push_back(QLine(preX, preY, width - 1, preY));
 
-    p.setPen(_colour.isValid() ? _colour : fore);
-    p.drawLines(wave_lines.data(), wave_lines.size());
+    _wave_key = key;
+    _wave_valid = true;
+
+    return true;
 }
 
 void LogicSignal::paint_caps(QPainter &p, QLineF *const lines,
@@ -401,31 +437,17 @@ bool LogicSignal::edges(uint64_t end, uint64_t start, uint64_t &rising, uint64_t
     if (_data->empty() || !_data->has_data(_probe->index))
         return false;
 
-    uint64_t index = min(start, end);
-    const uint64_t sample_count = _data->get_sample_count();
-    end = max(start, end);
-    start = index;
-    if (end > (sample_count - 1))
-        return false;
+    return _data->get_edge_count(min(start, end), max(start, end), get_index(),
+                                 rising, falling);
+}
 
-    const int ch_index = get_index();
-    bool sample = _data->get_sample(start, ch_index);
-
-    rising = 0;
-    falling = 0;
-    do {
-        if (_data->get_nxt_edge(index, sample, sample_count, 1, ch_index)) {
-            if (index > end)
-                break;
-            rising += !sample;
-            falling += sample;
-            sample = !sample;
-        } else {
-            break;
-        }
-    } while(index <= end);
+bool LogicSignal::summary(uint64_t end, uint64_t start, uint64_t &high, uint64_t &edges)
+{
+    if (_data->empty() || !_data->has_data(_probe->index))
+        return false;
 
-    return true;
+    return _data->get_range_summary(min(start, end), max(start, end), get_index(),
+                                    high, edges);
 }
 
 bool LogicSignal::mouse_press(int right, const QPoint pt)
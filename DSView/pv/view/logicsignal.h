@@ -48,8 +48,6 @@ private:
     static const int StateHeight;
     static const int StateRound;
 
-    static const int TogMaxScale = 10;
-
 public:
     enum LogicSetRegions{
         NONTRIG = 0,
@@ -101,6 +99,8 @@ public:
 
     bool edges(uint64_t end, uint64_t start, uint64_t &rising, uint64_t &falling);
 
+    bool summary(uint64_t end, uint64_t start, uint64_t &high, uint64_t &edges);
+
     bool mouse_press(int right, const QPoint pt);
 
     QRectF get_rect(LogicSetRegions type, int y, int right);
@@ -109,6 +109,17 @@ public:
 
     void paint_mid_align_sample(QPainter &p, int left, int right, QColor fore, QColor back, uint64_t end_align_sample);
 
+    // Takes the view state, the data end and the generation for
+    // the next wave, on the GUI thread.
+    bool prepare_wave(int left, int right, uint64_t end_align_sample);
+
+    // Walks the snapshot and rebuilds the wave lines if the prepared
+    // key changed. Reads only the key and the snapshot, so it may run
+    // off the GUI thread.
+    bool update_wave();
+
+    void paint_wave(QPainter &p, QColor fore);
+
 protected:
     void paint_type_options(QPainter &p, int right, const QPoint pt, QColor fore);
 
@@ -120,10 +131,37 @@ private:
 
     void paint_mid_align(QPainter &p, int left, int right, QColor fore, QColor back, uint64_t end_align_sample);
 
+    // Everything the wave geometry depends on, compared before
+    // walking the mipmap again.
+    struct WaveKey
+    {
+        int64_t offset;
+        double scale;
+        double samplerate;
+        int y;
+        int height;
+        int left;
+        int right;
+        uint64_t end_align;
+        uint64_t generation;
+
+        bool operator==(const WaveKey &o) const
+        {
+            return offset == o.offset && scale == o.scale
+                && samplerate == o.samplerate && y == o.y
+                && height == o.height && left == o.left && right == o.right
+                && end_align == o.end_align && generation == o.generation;
+        }
+    };
+
 private:
 	pv::data::LogicSnapshot* _data;
-    std::vector< std::pair<uint16_t, bool> > _cur_edges;
-    std::vector<std::pair<bool, bool>> _cur_pulses;
+    std::vector<uint8_t> _pixel_states;
+    std::vector<QLine> _wave_lines;
+    WaveKey     _wave_key; // of the lines
+    bool        _wave_valid;
+    WaveKey     _wave_next; // set by prepare_wave()
+    bool        _wave_ready;
     LogicSetRegions _trig;
     uint64_t    _paint_align_sample_count;
 };
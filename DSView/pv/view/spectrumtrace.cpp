@@ -23,6 +23,7 @@
 #include <algorithm>
 #include <math.h>
 #include <QTextStream>
+#include <QImage>
 #include <boost/functional/hash.hpp>
 #include <stdlib.h>
 
@@ -33,6 +34,7 @@
 #include "../view/viewport.h"
 #include "../data/spectrumstack.h"
 #include "../dsvdef.h"
+#include "ruler.h"
 
 using namespace boost;
 using namespace std;
@@ -43,9 +45,10 @@ namespace view {
 const int SpectrumTrace::UpMargin = 0;
 const int SpectrumTrace::DownMargin = 0;
 const int SpectrumTrace::RightMargin = 30;
-const QString SpectrumTrace::FFT_ViewMode[2] = {
+const QString SpectrumTrace::FFT_ViewMode[3] = {
     "Linear RMS",
-    "DBV RMS"
+    "DBV RMS",
+    "Spectrogram"
 };
 
 const QString SpectrumTrace::FreqPrefixes[9] =
@@ -66,6 +69,7 @@ const int SpectrumTrace::DbvRanges[4] = {
 
 const int SpectrumTrace::HoverPointSize = 3;
 const double SpectrumTrace::VerticalRate = 1.0 / 2000.0;
+const int SpectrumTrace::SpectrogramMinFrames = 16;
 
 SpectrumTrace::SpectrumTrace(pv::SigSession *session,
     pv::data::SpectrumStack *spectrum_stack, int index) :
@@ -76,7 +80,9 @@ SpectrumTrace::SpectrumTrace(pv::SigSession *session,
     _view_mode(0),
     _hover_en(false),
     _scale(1),
-    _offset(0)
+    _offset(0),
+    _time_scale(1),
+    _time_offset(0)
 {
     _typeWidth = 0;
 
@@ -85,6 +91,9 @@ SpectrumTrace::SpectrumTrace(pv::SigSession *session,
             _colour = s->get_colour();
         }
     }
+
+    connect(_spectrum_stack, SIGNAL(spectrogram_updated()),
+            this, SLOT(on_spectrogram_updated()));
 }
 
 SpectrumTrace::~SpectrumTrace()
@@ -111,6 +120,7 @@ void SpectrumTrace::set_view_mode(unsigned int mode)
 {
     assert(mode < sizeof(FFT_ViewMode)/sizeof(FFT_ViewMode[0]));
     _view_mode = mode;
+    _spectrum_stack->set_spectrogram_enable(mode == Spectrogram);
 }
 
 std::vector<QString> SpectrumTrace::get_view_modes_support()
@@ -131,6 +141,8 @@ void SpectrumTrace::init_zoom()
 {
     _scale = 1;
     _offset = 0;
+    _time_scale = 1;
+    _time_offset = 0;
 }
 
 void SpectrumTrace::zoom(double steps, int offset)
@@ -177,6 +189,42 @@ double SpectrumTrace::get_scale()
     return _scale;
 }
 
+void SpectrumTrace::zoom_time(double steps, int offset)
+{
+    if (!_view)
+        return;
+
+    _spectrum_stack->lock_spectrogram();
+    const uint64_t frames = _spectrum_stack->get_spectrogram_frames();
+    _spectrum_stack->unlock_spectrogram();
+
+    const int height = get_view_rect().height();
+    if (frames == 0 || height <= 0)
+        return;
+
+    double pre_offset = _time_offset + _time_scale*offset/height;
+    _time_scale *= std::pow(3.0/2.0, -steps);
+    _time_scale = max(min(_time_scale, 1.0), min(1.0, (double)SpectrogramMinFrames/frames));
+    _time_offset = pre_offset - _time_scale*offset/height;
+    _time_offset = max(min(_time_offset, 1-_time_scale), 0.0);
+
+    _view->set_update(_viewport, true);
+    _view->update();
+}
+
+void SpectrumTrace::set_time_offset(double delta)
+{
+    const int height = get_view_rect().height();
+    if (height <= 0)
+        return;
+
+    _time_offset = _time_offset + (delta*_time_scale / height);
+    _time_offset = max(min(_time_offset, 1-_time_scale), 0.0);
+
+    _view->set_update(_viewport, true);
+    _view->update();
+}
+
 void SpectrumTrace::set_dbv_range(int range)
 {
     _dbv_range = range;
@@ -279,6 +327,11 @@ void SpectrumTrace::paint_mid(QPainter &p, int left, int right, QColor fore, QCo
         return;
     assert(right >= left);
 
+    if (enabled() && _view_mode == Spectrogram) {
+        paint_spectrogram(p, left, right);
+        return;
+    }
+
     if (enabled()) {
         const std::vector<double> samples(_spectrum_stack->get_fft_spectrum());
         if(samples.empty())
@@ -410,6 +463,11 @@ void SpectrumTrace::paint_fore(QPainter &p, int left, int right, QColor fore, QC
                                              AlignLeft | AlignTop, freq_str).width();
     blank_right = min(delta_left, blank_right);
 
+    if (_view_mode == Spectrogram) {
+        paint_spectrogram_ruler(p, fore, text_height, blank_right);
+        return;
+    }
+
     // Vertical ruler
     const double vRange = _vmax - _vmin;
     const double vOffset = _vmin;
@@ -487,6 +545,146 @@ void SpectrumTrace::paint_type_options(QPainter &p, int right, const QPoint pt,
     (void)fore;
 }
 
+void SpectrumTrace::paint_spectrogram(QPainter &p, int left, int right)
+{
+    using pv::data::SpectrumStack;
+
+    const QRect rect = get_view_rect();
+    const int height = rect.height();
+    const double width = right - left;
+
+    double vdiv = 0;
+    double vfactor = 0;
+
+    for(auto s : _session->get_signals()) {
+        if (s->signal_type() == SR_CHANNEL_DSO) {
+            view::DsoSignal *dsoSig = (view::DsoSignal*)s;
+            if(dsoSig->get_index() == _spectrum_stack->get_index()) {
+                vdiv = dsoSig->get_vDialValue();
+                vfactor = dsoSig->get_factor();
+                break;
+            }
+        }
+    }
+    _vmax = 20*log10((vdiv*DS_CONF_DSO_HDIVS*vfactor)*VerticalRate);
+    _vmin = _vmax - _dbv_range;
+
+    // The cells keep quantized dB values, only the colour table
+    // depends on the current range.
+    QVector<QRgb> colours(256);
+    for (int i = 0; i < 256; i++) {
+        const double db = i + SpectrumStack::SpectrogramDbFloor;
+        double t = (db - _vmin) / (_vmax - _vmin);
+        t = max(min(t, 1.0), 0.0);
+        // black -> blue -> red -> yellow -> white
+        const int r = (int)(255 * max(min(3*t - 0.75, 1.0), 0.0));
+        const int g = (int)(255 * max(min(3*t - 1.75, 1.0), 0.0));
+        const int b = (int)(255 * max(min(t < 0.5 ? 3*t : 3*t - 2, 1.0), 0.0));
+        colours[i] = qRgb(r, g, b);
+    }
+
+    _spectrum_stack->lock_spectrogram();
+
+    const uint64_t frames = _spectrum_stack->get_spectrogram_frames();
+    const uint64_t bins = _spectrum_stack->get_spectrogram_bins();
+    const int levels = _spectrum_stack->get_spectrogram_levels();
+
+    if (frames == 0 || bins == 0 || height <= 0) {
+        _spectrum_stack->unlock_spectrogram();
+        return;
+    }
+
+    // frequency runs along x and time down along y, both are zoomed
+    const double view_off = bins * _offset;
+    const double view_size = bins * _scale;
+    const double view_first = frames * _time_offset;
+    const double view_frames = frames * _time_scale;
+    const double view_last = min(view_first + view_frames, (double)frames);
+
+    // a row per pixel at most, the tiles of that level are computed
+    // on demand and the ones out of view are dropped from the queue
+    const int level = _spectrum_stack->get_spectrogram_level(view_frames / height);
+    const uint64_t tile_frames = SpectrumStack::SpectrogramTileRows << level;
+    const uint64_t first_tile = (uint64_t)view_first / tile_frames;
+    const uint64_t last_tile = ((uint64_t)ceil(view_last) - 1) / tile_frames;
+    _spectrum_stack->request_spectrogram_tiles(level, first_tile, last_tile);
+
+    for (uint64_t t = first_tile; t <= last_tile; t++) {
+        const double f0 = max((double)(t * tile_frames), view_first);
+        const double f1 = min((double)((t + 1) * tile_frames), view_last);
+
+        // a tile not done yet is drawn from a coarser one
+        for (int l = level; l < levels; l++) {
+            const uint64_t tile = t >> (l - level);
+            uint64_t rows = 0;
+            const uint8_t *cells = _spectrum_stack->get_spectrogram_tile(l, tile, rows);
+            if (cells == NULL)
+                continue;
+
+            const double tile_first = (double)(tile * (SpectrumStack::SpectrogramTileRows << l));
+            const double row_frames = (double)(1ULL << l);
+            const double end = min(f1, tile_first + rows * row_frames);
+            if (end <= f0)
+                break;
+
+            const QRectF target(left, rect.top() + (f0 - view_first) * height / view_frames,
+                                width, (end - f0) * height / view_frames);
+            const QRectF source(view_off, (f0 - tile_first) / row_frames,
+                                view_size, (end - f0) / row_frames);
+
+            QImage image(cells, (int)bins, (int)rows, (int)bins, QImage::Format_Indexed8);
+            image.setColorTable(colours);
+            p.drawImage(target, image, source);
+            break;
+        }
+    }
+
+    _spectrum_stack->unlock_spectrogram();
+}
+
+void SpectrumTrace::paint_spectrogram_ruler(QPainter &p, QColor fore, int text_height, double &blank_right)
+{
+    using namespace Qt;
+
+    _spectrum_stack->lock_spectrogram();
+    const uint64_t frames = _spectrum_stack->get_spectrogram_frames();
+    const uint64_t hop = _spectrum_stack->get_spectrogram_hop();
+    _spectrum_stack->unlock_spectrogram();
+
+    const double view_first = frames * _time_offset;
+    const double view_frames = frames * _time_scale;
+
+    const double samplerate = _session->cur_snap_samplerate();
+    if (frames == 0 || samplerate == 0)
+        return;
+
+    const double width = get_view_rect().width();
+    const double height = get_view_rect().height();
+
+    p.setPen(fore);
+    p.setBrush(Qt::NoBrush);
+    for (int i = 1; i < VolDivNum; i++) {
+        const double y = height * i / VolDivNum;
+        const uint64_t index = (uint64_t)(view_first + view_frames * i / VolDivNum) * hop;
+        const QString time_str = Ruler::format_real_time(index, samplerate);
+        const double time_width = p.boundingRect(0, 0, INT_MAX, INT_MAX,
+            AlignLeft | AlignTop, time_str).width();
+        p.drawLine(width, y, width-TickHeight/2, y);
+        p.drawText(width-TickHeight-time_width, y-text_height/2, time_width, text_height,
+                   AlignCenter | AlignTop | TextDontClip, time_str);
+        blank_right = min(width-TickHeight-time_width, blank_right);
+    }
+}
+
+void SpectrumTrace::on_spectrogram_updated()
+{
+    if (!_view || !enabled() || _view_mode != Spectrogram)
+        return;
+
+    _view->set_update(_viewport, true);
+    _view->update();
+}
+
 QRect SpectrumTrace::get_view_rect()
 {
     assert(_viewport);
@@ -50,7 +50,7 @@ private:
     static const int UpMargin;
     static const int DownMargin;
     static const int RightMargin;
-    static const QString FFT_ViewMode[2];
+    static const QString FFT_ViewMode[3];
 
     static const QString FreqPrefixes[9];
     static const int FirstSIPrefixPower;
@@ -66,6 +66,15 @@ private:
 
     static const double VerticalRate;
 
+    static const int SpectrogramMinFrames;
+
+public:
+    enum spectrum_view_mode {
+        LinearRMS = 0,
+        DbvRMS,
+        Spectrogram
+    };
+
 public:
     SpectrumTrace(pv::SigSession *session, pv::data::SpectrumStack *spectrum_stack, int index);
     ~SpectrumTrace();
@@ -84,6 +93,10 @@ public:
     void set_scale(double scale);
     double get_scale();
 
+    // time axis of the spectrogram, offset is in pixels
+    void zoom_time(double steps, int offset);
+    void set_time_offset(double delta);
+
     void set_dbv_range(int range);
     int dbv_range();
     std::vector<int> get_dbv_ranges();
@@ -128,8 +141,11 @@ protected:
     void paint_type_options(QPainter &p, int right, const QPoint pt, QColor fore);
 
 private:
+    void paint_spectrogram(QPainter &p, int left, int right);
+    void paint_spectrogram_ruler(QPainter &p, QColor fore, int text_height, double &blank_right);
 
 private slots:
+    void on_spectrogram_updated();
 
 private:
     pv::SigSession *_session;
@@ -149,6 +165,9 @@ private:
 
     double _scale;
     double _offset;
+    // the part of the capture the spectrogram shows, as a fraction
+    double _time_scale;
+    double _time_offset;
 };
 
 } // namespace view
@@ -40,6 +40,7 @@
 #include "viewport.h"
 #include "spectrumtrace.h"
 #include "lissajoustrace.h"
+#include "eyetrace.h"
 #include "analogsignal.h"
 
 #include "../sigsession.h"
@@ -116,6 +117,7 @@ View::View(SigSession *session, pv::toolbars::SamplingBar *sampling_bar, QWidget
     _trace_view_map[SR_CHANNEL_FFT] = FFT_VIEW;
     _trace_view_map[SR_CHANNEL_LISSAJOUS] = TIME_VIEW;
     _trace_view_map[SR_CHANNEL_MATH] = TIME_VIEW;
+    _trace_view_map[SR_CHANNEL_EYE] = TIME_VIEW;
 
     _active_viewport = NULL;
     _ruler = new Ruler(*this);
@@ -371,6 +373,12 @@ void View::get_traces(int type, std::vector<Trace*> &traces)
         traces.push_back(lissajous);
     }
 
+    auto eye = _session->get_eye_trace();
+    if (eye && eye->enabled() &&
+        (type == ALL_VIEW || _trace_view_map[eye->get_type()] == type)){
+        traces.push_back(eye);
+    }
+
     auto math = _session->get_math_trace();
     if (math && math->enabled() &&
         (type == ALL_VIEW || _trace_view_map[math->get_type()] == type)){
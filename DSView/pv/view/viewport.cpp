@@ -38,6 +38,7 @@
 #include <QPainterPath> 
 #include <math.h>
 #include <QWheelEvent>
+#include <QtConcurrent/QtConcurrent>
  
 #include "../config/appconfig.h"
 #include "../dsvdef.h"
@@ -46,6 +47,7 @@
 #include "../ui/langresource.h"
 #include "../ui/fn.h"
 #include "lissajoustrace.h"
+#include "eyetrace.h"
 
 using namespace std;
 
@@ -266,8 +268,30 @@ void Viewport::paintSignals(QPainter &p, QColor fore, QColor back)
 
     if (_view.session().get_device()->get_work_mode() == LOGIC) 
     {
-        bool bFirst = true;
-        uint64_t end_align_sample;
+        std::vector<LogicSignal*> logic_signals;
+        for(auto t : traces){
+            if (t->enabled() && t->signal_type() == SR_CHANNEL_LOGIC)
+                logic_signals.push_back((LogicSignal*)t);
+        }
+
+        // The view state, the data end and the rects are taken once here,
+        // both passes below then build and draw the same waves.
+        if (!logic_signals.empty())
+        {
+            const uint64_t end_align_sample = logic_signals.front()->data()->get_ring_sample_count();
+
+            for (auto s : logic_signals)
+                s->prepare_wave(0, s->get_view_rect().right(), end_align_sample);
+        }
+
+        // Walking the mipmaps is the expensive part, do it for all visible
+        // channels on the thread pool and only draw lines on this thread.
+        if ((int)logic_signals.size() >= ParallelWaveMin)
+        {
+            QtConcurrent::blockingMap(logic_signals, [](LogicSignal *s){
+                s->update_wave();
+            });
+        }
 
         for(auto t : traces){
             if (t->enabled()){
@@ -275,12 +299,7 @@ void Viewport::paintSignals(QPainter &p, QColor fore, QColor back)
                 if (t->signal_type() == SR_CHANNEL_LOGIC)
                 {
                     LogicSignal *logic_signal = (LogicSignal*)t;
-                
-                    if (bFirst)
-                        end_align_sample = logic_signal->data()->get_ring_sample_count();
-            
-                    logic_signal->paint_mid_align_sample(p, 0, t->get_view_rect().right(), fore, back, end_align_sample);
-                    bFirst = false;
+                    logic_signal->paint_wave(p, fore);
                 }
                 else{
                     t->paint_mid(p, 0, t->get_view_rect().right(), fore, back);
@@ -297,7 +316,8 @@ void Viewport::paintSignals(QPainter &p, QColor fore, QColor back)
             _curOffset = _view.offset();
             _curSignalHeight = _view.get_signalHeight();
 
-            _pixmap = QPixmap(size());
+            if (_pixmap.size() != size())
+                _pixmap = QPixmap(size());
             _pixmap.fill(Qt::transparent);
 
             QPainter dbp(&_pixmap);
@@ -310,6 +330,10 @@ void Viewport::paintSignals(QPainter &p, QColor fore, QColor back)
                 if (lis_trace && lis_trace->enabled()){
                     isLissa = true;
                 }
+                auto eye_trace = _view.session().get_eye_trace();
+                if (eye_trace && eye_trace->enabled()){
+                    isLissa = true;
+                }
             }
            
             for(auto t : traces)
@@ -785,6 +809,8 @@ void Viewport::mouseMoveEvent(QMouseEvent *event)
                 if(t->enabled()) {
                     double delta = (_mouse_point - event->pos()).x();
                     t->set_offset(delta);
+                    if (t->view_mode() == view::SpectrumTrace::Spectrogram)
+                        t->set_time_offset((_mouse_point - event->pos()).y());
                     break;
                 }
             }
@@ -1215,11 +1241,13 @@ void Viewport::wheelEvent(QWheelEvent *event)
     assert(event);
 
     int x = 0;  //mouse x pos
+    int y = 0;  //mouse y pos
     int delta = 0;
     bool isVertical = true;
 
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
     x = (int)event->position().x(); 
+    y = (int)event->position().y();
     int anglex = event->angleDelta().x();
     int angley = event->angleDelta().y();
 
@@ -1233,6 +1261,7 @@ void Viewport::wheelEvent(QWheelEvent *event)
     }
 #else
     x = event->x();
+    y = event->y();
     delta = event->delta();
     isVertical = event->orientation() == Qt::Vertical;
 #endif
@@ -1249,7 +1278,12 @@ void Viewport::wheelEvent(QWheelEvent *event)
         { 
             if (t->enabled())
             {
-                t->zoom(zoom_scale, x);
+                // the wheel zooms the time of a spectrogram, with ctrl the frequency
+                if (t->view_mode() == view::SpectrumTrace::Spectrogram
+                    && !(event->modifiers() & Qt::ControlModifier))
+                    t->zoom_time(zoom_scale, y);
+                else
+                    t->zoom(zoom_scale, x);
                 break;
             }
         }
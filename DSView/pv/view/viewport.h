@@ -68,6 +68,7 @@ public:
     static const double DragDamping;
     static const int SnapMinSpace = 10;
     static const int WaitLoopTime = 400;
+    static const int ParallelWaveMin = 4;
     enum ActionType {
         NO_ACTION,
 
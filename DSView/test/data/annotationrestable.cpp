@@ -0,0 +1,83 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2016 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <string.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <libsigrokdecode.h>
+
+#include "../../pv/data/decode/annotation.h"
+#include "../../pv/data/decode/annotationrestable.h"
+#include "../../pv/data/decode/decoderstatus.h"
+#include "../../pv/dsvdef.h"
+
+using pv::data::decode::Annotation;
+
+BOOST_AUTO_TEST_SUITE(AnnotationResTableTest)
+
+static std::vector<QString> intern_lines(DecoderStatus &status, char **lines,
+	const char *number_hex, int format)
+{
+	srd_proto_ann_text text;
+	text.ann_text = lines;
+	text.str_number_hex = (char*)number_hex;
+
+	srd_proto_ann_record rec;
+	memset(&rec, 0, sizeof(rec));
+
+	const int index = Annotation::make_res_index(&text, &status);
+	BOOST_REQUIRE(index >= 0);
+
+	status.m_format = format;
+	return Annotation(&rec, index, &status).annotations();
+}
+
+// An @hex string is queued as a "\n" ignore-flag line, the number
+// is formatted in it's place.
+BOOST_AUTO_TEST_CASE(HexPlaceholder)
+{
+	DecoderStatus status;
+	char flag[] = "\n";
+	char *lines[] = {flag, NULL};
+
+	std::vector<QString> hex = intern_lines(status, lines, "41", DecoderDataFormat::hex);
+	BOOST_REQUIRE_EQUAL(hex.size(), 1U);
+	BOOST_CHECK(hex[0] == QString("41"));
+
+	std::vector<QString> dec = intern_lines(status, lines, "41", DecoderDataFormat::dec);
+	BOOST_REQUIRE_EQUAL(dec.size(), 1U);
+	BOOST_CHECK(dec[0] == QString("65"));
+}
+
+BOOST_AUTO_TEST_CASE(HexWithText)
+{
+	DecoderStatus status;
+	char text[] = "Data: {$}";
+	char flag[] = "\n";
+	char *lines[] = {text, flag, NULL};
+
+	std::vector<QString> hex = intern_lines(status, lines, "41", DecoderDataFormat::hex);
+	BOOST_REQUIRE_EQUAL(hex.size(), 1U);
+	BOOST_CHECK(hex[0] == QString("Data: 41"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,116 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2016 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+
+#include <thread>
+#include <future>
+#include <chrono>
+#include <atomic>
+
+#include <boost/test/unit_test.hpp>
+
+#include "../../pv/data/snapshot.h"
+
+using pv::data::Snapshot;
+
+BOOST_AUTO_TEST_SUITE(SnapshotTest)
+
+class TestSnapshot : public Snapshot
+{
+public:
+	TestSnapshot() : Snapshot(1, 0, 1), writes(0) {}
+
+	void clear() {}
+	void init() {}
+	bool has_data(int) { return true; }
+	int get_block_num() { return 0; }
+	uint64_t get_block_size(int) { return 0; }
+
+	void write()
+	{
+		ExclusiveGuard ex(this);
+		writes++;
+	}
+
+	std::atomic<int> writes;
+};
+
+static const std::chrono::seconds Timeout(5);
+
+BOOST_AUTO_TEST_CASE(WriterWaitsForReader)
+{
+	TestSnapshot s;
+	std::thread writer;
+
+	{
+		Snapshot::ReadGuard guard(&s);
+		writer = std::thread(&TestSnapshot::write, &s);
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		BOOST_CHECK_EQUAL(s.writes.load(), 0);
+	}
+
+	writer.join();
+	BOOST_CHECK_EQUAL(s.writes.load(), 1);
+}
+
+// A thread nests guards of two snapshots while a writer waits on
+// one of them, the inner guard must not wait on the outer one.
+BOOST_AUTO_TEST_CASE(NestedTwoSnapshots)
+{
+	TestSnapshot a;
+	TestSnapshot b;
+	std::promise<void> held;
+	std::promise<void> go;
+	std::promise<void> done;
+	std::shared_future<void> go_future(go.get_future());
+
+	std::thread reader([&]() {
+		Snapshot::ReadGuard gb(&b);
+		Snapshot::ReadGuard ga(&a);
+		held.set_value();
+		go_future.wait();
+		{
+			Snapshot::ReadGuard ga2(&a);
+			Snapshot::ReadGuard gb2(&b);
+		}
+		done.set_value();
+	});
+
+	held.get_future().wait();
+	std::thread writer(&TestSnapshot::write, &a);
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	go.set_value();
+
+	std::future<void> done_future(done.get_future());
+	const bool finished = done_future.wait_for(Timeout) == std::future_status::ready;
+	BOOST_REQUIRE(finished);
+
+	reader.join();
+	writer.join();
+	BOOST_CHECK_EQUAL(a.writes.load(), 1);
+	BOOST_CHECK_EQUAL(b.writes.load(), 0);
+
+	// both guards of the thread are gone, writers of b get through
+	b.write();
+	BOOST_CHECK_EQUAL(b.writes.load(), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -30,6 +30,11 @@
 #define RECEIVER_MAX_COUNT  10
 #define LOG_MAX_LENGTH      1000
 
+// Per-thread record ring, a power of two.
+#define RING_BUFFER_SIZE    (64 * 1024)
+
+#define RECORD_ALIGN(n)     (((n) + 15) & ~((size_t)15))
+
 enum xlog_receiver_type{ 
     RECEIVER_TYPE_CONSOLE = 0,
     RECEIVER_TYPE_FILE = 1,
@@ -38,7 +43,7 @@ enum xlog_receiver_type{
 
 struct xlog_receiver_info;
 
-typedef void (*xlog_print_func)(struct xlog_receiver_info *info, const char *domain, const char *format, va_list args);
+typedef void (*xlog_print_func)(struct xlog_receiver_info *info, const char *data, int length);
 
 struct xlog_receiver_info
 {
@@ -49,16 +54,54 @@ struct xlog_receiver_info
     xlog_receive_callback _rev; //user callback
 };
 
+/*
+    A formatted message in a ring, the text follows the head.
+    A record with _skip set pads the ring end, the next one starts at 0.
+*/
+struct xlog_record
+{
+    unsigned long long _seq;
+    unsigned int    _length;
+    unsigned int    _skip;
+};
+
+/*
+    Single producer, single consumer ring of one thread. The thread only
+    moves _head, the writer thread only moves _tail.
+*/
+struct xlog_ring
+{
+    size_t  _head;
+    size_t  _tail;
+    size_t  _snap_head; // writer side copy of _head
+    unsigned long long _dropped;
+    unsigned long long _reported;
+    int     _orphan;    // the thread has exited
+    struct xlog_ring *_next;
+    unsigned long long _data[RING_BUFFER_SIZE / 8];
+};
+
 struct xlog_context
 {
     struct xlog_receiver_info _receivers[RECEIVER_MAX_COUNT];
-    int     _log_level;    
+    volatile int    _log_level;    
     char    _error[50];
     int     _count;
     pthread_mutex_t _mutext;
+
+    struct xlog_ring *_rings;
+    pthread_key_t   _ring_key;
+    pthread_mutex_t _ring_mutex;
+    pthread_cond_t  _ring_cond;
+    pthread_t       _write_thread;
+    int     _stop;
+    int     _idle;      // the writer waits for a record
+    unsigned long long _seq;
+    unsigned long long _dropped;
 };
 
 struct xlog_writer{
+    const volatile int *_level; // must be first, see xlog_enabled()
     char    _domain[20];
     xlog_context    *_ctx;
 };
@@ -66,79 +109,288 @@ struct xlog_writer{
 /**
  * the default mode process
  */
-static void print_to_console(struct xlog_receiver_info *info, const char *domain, const char *format, va_list args)
+static void print_to_console(struct xlog_receiver_info *info, const char *data, int length)
 {
     (void)info;
-
-    if (domain && *domain){
-        fprintf(stderr, "%s", domain);
-        fprintf(stderr, ": ");
-    }
-    
-	vfprintf(stderr, format, args);
-	fprintf(stderr, "\n");
-    fflush(stderr);
+	fwrite(data, length, 1, stderr);
 }
  
 /**
  * the file mode process
  */
-static void print_to_file(struct xlog_receiver_info *info, const char *domain, const char *format, va_list args)
+static void print_to_file(struct xlog_receiver_info *info, const char *data, int length)
 {
-    char buf[LOG_MAX_LENGTH + 1];
-    int fmtl;
-    int wr=0;
-    int strl;
+    if (info->_file != NULL){
+	    fwrite(data, length, 1, info->_file);
+    }
+}
 
-    if (info->_file == NULL){
-        return;
+/**
+ * the callback mode process
+ */
+static void print_to_user_callback(struct xlog_receiver_info *info, const char *data, int length)
+{
+    if (info->_rev != NULL){
+	    info->_rev(data, length);
     }
+}
 
-    if (domain && *domain){
-        strl = strlen(domain);
-        strcpy(buf + wr, domain);
-        wr += strl;
-        strcpy(buf + wr, ": ");
-        wr += 2;
+static void print_to_receivers(xlog_context *ctx, const char *data, int length)
+{
+    int i;
+    struct xlog_receiver_info *inf;
+
+    for (i = 0; i < ctx->_count; i++){
+        inf = &ctx->_receivers[i];
+
+        if (inf->_fn != NULL && inf->_enable){
+            inf->_fn(inf, data, length);
+        }
     }
+}
 
-    fmtl = vsnprintf(buf + wr, LOG_MAX_LENGTH - wr - 1, format, args);
-    wr += fmtl;
-    *(buf + wr) = '\n';
-    wr += 1;
+static void flush_receivers(xlog_context *ctx)
+{
+    int i;
+    struct xlog_receiver_info *inf;
 
-	fwrite(buf, wr, 1, info->_file);
-    fflush(info->_file);
+    for (i = 0; i < ctx->_count; i++){
+        inf = &ctx->_receivers[i];
+
+        if (inf->_type == RECEIVER_TYPE_CONSOLE)
+            fflush(stderr);
+        else if (inf->_type == RECEIVER_TYPE_FILE && inf->_file != NULL)
+            fflush(inf->_file);
+    }
 }
 
+//-------------------------------------------------record ring
+
 /**
- * the callback mode process
+ * Copy a record into the ring, returns -1 and counts it as dropped
+ * when the ring is full, 1 when it got half full. Called by the owner
+ * thread only.
  */
-static void print_to_user_callback(struct xlog_receiver_info *info, const char *domain, const char *format, va_list args)
+static int ring_push(struct xlog_ring *ring, const char *data, int length, unsigned long long seq)
 {
-    char buf[LOG_MAX_LENGTH + 1];
-    int fmtl;
-    int wr=0;
-    int strl;
+    unsigned char *buf = (unsigned char*)ring->_data;
+    struct xlog_record *rec;
+    size_t need = RECORD_ALIGN(sizeof(struct xlog_record) + length);
+    size_t start = ring->_head;
+    size_t head = start;
+    size_t tail = __atomic_load_n(&ring->_tail, __ATOMIC_ACQUIRE);
+    size_t pos = head & (RING_BUFFER_SIZE - 1);
+    size_t pad = 0;
 
-    if (info->_rev == NULL){
-        return;
+    if (pos + need > RING_BUFFER_SIZE){
+        pad = RING_BUFFER_SIZE - pos;
     }
 
-    if (domain && *domain){
-        strl = strlen(domain);
-        strcpy(buf + wr, domain);
-        wr += strl;
-        strcpy(buf + wr, ": ");
-        wr += 2;
+    if (head + pad + need - tail > RING_BUFFER_SIZE){
+        __atomic_add_fetch(&ring->_dropped, 1, __ATOMIC_RELAXED);
+        return -1;
     }
 
-    fmtl = vsnprintf(buf + wr, LOG_MAX_LENGTH - wr - 1, format, args);
-    wr += fmtl;
-    *(buf + wr) = '\n';
-    wr += 1;
- 
-	info->_rev(buf, wr);
+    if (pad > 0){
+        rec = (struct xlog_record*)(buf + pos);
+        rec->_skip = 1;
+        head += pad;
+        pos = 0;
+    }
+
+    rec = (struct xlog_record*)(buf + pos);
+    rec->_seq = seq;
+    rec->_length = length;
+    rec->_skip = 0;
+    memcpy(rec + 1, data, length);
+
+    // Ordered with the load of _idle in xlog_print(), see write_proc().
+    __atomic_store_n(&ring->_head, head + need, __ATOMIC_SEQ_CST);
+
+    if (head + need - tail > RING_BUFFER_SIZE / 2 && start - tail <= RING_BUFFER_SIZE / 2)
+        return 1;
+    return 0;
+}
+
+/**
+ * The oldest record before the writer's head snapshot, or NULL.
+ */
+static struct xlog_record* ring_peek(struct xlog_ring *ring)
+{
+    unsigned char *buf = (unsigned char*)ring->_data;
+    struct xlog_record *rec;
+    size_t pos;
+
+    while (ring->_tail != ring->_snap_head)
+    {
+        pos = ring->_tail & (RING_BUFFER_SIZE - 1);
+        rec = (struct xlog_record*)(buf + pos);
+
+        if (!rec->_skip)
+            return rec;
+
+        __atomic_store_n(&ring->_tail, ring->_tail + RING_BUFFER_SIZE - pos, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+static void ring_pop(struct xlog_ring *ring, struct xlog_record *rec)
+{
+    size_t size = RECORD_ALIGN(sizeof(struct xlog_record) + rec->_length);
+    __atomic_store_n(&ring->_tail, ring->_tail + size, __ATOMIC_RELEASE);
+}
+
+static void ring_orphan(void *data)
+{
+    struct xlog_ring *ring = (struct xlog_ring*)data;
+    __atomic_store_n(&ring->_orphan, 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * The ring of the calling thread, created on its first message.
+ */
+static struct xlog_ring* get_thread_ring(xlog_context *ctx)
+{
+    struct xlog_ring *ring = (struct xlog_ring*)pthread_getspecific(ctx->_ring_key);
+
+    if (ring == NULL){
+        ring = (struct xlog_ring*)malloc(sizeof(struct xlog_ring));
+        if (ring == NULL){
+            return NULL;
+        }
+        memset(ring, 0, offsetof(struct xlog_ring, _data));
+
+        pthread_mutex_lock(&ctx->_ring_mutex);
+        ring->_next = ctx->_rings;
+        ctx->_rings = ring;
+        pthread_mutex_unlock(&ctx->_ring_mutex);
+
+        pthread_setspecific(ctx->_ring_key, ring);
+    }
+    return ring;
+}
+
+/**
+ * Write out the pending records of all threads in the order they were
+ * made, and free the rings of exited threads. Returns the record count.
+ */
+static int drain_rings(xlog_context *ctx)
+{
+    struct xlog_ring *ring, *best, **link;
+    struct xlog_record *rec, *best_rec;
+    unsigned long long dropped;
+    char buf[80];
+    int count = 0;
+    int len;
+
+    pthread_mutex_lock(&ctx->_ring_mutex);
+
+    for (ring = ctx->_rings; ring; ring = ring->_next){
+        ring->_snap_head = __atomic_load_n(&ring->_head, __ATOMIC_ACQUIRE);
+    }
+
+    pthread_mutex_lock(&ctx->_mutext);
+
+    for (;;)
+    {
+        best = NULL;
+        best_rec = NULL;
+
+        for (ring = ctx->_rings; ring; ring = ring->_next){
+            rec = ring_peek(ring);
+            if (rec && (best_rec == NULL || rec->_seq < best_rec->_seq)){
+                best = ring;
+                best_rec = rec;
+            }
+        }
+
+        if (best == NULL)
+            break;
+
+        print_to_receivers(ctx, (const char*)(best_rec + 1), best_rec->_length);
+        ring_pop(best, best_rec);
+        count++;
+    }
+
+    for (ring = ctx->_rings; ring; ring = ring->_next){
+        dropped = __atomic_load_n(&ring->_dropped, __ATOMIC_RELAXED);
+
+        if (dropped != ring->_reported){
+            len = snprintf(buf, sizeof(buf), "xlog: %llu log records dropped\n",
+                    dropped - ring->_reported);
+            print_to_receivers(ctx, buf, len);
+            __atomic_add_fetch(&ctx->_dropped, dropped - ring->_reported, __ATOMIC_RELAXED);
+            ring->_reported = dropped;
+            count++;
+        }
+    }
+
+    if (count > 0){
+        flush_receivers(ctx);
+    }
+
+    pthread_mutex_unlock(&ctx->_mutext);
+
+    // The thread wrote nothing after it was marked, so an empty ring stays empty.
+    link = &ctx->_rings;
+    while ((ring = *link) != NULL)
+    {
+        if (__atomic_load_n(&ring->_orphan, __ATOMIC_ACQUIRE)
+            && ring->_tail == __atomic_load_n(&ring->_head, __ATOMIC_ACQUIRE)){
+            *link = ring->_next;
+            free(ring);
+        }
+        else{
+            link = &ring->_next;
+        }
+    }
+
+    pthread_mutex_unlock(&ctx->_ring_mutex);
+
+    return count;
+}
+
+/**
+ * Called with _ring_mutex held.
+ */
+static int rings_empty(xlog_context *ctx)
+{
+    struct xlog_ring *ring;
+
+    for (ring = ctx->_rings; ring; ring = ring->_next){
+        if (ring->_tail != __atomic_load_n(&ring->_head, __ATOMIC_SEQ_CST))
+            return 0;
+    }
+    return 1;
+}
+
+static void* write_proc(void *param)
+{
+    xlog_context *ctx = (xlog_context*)param;
+    int stop;
+
+    for (;;)
+    {
+        stop = __atomic_load_n(&ctx->_stop, __ATOMIC_ACQUIRE);
+
+        if (drain_rings(ctx) > 0 && !stop)
+            continue;
+        if (stop)
+            break;
+
+        // Sleep until a record comes. _idle is set before the rings are
+        // checked and a producer reads it after its record is in, so
+        // either the check sees the record or the producer signals.
+        pthread_mutex_lock(&ctx->_ring_mutex);
+        __atomic_store_n(&ctx->_idle, 1, __ATOMIC_SEQ_CST);
+
+        while (!__atomic_load_n(&ctx->_stop, __ATOMIC_ACQUIRE) && rings_empty(ctx))
+            pthread_cond_wait(&ctx->_ring_cond, &ctx->_ring_mutex);
+
+        __atomic_store_n(&ctx->_idle, 0, __ATOMIC_RELAXED);
+        pthread_mutex_unlock(&ctx->_ring_mutex);
+    }
+    return NULL;
 }
 
 static xlog_context* xlog_new_context(int bConsole)
@@ -156,6 +408,7 @@ static xlog_context* xlog_new_context(int bConsole)
         }
         ctx->_count = 0;
         ctx->_log_level = XLOG_LEVEL_INFO;
+        ctx->_error[0] = '\0';
 
         if (bConsole){
             ctx->_receivers[0]._fn = print_to_console;
@@ -165,6 +418,31 @@ static xlog_context* xlog_new_context(int bConsole)
         }        
 
         pthread_mutex_init(&ctx->_mutext, NULL);
+
+        ctx->_rings = NULL;
+        ctx->_stop = 0;
+        ctx->_idle = 0;
+        ctx->_seq = 0;
+        ctx->_dropped = 0;
+        pthread_mutex_init(&ctx->_ring_mutex, NULL);
+        pthread_cond_init(&ctx->_ring_cond, NULL);
+
+        if (pthread_key_create(&ctx->_ring_key, ring_orphan) != 0){
+            pthread_cond_destroy(&ctx->_ring_cond);
+            pthread_mutex_destroy(&ctx->_ring_mutex);
+            pthread_mutex_destroy(&ctx->_mutext);
+            free(ctx);
+            return NULL;
+        }
+
+        if (pthread_create(&ctx->_write_thread, NULL, write_proc, ctx) != 0){
+            pthread_key_delete(ctx->_ring_key);
+            pthread_cond_destroy(&ctx->_ring_cond);
+            pthread_mutex_destroy(&ctx->_ring_mutex);
+            pthread_mutex_destroy(&ctx->_mutext);
+            free(ctx);
+            return NULL;
+        }
     }
     
     return ctx;
@@ -192,8 +470,25 @@ XLOG_API xlog_context* xlog_new2(int bConsole)
 XLOG_API void xlog_free(xlog_context* ctx)
 {   
     int i=0;
+    struct xlog_ring *ring;
 
     if (ctx != NULL){
+        pthread_mutex_lock(&ctx->_ring_mutex);
+        __atomic_store_n(&ctx->_stop, 1, __ATOMIC_RELEASE);
+        pthread_cond_signal(&ctx->_ring_cond);
+        pthread_mutex_unlock(&ctx->_ring_mutex);
+
+        pthread_join(ctx->_write_thread, NULL);
+
+        // Records made while the writer was stopping.
+        drain_rings(ctx);
+
+        while ((ring = ctx->_rings) != NULL){
+            ctx->_rings = ring->_next;
+            free(ring);
+        }
+        pthread_key_delete(ctx->_ring_key);
+
         for (i = 0; i < ctx->_count; i++)
         {
             if (ctx->_receivers[i]._file != NULL 
@@ -205,6 +500,8 @@ XLOG_API void xlog_free(xlog_context* ctx)
         }
 
         pthread_mutex_destroy(&ctx->_mutext);
+        pthread_cond_destroy(&ctx->_ring_cond);
+        pthread_mutex_destroy(&ctx->_ring_mutex);
 
         free(ctx); 
     } 
@@ -473,6 +770,7 @@ XLOG_API xlog_writer* xlog_create_writer(xlog_context* ctx, const char *domain)
     if (ctx != NULL){
         wr = (xlog_writer*)malloc(sizeof(xlog_writer));
         wr->_ctx = ctx;
+        wr->_level = &ctx->_log_level;
         xlog_set_domain(wr, domain);
         return wr;
     }    
@@ -505,78 +803,123 @@ XLOG_API int xlog_set_domain(xlog_writer* wr, const char *domain)
     return 0;
 }
 
+/**
+ * write out the queued records on the calling thread, for the fatal
+ * path where the writer thread may not run again.
+ */
+XLOG_API void xlog_flush(xlog_context* ctx)
+{
+    if (ctx != NULL){
+        drain_rings(ctx);
+    }
+}
+
+/**
+ * get the count of log records dropped because a thread's ring was full.
+ */
+XLOG_API unsigned long long xlog_get_dropped(xlog_context* ctx)
+{
+    if (ctx == NULL){
+        return 0;
+    }
+    return __atomic_load_n(&ctx->_dropped, __ATOMIC_RELAXED);
+}
+
 //-------------------------------------------------print api
 
 /**
- * print a error message, return 0 if success.
+ * Format the message on the calling thread and queue it for the writer
+ * thread. Only a record that finds the writer idle takes the ring lock,
+ * to wake it.
  */
-XLOG_API int xlog_err(xlog_writer *wr, const char *format, ...)
-{   
-    int i;
-    struct xlog_receiver_info *inf;
-    va_list args;
+static int xlog_print(xlog_writer *wr, int level, const char *format, va_list args)
+{
+    char buf[LOG_MAX_LENGTH + 1];
+    int fmtl;
+    int wr_len = 0;
+    int strl;
     xlog_context *ctx;
+    struct xlog_ring *ring;
+    unsigned long long seq;
+    int ret;
 
     if (wr == NULL){
         return -1;
     }
 
     ctx = wr->_ctx;
-    if (ctx == NULL || ctx->_log_level < XLOG_LEVEL_ERR || ctx->_count < 1){
+    if (ctx == NULL || ctx->_log_level < level || ctx->_count < 1){
         return -1;
     }
 
-    pthread_mutex_lock(&ctx->_mutext);
-
-    for (i = 0; i < ctx->_count; i++){
-        inf = &ctx->_receivers[i];
+    ring = get_thread_ring(ctx);
+    if (ring == NULL){
+        return -1;
+    }
 
-        if (inf->_fn != NULL && inf->_enable){
-            va_start(args, format);
-            inf->_fn(inf, wr->_domain, format, args);
-            va_end(args);
-        }        
+    if (wr->_domain[0]){
+        strl = strlen(wr->_domain);
+        strcpy(buf + wr_len, wr->_domain);
+        wr_len += strl;
+        strcpy(buf + wr_len, ": ");
+        wr_len += 2;
     }
 
-    pthread_mutex_unlock(&ctx->_mutext);
+    fmtl = vsnprintf(buf + wr_len, LOG_MAX_LENGTH - wr_len, format, args);
+    if (fmtl < 0)
+        fmtl = 0;
+    if (fmtl > LOG_MAX_LENGTH - wr_len - 1)
+        fmtl = LOG_MAX_LENGTH - wr_len - 1;
+    wr_len += fmtl;
+    *(buf + wr_len) = '\n';
+    wr_len += 1;
 
+    seq = __atomic_fetch_add(&ctx->_seq, 1, __ATOMIC_RELAXED);
+
+    ret = ring_push(ring, buf, wr_len, seq);
+    if (ret < 0)
+        return ret;
+
+    if (__atomic_load_n(&ctx->_idle, __ATOMIC_SEQ_CST)){
+        pthread_mutex_lock(&ctx->_ring_mutex);
+        pthread_cond_signal(&ctx->_ring_cond);
+        pthread_mutex_unlock(&ctx->_ring_mutex);
+    }
+    else if (ret > 0){
+        // A burst got the ring half full, hurry the writer.
+        pthread_cond_signal(&ctx->_ring_cond);
+    }
     return 0;
 }
 
 /**
- * print a warning message, return 0 if success.
+ * print a error message, return 0 if success.
  */
-XLOG_API int xlog_warn(xlog_writer *wr, const char *format, ...)
-{
-    int i;
-    struct xlog_receiver_info *inf;
+XLOG_API int xlog_err(xlog_writer *wr, const char *format, ...)
+{   
+    int ret;
     va_list args;
-    xlog_context *ctx;
-
-    if (wr == NULL){
-        return -1;
-    }
-
-    ctx = wr->_ctx;
-    if (ctx == NULL || ctx->_log_level < XLOG_LEVEL_WARN || ctx->_count < 1){
-        return -1;
-    }
 
-    pthread_mutex_lock(&ctx->_mutext);
+    va_start(args, format);
+    ret = xlog_print(wr, XLOG_LEVEL_ERR, format, args);
+    va_end(args);
 
-    for (i = 0; i < ctx->_count; i++){
-        inf = &ctx->_receivers[i];
+    return ret;
+}
 
-        if (inf->_fn != NULL && inf->_enable){
-            va_start(args, format);
-            inf->_fn(inf, wr->_domain, format, args);
-            va_end(args);
-        }        
-    }
+/**
+ * print a warning message, return 0 if success.
+ */
+XLOG_API int xlog_warn(xlog_writer *wr, const char *format, ...)
+{
+    int ret;
+    va_list args;
 
-    pthread_mutex_unlock(&ctx->_mutext);
+    va_start(args, format);
+    ret = xlog_print(wr, XLOG_LEVEL_WARN, format, args);
+    va_end(args);
 
-    return 0;    
+    return ret;
 }
 
 /**
@@ -584,35 +927,14 @@ XLOG_API int xlog_warn(xlog_writer *wr, const char *format, ...)
  */
 XLOG_API int xlog_info(xlog_writer *wr, const char *format, ...)
 {
-    int i;
-    struct xlog_receiver_info *inf;
+    int ret;
     va_list args;
-    xlog_context *ctx;
-
-    if (wr == NULL){
-        return -1;
-    }
-
-    ctx = wr->_ctx;
-    if (ctx == NULL || ctx->_log_level < XLOG_LEVEL_INFO || ctx->_count < 1){
-        return -1;
-    }
-
-    pthread_mutex_lock(&ctx->_mutext);
-
-    for (i = 0; i < ctx->_count; i++){
-        inf = &ctx->_receivers[i];
 
-        if (inf->_fn != NULL && inf->_enable){
-            va_start(args, format);
-            inf->_fn(inf, wr->_domain, format, args);
-            va_end(args);
-        }        
-    }
-
-    pthread_mutex_unlock(&ctx->_mutext);
+    va_start(args, format);
+    ret = xlog_print(wr, XLOG_LEVEL_INFO, format, args);
+    va_end(args);
 
-    return 0;    
+    return ret;
 }
 
 /**
@@ -620,35 +942,14 @@ XLOG_API int xlog_info(xlog_writer *wr, const char *format, ...)
  */
 XLOG_API int xlog_dbg(xlog_writer *wr, const char *format, ...)
 {
-    int i;
-    struct xlog_receiver_info *inf;
+    int ret;
     va_list args;
-    xlog_context *ctx;
 
-    if (wr == NULL){
-        return -1;
-    }
+    va_start(args, format);
+    ret = xlog_print(wr, XLOG_LEVEL_DBG, format, args);
+    va_end(args);
 
-    ctx = wr->_ctx;
-    if (ctx == NULL || ctx->_log_level < XLOG_LEVEL_DBG || ctx->_count < 1){
-        return -1;
-    }
-
-    pthread_mutex_lock(&ctx->_mutext);
-
-    for (i = 0; i < ctx->_count; i++){
-        inf = &ctx->_receivers[i];
-
-        if (inf->_fn != NULL && inf->_enable){
-            va_start(args, format);
-            inf->_fn(inf, wr->_domain, format, args);
-            va_end(args);
-        }        
-    }
-
-    pthread_mutex_unlock(&ctx->_mutext);
-
-    return 0;      
+    return ret;
 }
 
 /**
@@ -656,33 +957,12 @@ XLOG_API int xlog_dbg(xlog_writer *wr, const char *format, ...)
  */
 XLOG_API int xlog_detail(xlog_writer *wr, const char *format, ...)
 {
-    int i;
-    struct xlog_receiver_info *inf;
+    int ret;
     va_list args;
-    xlog_context *ctx;
 
-    if (wr == NULL){
-        return -1;
-    }
+    va_start(args, format);
+    ret = xlog_print(wr, XLOG_LEVEL_DETAIL, format, args);
+    va_end(args);
 
-    ctx = wr->_ctx;
-    if (ctx == NULL || ctx->_log_level < XLOG_LEVEL_DETAIL || ctx->_count < 1){
-        return -1;
-    }
-
-    pthread_mutex_lock(&ctx->_mutext);
-
-    for (i = 0; i < ctx->_count; i++){
-        inf = &ctx->_receivers[i];
-
-        if (inf->_fn != NULL && inf->_enable){
-            va_start(args, format);
-            inf->_fn(inf, wr->_domain, format, args);
-            va_end(args);
-        }        
-    }
-
-    pthread_mutex_unlock(&ctx->_mutext);
-
-    return 0;   
-}
\ No newline at end of file
+    return ret;
+}
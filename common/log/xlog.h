@@ -25,6 +25,9 @@
 *	xlog_writer *wr = xlog_create_writer(ctx, "module name");
 *	xlog_err(wr, "count:%d", 100);
 *	xlog_free(ctx); //free the context, all writer will can't to use
+*
+*	Messages are formatted on the calling thread into a ring of that
+*	thread, and written to the receivers by a writer thread of the context.
 */
 
 #ifndef	_X_LOG_H_
@@ -60,6 +63,28 @@ typedef struct xlog_context xlog_context;
 struct xlog_writer;
 typedef struct xlog_writer xlog_writer;
 
+/*
+	The leading member of every xlog_writer, lets xlog_enabled() read
+	the level of the context without a call.
+*/
+struct xlog_writer_head
+{
+	const volatile int *_level;
+};
+
+/*
+	Messages above this level are removed at compile time.
+*/
+#ifndef XLOG_MAX_LEVEL
+#define XLOG_MAX_LEVEL XLOG_LEVEL_DETAIL
+#endif
+
+/*
+	Test a level before formatting arguments, see the log macros.
+*/
+#define xlog_enabled(wr, level) ((level) <= XLOG_MAX_LEVEL && (wr) \
+			&& *((const struct xlog_writer_head*)(wr))->_level >= (level))
+
 /**
  * 	define log data receiver type
 */
@@ -122,6 +147,16 @@ XLOG_API const char* xlog_get_error(xlog_context* ctx);
  */
 XLOG_API int xlog_set_level(xlog_context* ctx, int level);
 
+/**
+ * 	write out the queued records on the calling thread.
+ */
+XLOG_API void xlog_flush(xlog_context* ctx);
+
+/**
+ * 	get the count of log records dropped because a thread's ring was full.
+ */
+XLOG_API unsigned long long xlog_get_dropped(xlog_context* ctx);
+
 /**
  * create a new writer
  * use free to delete the returns object.
@@ -201,6 +201,8 @@ enum sr_datafeed_packet_type {
 	SR_DF_FRAME_BEGIN,
 	SR_DF_FRAME_END,
     SR_DF_OVERFLOW,
+    /** Decoder annotations, for the export modules. */
+    SR_DF_ANNOTATION,
 };
 
 /** Values for sr_datafeed_analog.mq. */
@@ -378,6 +380,8 @@ struct sr_datafeed_meta {
 enum LA_DATA_FORMAT {
     LA_CROSS_DATA,
     LA_SPLIT_DATA,
+    /** cross data units of the changed samples only, see sample_index */
+    LA_EDGE_DATA,
 };
 
 struct sr_datafeed_logic {
@@ -391,6 +395,17 @@ struct sr_datafeed_logic {
     uint16_t data_error;
     uint64_t error_pattern;
 	void *data;
+    /** for LA_EDGE_DATA, the sample number of each unit */
+    const uint64_t *sample_index;
+};
+
+/** Annotations of one decoder row, the texts are UTF-8. */
+struct sr_datafeed_annotation {
+    const char *row;
+    uint64_t num;
+    const uint64_t *start;
+    const uint64_t *end;
+    const char **text;
 };
 
 struct sr_datafeed_dso {
@@ -640,6 +655,7 @@ enum CHANNEL_TYPE {
     SR_CHANNEL_FFT,
     SR_CHANNEL_LISSAJOUS,
     SR_CHANNEL_MATH,
+    SR_CHANNEL_EYE,
 };
 
 enum OPERATION_MODE {	
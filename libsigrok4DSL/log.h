@@ -48,10 +48,10 @@ SR_API void ds_log_set_context(xlog_context *ctx);
 SR_API void ds_log_level(int level);
 
 #define LOG_PREFIX "" 
-#define sr_err(fmt, args...) xlog_err(sr_log, LOG_PREFIX fmt, ## args)
-#define sr_warn(fmt, args...) xlog_warn(sr_log, LOG_PREFIX fmt, ## args)
-#define sr_info(fmt, args...) xlog_info(sr_log, LOG_PREFIX fmt, ## args)
-#define sr_dbg(fmt, args...) xlog_dbg(sr_log, LOG_PREFIX fmt, ## args)
-#define sr_detail(fmt, args...) xlog_detail(sr_log, LOG_PREFIX fmt, ## args)
+#define sr_err(fmt, args...) (xlog_enabled(sr_log, XLOG_LEVEL_ERR) ? xlog_err(sr_log, LOG_PREFIX fmt, ## args) : -1)
+#define sr_warn(fmt, args...) (xlog_enabled(sr_log, XLOG_LEVEL_WARN) ? xlog_warn(sr_log, LOG_PREFIX fmt, ## args) : -1)
+#define sr_info(fmt, args...) (xlog_enabled(sr_log, XLOG_LEVEL_INFO) ? xlog_info(sr_log, LOG_PREFIX fmt, ## args) : -1)
+#define sr_dbg(fmt, args...) (xlog_enabled(sr_log, XLOG_LEVEL_DBG) ? xlog_dbg(sr_log, LOG_PREFIX fmt, ## args) : -1)
+#define sr_detail(fmt, args...) (xlog_enabled(sr_log, XLOG_LEVEL_DETAIL) ? xlog_detail(sr_log, LOG_PREFIX fmt, ## args) : -1)
 
 #endif
\ No newline at end of file
@@ -22,6 +22,7 @@
 #include "../libsigrok-internal.h"
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 #include <glib.h>
 #include "../config.h" /* Needed for PACKAGE_STRING and others. */
 #include "../log.h"
@@ -48,15 +49,168 @@ struct context {
     uint64_t pre_data;
     uint64_t index;
     int type;
+    /* Decimals of the exact sample time, -1 to use printf. */
+    int time_digits;
+    uint64_t time_step;
+    /* One output line of logic data. */
+    char *line;
 };
 
+/* Writes the decimal digits of v, returns the length. */
+static int format_uint(char *buf, uint64_t v)
+{
+    char tmp[20];
+    int len = 0;
+    int i;
+
+    do {
+        tmp[len++] = '0' + (v % 10);
+        v /= 10;
+    } while (v != 0);
+
+    for (i = 0; i < len; i++)
+        buf[i] = tmp[len - 1 - i];
+
+    return len;
+}
+
+/* The sample time is exact in N decimals if the samplerate divides 10^N. */
+static void set_time_format(struct context *ctx)
+{
+    uint64_t scale = 1;
+    int digits;
+
+    ctx->time_digits = -1;
+
+    if (ctx->samplerate == 0)
+        return;
+
+    for (digits = 0; digits <= 18; digits++) {
+        if (scale % ctx->samplerate == 0) {
+            ctx->time_digits = digits;
+            ctx->time_step = scale / ctx->samplerate;
+            return;
+        }
+        scale *= 10;
+    }
+}
+
+/* Writes the time of a sample in seconds, trailing zeros are dropped. */
+static int format_time(const struct context *ctx, char *buf, uint64_t index)
+{
+    uint64_t frac;
+    int len, i;
+
+    if (ctx->time_digits < 0)
+        return sprintf(buf, "%0.15g", (double)index / (double)ctx->samplerate);
+
+    len = format_uint(buf, index / ctx->samplerate);
+    frac = (index % ctx->samplerate) * ctx->time_step;
+
+    if (frac != 0) {
+        buf[len++] = '.';
+        for (i = ctx->time_digits - 1; i >= 0; i--) {
+            buf[len + i] = '0' + (frac % 10);
+            frac /= 10;
+        }
+        len += ctx->time_digits;
+
+        while (buf[len - 1] == '0')
+            len--;
+    }
+
+    return len;
+}
+
+/* Same text as "%0.5f" for the voltages, without printf. */
+static void append_fixed5(GString *out, double v)
+{
+    char buf[32];
+    uint64_t ip, scaled;
+    double frac, d;
+    int len = 0;
+    int i;
+
+    if (!(v > -1e12 && v < 1e12)) {
+        g_string_append_printf(out, "%0.5f", v);
+        return;
+    }
+
+    if (v < 0) {
+        buf[len++] = '-';
+        v = -v;
+    }
+
+    /*
+     * printf rounds the exact binary value half to even. The fraction
+     * v - ip is exact, but scaling it by 1e5 rounds, so the truncation
+     * is corrected and the half is compared by fma(), which rounds
+     * only once and keeps the sign of the exact difference.
+     */
+    ip = (uint64_t)v;
+    frac = v - (double)ip;
+    scaled = (uint64_t)(frac * 100000.0);
+    if (fma(frac, 100000.0, -(double)scaled) < 0)
+        scaled--;
+    else if (fma(frac, 100000.0, -(double)(scaled + 1)) >= 0)
+        scaled++;
+
+    d = fma(frac, 200000.0, -(double)(2 * scaled + 1));
+    if (d > 0 || (d == 0 && (scaled & 1)))
+        scaled++;
+    if (scaled == 100000) {
+        ip++;
+        scaled = 0;
+    }
+
+    len += format_uint(buf + len, ip);
+    buf[len++] = '.';
+
+    for (i = 4; i >= 0; i--) {
+        buf[len + i] = '0' + (scaled % 10);
+        scaled /= 10;
+    }
+    len += 5;
+
+    g_string_append_len(out, buf, len);
+}
+
+/* Appends one line of logic data. */
+static void append_logic_line(struct context *ctx, GString *out,
+        const uint8_t *unit, uint64_t index)
+{
+    char *p = ctx->line;
+    unsigned int j;
+
+    p += format_time(ctx, p, index);
+
+    for (j = 0; j < ctx->num_enabled_channels; j++) {
+        *p++ = ctx->separator;
+        *p++ = (unit[j / 8] & (1 << (j % 8))) ? '1' : '0';
+    }
+    *p++ = '\n';
+
+    g_string_append_len(out, ctx->line, p - ctx->line);
+}
+
+/* The enabled channel bits of a unit. */
+static uint64_t unit_value(const struct context *ctx, const uint8_t *unit, uint16_t unitsize)
+{
+    uint64_t v = 0;
+    int i;
+
+    for (i = 0; i < unitsize && i < 8; i++)
+        v |= (uint64_t)unit[i] << (i * 8);
+
+    return v & ctx->mask;
+}
+
 /*
  * TODO:
  *  - Option to specify delimiter character and/or string.
  *  - Option to (not) print metadata as comments.
  *  - Option to specify the comment character(s), e.g. # or ; or C/C++-style.
  *  - Option to (not) print samplenumber / time as extra column.
- *  - Option to "compress" output (only print changed samples, VCD-like).
  *  - Option to print comma-separated bits, or whole bytes/words (for 8/16
  *    channel LAs) as ASCII/hex etc. etc.
  *  - Trigger support.
@@ -105,7 +259,10 @@ static int init(struct sr_output *o, GHashTable *options)
     ctx->channel_mmax = malloc(sizeof(double) * ctx->num_enabled_channels);
     ctx->channel_mmin = malloc(sizeof(double) * ctx->num_enabled_channels);
 
-    if (ctx->channel_index == NULL || ctx->channel_mmin == NULL){
+    /* Time column, and a separator and digit per channel. */
+    ctx->line = malloc(64 + 2 * ctx->num_enabled_channels);
+
+    if (ctx->channel_index == NULL || ctx->channel_mmin == NULL || ctx->line == NULL){
         sr_err("%s,ERROR:failed to alloc memory.", __func__);
         return SR_ERR;
     }
@@ -121,7 +278,7 @@ static int init(struct sr_output *o, GHashTable *options)
 			continue;
         ctx->channel_index[i] = ch->index;
         //ctx->mask |= (1 << ch->index);
-        ctx->mask |= (1 << i);
+        ctx->mask |= (1ULL << i);
         range = ch->vdiv * ch->vfactor * DS_CONF_DSO_VDIVS;
         ctx->channel_unit[i] = (range >= 5000000) ? 1000000 :
                                 (range >= 5000) ? 1000 : 1;
@@ -219,8 +376,8 @@ static int receive(const struct sr_output *o, const struct sr_datafeed_packet *p
 	struct context *ctx;
 	int idx;
 	uint64_t i, j;
-    unsigned char *p, c;
-    double tmpv;
+    unsigned char *p;
+    uint64_t cur_data;
     struct sr_channel *ch;
 
 	*out = NULL;
@@ -243,6 +400,7 @@ static int receive(const struct sr_output *o, const struct sr_datafeed_packet *p
             else if (src->key == SR_CONF_REF_MAX)
                 ctx->ref_max = g_variant_get_uint32(src->data);
         }
+        set_time_format(ctx);
 		break;
 	case SR_DF_LOGIC:
 		logic = packet->payload;
@@ -253,26 +411,29 @@ static int receive(const struct sr_output *o, const struct sr_datafeed_packet *p
 			*out = g_string_sized_new(512);
 		}
 
-		for (i = 0; i <= logic->length - logic->unitsize; i += logic->unitsize) {
+		if (logic->format == LA_EDGE_DATA) {
+            /* Only the changed samples, each with its sample number. */
+            for (i = 0, j = 0; i + logic->unitsize <= logic->length; i += logic->unitsize, j++) {
+                p = (unsigned char *)logic->data + i;
+                append_logic_line(ctx, *out, p, logic->sample_index[j]);
+                ctx->index = logic->sample_index[j] + 1;
+                ctx->pre_data = unit_value(ctx, p, logic->unitsize);
+            }
+            break;
+        }
+
+		for (i = 0; i + logic->unitsize <= logic->length; i += logic->unitsize) {
             ctx->index++;
+            p = (unsigned char *)logic->data + i;
+            cur_data = unit_value(ctx, p, logic->unitsize);
 
             if (packet->bExportOriginalData == 0){
-                if (ctx->index > 1 && (*(uint64_t *)(logic->data + i) & ctx->mask) == ctx->pre_data)
+                if (ctx->index > 1 && cur_data == ctx->pre_data)
                    continue;
             } 
-            
-            tmpv = (double)(ctx->index-1) / (double)ctx->samplerate;
-            g_string_append_printf(*out, "%0.15g", tmpv); 
 
-            for (j = 0; j < ctx->num_enabled_channels; j++) {
-                idx = j;
-				p = logic->data + i + idx / 8;
-				c = *p & (1 << (idx % 8));
-                g_string_append_c(*out, ctx->separator);
-                g_string_append_c(*out, c ? '1' : '0');
-			}
-			g_string_append_printf(*out, "\n");
-            ctx->pre_data = (*(uint64_t *)(logic->data + i) & ctx->mask);
+            append_logic_line(ctx, *out, p, ctx->index - 1);
+            ctx->pre_data = cur_data;
 		}
 		break;
      case SR_DF_DSO:
@@ -288,9 +449,9 @@ static int receive(const struct sr_output *o, const struct sr_datafeed_packet *p
             for (j = 0; j < ctx->num_enabled_channels; j++) {
                 idx = ctx->channel_index[j];
                 p = dso->data + i * ctx->num_enabled_channels + idx * ((ctx->num_enabled_channels > 1) ? 1 : 0);
-                g_string_append_printf(*out, "%0.5f", (ctx->channel_offset[j] - *p) *
-                                                       ctx->channel_scale[j] /
-                                                      (ctx->ref_max - ctx->ref_min));
+                append_fixed5(*out, (ctx->channel_offset[j] - *p) *
+                                     ctx->channel_scale[j] /
+                                     (ctx->ref_max - ctx->ref_min));
                 g_string_append_c(*out, ctx->separator);
             }
 
@@ -342,7 +503,7 @@ static int receive(const struct sr_output *o, const struct sr_datafeed_packet *p
                mapRange = (mmax - mmin);
                vf = (hw_offset - (double)(*p)) * mapRange / max_min_ref;
 
-               g_string_append_printf(*out, "%0.5f",  vf);
+               append_fixed5(*out, vf);
                g_string_append_c(*out, ctx->separator);
 
                ch_cfg_dex++;
@@ -368,6 +529,7 @@ static int cleanup(struct sr_output *o)
 	if (o->priv) {
 		ctx = o->priv;
 		g_free(ctx->channel_index);
+		g_free(ctx->line);
 		g_free(o->priv);
 		o->priv = NULL;
 	}
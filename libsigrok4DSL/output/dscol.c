@@ -0,0 +1,495 @@
+/*
+ * This file is part of the DSView project.
+ * DSView is based on PulseView.
+ *
+ * Copyright (C) 2024 DreamSourceLab <support@dreamsourcelab.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+/*
+ * Binary columnar export.
+ *
+ * The file is the 8 byte magic "DSCOL\r\n\0", then a list of chunks.
+ * A chunk is a 4 character tag, the uint32 payload length, and the
+ * payload padded with zeros to a multiple of 8 bytes. All numbers are
+ * little endian, and the arrays of 8 byte values are 8 byte aligned.
+ *
+ * SCHM  JSON text: samplerate, sample count and the columns. A column
+ *       has an id, a name, and for DSO/analog the unit, scale and offset,
+ *       value = (raw - offset) * scale.
+ * EDGE  Logic column: uint32 column, uint32 count, uint32 level, uint32 0,
+ *       uint64 sample[count]. The samples where the channel changes, the
+ *       first sample of the capture included. "level" is the value from
+ *       sample[0] on, and it toggles at each following sample.
+ * DATA  DSO/analog column: uint32 column, uint32 count, uint8 raw[count].
+ *       The chunks of a column follow each other in sample order.
+ * ANNO  Decoder annotations of one row: uint32 name length, the name
+ *       padded to 8 bytes, uint64 count, uint64 start[count],
+ *       uint64 end[count], uint32 text_offset[count + 1], the UTF-8 texts.
+ * END   uint64 sample count.
+ */
+
+#include "../libsigrok-internal.h"
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include "../config.h" /* Needed for PACKAGE_STRING and others. */
+#include "../log.h"
+#include <stdio.h>
+
+#undef LOG_PREFIX
+#define LOG_PREFIX "dscol: "
+
+#define DSCOL_MAGIC     "DSCOL\r\n"
+
+/* Edges kept per logic column before a chunk is written. */
+#define EDGE_CHUNK      8192
+
+struct column {
+    char *name;
+    /* DSO/analog: position of the channel in a sample. */
+    int pos;
+    const char *unit;
+    double scale;
+    double offset;
+    /* Logic: the current level and the edges not written yet. */
+    int level;
+    int first_level;
+    uint64_t *edges;
+    uint32_t edge_count;
+};
+
+struct context {
+    int type;
+    int num_columns;
+    struct column *columns;
+    /* Channels in one DSO/analog sample. */
+    int sample_width;
+    uint64_t samplerate;
+    uint64_t limit_samples;
+    uint32_t ref_min;
+    uint32_t ref_max;
+    uint64_t samplecount;
+    gboolean header_done;
+};
+
+static void append_u32(GString *out, uint32_t v)
+{
+    uint8_t b[4];
+
+    b[0] = v; b[1] = v >> 8; b[2] = v >> 16; b[3] = v >> 24;
+    g_string_append_len(out, (const char *)b, 4);
+}
+
+static void append_u64(GString *out, uint64_t v)
+{
+    append_u32(out, (uint32_t)v);
+    append_u32(out, (uint32_t)(v >> 32));
+}
+
+static void append_padding(GString *out)
+{
+    while (out->len % 8 != 0)
+        g_string_append_c(out, '\0');
+}
+
+/* Starts a chunk, returns the position of its length field. */
+static gsize begin_chunk(GString *out, const char *tag)
+{
+    gsize pos;
+
+    g_string_append_len(out, tag, 4);
+    pos = out->len;
+    append_u32(out, 0);
+
+    return pos;
+}
+
+static void end_chunk(GString *out, gsize pos)
+{
+    uint32_t len = out->len - pos - 4;
+    uint8_t *p = (uint8_t *)out->str + pos;
+
+    p[0] = len; p[1] = len >> 8; p[2] = len >> 16; p[3] = len >> 24;
+    append_padding(out);
+}
+
+static void append_json_string(GString *out, const char *s)
+{
+    g_string_append_c(out, '"');
+
+    for (; s && *s; s++) {
+        if (*s == '"' || *s == '\\')
+            g_string_append_printf(out, "\\%c", *s);
+        else if ((unsigned char)*s < 0x20)
+            g_string_append_printf(out, "\\u%04x", (unsigned char)*s);
+        else
+            g_string_append_c(out, *s);
+    }
+
+    g_string_append_c(out, '"');
+}
+
+static int init(struct sr_output *o, GHashTable *options)
+{
+    struct context *ctx;
+    struct sr_channel *ch;
+    struct column *col;
+    GSList *l;
+    int i, pos;
+    float range;
+    int unit;
+
+    if (!o || !o->sdi)
+        return SR_ERR_ARG;
+
+    ctx = g_try_malloc0(sizeof(struct context));
+    if (ctx == NULL) {
+        sr_err("%s,ERROR:failed to alloc memory.", __func__);
+        return SR_ERR;
+    }
+
+    o->priv = ctx;
+    ctx->type = g_variant_get_int16(g_hash_table_lookup(options, "type"));
+
+    for (l = o->sdi->channels; l; l = l->next) {
+        ch = l->data;
+        if (ch->type == ctx->type && ch->enabled)
+            ctx->num_columns++;
+    }
+
+    ctx->columns = g_try_malloc0(sizeof(struct column) * (ctx->num_columns + 1));
+    if (ctx->columns == NULL) {
+        sr_err("%s,ERROR:failed to alloc memory.", __func__);
+        return SR_ERR;
+    }
+
+    i = 0;
+    pos = 0;
+
+    for (l = o->sdi->channels; l; l = l->next, pos++) {
+        ch = l->data;
+        if (ch->type != ctx->type || !ch->enabled)
+            continue;
+
+        col = &ctx->columns[i];
+        col->name = g_strdup(ch->name);
+
+        if (ctx->type == SR_CHANNEL_LOGIC) {
+            col->edges = g_try_malloc(sizeof(uint64_t) * EDGE_CHUNK);
+            if (col->edges == NULL) {
+                sr_err("%s,ERROR:failed to alloc memory.", __func__);
+                return SR_ERR;
+            }
+        }
+        else if (ctx->type == SR_CHANNEL_DSO) {
+            /* The same units as the CSV export. */
+            range = ch->vdiv * ch->vfactor * DS_CONF_DSO_VDIVS;
+            unit = (range >= 5000000) ? 1000000 : (range >= 5000) ? 1000 : 1;
+            col->unit = unit >= 1000000 ? "kV" : unit >= 1000 ? "V" : "mV";
+            col->scale = range / unit;
+            col->offset = ch->hw_offset;
+            col->pos = ch->index;
+        }
+        else {
+            col->unit = ch->map_unit;
+            col->scale = ch->map_max - ch->map_min;
+            col->offset = ch->hw_offset;
+            col->pos = pos;
+        }
+        i++;
+    }
+
+    if (ctx->type == SR_CHANNEL_DSO) {
+        ctx->sample_width = ctx->num_columns;
+        if (ctx->num_columns == 1)
+            ctx->columns[0].pos = 0;
+    }
+    else {
+        ctx->sample_width = g_slist_length(o->sdi->channels);
+    }
+
+    return SR_OK;
+}
+
+static GString *gen_header(const struct sr_output *o)
+{
+    struct context *ctx;
+    struct column *col;
+    GString *header;
+    double range;
+    gsize pos;
+    int i;
+
+    ctx = o->priv;
+    header = g_string_sized_new(1024);
+    g_string_append_len(header, DSCOL_MAGIC, 8);
+
+    pos = begin_chunk(header, "SCHM");
+
+    g_string_append_printf(header, "{\"generator\":");
+    append_json_string(header, PACKAGE_STRING);
+    g_string_append_printf(header,
+            ",\"version\":1,\"samplerate\":%llu,\"samples\":%llu",
+            (u64_t)ctx->samplerate, (u64_t)ctx->limit_samples);
+    g_string_append_printf(header, ",\"kind\":\"%s\",\"columns\":[",
+            ctx->type == SR_CHANNEL_LOGIC ? "edges" : "samples");
+
+    /* The raw values are in the range of the reference levels. */
+    range = (ctx->ref_max > ctx->ref_min) ? (double)(ctx->ref_max - ctx->ref_min) : 1;
+
+    for (i = 0; i < ctx->num_columns; i++) {
+        col = &ctx->columns[i];
+
+        if (i > 0)
+            g_string_append_c(header, ',');
+
+        g_string_append_printf(header, "{\"id\":%d,\"name\":", i);
+        append_json_string(header, col->name);
+
+        if (ctx->type == SR_CHANNEL_LOGIC) {
+            g_string_append_printf(header, ",\"type\":\"uint64\"}");
+        }
+        else {
+            g_string_append_printf(header, ",\"type\":\"uint8\",\"unit\":");
+            append_json_string(header, col->unit);
+            g_string_append_printf(header, ",\"scale\":%.17g,\"offset\":%.17g}",
+                    -col->scale / range, col->offset);
+        }
+    }
+
+    g_string_append_printf(header, "]}");
+    end_chunk(header, pos);
+
+    return header;
+}
+
+static void write_edges(GString *out, struct column *col, int index)
+{
+    gsize pos;
+    uint32_t i;
+
+    if (col->edge_count == 0)
+        return;
+
+    pos = begin_chunk(out, "EDGE");
+    append_u32(out, index);
+    append_u32(out, col->edge_count);
+    append_u32(out, col->first_level);
+    append_u32(out, 0);
+
+    for (i = 0; i < col->edge_count; i++)
+        append_u64(out, col->edges[i]);
+
+    end_chunk(out, pos);
+    col->edge_count = 0;
+}
+
+static void add_logic_unit(struct context *ctx, GString *out,
+        const uint8_t *unit, uint16_t unitsize, uint64_t sample)
+{
+    struct column *col;
+    int i, bit;
+
+    for (i = 0; i < ctx->num_columns && i / 8 < unitsize; i++) {
+        col = &ctx->columns[i];
+        bit = (unit[i / 8] >> (i % 8)) & 1;
+
+        if (sample != 0 && bit == col->level)
+            continue;
+
+        if (col->edge_count == 0)
+            col->first_level = bit;
+
+        col->edges[col->edge_count++] = sample;
+        col->level = bit;
+
+        if (col->edge_count == EDGE_CHUNK)
+            write_edges(out, col, i);
+    }
+}
+
+/* One DATA chunk per column for a packet of interleaved samples. */
+static void write_samples(struct context *ctx, GString *out,
+        const uint8_t *data, uint64_t num_samples)
+{
+    struct column *col;
+    gsize pos;
+    uint64_t i;
+    int j;
+
+    for (j = 0; j < ctx->num_columns; j++) {
+        col = &ctx->columns[j];
+
+        pos = begin_chunk(out, "DATA");
+        append_u32(out, j);
+        append_u32(out, num_samples);
+
+        for (i = 0; i < num_samples; i++)
+            g_string_append_c(out, data[i * ctx->sample_width + col->pos]);
+
+        end_chunk(out, pos);
+    }
+}
+
+static void write_annotations(GString *out, const struct sr_datafeed_annotation *ann)
+{
+    gsize pos;
+    uint64_t i;
+    uint32_t offset;
+
+    pos = begin_chunk(out, "ANNO");
+    append_u32(out, strlen(ann->row));
+    g_string_append(out, ann->row);
+    append_padding(out);
+    append_u64(out, ann->num);
+
+    for (i = 0; i < ann->num; i++)
+        append_u64(out, ann->start[i]);
+    for (i = 0; i < ann->num; i++)
+        append_u64(out, ann->end[i]);
+
+    offset = 0;
+    append_u32(out, 0);
+    for (i = 0; i < ann->num; i++) {
+        offset += strlen(ann->text[i]);
+        append_u32(out, offset);
+    }
+    for (i = 0; i < ann->num; i++)
+        g_string_append(out, ann->text[i]);
+
+    end_chunk(out, pos);
+}
+
+static int receive(const struct sr_output *o, const struct sr_datafeed_packet *packet,
+        GString **out)
+{
+    const struct sr_datafeed_meta *meta;
+    const struct sr_datafeed_logic *logic;
+    const struct sr_datafeed_dso *dso;
+    const struct sr_datafeed_analog *analog;
+    const struct sr_config *src;
+    struct context *ctx;
+    GSList *l;
+    uint64_t i, j;
+    gsize pos;
+    int k;
+
+    *out = NULL;
+    if (!o || !o->sdi)
+        return SR_ERR_ARG;
+    if (!(ctx = o->priv))
+        return SR_ERR_ARG;
+
+    if (packet->type == SR_DF_META) {
+        meta = packet->payload;
+        for (l = meta->config; l; l = l->next) {
+            src = l->data;
+            if (src->key == SR_CONF_SAMPLERATE)
+                ctx->samplerate = g_variant_get_uint64(src->data);
+            else if (src->key == SR_CONF_LIMIT_SAMPLES)
+                ctx->limit_samples = g_variant_get_uint64(src->data);
+            else if (src->key == SR_CONF_REF_MIN)
+                ctx->ref_min = g_variant_get_uint32(src->data);
+            else if (src->key == SR_CONF_REF_MAX)
+                ctx->ref_max = g_variant_get_uint32(src->data);
+        }
+        return SR_OK;
+    }
+
+    if (!ctx->header_done) {
+        *out = gen_header(o);
+        ctx->header_done = TRUE;
+    } else {
+        *out = g_string_sized_new(512);
+    }
+
+    switch (packet->type) {
+    case SR_DF_LOGIC:
+        logic = packet->payload;
+        if (logic->unitsize == 0)
+            break;
+
+        for (i = 0, j = 0; i + logic->unitsize <= logic->length; i += logic->unitsize, j++) {
+            if (logic->format == LA_EDGE_DATA)
+                ctx->samplecount = logic->sample_index[j];
+            add_logic_unit(ctx, *out, (const uint8_t *)logic->data + i,
+                    logic->unitsize, ctx->samplecount);
+            ctx->samplecount++;
+        }
+        break;
+    case SR_DF_DSO:
+        dso = packet->payload;
+        write_samples(ctx, *out, dso->data, dso->num_samples);
+        ctx->samplecount += dso->num_samples;
+        break;
+    case SR_DF_ANALOG:
+        analog = packet->payload;
+        write_samples(ctx, *out, analog->data, analog->num_samples);
+        ctx->samplecount += analog->num_samples;
+        break;
+    case SR_DF_ANNOTATION:
+        write_annotations(*out, packet->payload);
+        break;
+    case SR_DF_END:
+        for (k = 0; k < ctx->num_columns; k++) {
+            if (ctx->columns[k].edges)
+                write_edges(*out, &ctx->columns[k], k);
+        }
+
+        pos = begin_chunk(*out, "END ");
+        append_u64(*out, ctx->limit_samples ? ctx->limit_samples : ctx->samplecount);
+        end_chunk(*out, pos);
+        break;
+    }
+
+    return SR_OK;
+}
+
+static int cleanup(struct sr_output *o)
+{
+    struct context *ctx;
+    int i;
+
+    if (!o || !o->sdi)
+        return SR_ERR_ARG;
+
+    if (o->priv) {
+        ctx = o->priv;
+        if (ctx->columns) {
+            for (i = 0; i < ctx->num_columns; i++) {
+                g_free(ctx->columns[i].name);
+                g_free(ctx->columns[i].edges);
+            }
+            g_free(ctx->columns);
+        }
+        g_free(ctx);
+        o->priv = NULL;
+    }
+
+    return SR_OK;
+}
+
+SR_PRIV struct sr_output_module output_dscol = {
+    .id = "dscol",
+    .name = "DSCOL",
+    .desc = "Binary columnar data",
+    .exts = (const char*[]){"dscol", NULL},
+    .options = NULL,
+    .init = init,
+    .receive = receive,
+    .cleanup = cleanup,
+};
@@ -63,6 +63,7 @@ extern SR_PRIV struct sr_output_module output_ols;
 extern SR_PRIV struct sr_output_module output_gnuplot;
 extern SR_PRIV struct sr_output_module output_chronovu_la8;
 extern SR_PRIV struct sr_output_module output_csv;
+extern SR_PRIV struct sr_output_module output_dscol;
 extern SR_PRIV struct sr_output_module output_analog;
 extern SR_PRIV struct sr_output_module output_srzip;
 extern SR_PRIV struct sr_output_module output_wav;
@@ -70,6 +71,7 @@ extern SR_PRIV struct sr_output_module output_wav;
 
 static const struct sr_output_module *output_module_list[] = {
 	&output_csv,
+	&output_dscol,
 	&output_vcd,
 	&output_gnuplot,
 	&output_srzip,
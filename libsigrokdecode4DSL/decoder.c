@@ -184,6 +184,7 @@ static void decoder_free(struct srd_decoder *dec)
 	g_free(dec->longname);
 	g_free(dec->name);
 	g_free(dec->id);
+	g_free(dec->module);
 
 	g_free(dec);
 }
@@ -717,58 +718,29 @@ SRD_PRIV long srd_decoder_apiver(const struct srd_decoder *d)
 	return apiver;
 }
 
-/**
- * Load a protocol decoder module into the embedded Python interpreter.
- *
- * @param module_name The module name to be loaded.
- *
- * @return SRD_OK upon success, a (negative) error code otherwise.
- *
- * @since 0.1.0
+/*
+ * Import the decoder module and check its Decoder class. Returns
+ * SRD_ERR_PYTHON if a Python exception is pending, SRD_ERR if the
+ * module was imported but is not a usable decoder. The GIL must be held.
  */
-SRD_API int srd_decoder_load(const char *module_name)
+static int decoder_import(struct srd_decoder *d, const char *module_name,
+		const char **fail_txt)
 {
 	PyObject *py_basedec;
-	struct srd_decoder *d;
 	long apiver;
 	int is_subclass;
-	const char *fail_txt = NULL;
-	PyGILState_STATE gstate;
-  
-	if (!srd_check_init())
-		return SRD_ERR;
-
-	if (!module_name)
-		return SRD_ERR_ARG;
-
-	gstate = PyGILState_Ensure();
-
-	if (PyDict_GetItemString(PyImport_GetModuleDict(), module_name)) {
-		/* Module was already imported. */
-		PyGILState_Release(gstate);
-		return SRD_OK;
-	}
-
-	d = malloc(sizeof(struct srd_decoder));
-	if (d == NULL){
-		srd_err("%s,ERROR:failed to alloc memory.", __func__);
-		goto err_out;
-	}
-	memset(d, 0, sizeof(struct srd_decoder));
-
-	fail_txt = NULL;
 
 	//Load module from python script file,module_name is a sub directory
 	d->py_mod = py_import_by_name(module_name);
 	if (!d->py_mod) {
-		fail_txt = "import by name failed";
-		goto except_out;
+		*fail_txt = "import by name failed";
+		return SRD_ERR_PYTHON;
 	}
 
 	if (!mod_sigrokdecode) {
 		srd_err("sigrokdecode module not loaded.");
-		fail_txt = "sigrokdecode(3) not loaded";
-		goto err_out;
+		*fail_txt = "sigrokdecode(3) not loaded";
+		return SRD_ERR;
 	}
 
 	/* 
@@ -777,8 +749,8 @@ SRD_API int srd_decoder_load(const char *module_name)
 	*/
 	d->py_dec = PyObject_GetAttrString(d->py_mod, "Decoder");
 	if (!d->py_dec) {
-		fail_txt = "no 'Decoder' attribute in imported module";
-		goto except_out;
+		*fail_txt = "no 'Decoder' attribute in imported module";
+		return SRD_ERR_PYTHON;
 	}
 
 	/*
@@ -786,8 +758,8 @@ SRD_API int srd_decoder_load(const char *module_name)
 	*/
 	py_basedec = PyObject_GetAttrString(mod_sigrokdecode, "Decoder");
 	if (!py_basedec) {
-		fail_txt = "no 'Decoder' attribute in sigrokdecode(3)";
-		goto except_out;
+		*fail_txt = "no 'Decoder' attribute in sigrokdecode(3)";
+		return SRD_ERR_PYTHON;
 	}
 
 	is_subclass = PyObject_IsSubclass(d->py_dec, py_basedec);
@@ -796,8 +768,8 @@ SRD_API int srd_decoder_load(const char *module_name)
 	if (!is_subclass) {
 		srd_err("Decoder class in protocol decoder module %s is not "
 			"a subclass of sigrokdecode.Decoder.", module_name);
-		fail_txt = "not a subclass of sigrokdecode.Decoder";
-		goto err_out;
+		*fail_txt = "not a subclass of sigrokdecode.Decoder";
+		return SRD_ERR;
 	}
 
 	/*
@@ -808,26 +780,145 @@ SRD_API int srd_decoder_load(const char *module_name)
 	if (apiver != 3) {
         srd_exception_catch(NULL, "Only PD API version 3 is supported, "
 			"decoder %s has version %ld", module_name, apiver);
-		fail_txt = "API version mismatch";
-		goto err_out;
+		*fail_txt = "API version mismatch";
+		return SRD_ERR;
 	}
 
 	/* Check Decoder class for required methods. */
 
 	if (check_method(d->py_dec, module_name, "reset") != SRD_OK) {
-		fail_txt = "no 'reset()' method";
-		goto err_out;
+		*fail_txt = "no 'reset()' method";
+		return SRD_ERR;
 	}
 
 	if (check_method(d->py_dec, module_name, "start") != SRD_OK) {
-		fail_txt = "no 'start()' method";
-		goto err_out;
+		*fail_txt = "no 'start()' method";
+		return SRD_ERR;
 	}
 
 	if (check_method(d->py_dec, module_name, "decode") != SRD_OK) {
-		fail_txt = "no 'decode()' method";
+		*fail_txt = "no 'decode()' method";
+		return SRD_ERR;
+	}
+
+	return SRD_OK;
+}
+
+static struct srd_decoder *get_by_module(const char *module_name)
+{
+	GSList *l;
+	struct srd_decoder *dec;
+
+	for (l = pd_list; l; l = l->next) {
+		dec = l->data;
+		if (dec->module && !strcmp(dec->module, module_name))
+			return dec;
+	}
+
+	return NULL;
+}
+
+/**
+ * Import the Python module of a decoder that was restored from the
+ * metadata manifest. Does nothing if the module is already imported.
+ *
+ * @param dec The decoder to import. Must not be NULL.
+ *
+ * @return SRD_OK upon success, a (negative) error code otherwise.
+ *
+ * @private
+ */
+SRD_PRIV int srd_decoder_import(struct srd_decoder *dec)
+{
+	struct srd_decoder tmp;
+	const char *fail_txt = NULL;
+	int ret;
+	PyGILState_STATE gstate;
+
+	assert(dec);
+
+	gstate = PyGILState_Ensure();
+
+	if (dec->py_dec) {
+		PyGILState_Release(gstate);
+		return SRD_OK;
+	}
+
+	memset(&tmp, 0, sizeof(tmp));
+	ret = decoder_import(&tmp, dec->module, &fail_txt);
+
+	if (ret == SRD_ERR_PYTHON)
+        srd_exception_catch(NULL, "Failed to import decoder %s: %s",
+				dec->module, fail_txt);
+	else if (ret != SRD_OK)
+		srd_err("Failed to import decoder %s: %s", dec->module, fail_txt);
+
+	/* The import may release the GIL, another thread can get here first. */
+	if (ret == SRD_OK && !dec->py_dec) {
+		dec->py_mod = tmp.py_mod;
+		dec->py_dec = tmp.py_dec;
+	}
+	else {
+		Py_XDECREF(tmp.py_dec);
+		Py_XDECREF(tmp.py_mod);
+	}
+
+	PyGILState_Release(gstate);
+
+	return ret;
+}
+
+/**
+ * Load a protocol decoder module into the embedded Python interpreter.
+ *
+ * @param module_name The module name to be loaded.
+ *
+ * @return SRD_OK upon success, a (negative) error code otherwise.
+ *
+ * @since 0.1.0
+ */
+SRD_API int srd_decoder_load(const char *module_name)
+{
+	struct srd_decoder *d;
+	int ret;
+	const char *fail_txt = NULL;
+	PyGILState_STATE gstate;
+  
+	if (!srd_check_init())
+		return SRD_ERR;
+
+	if (!module_name)
+		return SRD_ERR_ARG;
+
+	if (get_by_module(module_name)) {
+		/* Decoder was already restored from the manifest. */
+		return SRD_OK;
+	}
+
+	gstate = PyGILState_Ensure();
+
+	if (PyDict_GetItemString(PyImport_GetModuleDict(), module_name)) {
+		/* Module was already imported. */
+		PyGILState_Release(gstate);
+		return SRD_OK;
+	}
+
+	d = malloc(sizeof(struct srd_decoder));
+	if (d == NULL){
+		srd_err("%s,ERROR:failed to alloc memory.", __func__);
 		goto err_out;
 	}
+	memset(d, 0, sizeof(struct srd_decoder));
+
+	fail_txt = NULL;
+
+	ret = decoder_import(d, module_name, &fail_txt);
+	if (ret == SRD_ERR_PYTHON)
+		goto except_out;
+	if (ret != SRD_OK)
+		goto err_out;
+
+	d->module = g_strdup(module_name);
 
 	/* Store required fields in newly allocated strings. */
 	if (py_attr_as_str(d->py_dec, "id", &(d->id)) != SRD_OK) {
@@ -952,6 +1043,9 @@ SRD_API char *srd_decoder_doc_get(const struct srd_decoder *dec)
 	if (!dec)
 		return NULL;
 
+	if (srd_decoder_import((struct srd_decoder *)dec) != SRD_OK)
+		return NULL;
+
 	gstate = PyGILState_Ensure();
 
 	if (!PyObject_HasAttrString(dec->py_mod, "__doc__"))
@@ -1146,6 +1240,637 @@ SRD_API int srd_decoder_load_all(void)
 	return SRD_OK;
 }
 
+/* Bump when the manifest layout changes, older files are discarded. */
+#define MANIFEST_VERSION	1
+#define MANIFEST_GROUP		"__manifest__"
+
+static gint compare_names(gconstpointer a, gconstpointer b)
+{
+	return strcmp(*(const char **)a, *(const char **)b);
+}
+
+/*
+ * Hash the names and contents of the files in a decoder directory,
+ * in name order. Sub directories (__pycache__) are not part of it.
+ */
+static char *hash_module_dir(const char *dir_path)
+{
+	GDir *dir;
+	GChecksum *sum;
+	GPtrArray *names;
+	const gchar *entry;
+	gchar *file_path, *data;
+	gsize len;
+	guint i;
+	char *hash;
+
+	if (!(dir = g_dir_open(dir_path, 0, NULL)))
+		return NULL;
+
+	names = g_ptr_array_new_with_free_func(g_free);
+	while ((entry = g_dir_read_name(dir)) != NULL)
+		g_ptr_array_add(names, g_strdup(entry));
+	g_dir_close(dir);
+	g_ptr_array_sort(names, compare_names);
+
+	sum = g_checksum_new(G_CHECKSUM_SHA1);
+
+	for (i = 0; i < names->len; i++) {
+		file_path = g_build_filename(dir_path, names->pdata[i], NULL);
+
+		if (!g_file_test(file_path, G_FILE_TEST_IS_DIR)
+				&& g_file_get_contents(file_path, &data, &len, NULL)) {
+			g_checksum_update(sum, names->pdata[i],
+					strlen(names->pdata[i]) + 1);
+			g_checksum_update(sum, (const guchar *)data, len);
+			g_free(data);
+		}
+		g_free(file_path);
+	}
+
+	hash = g_strdup(g_checksum_get_string(sum));
+	g_checksum_free(sum);
+	g_ptr_array_free(names, TRUE);
+
+	return hash;
+}
+
+static void manifest_set_str(GKeyFile *kf, const char *group,
+		const char *key, const char *value)
+{
+	g_key_file_set_string(kf, group, key, value ? value : "");
+}
+
+static void manifest_set_strlist(GKeyFile *kf, const char *group,
+		const char *key, const GSList *list)
+{
+	const gchar **strv;
+	guint i, n;
+
+	n = g_slist_length((GSList *)list);
+	strv = g_malloc0(sizeof(gchar *) * (n + 1));
+	for (i = 0; list; list = list->next)
+		strv[i++] = list->data;
+
+	g_key_file_set_string_list(kf, group, key, strv, n);
+	g_free(strv);
+}
+
+static void manifest_set_strv(GKeyFile *kf, const char *group,
+		const char *key, char **strv)
+{
+	g_key_file_set_string_list(kf, group, key,
+			(const gchar * const *)strv, g_strv_length(strv));
+}
+
+static void manifest_set_channels(GKeyFile *kf, const char *group,
+		const char *prefix, const GSList *channels)
+{
+	const struct srd_channel *ch;
+	const gchar *strv[4];
+	gchar *key;
+	int i;
+
+	g_key_file_set_integer(kf, group, prefix,
+			g_slist_length((GSList *)channels));
+
+	for (i = 0; channels; channels = channels->next, i++) {
+		ch = channels->data;
+		strv[0] = ch->id;
+		strv[1] = ch->name ? ch->name : "";
+		strv[2] = ch->desc ? ch->desc : "";
+		strv[3] = ch->idn ? ch->idn : "";
+
+		key = g_strdup_printf("%s.%d", prefix, i);
+		g_key_file_set_string_list(kf, group, key, strv, 4);
+		g_free(key);
+
+		key = g_strdup_printf("%s.%d.type", prefix, i);
+		g_key_file_set_integer(kf, group, key, ch->type);
+		g_free(key);
+	}
+}
+
+/*
+ * Store the decoder metadata under the group of its module. Option
+ * values are kept in GVariant text format, annotation lists keep their
+ * in-memory order.
+ */
+static void manifest_write_decoder(GKeyFile *kf, const struct srd_decoder *d,
+		const char *hash)
+{
+	const char *group = d->module;
+	const struct srd_decoder_option *o;
+	const struct srd_decoder_annotation_row *row;
+	const GSList *l, *c;
+	GPtrArray *strv;
+	gint *ints;
+	gsize n;
+	gchar *key;
+	int i;
+
+	g_key_file_set_string(kf, group, "hash", hash);
+	manifest_set_str(kf, group, "id", d->id);
+	manifest_set_str(kf, group, "name", d->name);
+	manifest_set_str(kf, group, "longname", d->longname);
+	manifest_set_str(kf, group, "desc", d->desc);
+	manifest_set_str(kf, group, "license", d->license);
+	manifest_set_strlist(kf, group, "inputs", d->inputs);
+	manifest_set_strlist(kf, group, "outputs", d->outputs);
+	manifest_set_strlist(kf, group, "tags", d->tags);
+
+	manifest_set_channels(kf, group, "channel", d->channels);
+	manifest_set_channels(kf, group, "opt_channel", d->opt_channels);
+
+	g_key_file_set_integer(kf, group, "option", g_slist_length(d->options));
+	for (l = d->options, i = 0; l; l = l->next, i++) {
+		o = l->data;
+		strv = g_ptr_array_new_with_free_func(g_free);
+		g_ptr_array_add(strv, g_strdup(o->id));
+		g_ptr_array_add(strv, g_strdup(o->desc ? o->desc : ""));
+		g_ptr_array_add(strv, g_strdup(o->idn ? o->idn : ""));
+		g_ptr_array_add(strv, o->def ? g_variant_print(o->def, TRUE) : g_strdup(""));
+		for (c = o->values; c; c = c->next)
+			g_ptr_array_add(strv, g_variant_print(c->data, TRUE));
+
+		key = g_strdup_printf("option.%d", i);
+		g_key_file_set_string_list(kf, group, key,
+				(const gchar * const *)strv->pdata, strv->len);
+		g_free(key);
+		g_ptr_array_free(strv, TRUE);
+	}
+
+	g_key_file_set_integer(kf, group, "annotation",
+			g_slist_length(d->annotations));
+	for (l = d->annotations, i = 0; l; l = l->next, i++) {
+		key = g_strdup_printf("annotation.%d", i);
+		manifest_set_strv(kf, group, key, l->data);
+		g_free(key);
+	}
+
+	n = g_slist_length(d->ann_types);
+	ints = g_malloc0(sizeof(gint) * (n + 1));
+	for (l = d->ann_types, i = 0; l; l = l->next, i++)
+		ints[i] = GPOINTER_TO_INT(l->data);
+	g_key_file_set_integer_list(kf, group, "ann_types", ints, n);
+	g_free(ints);
+
+	g_key_file_set_integer(kf, group, "annotation_row",
+			g_slist_length(d->annotation_rows));
+	for (l = d->annotation_rows, i = 0; l; l = l->next, i++) {
+		row = l->data;
+		key = g_strdup_printf("annotation_row.%d", i);
+		g_key_file_set_string(kf, group, key, row->id);
+		g_free(key);
+
+		key = g_strdup_printf("annotation_row.%d.desc", i);
+		manifest_set_str(kf, group, key, row->desc);
+		g_free(key);
+
+		n = g_slist_length(row->ann_classes);
+		ints = g_malloc0(sizeof(gint) * (n + 1));
+		for (c = row->ann_classes, n = 0; c; c = c->next)
+			ints[n++] = (gint)GPOINTER_TO_SIZE(c->data);
+		key = g_strdup_printf("annotation_row.%d.classes", i);
+		g_key_file_set_integer_list(kf, group, key, ints, n);
+		g_free(key);
+		g_free(ints);
+	}
+
+	g_key_file_set_integer(kf, group, "binary", g_slist_length(d->binary));
+	for (l = d->binary, i = 0; l; l = l->next, i++) {
+		key = g_strdup_printf("binary.%d", i);
+		manifest_set_strv(kf, group, key, l->data);
+		g_free(key);
+	}
+}
+
+static char *manifest_get_str(GKeyFile *kf, const char *group,
+		const char *key, gboolean *ok)
+{
+	GError *err = NULL;
+	char *str;
+
+	str = g_key_file_get_string(kf, group, key, &err);
+	if (err) {
+		g_error_free(err);
+		*ok = FALSE;
+	}
+	return str;
+}
+
+/* Empty strings are stored for the optional fields. */
+static char *null_if_empty(char *str)
+{
+	if (str && *str == '\0') {
+		g_free(str);
+		return NULL;
+	}
+	return str;
+}
+
+static char **manifest_get_strv(GKeyFile *kf, const char *group,
+		const char *key, gboolean *ok)
+{
+	GError *err = NULL;
+	char **strv;
+
+	strv = g_key_file_get_string_list(kf, group, key, NULL, &err);
+	if (err) {
+		g_error_free(err);
+		*ok = FALSE;
+		return NULL;
+	}
+	if (!strv)
+		strv = g_malloc0(sizeof(char *));
+	return strv;
+}
+
+static GSList *manifest_get_strlist(GKeyFile *kf, const char *group,
+		const char *key, gboolean *ok)
+{
+	GSList *list = NULL;
+	char **strv;
+	int i;
+
+	if (!(strv = manifest_get_strv(kf, group, key, ok)))
+		return NULL;
+
+	/* The list takes over the strings. */
+	for (i = 0; strv[i]; i++)
+		list = g_slist_append(list, strv[i]);
+	g_free(strv);
+
+	return list;
+}
+
+static gint *manifest_get_ints(GKeyFile *kf, const char *group,
+		const char *key, gsize *len, gboolean *ok)
+{
+	GError *err = NULL;
+	gint *ints;
+
+	ints = g_key_file_get_integer_list(kf, group, key, len, &err);
+	if (err) {
+		g_error_free(err);
+		*ok = FALSE;
+		*len = 0;
+		return NULL;
+	}
+	return ints;
+}
+
+static int manifest_get_count(GKeyFile *kf, const char *group,
+		const char *key, gboolean *ok)
+{
+	GError *err = NULL;
+	int n;
+
+	n = g_key_file_get_integer(kf, group, key, &err);
+	if (err || n < 0) {
+		if (err)
+			g_error_free(err);
+		*ok = FALSE;
+		return 0;
+	}
+	return n;
+}
+
+static GSList *manifest_get_channels(GKeyFile *kf, const char *group,
+		const char *prefix, int offset, gboolean *ok)
+{
+	struct srd_channel *ch;
+	GSList *list = NULL;
+	char **strv;
+	gchar *key;
+	int i, n;
+
+	n = manifest_get_count(kf, group, prefix, ok);
+
+	for (i = 0; i < n && *ok; i++) {
+		key = g_strdup_printf("%s.%d", prefix, i);
+		strv = manifest_get_strv(kf, group, key, ok);
+		g_free(key);
+
+		if (!strv || g_strv_length(strv) != 4) {
+			g_strfreev(strv);
+			*ok = FALSE;
+			break;
+		}
+
+		ch = g_malloc0(sizeof(struct srd_channel));
+		ch->id = strv[0];
+		ch->name = strv[1];
+		ch->desc = strv[2];
+		ch->idn = null_if_empty(strv[3]);
+		g_free(strv);
+
+		key = g_strdup_printf("%s.%d.type", prefix, i);
+		ch->type = g_key_file_get_integer(kf, group, key, NULL);
+		g_free(key);
+		ch->order = offset + i;
+
+		list = g_slist_append(list, ch);
+	}
+
+	return list;
+}
+
+static GVariant *manifest_parse_variant(const char *text, gboolean *ok)
+{
+	GVariant *var;
+
+	var = g_variant_parse(NULL, text, NULL, NULL, NULL);
+	if (!var)
+		*ok = FALSE;
+	return var ? g_variant_ref_sink(var) : NULL;
+}
+
+/* Rebuild a decoder from its manifest group, without importing it. */
+static struct srd_decoder *manifest_read_decoder(GKeyFile *kf,
+		const char *group)
+{
+	struct srd_decoder *d;
+	struct srd_decoder_option *o;
+	struct srd_decoder_annotation_row *row;
+	gboolean ok = TRUE;
+	char **strv;
+	gint *ints;
+	gsize len, k;
+	gchar *key;
+	int i, n;
+
+	d = g_malloc0(sizeof(struct srd_decoder));
+	d->module = g_strdup(group);
+
+	d->id = manifest_get_str(kf, group, "id", &ok);
+	d->name = manifest_get_str(kf, group, "name", &ok);
+	d->longname = manifest_get_str(kf, group, "longname", &ok);
+	d->desc = manifest_get_str(kf, group, "desc", &ok);
+	d->license = manifest_get_str(kf, group, "license", &ok);
+	d->inputs = manifest_get_strlist(kf, group, "inputs", &ok);
+	d->outputs = manifest_get_strlist(kf, group, "outputs", &ok);
+	d->tags = manifest_get_strlist(kf, group, "tags", &ok);
+
+	d->channels = manifest_get_channels(kf, group, "channel", 0, &ok);
+	d->opt_channels = manifest_get_channels(kf, group, "opt_channel",
+			g_slist_length(d->channels), &ok);
+
+	n = manifest_get_count(kf, group, "option", &ok);
+	for (i = 0; i < n && ok; i++) {
+		key = g_strdup_printf("option.%d", i);
+		strv = manifest_get_strv(kf, group, key, &ok);
+		g_free(key);
+
+		if (!strv || g_strv_length(strv) < 4) {
+			g_strfreev(strv);
+			ok = FALSE;
+			break;
+		}
+
+		o = g_malloc0(sizeof(struct srd_decoder_option));
+		d->options = g_slist_append(d->options, o);
+		o->id = g_strdup(strv[0]);
+		o->desc = null_if_empty(g_strdup(strv[1]));
+		o->idn = null_if_empty(g_strdup(strv[2]));
+		if (*strv[3])
+			o->def = manifest_parse_variant(strv[3], &ok);
+		for (k = 4; strv[k] && ok; k++)
+			o->values = g_slist_append(o->values,
+					manifest_parse_variant(strv[k], &ok));
+		g_strfreev(strv);
+	}
+
+	n = manifest_get_count(kf, group, "annotation", &ok);
+	for (i = 0; i < n && ok; i++) {
+		key = g_strdup_printf("annotation.%d", i);
+		strv = manifest_get_strv(kf, group, key, &ok);
+		g_free(key);
+		if (strv)
+			d->annotations = g_slist_append(d->annotations, strv);
+	}
+
+	ints = manifest_get_ints(kf, group, "ann_types", &len, &ok);
+	for (k = 0; k < len; k++)
+		d->ann_types = g_slist_append(d->ann_types, GINT_TO_POINTER(ints[k]));
+	g_free(ints);
+
+	n = manifest_get_count(kf, group, "annotation_row", &ok);
+	for (i = 0; i < n && ok; i++) {
+		row = g_malloc0(sizeof(struct srd_decoder_annotation_row));
+		d->annotation_rows = g_slist_append(d->annotation_rows, row);
+
+		key = g_strdup_printf("annotation_row.%d", i);
+		row->id = manifest_get_str(kf, group, key, &ok);
+		g_free(key);
+
+		key = g_strdup_printf("annotation_row.%d.desc", i);
+		row->desc = manifest_get_str(kf, group, key, &ok);
+		g_free(key);
+
+		key = g_strdup_printf("annotation_row.%d.classes", i);
+		ints = manifest_get_ints(kf, group, key, &len, &ok);
+		g_free(key);
+		for (k = 0; k < len; k++)
+			row->ann_classes = g_slist_append(row->ann_classes,
+					GSIZE_TO_POINTER((gsize)ints[k]));
+		g_free(ints);
+	}
+
+	n = manifest_get_count(kf, group, "binary", &ok);
+	for (i = 0; i < n && ok; i++) {
+		key = g_strdup_printf("binary.%d", i);
+		strv = manifest_get_strv(kf, group, key, &ok);
+		g_free(key);
+		if (strv)
+			d->binary = g_slist_append(d->binary, strv);
+	}
+
+	if (!ok || !d->id || !*d->id) {
+		srd_warn("Decoder manifest entry of %s is broken.", group);
+		decoder_free(d);
+		return NULL;
+	}
+
+	return d;
+}
+
+static gboolean manifest_entry_valid(GKeyFile *kf, const char *group,
+		const char *hash)
+{
+	gchar *stored;
+	gboolean valid;
+
+	stored = g_key_file_get_string(kf, group, "hash", NULL);
+	valid = stored && !strcmp(stored, hash);
+	g_free(stored);
+
+	return valid;
+}
+
+static gboolean common_unchanged(GKeyFile *cache)
+{
+	GSList *l;
+	gchar *dir_path, *hash;
+	gboolean same = TRUE;
+
+	for (l = searchpaths; l && same; l = l->next) {
+		dir_path = g_build_filename(l->data, "common", NULL);
+		hash = hash_module_dir(dir_path);
+		g_free(dir_path);
+
+		if (hash) {
+			same = manifest_entry_valid(cache, "common", hash);
+			g_free(hash);
+			break;
+		}
+	}
+
+	return same;
+}
+
+static gboolean manifest_load_module(GKeyFile *cache, GKeyFile *out,
+		const char *path, const char *module_name)
+{
+	struct srd_decoder *d;
+	gchar *dir_path, *hash;
+	gboolean hit;
+
+	dir_path = g_build_filename(path, module_name, NULL);
+	hash = hash_module_dir(dir_path);
+	g_free(dir_path);
+
+	if (!hash) {
+		srd_decoder_load(module_name);
+		return FALSE;
+	}
+
+	hit = FALSE;
+
+	if (manifest_entry_valid(cache, module_name, hash)) {
+		if (g_key_file_get_boolean(cache, module_name, "failed", NULL)) {
+			/* Not a decoder (e.g. "common"), don't retry it. */
+			hit = TRUE;
+		}
+		else if ((d = manifest_read_decoder(cache, module_name)) != NULL) {
+			pd_list = g_slist_append(pd_list, d);
+			hit = TRUE;
+		}
+	}
+
+	if (!hit) {
+		srd_info("Decoder %s is not in the manifest, importing it.",
+			module_name);
+		srd_decoder_load(module_name);
+	}
+
+	d = get_by_module(module_name);
+	if (d)
+		manifest_write_decoder(out, d, hash);
+	else {
+		g_key_file_set_string(out, module_name, "hash", hash);
+		g_key_file_set_boolean(out, module_name, "failed", TRUE);
+	}
+
+	g_free(hash);
+
+	return !hit;
+}
+
+/**
+ * Load all installed protocol decoders, using a metadata manifest.
+ *
+ * Decoders whose files did not change since the manifest was written
+ * are restored from it without importing their Python module, which
+ * happens when the first instance is created. All others are loaded
+ * like srd_decoder_load_all() does, and the manifest is updated.
+ *
+ * @param manifest_path The manifest file. Need not exist.
+ *
+ * @return SRD_OK upon success, a (negative) error code otherwise.
+ *
+ * @since 0.6.0
+ */
+SRD_API int srd_decoder_load_all_cached(const char *manifest_path)
+{
+	GKeyFile *cache, *out;
+	GSList *l;
+	GDir *dir;
+	const gchar *direntry;
+	gchar *old_data, *new_data, *full_path;
+	gsize len;
+	gboolean is_dir;
+	int misses;
+
+	if (!srd_check_init())
+		return SRD_ERR;
+
+	if (!manifest_path)
+		return srd_decoder_load_all();
+
+	cache = g_key_file_new();
+	out = g_key_file_new();
+	old_data = NULL;
+
+	if (g_file_get_contents(manifest_path, &old_data, &len, NULL)) {
+		if (!g_key_file_load_from_data(cache, old_data, len,
+				G_KEY_FILE_NONE, NULL)
+				|| g_key_file_get_integer(cache, MANIFEST_GROUP,
+					"version", NULL) != MANIFEST_VERSION) {
+			g_key_file_free(cache);
+			cache = g_key_file_new();
+		}
+	}
+
+	/* Decoders can take metadata from the shared "common" package. */
+	if (!common_unchanged(cache)) {
+		g_key_file_free(cache);
+		cache = g_key_file_new();
+	}
+
+	g_key_file_set_integer(out, MANIFEST_GROUP, "version", MANIFEST_VERSION);
+	misses = 0;
+
+	for (l = searchpaths; l; l = l->next) {
+		if (!(dir = g_dir_open(l->data, 0, NULL))) {
+			srd_decoder_load_all_zip_path(l->data);
+			continue;
+		}
+
+		while ((direntry = g_dir_read_name(dir)) != NULL) {
+			if (!strcmp(direntry, "__pycache__") || get_by_module(direntry))
+				continue;
+
+			full_path = g_build_filename(l->data, direntry, NULL);
+			is_dir = g_file_test(full_path, G_FILE_TEST_IS_DIR);
+			g_free(full_path);
+
+			if (!is_dir)
+				srd_decoder_load(direntry);
+			else if (manifest_load_module(cache, out, l->data, direntry))
+				misses++;
+		}
+		g_dir_close(dir);
+	}
+
+	if (misses > 0)
+		srd_info("Imported %d decoder(s) missing from the manifest.", misses);
+
+	/* Rewrite only if something changed, entries of removed decoders go away. */
+	new_data = g_key_file_to_data(out, &len, NULL);
+	if (new_data && (!old_data || strcmp(old_data, new_data))) {
+		if (!g_file_set_contents(manifest_path, new_data, len, NULL))
+			srd_warn("Failed to write the decoder manifest %s.", manifest_path);
+	}
+
+	g_free(new_data);
+	g_free(old_data);
+	g_key_file_free(out);
+	g_key_file_free(cache);
+
+	return SRD_OK;
+}
+
 static void srd_decoder_unload_cb(void *arg, void *ignored)
 {
 	(void)ignored;
@@ -49,6 +49,11 @@ extern SRD_PRIV GSList *sessions;
  * @{
  */
 
+/* Annotations held back before the frontend gets them in one call. */
+#define ANN_BATCH_SIZE 4096
+
+static void ann_text_free(gpointer data);
+
 static void oldpins_array_seed(struct srd_decoder_inst *di)
 {
 	size_t count;
@@ -355,6 +360,10 @@ SRD_API struct srd_decoder_inst *srd_inst_new(struct srd_session *sess,
 		return NULL;
 	}
 
+	/* Decoders restored from the manifest are imported on first use. */
+	if (srd_decoder_import(dec) != SRD_OK)
+		return NULL;
+
 	di = malloc(sizeof(struct srd_decoder_inst));
 	if (di == NULL){
 		srd_err("%s,ERROR:failed to alloc memory.", __func__);
@@ -447,6 +456,16 @@ SRD_API struct srd_decoder_inst *srd_inst_new(struct srd_session *sess,
 	g_cond_init(&di->got_new_samples_cond);
 	g_cond_init(&di->handled_all_samples_cond);
 	g_mutex_init(&di->data_mutex);
+	g_mutex_init(&di->ann_batch_mutex);
+	g_mutex_init(&di->ann_flush_mutex);
+
+	di->ann_batch = g_array_sized_new(FALSE, FALSE,
+			sizeof(struct srd_proto_ann_record), ANN_BATCH_SIZE);
+	di->ann_flush_batch = g_array_sized_new(FALSE, FALSE,
+			sizeof(struct srd_proto_ann_record), ANN_BATCH_SIZE);
+	di->ann_texts = g_ptr_array_new_with_free_func(ann_text_free);
+	di->ann_text_index = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	di->ann_key = g_string_sized_new(64);
 
 	/* Instance takes input from a frontend by default. */
 	sess->di_list = g_slist_append(sess->di_list, di);
@@ -461,6 +480,15 @@ err:
     return NULL;
 }
 
+static void ann_text_free(gpointer data)
+{
+	struct srd_proto_ann_text *text = data;
+
+	g_strfreev(text->ann_text);
+	g_free(text->str_number_hex);
+	g_free(text);
+}
+
 static void srd_inst_join_decode_thread(struct srd_decoder_inst *di)
 {
 	if (!di)
@@ -1268,6 +1296,9 @@ SRD_PRIV int srd_inst_decode(struct srd_decoder_inst *di,
 		g_cond_wait(&di->handled_all_samples_cond, &di->data_mutex);
 	g_mutex_unlock(&di->data_mutex);
 
+	/* Hand over the annotations of this chunk, stacked PDs included. */
+	srd_inst_ann_flush(di, TRUE);
+
 
 	//the python got error
 	if (di->python_proc_error)
@@ -1319,6 +1350,11 @@ SRD_PRIV int srd_inst_terminate_reset(struct srd_decoder_inst *di)
 	srd_inst_join_decode_thread(di);
 	srd_inst_reset_state(di);
 
+	/* Annotations of the aborted run are not wanted any more. */
+	g_mutex_lock(&di->ann_batch_mutex);
+	g_array_set_size(di->ann_batch, 0);
+	g_mutex_unlock(&di->ann_batch_mutex);
+
 	/*
 	 * Have the Python side's .reset() method executed (if the PD
 	 * implements it). It's assumed that .reset() assigns variables
@@ -1377,6 +1413,13 @@ SRD_PRIV void srd_inst_free(struct srd_decoder_inst *di)
 		g_free(pdo);
 	}
 	g_slist_free(di->pd_output);
+	g_array_free(di->ann_batch, TRUE);
+	g_array_free(di->ann_flush_batch, TRUE);
+	g_ptr_array_free(di->ann_texts, TRUE);
+	g_hash_table_destroy(di->ann_text_index);
+	g_string_free(di->ann_key, TRUE);
+	g_mutex_clear(&di->ann_batch_mutex);
+	g_mutex_clear(&di->ann_flush_mutex);
 	g_free(di);
 }
 
@@ -1389,4 +1432,119 @@ SRD_PRIV void srd_inst_free_all(struct srd_session *sess)
 	g_slist_free_full(sess->di_list, (GDestroyNotify)srd_inst_free);
 }
 
+/**
+ * Look up the text id of an annotation, adding the text if it was
+ * never seen by this instance. Must be called with ann_batch_mutex held.
+ *
+ * @param di The decoder instance that put the annotation.
+ * @param lines The text lines, may be NULL if line_count is 0.
+ * @param line_count Number of lines.
+ * @param number_hex The numerical value in hex, empty string if none.
+ *
+ * @return The text id.
+ *
+ * @private
+ */
+SRD_PRIV unsigned int srd_inst_ann_intern(struct srd_decoder_inst *di,
+		const char **lines, int line_count, const char *number_hex)
+{
+	struct srd_proto_ann_text *text;
+	gpointer value;
+	unsigned int text_id;
+	int i;
+
+	/* Lines can not contain control characters, so they are safe separators. */
+	g_string_truncate(di->ann_key, 0);
+	for (i = 0; i < line_count; i++) {
+		g_string_append(di->ann_key, lines[i]);
+		g_string_append_c(di->ann_key, '\x1f');
+	}
+	g_string_append_c(di->ann_key, '\x1e');
+	g_string_append(di->ann_key, number_hex);
+
+	if (g_hash_table_lookup_extended(di->ann_text_index, di->ann_key->str, NULL, &value))
+		return GPOINTER_TO_UINT(value);
+
+	text = g_new0(struct srd_proto_ann_text, 1);
+	if (line_count > 0) {
+		text->ann_text = g_new0(char *, line_count + 1);
+		for (i = 0; i < line_count; i++)
+			text->ann_text[i] = g_strdup(lines[i]);
+	}
+	text->str_number_hex = g_strdup(number_hex);
+
+	text_id = di->ann_texts->len;
+	g_ptr_array_add(di->ann_texts, text);
+	g_hash_table_insert(di->ann_text_index, g_strdup(di->ann_key->str),
+			GUINT_TO_POINTER(text_id));
+
+	return text_id;
+}
+
+/**
+ * Queue one annotation for the frontend. Must be called with
+ * ann_batch_mutex held.
+ *
+ * @return TRUE when the batch is full and should be flushed.
+ *
+ * @private
+ */
+SRD_PRIV gboolean srd_inst_ann_push(struct srd_decoder_inst *di,
+		const struct srd_proto_ann_record *rec)
+{
+	g_array_append_val(di->ann_batch, *rec);
+
+	return di->ann_batch->len >= ANN_BATCH_SIZE;
+}
+
+/**
+ * Pass the queued annotations to the session's batch callback.
+ *
+ * Must be called without the GIL held, the frontend does not need
+ * Python to take the batch. The queue is swapped out under
+ * ann_batch_mutex and the callback runs after it is unlocked, so
+ * the decoder can keep queueing meanwhile. The texts only grow on
+ * the thread that decodes this instance, which is either this one
+ * or parked until the chunk is handled.
+ *
+ * @param di The decoder instance to flush.
+ * @param stack TRUE to also flush the instances stacked on top of it.
+ *
+ * @private
+ */
+SRD_PRIV void srd_inst_ann_flush(struct srd_decoder_inst *di, gboolean stack)
+{
+	struct srd_proto_ann_batch batch;
+	GArray *records;
+	GSList *l;
+
+	if (!di)
+		return;
+
+	/* Keeps the batches in order if two threads flush. */
+	g_mutex_lock(&di->ann_flush_mutex);
+
+	g_mutex_lock(&di->ann_batch_mutex);
+	records = di->ann_batch;
+	di->ann_batch = di->ann_flush_batch;
+	di->ann_flush_batch = records;
+	batch.texts = (struct srd_proto_ann_text *const *)di->ann_texts->pdata;
+	g_mutex_unlock(&di->ann_batch_mutex);
+
+	if (records->len > 0 && di->sess->ann_batch_cb) {
+		batch.di = di;
+		batch.records = (const struct srd_proto_ann_record *)records->data;
+		batch.count = records->len;
+		di->sess->ann_batch_cb(&batch, di->sess->ann_batch_cb_data);
+	}
+	g_array_set_size(records, 0);
+
+	g_mutex_unlock(&di->ann_flush_mutex);
+
+	if (stack) {
+		for (l = di->next_di; l; l = l->next)
+			srd_inst_ann_flush(l->data, TRUE);
+	}
+}
+
 /** @} */
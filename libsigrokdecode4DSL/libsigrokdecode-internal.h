@@ -77,6 +77,11 @@ SRD_PRIV int process_samples_until_condition_match(struct srd_decoder_inst *di,
 SRD_PRIV int srd_inst_terminate_reset(struct srd_decoder_inst *di);
 SRD_PRIV void srd_inst_free(struct srd_decoder_inst *di);
 SRD_PRIV void srd_inst_free_all(struct srd_session *sess);
+SRD_PRIV unsigned int srd_inst_ann_intern(struct srd_decoder_inst *di,
+        const char **lines, int line_count, const char *number_hex);
+SRD_PRIV gboolean srd_inst_ann_push(struct srd_decoder_inst *di,
+        const struct srd_proto_ann_record *rec);
+SRD_PRIV void srd_inst_ann_flush(struct srd_decoder_inst *di, gboolean stack);
 
 /* log.c */
 #if defined(G_OS_WIN32) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 4))
@@ -92,6 +97,7 @@ SRD_PRIV void srd_inst_free_all(struct srd_session *sess);
 
 /* decoder.c */
 SRD_PRIV long srd_decoder_apiver(const struct srd_decoder *d);
+SRD_PRIV int srd_decoder_import(struct srd_decoder *dec);
 
 /* type_decoder.c */
 SRD_PRIV PyObject *srd_Decoder_type_new(void);
@@ -32,6 +32,8 @@
 extern "C" {
 #endif
 
+struct srd_proto_ann_batch;
+
 struct srd_session {
     int session_id;
 
@@ -43,6 +45,10 @@ struct srd_session {
 
     /* List of frontend callbacks to receive decoder output. */
     GSList *callbacks;
+
+    /* Receives annotations in batches instead of the SRD_OUTPUT_ANN callback. */
+    void (*ann_batch_cb)(const struct srd_proto_ann_batch *batch, void *cb_data);
+    void *ann_batch_cb_data;
 };
 
 /**
@@ -206,7 +212,13 @@ struct srd_decoder {
 	/** List of decoder options. */
 	GSList *options;
 
-	/** Python module. */
+	/** Module (directory) name the decoder was loaded from. */
+	char *module;
+
+	/**
+	 * Python module. NULL for a decoder restored from the metadata
+	 * manifest until its first instance is created.
+	 */
 	void *py_mod;
 
 	/** sigrokdecode.Decoder class. */
@@ -326,6 +338,26 @@ struct srd_decoder_inst {
 
 	/** the task normal ends flag */
 	int  is_task_stop_signal;
+
+	/**
+	 * Annotations waiting for the next flush to the frontend.
+	 * Type is srd_proto_ann_record, guarded by ann_batch_mutex.
+	 */
+	GArray *ann_batch;
+	GMutex ann_batch_mutex;
+
+	/* Swapped with ann_batch by a flush, under ann_flush_mutex. */
+	GArray *ann_flush_batch;
+	GMutex ann_flush_mutex;
+
+	/**
+	 * Interned annotation texts, srd_proto_ann_text* type. A text id
+	 * is the index in this array and stays valid until the instance
+	 * is freed. ann_text_index maps the joined lines to the id.
+	 */
+	GPtrArray *ann_texts;
+	GHashTable *ann_text_index;
+	GString *ann_key;
 };
 
 struct srd_pd_output {
@@ -358,9 +390,34 @@ struct srd_proto_data_binary {
 	const unsigned char *data;
 };
 
+/* Text lines and numerical value of one or more annotations. */
+struct srd_proto_ann_text {
+	char **ann_text; //text string lines, NULL if only a number was put
+	char *str_number_hex; //numerical value hex format string, empty if none
+};
+/* One annotation of a batch, plain data. */
+struct srd_proto_ann_record {
+	uint64_t start_sample;
+	uint64_t end_sample;
+	struct srd_pd_output *pdo;
+	int ann_class;
+	int ann_type;
+	long long numberic_value;
+	unsigned int text_id; //index of the instance's srd_proto_ann_text
+};
+struct srd_proto_ann_batch {
+	struct srd_decoder_inst *di;
+	const struct srd_proto_ann_record *records;
+	unsigned int count;
+	struct srd_proto_ann_text *const *texts; //indexed by text_id
+};
+
 typedef void (*srd_pd_output_callback)(struct srd_proto_data *pdata,
 					void *cb_data);
 
+typedef void (*srd_pd_ann_batch_callback)(const struct srd_proto_ann_batch *batch,
+					void *cb_data);
+
 struct srd_pd_callback {
 	int output_type;
 	srd_pd_output_callback cb;
@@ -385,6 +442,8 @@ SRD_API int srd_session_terminate_reset(struct srd_session *sess);
 SRD_API int srd_session_destroy(struct srd_session *sess);
 SRD_API int srd_pd_output_callback_add(struct srd_session *sess,
 		int output_type, srd_pd_output_callback cb, void *cb_data);
+SRD_API int srd_pd_ann_batch_callback_add(struct srd_session *sess,
+		srd_pd_ann_batch_callback cb, void *cb_data);
 
 SRD_API int srd_session_end(struct srd_session *sess, char **error);
 
@@ -395,6 +454,7 @@ SRD_API int srd_decoder_load(const char *name);
 SRD_API char *srd_decoder_doc_get(const struct srd_decoder *dec);
 SRD_API int srd_decoder_unload(struct srd_decoder *dec);
 SRD_API int srd_decoder_load_all(void);
+SRD_API int srd_decoder_load_all_cached(const char *manifest_path);
 SRD_API int srd_decoder_unload_all(void);
 
 /* instance.c */
@@ -48,10 +48,10 @@ SRD_API void srd_log_set_context(xlog_context *ctx);
 SRD_API void srd_log_level(int level);
 
 #define LOG_PREFIX "" 
-#define srd_err(fmt, args...) xlog_err(srd_log, LOG_PREFIX fmt, ## args)
-#define srd_warn(fmt, args...) xlog_warn(srd_log, LOG_PREFIX fmt, ## args)
-#define srd_info(fmt, args...) xlog_info(srd_log, LOG_PREFIX fmt, ## args)
-#define srd_dbg(fmt, args...) xlog_dbg(srd_log, LOG_PREFIX fmt, ## args)
-#define srd_detail(fmt, args...) xlog_detail(srd_log, LOG_PREFIX fmt, ## args)
+#define srd_err(fmt, args...) (xlog_enabled(srd_log, XLOG_LEVEL_ERR) ? xlog_err(srd_log, LOG_PREFIX fmt, ## args) : -1)
+#define srd_warn(fmt, args...) (xlog_enabled(srd_log, XLOG_LEVEL_WARN) ? xlog_warn(srd_log, LOG_PREFIX fmt, ## args) : -1)
+#define srd_info(fmt, args...) (xlog_enabled(srd_log, XLOG_LEVEL_INFO) ? xlog_info(srd_log, LOG_PREFIX fmt, ## args) : -1)
+#define srd_dbg(fmt, args...) (xlog_enabled(srd_log, XLOG_LEVEL_DBG) ? xlog_dbg(srd_log, LOG_PREFIX fmt, ## args) : -1)
+#define srd_detail(fmt, args...) (xlog_enabled(srd_log, XLOG_LEVEL_DETAIL) ? xlog_detail(srd_log, LOG_PREFIX fmt, ## args) : -1)
 
 #endif
\ No newline at end of file
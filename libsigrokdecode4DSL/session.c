@@ -403,6 +403,32 @@ SRD_API int srd_pd_output_callback_add(struct srd_session *sess,
 	return SRD_OK;
 }
 
+/**
+ * Register a callback that receives annotations in batches.
+ *
+ * Annotations are queued per decoder instance and passed on once the
+ * instance has handled a chunk of samples, or when the queue is full.
+ * The SRD_OUTPUT_ANN callback is not called any more for this session.
+ *
+ * @param sess The output session in which to register the callback.
+ *             Must not be NULL.
+ * @param cb The function to call. Must not be NULL.
+ * @param cb_data Private data for the callback function. Can be NULL.
+ *
+ * @return SRD_OK upon success, a (negative) error code otherwise.
+ */
+SRD_API int srd_pd_ann_batch_callback_add(struct srd_session *sess,
+		srd_pd_ann_batch_callback cb, void *cb_data)
+{
+	if (!sess || !cb)
+		return SRD_ERR_ARG;
+
+	sess->ann_batch_cb = cb;
+	sess->ann_batch_cb_data = cb_data;
+
+	return SRD_OK;
+}
+
 /** @private */
 SRD_PRIV struct srd_pd_callback *srd_pd_output_callback_find(
 		struct srd_session *sess, int output_type)
@@ -425,6 +451,14 @@ SRD_PRIV struct srd_pd_callback *srd_pd_output_callback_find(
 	return pd_cb;
 }
 
+static void session_ann_flush(struct srd_session *sess)
+{
+	GSList *d;
+
+	for (d = sess->di_list; d; d = d->next)
+		srd_inst_ann_flush(d->data, TRUE);
+}
+
 SRD_API int srd_session_end(struct srd_session *sess, char **error)
 {
 	GSList *d;
@@ -457,6 +491,7 @@ SRD_API int srd_session_end(struct srd_session *sess, char **error)
 				srd_exception_catch(error, "Protocol decoder instance %s",
 									di->inst_id);
 				PyGILState_Release(gstate);
+				session_ann_flush(sess);
 				return SRD_ERR_PYTHON;
 			}
 		}
@@ -465,12 +500,17 @@ SRD_API int srd_session_end(struct srd_session *sess, char **error)
 			ret = srd_call_sub_decoder_end(di, error);
 			if (ret != SRD_OK){
 				PyGILState_Release(gstate);
+				session_ann_flush(sess);
 				return ret;
 			}
 		}
 	}
 
 	PyGILState_Release(gstate);
+
+	/* Annotations put by end() */
+	session_ann_flush(sess);
+
 	return SRD_OK;
 }
 
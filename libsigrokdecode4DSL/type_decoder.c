@@ -175,22 +175,15 @@ err:
 }
 
 /*
+ Check the [annotation class, [string, ...]] list and get its parts.
  @obj is the fourth param from python calls put()
 */
-static int convert_annotation(struct srd_decoder_inst *di, PyObject *obj,
-		struct srd_proto_data *pdata)
+static int parse_annotation_head(struct srd_decoder_inst *di, PyObject *obj,
+		int *out_class, gpointer *out_type, PyObject **out_list, int *out_size)
 {
 	PyObject *py_tmp;
-	struct srd_proto_data_annotation *pda;
 	int ann_class;
-    char **ann_text;
-	gpointer ann_type_ptr;
-	PyGILState_STATE gstate;
-	int ann_size; 
-
-	pda = pdata->data;
-
-	gstate = PyGILState_Ensure();
+	int ann_size;
 
 	/* Should be a list of [annotation class, [string, ...]]. */
 	if (!PyList_Check(obj)) {
@@ -224,7 +217,8 @@ static int convert_annotation(struct srd_decoder_inst *di, PyObject *obj,
 			"annotation class %d.", di->decoder->name, ann_class);
 		goto err;
 	}
-	ann_type_ptr = g_slist_nth_data(di->decoder->ann_types, ann_class);
+	*out_class = ann_class;
+	*out_type = g_slist_nth_data(di->decoder->ann_types, ann_class);
 
 	/* 
 		Second element must be a list.
@@ -241,7 +235,37 @@ static int convert_annotation(struct srd_decoder_inst *di, PyObject *obj,
 			srd_err("Protocol decoder %s, put() param, the annotation list is empty.", di->decoder->name);
 		goto err;
 	}
-	 
+
+	*out_list = py_tmp;
+	*out_size = ann_size;
+
+	return SRD_OK;
+
+err:
+	return SRD_ERR_PYTHON;
+}
+
+/*
+ @obj is the fourth param from python calls put()
+*/
+static int convert_annotation(struct srd_decoder_inst *di, PyObject *obj,
+		struct srd_proto_data *pdata)
+{
+	PyObject *py_tmp;
+	struct srd_proto_data_annotation *pda;
+	int ann_class;
+    char **ann_text;
+	gpointer ann_type_ptr;
+	PyGILState_STATE gstate;
+	int ann_size; 
+
+	pda = pdata->data;
+
+	gstate = PyGILState_Ensure();
+
+	if (parse_annotation_head(di, obj, &ann_class, &ann_type_ptr, &py_tmp, &ann_size) != SRD_OK)
+		goto err;
+
 	pda->str_number_hex[0] = 0;
 	ann_text = NULL;
 	pda->numberic_value = 0; 
@@ -266,6 +290,118 @@ err:
 	return SRD_ERR_PYTHON;
 }
 
+/*
+ Like convert_annotation(), but the text lines are interned in the
+ instance and the annotation is queued for the batch callback. The
+ strings are only borrowed from Python, they are copied once per
+ distinct text.
+ @batch_full is set when the queue should be flushed.
+*/
+static int queue_annotation(struct srd_decoder_inst *di, PyObject *obj,
+		struct srd_proto_data *pdata, gboolean *batch_full)
+{
+	PyObject *py_list, *py_tmp;
+	PyObject *py_bytes[10];
+	const char *lines[10];
+	char at_hex[DECODE_NUM_HEX_MAX_LEN];
+	char number_hex[DECODE_NUM_HEX_MAX_LEN];
+	struct srd_proto_ann_record rec;
+	gpointer ann_type_ptr;
+	int ann_class, ann_size;
+	int bytes_count, line_count;
+	gboolean has_number;
+	long long numberic_value;
+	const char *str;
+	char *up_ptr;
+	int nstr, i;
+	int ret = SRD_ERR_PYTHON;
+
+	if (parse_annotation_head(di, obj, &ann_class, &ann_type_ptr, &py_list, &ann_size) != SRD_OK)
+		return SRD_ERR_PYTHON;
+
+	bytes_count = 0;
+	line_count = 0;
+	has_number = FALSE;
+	numberic_value = 0;
+	at_hex[0] = 0;
+
+	for (i = 0; i < ann_size; i++) {
+		py_tmp = PyList_GetItem(py_list, i);
+
+		if (PyLong_Check(py_tmp)) {
+			numberic_value = PyLong_AsLongLong(py_tmp);
+			has_number = TRUE;
+			continue;
+		}
+		if (!PyUnicode_Check(py_tmp) || bytes_count == G_N_ELEMENTS(py_bytes))
+			continue;
+
+		if (!(py_bytes[bytes_count] = PyUnicode_AsUTF8String(py_tmp))) {
+			srd_exception_catch(NULL, "Failed to obtain string item");
+			goto end;
+		}
+		str = PyBytes_AsString(py_bytes[bytes_count++]);
+
+		//check numberic field value
+		if (str[0] == '@') {
+			nstr = strlen(str) - 1;
+
+			if (nstr > 0 && nstr < DECODE_NUM_HEX_MAX_LEN) {
+				strcpy(at_hex, str + 1);
+
+				//convert to upper
+				for (up_ptr = at_hex; *up_ptr; up_ptr++) {
+					if (*up_ptr >= 'a' && *up_ptr <= 'f')
+						*up_ptr -= 32;
+				}
+
+				//keep the line with the ignore flag, the frontend
+				//maps the line indexes to the formats
+				str = "\n";
+			}
+			else if (nstr > 0) {
+				// Remove the first letter.
+				str++;
+			}
+		}
+
+		lines[line_count++] = str;
+	}
+
+	if (!has_number && bytes_count == 0) {
+		srd_err("Protocol decoder %s submitted annotation list, but "
+			"second element was malformed.", di->decoder->name);
+		goto end;
+	}
+
+	if (at_hex[0])
+		strcpy(number_hex, at_hex);
+	else if (has_number)
+		sprintf(number_hex, "%02llX", numberic_value);
+	else
+		number_hex[0] = 0;
+
+	rec.start_sample = pdata->start_sample;
+	rec.end_sample = pdata->end_sample;
+	rec.pdo = pdata->pdo;
+	rec.ann_class = ann_class;
+	rec.ann_type = GPOINTER_TO_INT(ann_type_ptr);
+	rec.numberic_value = numberic_value;
+
+	g_mutex_lock(&di->ann_batch_mutex);
+	rec.text_id = srd_inst_ann_intern(di, lines, line_count, number_hex);
+	*batch_full = srd_inst_ann_push(di, &rec);
+	g_mutex_unlock(&di->ann_batch_mutex);
+
+	ret = SRD_OK;
+
+end:
+	for (i = 0; i < bytes_count; i++)
+		Py_DECREF(py_bytes[i]);
+
+	return ret;
+}
+
 static void release_binary(struct srd_proto_data_binary *pdb)
 {
 	if (!pdb)
@@ -471,6 +607,7 @@ static PyObject *Decoder_put(PyObject *self, PyObject *args)
 	int output_id;
 	struct srd_pd_callback *cb;
 	PyGILState_STATE gstate; 
+	gboolean batch_full;
 
 	py_data = NULL; //the fourth param from python
 
@@ -515,7 +652,19 @@ static PyObject *Decoder_put(PyObject *self, PyObject *args)
 	switch (pdo->output_type) {
 	case SRD_OUTPUT_ANN:
 		/* Annotations are only fed to callbacks. */
-		if ((cb = srd_pd_output_callback_find(di->sess, pdo->output_type))) {
+		if (di->sess->ann_batch_cb) {
+			batch_full = FALSE;
+			if (queue_annotation(di, py_data, &pdata, &batch_full) != SRD_OK) {
+				/* An error was already logged. */
+				break;
+			}
+			if (batch_full) {
+				Py_BEGIN_ALLOW_THREADS
+				srd_inst_ann_flush(di, FALSE);
+				Py_END_ALLOW_THREADS
+			}
+		}
+		else if ((cb = srd_pd_output_callback_find(di->sess, pdo->output_type))) {
 			pdata.data = &pda;
 			/* Convert from PyDict to srd_proto_data_annotation. */
 			if (convert_annotation(di, py_data, &pdata) != SRD_OK) {